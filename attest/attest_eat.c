@@ -0,0 +1,374 @@
+#include "attest_eat.h"
+#include "json_writer.h"
+#include "atomic_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <openssl/pem.h>
+#include <openssl/crypto.h>
+#include <openssl/ec.h>
+#include <openssl/rsa.h>
+
+const uint8_t attest_pcr_index[ATTEST_PCR_COUNT] = { 0, 1, 2, 7 };
+
+static int sha256(const void *data, size_t len, uint8_t out[ATTEST_DIGEST_LEN])
+{
+    return EVP_Digest(data, len, out, NULL, EVP_sha256(), NULL) == 1 ? ATTEST_OK : ATTEST_ERR_CRYPTO;
+}
+
+static void to_hex(const uint8_t *data, size_t len, char *out)
+{
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < len; i++) {
+        out[i * 2] = digits[data[i] >> 4];
+        out[i * 2 + 1] = digits[data[i] & 0xf];
+    }
+    out[len * 2] = '\0';
+}
+
+static const char *const alg_names[ATTEST_ALG_COUNT] = {
+    [ATTEST_ALG_RSA2048] = "rsa",
+    [ATTEST_ALG_P256]    = "ecdsa-p256",
+    [ATTEST_ALG_ED25519] = "ed25519",
+};
+
+int attest_alg_from_name(const char *name)
+{
+    for (int i = 0; i < ATTEST_ALG_COUNT; i++) {
+        if (strcmp(name, alg_names[i]) == 0)
+            return i;
+    }
+    if (strcmp(name, "p256") == 0)
+        return ATTEST_ALG_P256;
+    return -1;
+}
+
+const char *attest_alg_name(int alg)
+{
+    return alg >= 0 && alg < ATTEST_ALG_COUNT ? alg_names[alg] : "unknown";
+}
+
+static char *bio_to_string(BIO *bio, size_t *len)
+{
+    char *data;
+    long n = BIO_get_mem_data(bio, &data);
+    if (n <= 0)
+        return NULL;
+    char *copy = malloc((size_t)n + 1);
+    if (!copy)
+        return NULL;
+    memcpy(copy, data, (size_t)n);
+    copy[n] = '\0';
+    *len = (size_t)n;
+    return copy;
+}
+
+/* Classifies the key and does the one-off work every signature used to repeat */
+static int key_prepare(struct AttestKey *key)
+{
+    char group[32] = "";
+    size_t group_len;
+
+    switch (EVP_PKEY_get_base_id(key->pkey)) {
+    case EVP_PKEY_RSA:
+        key->alg = ATTEST_ALG_RSA2048;
+        break;
+    case EVP_PKEY_EC:
+        if (EVP_PKEY_get_group_name(key->pkey, group, sizeof(group), &group_len) != 1 ||
+            (strcmp(group, "prime256v1") != 0 && strcmp(group, "P-256") != 0))
+            return ATTEST_ERR_CRYPTO;
+        key->alg = ATTEST_ALG_P256;
+        break;
+    case EVP_PKEY_ED25519:
+        key->alg = ATTEST_ALG_ED25519;
+        break;
+    default:
+        return ATTEST_ERR_CRYPTO;
+    }
+    key->bits = EVP_PKEY_get_bits(key->pkey);
+    if (key->alg == ATTEST_ALG_RSA2048)
+        snprintf(key->sig_alg, sizeof(key->sig_alg), "RSA-%d-SHA256", key->bits);
+    else
+        snprintf(key->sig_alg, sizeof(key->sig_alg), "%s",
+                 key->alg == ATTEST_ALG_P256 ? "ECDSA-P256-SHA256" : "Ed25519");
+
+    /* Ed25519 hashes internally and takes no separate digest */
+    const EVP_MD *md = key->alg == ATTEST_ALG_ED25519 ? NULL : EVP_sha256();
+    key->sign_ctx = EVP_MD_CTX_new();
+    key->work_ctx = EVP_MD_CTX_new();
+    if (!key->sign_ctx || !key->work_ctx ||
+        EVP_DigestSignInit(key->sign_ctx, NULL, md, NULL, key->pkey) != 1)
+        return ATTEST_ERR_CRYPTO;
+
+    BIO *bio = BIO_new(BIO_s_mem());
+    if (bio && PEM_write_bio_PUBKEY(bio, key->pkey) == 1)
+        key->public_pem = bio_to_string(bio, &key->public_pem_len);
+    BIO_free(bio);
+    return key->public_pem ? ATTEST_OK : ATTEST_ERR_CRYPTO;
+}
+
+int attest_key_generate(struct AttestKey *key, int alg)
+{
+    memset(key, 0, sizeof(*key));
+    switch (alg) {
+    case ATTEST_ALG_RSA2048:
+        key->pkey = EVP_RSA_gen(ATTEST_KEY_BITS);
+        break;
+    case ATTEST_ALG_P256:
+        key->pkey = EVP_EC_gen("P-256");
+        break;
+    case ATTEST_ALG_ED25519:
+        key->pkey = EVP_PKEY_Q_keygen(NULL, NULL, "ED25519");
+        break;
+    }
+    if (!key->pkey)
+        return ATTEST_ERR_CRYPTO;
+    int ret = key_prepare(key);
+    if (ret != ATTEST_OK)
+        attest_key_free(key);
+    return ret;
+}
+
+int attest_key_from_pem(struct AttestKey *key, const char *pem, size_t len)
+{
+    memset(key, 0, sizeof(*key));
+    BIO *bio = BIO_new_mem_buf(pem, (int)len);
+    if (!bio)
+        return ATTEST_ERR_CRYPTO;
+    key->pkey = PEM_read_bio_PrivateKey(bio, NULL, NULL, NULL);
+    BIO_free(bio);
+    if (!key->pkey)
+        return ATTEST_ERR_CRYPTO;
+    int ret = key_prepare(key);
+    if (ret != ATTEST_OK)
+        attest_key_free(key);
+    return ret;
+}
+
+int attest_key_private_pem(const struct AttestKey *key, char **pem, size_t *len)
+{
+    BIO *bio = BIO_new(BIO_s_mem());
+    *pem = NULL;
+    if (bio && PEM_write_bio_PrivateKey(bio, key->pkey, NULL, NULL, 0, NULL, NULL) == 1)
+        *pem = bio_to_string(bio, len);
+    BIO_free(bio);
+    return *pem ? ATTEST_OK : ATTEST_ERR_CRYPTO;
+}
+
+/*
+ * Loads the AIK from priv_path, or generates one of type alg there the way
+ * generate_aik() did with openssl genrsa. An existing key is kept whatever
+ * its type. The public half is derived from the private key so the two
+ * files can never disagree.
+ */
+int attest_key_load(struct AttestKey *key, const char *priv_path, const char *pub_path,
+                    int alg, bool *generated)
+{
+    int ret;
+    *generated = false;
+
+    BIO *in = BIO_new_file(priv_path, "r");
+    if (in) {
+        memset(key, 0, sizeof(*key));
+        key->pkey = PEM_read_bio_PrivateKey(in, NULL, NULL, NULL);
+        BIO_free(in);
+        if (!key->pkey)
+            return ATTEST_ERR_CRYPTO;
+        ret = key_prepare(key);
+        if (ret != ATTEST_OK) {
+            attest_key_free(key);
+            return ret;
+        }
+    } else {
+        char *pem;
+        size_t len;
+        ret = attest_key_generate(key, alg);
+        if (ret != ATTEST_OK)
+            return ret;
+        ret = attest_key_private_pem(key, &pem, &len);
+        if (ret == ATTEST_OK) {
+            ret = atomic_publish(priv_path, pem, len, 0600, ATOMIC_SYNC_DIR) == ATOMIC_OK
+                  ? ATTEST_OK : ATTEST_ERR_IO;
+            OPENSSL_cleanse(pem, len);
+            free(pem);
+        }
+        if (ret != ATTEST_OK) {
+            attest_key_free(key);
+            return ret;
+        }
+        *generated = true;
+    }
+
+    if (*generated || access(pub_path, F_OK) != 0) {
+        if (atomic_publish(pub_path, key->public_pem, key->public_pem_len, 0644,
+                           ATOMIC_SYNC_DIR) != ATOMIC_OK) {
+            attest_key_free(key);
+            return ATTEST_ERR_IO;
+        }
+    }
+    return ATTEST_OK;
+}
+
+void attest_key_free(struct AttestKey *key)
+{
+    EVP_MD_CTX_free(key->sign_ctx);
+    EVP_MD_CTX_free(key->work_ctx);
+    EVP_PKEY_free(key->pkey);
+    free(key->public_pem);
+    memset(key, 0, sizeof(*key));
+}
+
+int attest_sign(const struct AttestKey *key, const void *data, size_t len,
+                uint8_t *sig, size_t *sig_len)
+{
+    if ((size_t)EVP_PKEY_get_size(key->pkey) > *sig_len)
+        return ATTEST_ERR_OVERFLOW;
+    /* providers without context duplication fall back to a fresh init */
+    if (EVP_MD_CTX_copy_ex(key->work_ctx, key->sign_ctx) != 1 &&
+        EVP_DigestSignInit(key->work_ctx, NULL,
+                           key->alg == ATTEST_ALG_ED25519 ? NULL : EVP_sha256(),
+                           NULL, key->pkey) != 1)
+        return ATTEST_ERR_CRYPTO;
+    return EVP_DigestSign(key->work_ctx, sig, sig_len, data, len) == 1 ? ATTEST_OK
+                                                                       : ATTEST_ERR_CRYPTO;
+}
+
+/* Same byte strings the shell fed to sha256sum, trailing newline from echo included */
+int attest_measure(const struct AttestInputs *in, struct AttestMeasurement *m)
+{
+    static const char placeholder[] = "kernel-placeholder\n";
+    static const char bootloader[] = "bootloader-config\n";
+    char text[96];
+    int ret = 0;
+
+    if (in->kernel_version)
+        ret |= sha256(in->kernel_version, in->kernel_version_len, m->pcr[0]);
+    else
+        ret |= sha256(placeholder, sizeof(placeholder) - 1, m->pcr[0]);
+    ret |= sha256(bootloader, sizeof(bootloader) - 1, m->pcr[1]);
+    int n = snprintf(text, sizeof(text), "tier%u_boot%llu\n", in->tier,
+                     (unsigned long long)in->boot_count);
+    ret |= sha256(text, (size_t)n, m->pcr[2]);
+    n = snprintf(text, sizeof(text), "secureboot_tier%u_health%u\n", in->tier, in->health_score);
+    ret |= sha256(text, (size_t)n, m->pcr[3]);
+    if (ret)
+        return ATTEST_ERR_CRYPTO;
+
+    char pcrs[(ATTEST_PCR_COUNT + 1) * (ATTEST_DIGEST_LEN * 2 + 10)];
+    size_t len = 0;
+    for (int i = 0; i < ATTEST_PCR_COUNT; i++) {
+        to_hex(m->pcr[i], ATTEST_DIGEST_LEN, m->pcr_hex[i]);
+        len += (size_t)snprintf(pcrs + len, sizeof(pcrs) - len, "PCR-%02u: %s\n",
+                                attest_pcr_index[i], m->pcr_hex[i]);
+    }
+    m->image_events = in->events ? event_log_replay(in->events, MEASURE_PCR_IMAGES, m->image_pcr) : 0;
+    if (m->image_events < 0)
+        return ATTEST_ERR_CRYPTO;
+    if (m->image_events > 0) {
+        to_hex(m->image_pcr, ATTEST_DIGEST_LEN, m->image_pcr_hex);
+        len += (size_t)snprintf(pcrs + len, sizeof(pcrs) - len, "PCR-%02u: %s\n",
+                                MEASURE_PCR_IMAGES, m->image_pcr_hex);
+    }
+    if (sha256(pcrs, len, m->digest) != ATTEST_OK)
+        return ATTEST_ERR_CRYPTO;
+    to_hex(m->digest, ATTEST_DIGEST_LEN, m->digest_hex);
+    return ATTEST_OK;
+}
+
+int attest_quote(const struct AttestInputs *in, const struct AttestMeasurement *m,
+                 char *buf, size_t cap)
+{
+    int n = snprintf(buf, cap,
+                     "TPM_QUOTE_V1\ntimestamp: %lld\nnonce: %s\npcr_digest: %s\ntier: %u\nclock: %s\n",
+                     (long long)in->timestamp, in->nonce, m->digest_hex, in->tier, in->clock);
+    if (n < 0 || (size_t)n >= cap)
+        return ATTEST_ERR_OVERFLOW;
+    return n;
+}
+
+/* Field order and names follow create_eat_token() so verifier.py sees no difference */
+int attest_eat_json(const struct AttestInputs *in, const struct AttestMeasurement *m,
+                    const char *quote, size_t quote_len, const uint8_t *sig, size_t sig_len,
+                    const struct AttestKey *key, char *buf, size_t cap)
+{
+    struct JsonWriter w;
+    json_init_buffer(&w, buf, cap, true);
+    json_object_begin(&w);
+    json_kv_string(&w, "format", "pac-eat-v2-signed");
+    json_kv_int(&w, "timestamp", (int64_t)in->timestamp);
+    json_kv_string(&w, "nonce", in->nonce);
+    json_kv_string(&w, "device_id", in->device_id);
+    json_key(&w, "boot_state");
+    json_object_begin(&w);
+    json_kv_uint(&w, "tier", in->tier);
+    json_kv_uint(&w, "boot_count", in->boot_count);
+    json_object_end(&w);
+
+    json_key(&w, "tpm_attestation");
+    json_object_begin(&w);
+    json_kv_string(&w, "version", "2.0");
+    json_key(&w, "quote_data");
+    json_base64(&w, (const uint8_t *)quote, quote_len);
+    json_key(&w, "signature");
+    json_base64(&w, sig, sig_len);
+    json_kv_string(&w, "signature_algorithm", key->sig_alg);
+    json_key(&w, "public_key");
+    json_base64(&w, (const uint8_t *)key->public_pem, key->public_pem_len);
+    json_kv_string(&w, "pcr_digest", m->digest_hex);
+    json_key(&w, "pcrs");
+    json_object_begin(&w);
+    for (int i = 0; i < ATTEST_PCR_COUNT; i++) {
+        char idx[4];
+        snprintf(idx, sizeof(idx), "%u", attest_pcr_index[i]);
+        json_kv_string(&w, idx, m->pcr_hex[i]);
+    }
+    if (m->image_events > 0) {
+        char idx[4];
+        snprintf(idx, sizeof(idx), "%u", MEASURE_PCR_IMAGES);
+        json_kv_string(&w, idx, m->image_pcr_hex);
+    }
+    json_object_end(&w);
+    if (m->image_events > 0) {
+        json_key(&w, "event_log");
+        json_array_begin(&w);
+        for (int i = 0; i < in->events->count; i++) {
+            const struct MeasureEvent *ev = &in->events->events[i];
+            json_object_begin(&w);
+            json_kv_uint(&w, "pcr", ev->pcr);
+            json_kv_string(&w, "type", ev->type);
+            json_key(&w, "digest");
+            json_hex(&w, ev->digest, MEASURE_DIGEST_LEN);
+            json_kv_string(&w, "name", ev->name);
+            json_object_end(&w);
+        }
+        json_array_end(&w);
+    }
+    json_object_end(&w);
+
+    json_key(&w, "health_status");
+    if (in->health_json && in->health_json_len > 0) {
+        json_raw(&w, in->health_json, in->health_json_len);
+    } else {
+        json_object_begin(&w);
+        json_kv_string(&w, "overall_status", "healthy");
+        json_kv_uint(&w, "overall_score", 8);
+        json_object_end(&w);
+    }
+
+    json_key(&w, "metadata");
+    json_object_begin(&w);
+    json_kv_string(&w, "pac_version", "2.0");
+    json_kv_string(&w, "agent", "pac_attestd");
+    json_kv_string(&w, "crypto", "real");
+    json_object_end(&w);
+    json_object_end(&w);
+
+    int ret = json_finish(&w);
+    if (ret < 0)
+        return ret == JSON_ERR_OVERFLOW ? ATTEST_ERR_OVERFLOW : ATTEST_ERR_IO;
+    if ((size_t)ret >= cap)
+        return ATTEST_ERR_OVERFLOW;
+    buf[ret] = '\0';
+    return ret;
+}
@@ -0,0 +1,95 @@
+#ifndef ATTEST_EAT_H
+#define ATTEST_EAT_H
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <openssl/evp.h>
+#include "measure.h"
+
+#define ATTEST_OK             0
+#define ATTEST_ERR_IO        -1
+#define ATTEST_ERR_CRYPTO    -2
+#define ATTEST_ERR_OVERFLOW  -3
+
+#define ATTEST_KEY_BITS      2048
+#define ATTEST_DIGEST_LEN    32
+#define ATTEST_PCR_COUNT     4
+#define ATTEST_SIG_MAX       512
+#define ATTEST_QUOTE_MAX     512
+#define ATTEST_TOKEN_MAX     (32 * 1024)
+
+/* AIK algorithms; RSA-2048 is what the shell agent always generated */
+#define ATTEST_ALG_RSA2048   0
+#define ATTEST_ALG_P256      1
+#define ATTEST_ALG_ED25519   2
+#define ATTEST_ALG_COUNT     3
+
+/*
+ * AIK held in memory for the life of the agent; the PEM is what the token
+ * carries. sign_ctx is initialised once with the key so each quote only
+ * copies it instead of re-parsing and re-deriving the key.
+ */
+struct AttestKey {
+    EVP_PKEY   *pkey;
+    EVP_MD_CTX *sign_ctx;
+    EVP_MD_CTX *work_ctx;
+    char       *public_pem;
+    size_t      public_pem_len;
+    int         alg;
+    int         bits;
+    char        sig_alg[24];
+};
+
+/* Everything the shell agent gathered with journal_tool, cat, hostname and date */
+struct AttestInputs {
+    uint8_t     tier;
+    uint64_t    boot_count;
+    uint8_t     health_score;
+    const char *kernel_version;
+    size_t      kernel_version_len;
+    time_t      timestamp;
+    char        clock[32];
+    char        device_id[96];
+    const char *nonce;
+    const char *health_json;
+    size_t      health_json_len;
+    const struct EventLog *events;
+};
+
+/*
+ * PCR-00, 01, 02 and 07 in the layout of pcrs.txt, plus PCR-08 replayed
+ * from the event log once any rootfs image has been measured.
+ */
+struct AttestMeasurement {
+    uint8_t pcr[ATTEST_PCR_COUNT][ATTEST_DIGEST_LEN];
+    char    pcr_hex[ATTEST_PCR_COUNT][ATTEST_DIGEST_LEN * 2 + 1];
+    int     image_events;
+    uint8_t image_pcr[ATTEST_DIGEST_LEN];
+    char    image_pcr_hex[ATTEST_DIGEST_LEN * 2 + 1];
+    uint8_t digest[ATTEST_DIGEST_LEN];
+    char    digest_hex[ATTEST_DIGEST_LEN * 2 + 1];
+};
+
+extern const uint8_t attest_pcr_index[ATTEST_PCR_COUNT];
+
+int attest_alg_from_name(const char *name);
+const char *attest_alg_name(int alg);
+
+int attest_key_generate(struct AttestKey *key, int alg);
+int attest_key_from_pem(struct AttestKey *key, const char *pem, size_t len);
+int attest_key_load(struct AttestKey *key, const char *priv_path, const char *pub_path,
+                    int alg, bool *generated);
+int attest_key_private_pem(const struct AttestKey *key, char **pem, size_t *len);
+void attest_key_free(struct AttestKey *key);
+int attest_sign(const struct AttestKey *key, const void *data, size_t len,
+                uint8_t *sig, size_t *sig_len);
+
+int attest_measure(const struct AttestInputs *in, struct AttestMeasurement *m);
+int attest_quote(const struct AttestInputs *in, const struct AttestMeasurement *m,
+                 char *buf, size_t cap);
+int attest_eat_json(const struct AttestInputs *in, const struct AttestMeasurement *m,
+                    const char *quote, size_t quote_len, const uint8_t *sig, size_t sig_len,
+                    const struct AttestKey *key, char *buf, size_t cap);
+
+#endif
@@ -0,0 +1,349 @@
+#define _GNU_SOURCE
+#include "measure.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <openssl/evp.h>
+
+#define CACHE_HEADER "# pac-measure-cache v1\n"
+#define LOG_HEADER   "# pac-event-log v1 boot "
+
+static void to_hex(const uint8_t *data, size_t len, char *out)
+{
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < len; i++) {
+        out[i * 2] = digits[data[i] >> 4];
+        out[i * 2 + 1] = digits[data[i] & 0xf];
+    }
+    out[len * 2] = '\0';
+}
+
+static int from_hex(const char *hex, uint8_t *out, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        unsigned v;
+        if (sscanf(hex + i * 2, "%2x", &v) != 1)
+            return -1;
+        out[i] = (uint8_t)v;
+    }
+    return hex[len * 2] == '\0' ? 0 : -1;
+}
+
+/*
+ * Hashes a whole file in MEASURE_CHUNK reads into an aligned buffer. The
+ * next window is requested with WILLNEED before the current one is hashed
+ * so the disk stays busy, and hashed pages are dropped so measuring a
+ * rootfs image does not push the running system out of the page cache.
+ */
+int measure_stream(int fd, uint8_t digest[MEASURE_DIGEST_LEN], uint64_t *bytes)
+{
+    void *buf;
+    if (posix_memalign(&buf, MEASURE_ALIGN, MEASURE_CHUNK) != 0)
+        return MEASURE_ERR_IO;
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    if (!ctx || EVP_DigestInit_ex(ctx, EVP_sha256(), NULL) != 1) {
+        EVP_MD_CTX_free(ctx);
+        free(buf);
+        return MEASURE_ERR_CRYPTO;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    int ret = MEASURE_OK;
+    off_t off = 0;
+    for (;;) {
+        posix_fadvise(fd, off + MEASURE_CHUNK, MEASURE_CHUNK, POSIX_FADV_WILLNEED);
+        size_t len = 0;
+        while (len < MEASURE_CHUNK) {
+            ssize_t n = read(fd, (char *)buf + len, MEASURE_CHUNK - len);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0) {
+                ret = MEASURE_ERR_IO;
+                break;
+            }
+            if (n == 0)
+                break;
+            len += (size_t)n;
+        }
+        if (ret != MEASURE_OK || len == 0)
+            break;
+        if (EVP_DigestUpdate(ctx, buf, len) != 1) {
+            ret = MEASURE_ERR_CRYPTO;
+            break;
+        }
+        posix_fadvise(fd, off, (off_t)len, POSIX_FADV_DONTNEED);
+        off += (off_t)len;
+        if (len < MEASURE_CHUNK)
+            break;
+    }
+    if (ret == MEASURE_OK && EVP_DigestFinal_ex(ctx, digest, NULL) != 1)
+        ret = MEASURE_ERR_CRYPTO;
+    EVP_MD_CTX_free(ctx);
+    free(buf);
+    if (bytes)
+        *bytes = (uint64_t)off;
+    return ret;
+}
+
+/* dm-verity root published by the build as verity.roothash beside rootfs.img */
+static void read_verity_root(const char *path, char *out, size_t cap)
+{
+    char root_path[ATOMIC_PATH_MAX + 16];
+    const char *slash = strrchr(path, '/');
+    int dirlen = slash ? (int)(slash - path) : 1;
+    snprintf(root_path, sizeof(root_path), "%.*s/verity.roothash", dirlen, slash ? path : ".");
+
+    out[0] = '\0';
+    FILE *f = fopen(root_path, "r");
+    if (!f)
+        return;
+    if (fgets(out, (int)cap, f))
+        out[strcspn(out, " \t\r\n")] = '\0';
+    fclose(f);
+}
+
+int measure_key_for(const char *path, struct MeasureKey *key)
+{
+    struct stat st;
+    memset(key, 0, sizeof(*key));
+    if (stat(path, &st) != 0)
+        return MEASURE_ERR_IO;
+    key->dev = (uint64_t)st.st_dev;
+    key->ino = (uint64_t)st.st_ino;
+    key->size = (uint64_t)st.st_size;
+    key->mtime_sec = (int64_t)st.st_mtim.tv_sec;
+    key->mtime_nsec = st.st_mtim.tv_nsec;
+    read_verity_root(path, key->verity, sizeof(key->verity));
+    return MEASURE_OK;
+}
+
+static bool key_equal(const struct MeasureKey *a, const struct MeasureKey *b)
+{
+    return a->dev == b->dev && a->ino == b->ino && a->size == b->size &&
+           a->mtime_sec == b->mtime_sec && a->mtime_nsec == b->mtime_nsec &&
+           strcmp(a->verity, b->verity) == 0;
+}
+
+static struct MeasureEntry *cache_find(struct MeasureCache *cache, const char *path)
+{
+    for (int i = 0; i < cache->count; i++) {
+        if (strcmp(cache->entries[i].path, path) == 0)
+            return &cache->entries[i];
+    }
+    return NULL;
+}
+
+int measure_image(struct MeasureCache *cache, const char *path,
+                  uint8_t digest[MEASURE_DIGEST_LEN], bool *cached)
+{
+    struct MeasureKey key, after;
+    *cached = false;
+    if (strlen(path) >= ATOMIC_PATH_MAX || strpbrk(path, " \t\n"))
+        return MEASURE_ERR_FORMAT;
+    int ret = measure_key_for(path, &key);
+    if (ret != MEASURE_OK)
+        return ret;
+
+    struct MeasureEntry *e = cache_find(cache, path);
+    if (e && key_equal(&e->key, &key)) {
+        memcpy(digest, e->digest, MEASURE_DIGEST_LEN);
+        cache->hits++;
+        *cached = true;
+        return MEASURE_OK;
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return MEASURE_ERR_IO;
+    uint64_t bytes = 0;
+    ret = measure_stream(fd, digest, &bytes);
+    close(fd);
+    cache->misses++;
+    cache->bytes_hashed += bytes;
+    if (ret != MEASURE_OK)
+        return ret;
+
+    /* an image rewritten while it was being hashed is measured but not cached */
+    if (measure_key_for(path, &after) != MEASURE_OK || !key_equal(&key, &after))
+        return MEASURE_OK;
+    if (!e) {
+        if (cache->count == MEASURE_MAX_ENTRIES)
+            return MEASURE_OK;
+        e = &cache->entries[cache->count++];
+        snprintf(e->path, sizeof(e->path), "%s", path);
+    }
+    e->key = key;
+    memcpy(e->digest, digest, MEASURE_DIGEST_LEN);
+    cache->dirty = true;
+    return MEASURE_OK;
+}
+
+int measure_cache_load(struct MeasureCache *cache, const char *path)
+{
+    char line[ATOMIC_PATH_MAX + MEASURE_VERITY_MAX + 160];
+    memset(cache, 0, sizeof(*cache));
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return errno == ENOENT ? MEASURE_OK : MEASURE_ERR_IO;
+    if (!fgets(line, sizeof(line), f) || strcmp(line, CACHE_HEADER) != 0) {
+        fclose(f);
+        return MEASURE_ERR_FORMAT;
+    }
+    while (cache->count < MEASURE_MAX_ENTRIES && fgets(line, sizeof(line), f)) {
+        struct MeasureEntry *e = &cache->entries[cache->count];
+        unsigned long long dev, ino, size;
+        long long sec;
+        char digest[MEASURE_DIGEST_LEN * 2 + 2];
+        if (sscanf(line, "%255s %llu %llu %llu %lld %ld %128s %65s", e->path, &dev, &ino, &size,
+                   &sec, &e->key.mtime_nsec, e->key.verity, digest) != 8 ||
+            from_hex(digest, e->digest, MEASURE_DIGEST_LEN) != 0)
+            continue;
+        e->key.dev = dev;
+        e->key.ino = ino;
+        e->key.size = size;
+        e->key.mtime_sec = sec;
+        if (strcmp(e->key.verity, "-") == 0)
+            e->key.verity[0] = '\0';
+        cache->count++;
+    }
+    fclose(f);
+    return MEASURE_OK;
+}
+
+int measure_cache_save(struct MeasureCache *cache, const char *path)
+{
+    if (!cache->dirty)
+        return MEASURE_OK;
+    static char buf[sizeof(CACHE_HEADER) +
+                    MEASURE_MAX_ENTRIES * (ATOMIC_PATH_MAX + MEASURE_VERITY_MAX + 160)];
+    size_t len = strlen(CACHE_HEADER);
+    memcpy(buf, CACHE_HEADER, len);
+    for (int i = 0; i < cache->count; i++) {
+        const struct MeasureEntry *e = &cache->entries[i];
+        char hex[MEASURE_DIGEST_LEN * 2 + 1];
+        to_hex(e->digest, MEASURE_DIGEST_LEN, hex);
+        len += (size_t)snprintf(buf + len, sizeof(buf) - len, "%s %llu %llu %llu %lld %ld %s %s\n",
+                                e->path, (unsigned long long)e->key.dev,
+                                (unsigned long long)e->key.ino, (unsigned long long)e->key.size,
+                                (long long)e->key.mtime_sec, e->key.mtime_nsec,
+                                e->key.verity[0] ? e->key.verity : "-", hex);
+    }
+    if (atomic_publish(path, buf, len, 0600, 0) != ATOMIC_OK)
+        return MEASURE_ERR_IO;
+    cache->dirty = false;
+    return MEASURE_OK;
+}
+
+/* A log written during another boot is discarded, like a TPM event log at reset */
+int event_log_load(struct EventLog *log, const char *path, const char *boot_id)
+{
+    char line[ATOMIC_PATH_MAX + 128];
+    memset(log, 0, sizeof(*log));
+    snprintf(log->boot_id, sizeof(log->boot_id), "%s", boot_id);
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return errno == ENOENT ? MEASURE_OK : MEASURE_ERR_IO;
+    size_t hlen = strlen(LOG_HEADER);
+    if (!fgets(line, sizeof(line), f) || strncmp(line, LOG_HEADER, hlen) != 0 ||
+        strcspn(line + hlen, "\n") != strlen(boot_id) ||
+        strncmp(line + hlen, boot_id, strlen(boot_id)) != 0) {
+        fclose(f);
+        return MEASURE_OK;
+    }
+    while (log->count < MEASURE_MAX_EVENTS && fgets(line, sizeof(line), f)) {
+        struct MeasureEvent *ev = &log->events[log->count];
+        unsigned pcr;
+        char digest[MEASURE_DIGEST_LEN * 2 + 2];
+        if (sscanf(line, "%u %23s sha256:%65s %255s", &pcr, ev->type, digest, ev->name) != 4 ||
+            pcr > 23 || from_hex(digest, ev->digest, MEASURE_DIGEST_LEN) != 0) {
+            fclose(f);
+            log->count = 0;
+            return MEASURE_ERR_FORMAT;
+        }
+        ev->pcr = (uint8_t)pcr;
+        log->count++;
+    }
+    fclose(f);
+    log->persisted = log->count;
+    return MEASURE_OK;
+}
+
+/* Returns 1 when an event was appended, 0 when the latest one for name already matches */
+int event_log_record(struct EventLog *log, uint8_t pcr, const char *type,
+                     const uint8_t digest[MEASURE_DIGEST_LEN], const char *name)
+{
+    for (int i = log->count - 1; i >= 0; i--) {
+        const struct MeasureEvent *ev = &log->events[i];
+        if (ev->pcr == pcr && strcmp(ev->name, name) == 0) {
+            if (memcmp(ev->digest, digest, MEASURE_DIGEST_LEN) == 0)
+                return 0;
+            break;
+        }
+    }
+    if (log->count == MEASURE_MAX_EVENTS)
+        return MEASURE_ERR_FULL;
+    struct MeasureEvent *ev = &log->events[log->count++];
+    ev->pcr = pcr;
+    snprintf(ev->type, sizeof(ev->type), "%s", type);
+    memcpy(ev->digest, digest, MEASURE_DIGEST_LEN);
+    snprintf(ev->name, sizeof(ev->name), "%s", name);
+    return 1;
+}
+
+static size_t format_event(const struct MeasureEvent *ev, char *buf, size_t cap)
+{
+    char hex[MEASURE_DIGEST_LEN * 2 + 1];
+    to_hex(ev->digest, MEASURE_DIGEST_LEN, hex);
+    int n = snprintf(buf, cap, "%u %s sha256:%s %s\n", ev->pcr, ev->type, hex, ev->name);
+    return n > 0 && (size_t)n < cap ? (size_t)n : 0;
+}
+
+/* Rewrites the log for a new boot, otherwise appends only the new events */
+int event_log_save(struct EventLog *log, const char *path)
+{
+    static char buf[128 + MEASURE_MAX_EVENTS * (ATOMIC_PATH_MAX + 128)];
+    size_t len = 0;
+    if (log->persisted == log->count)
+        return MEASURE_OK;
+    if (log->persisted == 0)
+        len = (size_t)snprintf(buf, sizeof(buf), LOG_HEADER "%s\n", log->boot_id);
+    for (int i = log->persisted; i < log->count; i++)
+        len += format_event(&log->events[i], buf + len, sizeof(buf) - len);
+
+    if (log->persisted == 0) {
+        if (atomic_publish(path, buf, len, 0644, 0) != ATOMIC_OK)
+            return MEASURE_ERR_IO;
+    } else {
+        int fd = open(path, O_WRONLY | O_APPEND | O_CLOEXEC);
+        if (fd < 0)
+            return MEASURE_ERR_IO;
+        bool ok = write(fd, buf, len) == (ssize_t)len && fdatasync(fd) == 0;
+        close(fd);
+        if (!ok)
+            return MEASURE_ERR_IO;
+    }
+    log->persisted = log->count;
+    return MEASURE_OK;
+}
+
+/* Recomputes a PCR from zero by extending it with every logged event, as a verifier would */
+int event_log_replay(const struct EventLog *log, uint8_t pcr, uint8_t value[MEASURE_DIGEST_LEN])
+{
+    uint8_t buf[MEASURE_DIGEST_LEN * 2];
+    int n = 0;
+    memset(value, 0, MEASURE_DIGEST_LEN);
+    for (int i = 0; i < log->count; i++) {
+        if (log->events[i].pcr != pcr)
+            continue;
+        memcpy(buf, value, MEASURE_DIGEST_LEN);
+        memcpy(buf + MEASURE_DIGEST_LEN, log->events[i].digest, MEASURE_DIGEST_LEN);
+        if (EVP_Digest(buf, sizeof(buf), value, NULL, EVP_sha256(), NULL) != 1)
+            return MEASURE_ERR_CRYPTO;
+        n++;
+    }
+    return n;
+}
@@ -0,0 +1,82 @@
+#ifndef MEASURE_H
+#define MEASURE_H
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "atomic_file.h"
+
+#define MEASURE_OK            0
+#define MEASURE_ERR_IO       -1
+#define MEASURE_ERR_CRYPTO   -2
+#define MEASURE_ERR_FULL     -3
+#define MEASURE_ERR_FORMAT   -4
+
+#define MEASURE_DIGEST_LEN   32
+#define MEASURE_CHUNK        (1024 * 1024)
+#define MEASURE_ALIGN        4096
+#define MEASURE_MAX_ENTRIES  16
+#define MEASURE_MAX_EVENTS   64
+#define MEASURE_VERITY_MAX   129
+
+/* PCR the tier rootfs images are extended into, as the OS loader PCRs are */
+#define MEASURE_PCR_IMAGES   8
+#define MEASURE_EVENT_IMAGE  "rootfs-image"
+
+/*
+ * A cached digest is reused only while the image is the same inode with
+ * the same size and mtime and, when the image ships a verity.roothash next
+ * to it, the same dm-verity root.
+ */
+struct MeasureKey {
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t size;
+    int64_t  mtime_sec;
+    long     mtime_nsec;
+    char     verity[MEASURE_VERITY_MAX];
+};
+
+struct MeasureEntry {
+    char    path[ATOMIC_PATH_MAX];
+    struct MeasureKey key;
+    uint8_t digest[MEASURE_DIGEST_LEN];
+};
+
+struct MeasureCache {
+    struct MeasureEntry entries[MEASURE_MAX_ENTRIES];
+    int      count;
+    bool     dirty;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t bytes_hashed;
+};
+
+struct MeasureEvent {
+    uint8_t pcr;
+    char    type[24];
+    uint8_t digest[MEASURE_DIGEST_LEN];
+    char    name[ATOMIC_PATH_MAX];
+};
+
+/* TCG-style event log for the current boot; events past 'persisted' are not on disk yet */
+struct EventLog {
+    char boot_id[40];
+    struct MeasureEvent events[MEASURE_MAX_EVENTS];
+    int  count;
+    int  persisted;
+};
+
+int measure_stream(int fd, uint8_t digest[MEASURE_DIGEST_LEN], uint64_t *bytes);
+int measure_key_for(const char *path, struct MeasureKey *key);
+int measure_image(struct MeasureCache *cache, const char *path,
+                  uint8_t digest[MEASURE_DIGEST_LEN], bool *cached);
+int measure_cache_load(struct MeasureCache *cache, const char *path);
+int measure_cache_save(struct MeasureCache *cache, const char *path);
+
+int event_log_load(struct EventLog *log, const char *path, const char *boot_id);
+int event_log_record(struct EventLog *log, uint8_t pcr, const char *type,
+                     const uint8_t digest[MEASURE_DIGEST_LEN], const char *name);
+int event_log_save(struct EventLog *log, const char *path);
+int event_log_replay(const struct EventLog *log, uint8_t pcr, uint8_t value[MEASURE_DIGEST_LEN]);
+
+#endif
@@ -0,0 +1,722 @@
+#define _GNU_SOURCE
+#include "merkle.h"
+#include "atomic_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/openat2.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+
+#define MANIFEST_HEADER "# pac-merkle v1\n"
+#define MERKLE_PATH_MAX 4096
+
+static void to_hex(const uint8_t *data, size_t len, char *out)
+{
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < len; i++) {
+        out[i * 2] = digits[data[i] >> 4];
+        out[i * 2 + 1] = digits[data[i] & 0xf];
+    }
+    out[len * 2] = '\0';
+}
+
+static int from_hex(const char *hex, uint8_t *out, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        unsigned v;
+        if (sscanf(hex + i * 2, "%2x", &v) != 1)
+            return -1;
+        out[i] = (uint8_t)v;
+    }
+    return hex[len * 2] == '\0' ? 0 : -1;
+}
+
+static double elapsed_ms(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) * 1000.0 +
+           (double)(now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+static int leaf_cmp(const void *a, const void *b)
+{
+    return strcmp(((const struct MerkleLeaf *)a)->path, ((const struct MerkleLeaf *)b)->path);
+}
+
+static struct MerkleLeaf *leaf_add(struct MerkleManifest *m, const char *path)
+{
+    if (m->count == m->cap) {
+        size_t cap = m->cap ? m->cap * 2 : 256;
+        struct MerkleLeaf *grown = realloc(m->leaves, cap * sizeof(*grown));
+        if (!grown)
+            return NULL;
+        m->leaves = grown;
+        m->cap = cap;
+    }
+    struct MerkleLeaf *leaf = &m->leaves[m->count];
+    memset(leaf, 0, sizeof(*leaf));
+    leaf->path = strdup(path);
+    if (!leaf->path)
+        return NULL;
+    m->count++;
+    return leaf;
+}
+
+void merkle_free(struct MerkleManifest *m)
+{
+    for (size_t i = 0; i < m->count; i++)
+        free(m->leaves[i].path);
+    free(m->leaves);
+    memset(m, 0, sizeof(*m));
+}
+
+static int scan_dir(struct MerkleManifest *m, int dfd, const char *prefix)
+{
+    DIR *dir = fdopendir(dfd);
+    if (!dir) {
+        close(dfd);
+        return MERKLE_ERR_IO;
+    }
+    int ret = MERKLE_OK;
+    struct dirent *de;
+    while (ret == MERKLE_OK && (de = readdir(dir)) != NULL) {
+        const char *name = de->d_name;
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+            continue;
+        if (!*prefix && (strcmp(name, MERKLE_MANIFEST) == 0 ||
+                         strcmp(name, MERKLE_SIGNATURE) == 0))
+            continue;
+        char path[MERKLE_PATH_MAX];
+        int n = snprintf(path, sizeof(path), "%s%s%s", prefix, *prefix ? "/" : "", name);
+        if (n < 0 || (size_t)n >= sizeof(path) || strchr(name, '\n')) {
+            fprintf(stderr, "attest: cannot record path %s/%s\n", prefix, name);
+            ret = MERKLE_ERR_FORMAT;
+            break;
+        }
+        struct stat st;
+        if (fstatat(dirfd(dir), name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+            ret = MERKLE_ERR_IO;
+            break;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            int sub = openat(dirfd(dir), name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            ret = sub < 0 ? MERKLE_ERR_IO : scan_dir(m, sub, path);
+        } else if (S_ISREG(st.st_mode) || S_ISLNK(st.st_mode)) {
+            struct MerkleLeaf *leaf = leaf_add(m, path);
+            if (!leaf) {
+                ret = MERKLE_ERR_IO;
+                break;
+            }
+            leaf->mode = (uint32_t)st.st_mode;
+            leaf->size = (uint64_t)st.st_size;
+        }
+    }
+    closedir(dir);
+    return ret;
+}
+
+/* Regular files and symlinks under dir, sorted by path; digests are left zero */
+int merkle_scan(struct MerkleManifest *m, const char *dir)
+{
+    memset(m, 0, sizeof(*m));
+    int dfd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dfd < 0)
+        return MERKLE_ERR_IO;
+    int ret = scan_dir(m, dfd, "");
+    if (ret != MERKLE_OK) {
+        merkle_free(m);
+        return ret;
+    }
+    qsort(m->leaves, m->count, sizeof(*m->leaves), leaf_cmp);
+    return MERKLE_OK;
+}
+
+struct MerkleLeaf *merkle_find(const struct MerkleManifest *m, const char *path)
+{
+    while (path[0] == '/' || (path[0] == '.' && path[1] == '/'))
+        path += path[0] == '/' ? 1 : 2;
+    struct MerkleLeaf key = { .path = (char *)path };
+    return bsearch(&key, m->leaves, m->count, sizeof(*m->leaves), leaf_cmp);
+}
+
+/*
+ * Calls fn for each non-empty, non-comment line of a file list such as the
+ * one recorded from the files opened during early boot. Paths may be
+ * absolute within the tier root or relative to it.
+ */
+static int for_each_listed(const char *list_path, int (*fn)(const char *, void *), void *arg)
+{
+    FILE *f = fopen(list_path, "r");
+    if (!f)
+        return MERKLE_ERR_IO;
+    char line[MERKLE_PATH_MAX];
+    int ret = MERKLE_OK;
+    while (ret == MERKLE_OK && fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#')
+            continue;
+        ret = fn(line, arg);
+    }
+    fclose(f);
+    return ret;
+}
+
+static int mark_one(const char *path, void *arg)
+{
+    struct MerkleLeaf *leaf = merkle_find(arg, path);
+    if (!leaf) {
+        fprintf(stderr, "attest: early file %s is not in the tree\n", path);
+        return MERKLE_ERR_FORMAT;
+    }
+    leaf->flags |= MERKLE_FLAG_EARLY;
+    return MERKLE_OK;
+}
+
+int merkle_mark_early(struct MerkleManifest *m, const char *list_path)
+{
+    return for_each_listed(list_path, mark_one, m);
+}
+
+/*
+ * Resolves path beneath the tier root without following any symlink, so a
+ * directory swapped for a link cannot redirect verification outside the
+ * tree. Kernels without openat2 fall back to openat, which only refuses a
+ * link in the final component.
+ */
+static int open_beneath(int dfd, const char *path, int flags)
+{
+    static int have_openat2 = 1;
+    if (__atomic_load_n(&have_openat2, __ATOMIC_RELAXED)) {
+        struct open_how how = {
+            .flags = (uint64_t)(flags | O_NOFOLLOW | O_CLOEXEC),
+            .resolve = RESOLVE_BENEATH | RESOLVE_NO_SYMLINKS,
+        };
+        int fd = (int)syscall(SYS_openat2, dfd, path, &how, sizeof(how));
+        if (fd >= 0 || errno != ENOSYS)
+            return fd;
+        __atomic_store_n(&have_openat2, 0, __ATOMIC_RELAXED);
+    }
+    return openat(dfd, path, flags | O_NOFOLLOW | O_CLOEXEC);
+}
+
+struct Pool {
+    struct MerkleLeaf *leaves;
+    int      dirfd;
+    size_t  *order;
+    size_t   n;
+    size_t   next;
+    int      stop;
+    bool     build;
+    bool     has_deadline;
+    struct timespec deadline;
+    pthread_mutex_t lock;
+    struct MerkleReport *rep;
+    int      error;
+};
+
+static bool past_deadline(struct Pool *p)
+{
+    if (!p->has_deadline)
+        return false;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec > p->deadline.tv_sec ||
+           (now.tv_sec == p->deadline.tv_sec && now.tv_nsec >= p->deadline.tv_nsec);
+}
+
+/* Digest, size and mode of one leaf as it is on disk now */
+static int hash_leaf(struct Pool *p, const struct MerkleLeaf *leaf, uint8_t *buf,
+                     EVP_MD_CTX *ctx, uint8_t digest[MERKLE_DIGEST_LEN], struct stat *st)
+{
+    /* O_NONBLOCK so a FIFO planted in place of a file cannot stall the check */
+    int fd = open_beneath(p->dirfd, leaf->path, O_RDONLY | O_NONBLOCK);
+    if (fd < 0 && errno == ELOOP)
+        fd = open_beneath(p->dirfd, leaf->path, O_PATH);
+    if (fd < 0 || fstat(fd, st) != 0) {
+        if (fd >= 0)
+            close(fd);
+        return MERKLE_ERR_IO;
+    }
+    if (EVP_DigestInit_ex(ctx, EVP_sha256(), NULL) != 1) {
+        close(fd);
+        return MERKLE_ERR_CRYPTO;
+    }
+    /* a size or type change fails the leaf without reading the file */
+    if (!p->build && ((uint32_t)st->st_mode != leaf->mode || (uint64_t)st->st_size != leaf->size)) {
+        close(fd);
+        return MERKLE_ERR_MISMATCH;
+    }
+
+    int ret = MERKLE_OK;
+    if (S_ISLNK(st->st_mode)) {
+        ssize_t n = readlinkat(fd, "", (char *)buf, MERKLE_CHUNK);
+        if (n < 0)
+            ret = MERKLE_ERR_IO;
+        else if (EVP_DigestUpdate(ctx, buf, (size_t)n) != 1)
+            ret = MERKLE_ERR_CRYPTO;
+    } else if (S_ISREG(st->st_mode)) {
+        for (;;) {
+            ssize_t n = read(fd, buf, MERKLE_CHUNK);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0) {
+                ret = MERKLE_ERR_IO;
+                break;
+            }
+            if (n == 0)
+                break;
+            if (EVP_DigestUpdate(ctx, buf, (size_t)n) != 1) {
+                ret = MERKLE_ERR_CRYPTO;
+                break;
+            }
+            __atomic_fetch_add(&p->rep->bytes, (uint64_t)n, __ATOMIC_RELAXED);
+            if (past_deadline(p)) {
+                ret = MERKLE_ERR_TIMEOUT;
+                break;
+            }
+        }
+    } else {
+        ret = MERKLE_ERR_MISMATCH;
+    }
+    close(fd);
+    if (ret == MERKLE_OK && EVP_DigestFinal_ex(ctx, digest, NULL) != 1)
+        ret = MERKLE_ERR_CRYPTO;
+    return ret;
+}
+
+static void leaf_failed(struct Pool *p, const struct MerkleLeaf *leaf, int err)
+{
+    pthread_mutex_lock(&p->lock);
+    p->rep->failed++;
+    if (!p->rep->first_bad[0])
+        snprintf(p->rep->first_bad, sizeof(p->rep->first_bad), "%s", leaf->path);
+    if (p->build && !p->error)
+        p->error = err;
+    pthread_mutex_unlock(&p->lock);
+}
+
+/*
+ * Workers take the next leaf from a shared counter; the order is largest
+ * file first so one big file picked up last cannot leave a single core
+ * hashing while the others sit idle.
+ */
+static void *pool_worker(void *arg)
+{
+    struct Pool *p = arg;
+    uint8_t *buf = malloc(MERKLE_CHUNK);
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    if (!buf || !ctx) {
+        __atomic_store_n(&p->stop, 1, __ATOMIC_RELAXED);
+        pthread_mutex_lock(&p->lock);
+        p->error = MERKLE_ERR_IO;
+        pthread_mutex_unlock(&p->lock);
+        free(buf);
+        EVP_MD_CTX_free(ctx);
+        return NULL;
+    }
+    for (;;) {
+        if (__atomic_load_n(&p->stop, __ATOMIC_RELAXED))
+            break;
+        size_t i = __atomic_fetch_add(&p->next, 1, __ATOMIC_RELAXED);
+        if (i >= p->n)
+            break;
+        if (past_deadline(p)) {
+            __atomic_store_n(&p->stop, 1, __ATOMIC_RELAXED);
+            __atomic_store_n(&p->rep->timed_out, true, __ATOMIC_RELAXED);
+            break;
+        }
+        struct MerkleLeaf *leaf = &p->leaves[p->order[i]];
+        uint8_t digest[MERKLE_DIGEST_LEN];
+        struct stat st;
+        int ret = hash_leaf(p, leaf, buf, ctx, digest, &st);
+        if (ret == MERKLE_ERR_TIMEOUT) {
+            __atomic_store_n(&p->stop, 1, __ATOMIC_RELAXED);
+            __atomic_store_n(&p->rep->timed_out, true, __ATOMIC_RELAXED);
+            break;
+        }
+        if (ret == MERKLE_OK && p->build) {
+            memcpy(leaf->digest, digest, sizeof(digest));
+            leaf->mode = (uint32_t)st.st_mode;
+            leaf->size = (uint64_t)st.st_size;
+        } else if (ret == MERKLE_OK && memcmp(digest, leaf->digest, sizeof(digest)) != 0) {
+            ret = MERKLE_ERR_MISMATCH;
+        }
+        if (ret != MERKLE_OK)
+            leaf_failed(p, leaf, ret);
+        __atomic_fetch_add(&p->rep->checked, 1, __ATOMIC_RELAXED);
+    }
+    EVP_MD_CTX_free(ctx);
+    free(buf);
+    return NULL;
+}
+
+static int size_desc(const void *a, const void *b, void *arg)
+{
+    const struct MerkleLeaf *leaves = arg;
+    uint64_t sa = leaves[*(const size_t *)a].size;
+    uint64_t sb = leaves[*(const size_t *)b].size;
+    return sa < sb ? 1 : sa > sb ? -1 : 0;
+}
+
+int merkle_default_threads(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1)
+        n = 1;
+    return n > MERKLE_MAX_THREADS ? MERKLE_MAX_THREADS : (int)n;
+}
+
+static int run_pool(struct Pool *p, int threads)
+{
+    if (threads <= 0)
+        threads = merkle_default_threads();
+    if (threads > MERKLE_MAX_THREADS)
+        threads = MERKLE_MAX_THREADS;
+    if ((size_t)threads > p->n)
+        threads = p->n ? (int)p->n : 1;
+
+    qsort_r(p->order, p->n, sizeof(*p->order), size_desc, p->leaves);
+    pthread_mutex_init(&p->lock, NULL);
+
+    pthread_t tids[MERKLE_MAX_THREADS];
+    int started = 0;
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&tids[started], NULL, pool_worker, p) != 0)
+            break;
+        started++;
+    }
+    pool_worker(p);
+    for (int i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
+    pthread_mutex_destroy(&p->lock);
+    return p->error;
+}
+
+/* Fills in the digest of every leaf, hashing files on all cores */
+int merkle_hash(struct MerkleManifest *m, const char *dir, int threads)
+{
+    struct MerkleReport rep;
+    memset(&rep, 0, sizeof(rep));
+    struct Pool p = {
+        .leaves = m->leaves,
+        .n = m->count,
+        .build = true,
+        .rep = &rep,
+    };
+    p.order = malloc((m->count ? m->count : 1) * sizeof(*p.order));
+    p.dirfd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (!p.order || p.dirfd < 0) {
+        free(p.order);
+        if (p.dirfd >= 0)
+            close(p.dirfd);
+        return MERKLE_ERR_IO;
+    }
+    for (size_t i = 0; i < m->count; i++)
+        p.order[i] = i;
+    int ret = run_pool(&p, threads);
+    if (ret != MERKLE_OK)
+        fprintf(stderr, "attest: cannot hash %s/%s\n", dir, rep.first_bad);
+    close(p.dirfd);
+    free(p.order);
+    if (ret == MERKLE_OK)
+        ret = merkle_compute_root(m, m->root);
+    return ret;
+}
+
+static void put_be(uint8_t *out, uint64_t v, int bytes)
+{
+    for (int i = bytes - 1; i >= 0; i--) {
+        out[i] = (uint8_t)v;
+        v >>= 8;
+    }
+}
+
+/*
+ * Leaves are H(0x00 || digest || mode || size || flags || path) and inner
+ * nodes H(0x01 || left || right), so a leaf can never be passed off as a
+ * node. An odd node at the end of a level moves up unchanged. The early
+ * flag is part of the leaf, so the signature also covers which files lazy
+ * verification will check.
+ */
+int merkle_compute_root(const struct MerkleManifest *m, uint8_t root[MERKLE_DIGEST_LEN])
+{
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    if (!ctx)
+        return MERKLE_ERR_CRYPTO;
+    if (m->count == 0) {
+        int ok = EVP_DigestInit_ex(ctx, EVP_sha256(), NULL) == 1 &&
+                 EVP_DigestFinal_ex(ctx, root, NULL) == 1;
+        EVP_MD_CTX_free(ctx);
+        return ok ? MERKLE_OK : MERKLE_ERR_CRYPTO;
+    }
+    uint8_t (*level)[MERKLE_DIGEST_LEN] = malloc(m->count * MERKLE_DIGEST_LEN);
+    if (!level) {
+        EVP_MD_CTX_free(ctx);
+        return MERKLE_ERR_IO;
+    }
+
+    int ok = 1;
+    for (size_t i = 0; ok && i < m->count; i++) {
+        const struct MerkleLeaf *leaf = &m->leaves[i];
+        uint8_t prefix[1 + MERKLE_DIGEST_LEN + 4 + 8 + 1];
+        prefix[0] = 0x00;
+        memcpy(prefix + 1, leaf->digest, MERKLE_DIGEST_LEN);
+        put_be(prefix + 1 + MERKLE_DIGEST_LEN, leaf->mode, 4);
+        put_be(prefix + 1 + MERKLE_DIGEST_LEN + 4, leaf->size, 8);
+        prefix[sizeof(prefix) - 1] = leaf->flags;
+        ok = EVP_DigestInit_ex(ctx, EVP_sha256(), NULL) == 1 &&
+             EVP_DigestUpdate(ctx, prefix, sizeof(prefix)) == 1 &&
+             EVP_DigestUpdate(ctx, leaf->path, strlen(leaf->path)) == 1 &&
+             EVP_DigestFinal_ex(ctx, level[i], NULL) == 1;
+    }
+    static const uint8_t node_tag = 0x01;
+    for (size_t n = m->count; ok && n > 1; n = (n + 1) / 2) {
+        for (size_t i = 0; ok && i < n / 2; i++) {
+            ok = EVP_DigestInit_ex(ctx, EVP_sha256(), NULL) == 1 &&
+                 EVP_DigestUpdate(ctx, &node_tag, 1) == 1 &&
+                 EVP_DigestUpdate(ctx, level[2 * i], 2 * MERKLE_DIGEST_LEN) == 1 &&
+                 EVP_DigestFinal_ex(ctx, level[i], NULL) == 1;
+        }
+        if (n & 1)
+            memmove(level[n / 2], level[n - 1], MERKLE_DIGEST_LEN);
+    }
+    if (ok)
+        memcpy(root, level[0], MERKLE_DIGEST_LEN);
+    free(level);
+    EVP_MD_CTX_free(ctx);
+    return ok ? MERKLE_OK : MERKLE_ERR_CRYPTO;
+}
+
+int merkle_save(const struct MerkleManifest *m, const char *path)
+{
+    char *buf = NULL;
+    size_t len = 0;
+    FILE *f = open_memstream(&buf, &len);
+    if (!f)
+        return MERKLE_ERR_IO;
+    char hex[MERKLE_DIGEST_LEN * 2 + 1];
+    to_hex(m->root, MERKLE_DIGEST_LEN, hex);
+    fprintf(f, MANIFEST_HEADER "root %s\nfiles %zu\n", hex, m->count);
+    for (size_t i = 0; i < m->count; i++) {
+        const struct MerkleLeaf *leaf = &m->leaves[i];
+        to_hex(leaf->digest, MERKLE_DIGEST_LEN, hex);
+        fprintf(f, "%s %06o %llu %c %s\n", hex, leaf->mode, (unsigned long long)leaf->size,
+                leaf->flags & MERKLE_FLAG_EARLY ? 'e' : '-', leaf->path);
+    }
+    if (fclose(f) != 0) {
+        free(buf);
+        return MERKLE_ERR_IO;
+    }
+    int ret = atomic_publish(path, buf, len, 0644, ATOMIC_SYNC_DIR);
+    free(buf);
+    return ret == 0 ? MERKLE_OK : MERKLE_ERR_IO;
+}
+
+/*
+ * Loads a manifest and checks the leaves hash to the root in its header.
+ * Leaves must be in strictly ascending path order, which also rules out
+ * a path being listed twice.
+ */
+int merkle_load(struct MerkleManifest *m, const char *path)
+{
+    memset(m, 0, sizeof(*m));
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return MERKLE_ERR_IO;
+
+    char *line = NULL;
+    size_t cap = 0;
+    char hex[MERKLE_DIGEST_LEN * 2 + 2];
+    size_t files = 0;
+    int ret = MERKLE_ERR_FORMAT;
+    if (getline(&line, &cap, f) < 0 || strcmp(line, MANIFEST_HEADER) != 0)
+        goto out;
+    if (getline(&line, &cap, f) < 0 || sscanf(line, "root %65s", hex) != 1 ||
+        from_hex(hex, m->root, MERKLE_DIGEST_LEN) != 0)
+        goto out;
+    if (getline(&line, &cap, f) < 0 || sscanf(line, "files %zu", &files) != 1)
+        goto out;
+
+    ssize_t n;
+    while ((n = getline(&line, &cap, f)) > 0) {
+        if (line[n - 1] == '\n')
+            line[--n] = '\0';
+        unsigned mode;
+        unsigned long long size;
+        char flag;
+        int off = 0;
+        if (sscanf(line, "%65s %o %llu %c %n", hex, &mode, &size, &flag, &off) != 4 || off == 0 ||
+            line[off] == '\0' || (flag != 'e' && flag != '-'))
+            goto out;
+        if (m->count && strcmp(m->leaves[m->count - 1].path, line + off) >= 0)
+            goto out;
+        struct MerkleLeaf *leaf = leaf_add(m, line + off);
+        if (!leaf) {
+            ret = MERKLE_ERR_IO;
+            goto out;
+        }
+        if (from_hex(hex, leaf->digest, MERKLE_DIGEST_LEN) != 0)
+            goto out;
+        leaf->mode = mode;
+        leaf->size = size;
+        leaf->flags = flag == 'e' ? MERKLE_FLAG_EARLY : 0;
+    }
+    if (m->count != files)
+        goto out;
+
+    uint8_t root[MERKLE_DIGEST_LEN];
+    ret = merkle_compute_root(m, root);
+    if (ret == MERKLE_OK && memcmp(root, m->root, MERKLE_DIGEST_LEN) != 0)
+        ret = MERKLE_ERR_MISMATCH;
+out:
+    free(line);
+    fclose(f);
+    if (ret != MERKLE_OK)
+        merkle_free(m);
+    return ret;
+}
+
+/* The signature is over the 32 raw root bytes: SHA-256 for RSA and ECDSA keys, pure Ed25519 */
+int merkle_verify_root(const uint8_t root[MERKLE_DIGEST_LEN], const uint8_t *sig, size_t sig_len,
+                       const char *pubkey_path)
+{
+    BIO *in = BIO_new_file(pubkey_path, "r");
+    if (!in)
+        return MERKLE_ERR_IO;
+    EVP_PKEY *pkey = PEM_read_bio_PUBKEY(in, NULL, NULL, NULL);
+    BIO_free(in);
+    if (!pkey)
+        return MERKLE_ERR_CRYPTO;
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    const EVP_MD *md = EVP_PKEY_get_base_id(pkey) == EVP_PKEY_ED25519 ? NULL : EVP_sha256();
+    int ret = MERKLE_ERR_CRYPTO;
+    if (ctx && EVP_DigestVerifyInit(ctx, NULL, md, NULL, pkey) == 1) {
+        int ok = EVP_DigestVerify(ctx, sig, sig_len, root, MERKLE_DIGEST_LEN);
+        ret = ok == 1 ? MERKLE_OK : ok == 0 ? MERKLE_ERR_MISMATCH : MERKLE_ERR_CRYPTO;
+    }
+    EVP_MD_CTX_free(ctx);
+    EVP_PKEY_free(pkey);
+    return ret;
+}
+
+struct Selection {
+    const struct MerkleManifest *m;
+    bool   *chosen;
+    struct MerkleReport *rep;
+};
+
+static int select_one(const char *path, void *arg)
+{
+    struct Selection *sel = arg;
+    struct MerkleLeaf *leaf = merkle_find(sel->m, path);
+    if (leaf) {
+        sel->chosen[leaf - sel->m->leaves] = true;
+        return MERKLE_OK;
+    }
+    /* a file early boot opened that the manifest does not cover fails closed */
+    sel->rep->failed++;
+    if (!sel->rep->first_bad[0])
+        snprintf(sel->rep->first_bad, sizeof(sel->rep->first_bad), "%s", path);
+    return MERKLE_OK;
+}
+
+/* Files on disk that the manifest does not list; only a full check looks */
+static void count_unlisted(const struct MerkleManifest *m, const char *dir,
+                           struct MerkleReport *rep)
+{
+    struct MerkleManifest disk;
+    if (merkle_scan(&disk, dir) != MERKLE_OK) {
+        rep->unlisted++;
+        return;
+    }
+    for (size_t i = 0; i < disk.count; i++) {
+        if (merkle_find(m, disk.leaves[i].path))
+            continue;
+        rep->unlisted++;
+        if (!rep->first_bad[0])
+            snprintf(rep->first_bad, sizeof(rep->first_bad), "%s", disk.leaves[i].path);
+    }
+    merkle_free(&disk);
+}
+
+/*
+ * Hashes the selected leaves of an already loaded and signature-checked
+ * manifest against the tree at dir. With a deadline the check stops as
+ * soon as it runs out of time and reports MERKLE_ERR_TIMEOUT, so the
+ * caller can fail closed in bounded time however large the tree is.
+ */
+int merkle_check(const struct MerkleManifest *m, const char *dir, int select,
+                 const char *list_path, int threads, int deadline_ms,
+                 struct MerkleReport *rep)
+{
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    memset(rep, 0, sizeof(*rep));
+
+    struct Pool p = {
+        .leaves = m->leaves,
+        .rep = rep,
+        .has_deadline = deadline_ms > 0,
+    };
+    if (p.has_deadline) {
+        p.deadline = start;
+        p.deadline.tv_sec += deadline_ms / 1000;
+        p.deadline.tv_nsec += (long)(deadline_ms % 1000) * 1000000L;
+        if (p.deadline.tv_nsec >= 1000000000L) {
+            p.deadline.tv_sec++;
+            p.deadline.tv_nsec -= 1000000000L;
+        }
+    }
+    size_t slots = m->count ? m->count : 1;
+    p.order = malloc(slots * sizeof(*p.order));
+    bool *chosen = calloc(slots, sizeof(*chosen));
+    p.dirfd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    int ret = MERKLE_OK;
+    if (!p.order || !chosen || p.dirfd < 0) {
+        ret = MERKLE_ERR_IO;
+        goto out;
+    }
+
+    if (select == MERKLE_CHECK_LIST) {
+        struct Selection sel = { .m = m, .chosen = chosen, .rep = rep };
+        ret = for_each_listed(list_path, select_one, &sel);
+        if (ret != MERKLE_OK)
+            goto out;
+    }
+    for (size_t i = 0; i < m->count; i++) {
+        bool take = select == MERKLE_CHECK_ALL ||
+                    (select == MERKLE_CHECK_EARLY && (m->leaves[i].flags & MERKLE_FLAG_EARLY)) ||
+                    (select == MERKLE_CHECK_LIST && chosen[i]);
+        if (take)
+            p.order[p.n++] = i;
+    }
+    ret = run_pool(&p, threads);
+    if (ret == MERKLE_OK && select == MERKLE_CHECK_ALL && !rep->timed_out) {
+        count_unlisted(m, dir, rep);
+        if (past_deadline(&p))
+            rep->timed_out = true;
+    }
+    if (ret == MERKLE_OK) {
+        if (rep->timed_out)
+            ret = MERKLE_ERR_TIMEOUT;
+        else if (rep->failed || rep->unlisted)
+            ret = MERKLE_ERR_MISMATCH;
+    }
+out:
+    if (p.dirfd >= 0)
+        close(p.dirfd);
+    free(chosen);
+    free(p.order);
+    rep->elapsed_ms = elapsed_ms(&start);
+    return ret;
+}
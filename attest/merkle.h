@@ -0,0 +1,78 @@
+#ifndef MERKLE_H
+#define MERKLE_H
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MERKLE_OK             0
+#define MERKLE_ERR_IO        -1
+#define MERKLE_ERR_CRYPTO    -2
+#define MERKLE_ERR_FORMAT    -3
+#define MERKLE_ERR_MISMATCH  -4
+#define MERKLE_ERR_TIMEOUT   -5
+
+#define MERKLE_DIGEST_LEN    32
+#define MERKLE_SIG_MAX       512
+#define MERKLE_MAX_THREADS   64
+#define MERKLE_CHUNK         (256 * 1024)
+
+/* Written at the top of the tier root and left out of the tree itself */
+#define MERKLE_MANIFEST      "manifest.merkle"
+#define MERKLE_SIGNATURE     "manifest.merkle.sig"
+
+/* Leaf flags; early files are the ones lazy verification hashes */
+#define MERKLE_FLAG_EARLY    0x01
+
+/*
+ * One regular file or symlink under the tier root. The digest is the
+ * SHA-256 of the file contents, or of the link target for a symlink.
+ * Leaves are kept sorted by path so the tree is independent of readdir
+ * order and a path can be found with bsearch.
+ */
+struct MerkleLeaf {
+    char    *path;
+    uint32_t mode;
+    uint64_t size;
+    uint8_t  flags;
+    uint8_t  digest[MERKLE_DIGEST_LEN];
+};
+
+struct MerkleManifest {
+    struct MerkleLeaf *leaves;
+    size_t  count;
+    size_t  cap;
+    uint8_t root[MERKLE_DIGEST_LEN];
+};
+
+/* Which leaves merkle_check hashes */
+#define MERKLE_CHECK_ALL     0
+#define MERKLE_CHECK_EARLY   1
+#define MERKLE_CHECK_LIST    2
+
+struct MerkleReport {
+    size_t   checked;
+    size_t   failed;
+    size_t   unlisted;
+    uint64_t bytes;
+    bool     timed_out;
+    double   elapsed_ms;
+    char     first_bad[256];
+};
+
+int merkle_scan(struct MerkleManifest *m, const char *dir);
+struct MerkleLeaf *merkle_find(const struct MerkleManifest *m, const char *path);
+int merkle_mark_early(struct MerkleManifest *m, const char *list_path);
+int merkle_hash(struct MerkleManifest *m, const char *dir, int threads);
+int merkle_compute_root(const struct MerkleManifest *m, uint8_t root[MERKLE_DIGEST_LEN]);
+int merkle_save(const struct MerkleManifest *m, const char *path);
+int merkle_load(struct MerkleManifest *m, const char *path);
+void merkle_free(struct MerkleManifest *m);
+
+int merkle_verify_root(const uint8_t root[MERKLE_DIGEST_LEN], const uint8_t *sig, size_t sig_len,
+                       const char *pubkey_path);
+int merkle_check(const struct MerkleManifest *m, const char *dir, int select,
+                 const char *list_path, int threads, int deadline_ms,
+                 struct MerkleReport *rep);
+int merkle_default_threads(void);
+
+#endif
@@ -0,0 +1,663 @@
+#define _GNU_SOURCE
+#include "attest_eat.h"
+#include "boot_journal.h"
+#include "health_check.h"
+#include "health_shm.h"
+#include "json_writer.h"
+#include "atomic_file.h"
+#include "http_client.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define ATTEST_VERIFIER_URL  "http://10.0.2.2:8080"
+#define ATTEST_JOURNAL       "/var/pac/journal.dat"
+#define ATTEST_HEALTH_JSON   "/tmp/health.json"
+#define ATTEST_OUTPUT_DIR    "/tmp/pac_attestation"
+#define ATTEST_TIER2_IMAGE   "/tier2/rootfs.img"
+#define ATTEST_TIER3_IMAGE   "/tier3/rootfs.img"
+#define ATTEST_NONCE_MAX     128
+#define ATTEST_HEALTH_MAX    (16 * 1024)
+#define ATTEST_RESPONSE_MAX  (16 * 1024)
+#define ATTEST_TIMEOUT_MS    10000
+#define ATTEST_MAX_IMAGES    8
+
+struct Agent {
+    const char *journal_path;
+    const char *health_path;
+    const char *shm_path;
+    const char *output_dir;
+    const char *verifier_url;
+    struct HttpUrl verifier;
+    struct HttpConn conn;
+    uint32_t timeout_ms;
+    bool send;
+    bool verbose;
+    struct AttestKey key;
+    char priv_path[ATOMIC_PATH_MAX];
+    char pub_path[ATOMIC_PATH_MAX];
+    char token_path[ATOMIC_PATH_MAX];
+    const char *images[ATTEST_MAX_IMAGES];
+    int image_count;
+    bool explicit_images;
+    struct MeasureCache cache;
+    struct EventLog log;
+    char cache_path[ATOMIC_PATH_MAX];
+    char log_path[ATOMIC_PATH_MAX];
+    char state_path[ATOMIC_PATH_MAX];
+};
+
+static volatile sig_atomic_t stop_requested;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+
+static void alog(const struct Agent *a, const char *fmt, ...)
+{
+    if (!a->verbose)
+        return;
+    va_list ap;
+    va_start(ap, fmt);
+    fputs("[ATTEST] ", stderr);
+    vfprintf(stderr, fmt, ap);
+    fputc('\n', stderr);
+    va_end(ap);
+}
+
+static void usage(const char *prog)
+{
+    printf("PAC Attestation Agent\n\n");
+    printf("Usage: %s [options]\n\n", prog);
+    printf("Measures the platform, signs a TPM-style quote with the AIK and submits the\n");
+    printf("EAT token to the remote verifier, as attest_agent_crypto.sh does.\n\n");
+    printf("Options:\n");
+    printf("  -j FILE          Boot journal (default: %s)\n", ATTEST_JOURNAL);
+    printf("  --health FILE    Health report JSON (default: %s)\n", ATTEST_HEALTH_JSON);
+    printf("  --shm PATH       Read health from the health daemon segment instead\n");
+    printf("  -o DIR           Key, token and verifier.state directory (default: %s)\n",
+           ATTEST_OUTPUT_DIR);
+    printf("  --verifier URL   Verifier base URL (default: %s)\n", ATTEST_VERIFIER_URL);
+    printf("  --no-send        Build and store the token without contacting the verifier;\n");
+    printf("                   the nonce is then taken from --nonce\n");
+    printf("  --nonce HEX      Use this nonce instead of requesting one\n");
+    printf("  --interval SEC   Re-attest every SEC seconds until SIGTERM\n");
+    printf("  --timeout MS     Per-request HTTP timeout (default: %d)\n", ATTEST_TIMEOUT_MS);
+    printf("  --key-type TYPE  AIK to generate when none exists: rsa, ecdsa-p256 or ed25519\n");
+    printf("                   (default: rsa)\n");
+    printf("  --bench N        Time N quote signatures per key type and exit\n");
+    printf("  --image PATH     Measure this image into PCR-%u (repeatable; default:\n",
+           MEASURE_PCR_IMAGES);
+    printf("                   %s and %s when present)\n", ATTEST_TIER2_IMAGE,
+           ATTEST_TIER3_IMAGE);
+    printf("  --no-measure     Do not measure any rootfs image\n");
+    printf("  -q               Only report errors\n");
+    printf("  -v               Verbose output\n");
+    printf("  -h               Show this help\n\n");
+    printf("Environment: VERIFIER_URL, JOURNAL, HEALTH_JSON, OUTPUT_DIR, AIK_TYPE, VERBOSE\n\n");
+    printf("Exit codes: 0 = attestation passed, 1 = attestation failed or error\n");
+}
+
+static const char *env_str(const char *name, const char *fallback)
+{
+    const char *v = getenv(name);
+    return v && *v ? v : fallback;
+}
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static ssize_t read_file(const char *path, char *buf, size_t cap)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+    size_t len = 0;
+    while (len < cap - 1) {
+        ssize_t n = read(fd, buf + len, cap - 1 - len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        len += (size_t)n;
+    }
+    close(fd);
+    buf[len] = '\0';
+    return (ssize_t)len;
+}
+
+/* Locates "key": in a flat JSON reply and returns the first byte of its value */
+static const char *json_value(const char *body, const char *key)
+{
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+    const char *p = strstr(body, pattern);
+    if (!p)
+        return NULL;
+    p += strlen(pattern);
+    while (isspace((unsigned char)*p))
+        p++;
+    if (*p != ':')
+        return NULL;
+    p++;
+    while (isspace((unsigned char)*p))
+        p++;
+    return p;
+}
+
+static bool json_string_value(const char *body, const char *key, char *out, size_t cap)
+{
+    const char *p = json_value(body, key);
+    if (!p || *p != '"')
+        return false;
+    const char *end = strchr(++p, '"');
+    if (!end || (size_t)(end - p) >= cap)
+        return false;
+    memcpy(out, p, (size_t)(end - p));
+    out[end - p] = '\0';
+    return true;
+}
+
+/* Journal facts default to tier 3, boot 1 when there is no journal, like the shell */
+static void load_boot_state(const struct Agent *a, struct AttestInputs *in)
+{
+    struct BootRecord rec;
+    in->tier = 3;
+    in->boot_count = 1;
+    if (access(a->journal_path, F_OK) != 0)
+        return;
+    journal_set_verbose(false);
+    if (journal_init(a->journal_path) == JOURNAL_OK && journal_read(&rec) == JOURNAL_OK) {
+        in->tier = rec.tier;
+        in->boot_count = rec.boot_count;
+    }
+    journal_close();
+}
+
+static void load_health(const struct Agent *a, struct AttestInputs *in, char *buf, size_t cap)
+{
+    in->health_score = 8;
+    in->health_json = NULL;
+    in->health_json_len = 0;
+
+    if (a->shm_path) {
+        struct HealthShm *shm = health_shm_attach(a->shm_path);
+        struct HealthSnapshot snap;
+        if (shm && health_shm_snapshot(shm, &snap) == 0) {
+            struct JsonWriter w;
+            json_init_buffer(&w, buf, cap, true);
+            health_report_write_json(&snap.report, &w);
+            int len = json_finish(&w);
+            if (len > 0) {
+                in->health_json = buf;
+                in->health_json_len = (size_t)len;
+            }
+            in->health_score = snap.report.overall_score;
+        } else {
+            fprintf(stderr, "attest: no health sample in %s, using defaults\n", a->shm_path);
+        }
+        if (shm)
+            health_shm_detach(shm);
+        return;
+    }
+
+    ssize_t len = read_file(a->health_path, buf, cap);
+    if (len <= 0)
+        return;
+    in->health_json = buf;
+    in->health_json_len = (size_t)len;
+    const char *score = json_value(buf, "overall_score");
+    if (score && isdigit((unsigned char)*score))
+        in->health_score = (uint8_t)strtoul(score, NULL, 10);
+}
+
+static void load_platform(struct AttestInputs *in, char *kernel, size_t cap)
+{
+    char buf[128];
+
+    ssize_t len = read_file("/proc/version", kernel, cap);
+    in->kernel_version = len >= 0 ? kernel : NULL;
+    in->kernel_version_len = len >= 0 ? (size_t)len : 0;
+
+    snprintf(in->clock, sizeof(in->clock), "0");
+    if (read_file("/proc/uptime", buf, sizeof(buf)) > 0) {
+        size_t n = strcspn(buf, " \n");
+        if (n >= sizeof(in->clock))
+            n = sizeof(in->clock) - 1;
+        memcpy(in->clock, buf, n);
+        in->clock[n] = '\0';
+    }
+
+    char host[64] = "localhost";
+    gethostname(host, sizeof(host) - 1);
+    char boot_id[9] = "secure";
+    if (read_file("/proc/sys/kernel/random/boot_id", buf, sizeof(buf)) >= 8) {
+        memcpy(boot_id, buf, 8);
+        boot_id[8] = '\0';
+    }
+    snprintf(in->device_id, sizeof(in->device_id), "pac-%s-%s", host, boot_id);
+    in->timestamp = time(NULL);
+}
+
+/*
+ * The nonce request goes out first and its reply is only read once the
+ * platform has been measured, so the round trip overlaps local work.
+ */
+static int request_nonce(struct Agent *a)
+{
+    alog(a, "Requesting nonce from verifier: %s/nonce", a->verifier_url);
+    int ret = http_conn_send(&a->conn, "GET", "/nonce", NULL, NULL, 0, a->timeout_ms);
+    if (ret != HTTP_OK) {
+        fprintf(stderr, "attest: nonce request failed: %s\n", http_strerror(ret));
+        return -1;
+    }
+    return 0;
+}
+
+static int read_nonce(struct Agent *a, char *nonce, size_t cap)
+{
+    char buf[ATTEST_RESPONSE_MAX];
+    struct HttpResponse resp;
+
+    bool reused = a->conn.served > 0;
+    int ret = http_conn_recv(&a->conn, a->timeout_ms, buf, sizeof(buf), &resp);
+    /* the verifier dropped the idle connection before answering; ask again on a new one */
+    if (ret == HTTP_ERR_CLOSED && reused)
+        ret = http_conn_request(&a->conn, "GET", "/nonce", NULL, NULL, 0, a->timeout_ms,
+                                buf, sizeof(buf), &resp);
+    if (ret != HTTP_OK) {
+        fprintf(stderr, "attest: nonce request failed: %s\n", http_strerror(ret));
+        return -1;
+    }
+    if (resp.status != 200 || !json_string_value(resp.body, "nonce", nonce, cap) || !*nonce) {
+        fprintf(stderr, "attest: verifier returned no nonce (HTTP %d)\n", resp.status);
+        return -1;
+    }
+    /* the nonce is copied into the quote text line by line */
+    for (const char *p = nonce; *p; p++) {
+        if (!isalnum((unsigned char)*p)) {
+            fprintf(stderr, "attest: verifier nonce is not alphanumeric\n");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int submit_token(struct Agent *a, const char *token, size_t len)
+{
+    char buf[ATTEST_RESPONSE_MAX];
+    struct HttpResponse resp;
+    char reason[256] = "";
+
+    alog(a, "Sending signed EAT token to verifier: %s/verify (%zu bytes)", a->verifier_url, len);
+    int ret = http_conn_request(&a->conn, "POST", "/verify", "application/json", token, len,
+                                a->timeout_ms, buf, sizeof(buf), &resp);
+    if (ret != HTTP_OK) {
+        fprintf(stderr, "attest: failed to send token: %s\n", http_strerror(ret));
+        fprintf(stderr, "attest: token saved locally at %s\n", a->token_path);
+        return 1;
+    }
+    if (resp.status >= 400) {
+        fprintf(stderr, "attest: HTTP error from verifier: %d\n", resp.status);
+        alog(a, "Response: %s", resp.body);
+        return 1;
+    }
+    json_string_value(resp.body, "reason", reason, sizeof(reason));
+    const char *allow = json_value(resp.body, "allow");
+    if (allow && strncmp(allow, "true", 4) == 0) {
+        alog(a, " ATTESTATION PASSED - Cryptographic verification successful!");
+        if (*reason)
+            printf("    %s\n", reason);
+        return 0;
+    }
+    if (allow && strncmp(allow, "false", 5) == 0) {
+        fprintf(stderr, "[ATTEST] WARNING:  Attestation FAILED: %s\n", reason);
+        return 1;
+    }
+    alog(a, "Response: %s", resp.body);
+    return 0;
+}
+
+static void read_boot_id(char *out, size_t cap)
+{
+    char buf[40];
+    snprintf(out, cap, "unknown");
+    if (read_file("/proc/sys/kernel/random/boot_id", buf, sizeof(buf)) > 0) {
+        buf[strcspn(buf, " \n")] = '\0';
+        if (*buf)
+            snprintf(out, cap, "%s", buf);
+    }
+}
+
+/*
+ * Unchanged images cost a stat and a cache lookup; only a new or rewritten
+ * image is streamed through SHA-256 and appended to the event log.
+ */
+static void measure_images(struct Agent *a)
+{
+    for (int i = 0; i < a->image_count; i++) {
+        const char *path = a->images[i];
+        uint8_t digest[MEASURE_DIGEST_LEN];
+        bool cached;
+
+        if (!a->explicit_images && access(path, F_OK) != 0)
+            continue;
+        uint64_t bytes = a->cache.bytes_hashed;
+        uint64_t t0 = now_us();
+        int ret = measure_image(&a->cache, path, digest, &cached);
+        if (ret != MEASURE_OK) {
+            fprintf(stderr, "attest: cannot measure %s\n", path);
+            continue;
+        }
+        if (cached) {
+            alog(a, "Measured %s (cached)", path);
+        } else {
+            double ms = (double)(now_us() - t0) / 1000.0;
+            double mib = (double)(a->cache.bytes_hashed - bytes) / (1024.0 * 1024.0);
+            alog(a, "Measured %s: %.1f MiB in %.1f ms (%.0f MiB/s)", path, mib, ms,
+                 ms > 0 ? mib * 1000.0 / ms : 0.0);
+        }
+        ret = event_log_record(&a->log, MEASURE_PCR_IMAGES, MEASURE_EVENT_IMAGE, digest, path);
+        if (ret == MEASURE_ERR_FULL)
+            fprintf(stderr, "attest: event log full, %s not extended\n", path);
+        else if (ret == 1)
+            alog(a, "Extended PCR-%02u with %s", MEASURE_PCR_IMAGES, path);
+    }
+    if (measure_cache_save(&a->cache, a->cache_path) != MEASURE_OK)
+        fprintf(stderr, "attest: cannot write %s\n", a->cache_path);
+    if (event_log_save(&a->log, a->log_path) != MEASURE_OK)
+        fprintf(stderr, "attest: cannot write %s\n", a->log_path);
+}
+
+static int attest_exchange(struct Agent *a, const char *fixed_nonce)
+{
+    char nonce[ATTEST_NONCE_MAX + 1];
+    char kernel[512];
+    char health[ATTEST_HEALTH_MAX];
+    char quote[ATTEST_QUOTE_MAX];
+    uint8_t sig[ATTEST_SIG_MAX];
+    size_t sig_len = sizeof(sig);
+    static char token[ATTEST_TOKEN_MAX];
+    struct AttestInputs in;
+    struct AttestMeasurement m;
+
+    uint64_t t0 = now_us();
+    if (!fixed_nonce && request_nonce(a) != 0)
+        return 1;
+
+    memset(&in, 0, sizeof(in));
+    load_boot_state(a, &in);
+    load_health(a, &in, health, sizeof(health));
+    load_platform(&in, kernel, sizeof(kernel));
+    measure_images(a);
+    in.events = &a->log;
+    if (attest_measure(&in, &m) != ATTEST_OK) {
+        fprintf(stderr, "attest: failed to measure platform\n");
+        return 1;
+    }
+    uint64_t t1 = now_us();
+
+    if (fixed_nonce)
+        snprintf(nonce, sizeof(nonce), "%s", fixed_nonce);
+    else if (read_nonce(a, nonce, sizeof(nonce)) != 0)
+        return 1;
+    in.nonce = nonce;
+    uint64_t t2 = now_us();
+
+    int qlen;
+    if ((qlen = attest_quote(&in, &m, quote, sizeof(quote))) < 0 ||
+        attest_sign(&a->key, quote, (size_t)qlen, sig, &sig_len) != ATTEST_OK) {
+        fprintf(stderr, "attest: failed to sign quote\n");
+        return 1;
+    }
+    int tlen = attest_eat_json(&in, &m, quote, (size_t)qlen, sig, sig_len, &a->key,
+                               token, sizeof(token));
+    if (tlen < 0) {
+        fprintf(stderr, "attest: failed to build EAT token\n");
+        return 1;
+    }
+    uint64_t t3 = now_us();
+    alog(a, " Quote signed with %s, tier %u boot %llu", a->key.sig_alg, in.tier,
+         (unsigned long long)in.boot_count);
+
+    if (atomic_publish(a->token_path, token, (size_t)tlen, 0644, 0) != ATOMIC_OK)
+        fprintf(stderr, "attest: cannot write %s: %s\n", a->token_path, strerror(errno));
+
+    int result = a->send ? submit_token(a, token, (size_t)tlen) : 0;
+    uint64_t t4 = now_us();
+    alog(a, "Attestation took %.2f ms (measure %.2f, nonce wait %.2f, sign %.2f, verify %.2f; "
+         "%llu connection(s), %llu request(s) so far)",
+         (double)(t4 - t0) / 1000.0, (double)(t1 - t0) / 1000.0, (double)(t2 - t1) / 1000.0,
+         (double)(t3 - t2) / 1000.0, (double)(t4 - t3) / 1000.0,
+         (unsigned long long)a->conn.connects, (unsigned long long)a->conn.requests);
+    return result;
+}
+
+/*
+ * A verifier in backoff is skipped at once rather than waited for; the
+ * outcome of every exchange is published for the policy monitor.
+ */
+static int attest_once(struct Agent *a, const char *fixed_nonce)
+{
+    if (a->send && !http_conn_ready(&a->conn, http_now_ms())) {
+        alog(a, "Verifier unreachable, next attempt in %lld ms",
+             (long long)(a->conn.retry_at_ms - http_now_ms()));
+        return 1;
+    }
+    int result = attest_exchange(a, fixed_nonce);
+    /* a reply left unread after a local failure would answer the next request */
+    if (a->conn.in_flight)
+        http_conn_close(&a->conn);
+    if (a->send && http_conn_save_state(&a->conn, a->state_path) != HTTP_OK)
+        fprintf(stderr, "attest: cannot write %s\n", a->state_path);
+    return result;
+}
+
+/*
+ * Compares what every quote cost when the shell re-read the PEM for each
+ * openssl dgst -sign against signing with the resident context.
+ */
+static int bench(unsigned long iterations)
+{
+    static const char quote[] =
+        "TPM_QUOTE_V1\ntimestamp: 1700000000\nnonce: 00112233445566778899aabbccddeeff\n"
+        "pcr_digest: a35dd3107dc36d38308d0bc0894e78dbd5b683839d5db6ba02647a1d2e56478c\n"
+        "tier: 2\nclock: 12.34\n";
+    uint8_t sig[ATTEST_SIG_MAX];
+
+    printf("%-12s %12s %16s %16s %10s\n", "key", "keygen ms", "parse+sign us", "resident us",
+           "sig bytes");
+    for (int alg = 0; alg < ATTEST_ALG_COUNT; alg++) {
+        struct AttestKey key, cold;
+        char *pem;
+        size_t pem_len, sig_len = sizeof(sig);
+
+        uint64_t t0 = now_us();
+        if (attest_key_generate(&key, alg) != ATTEST_OK ||
+            attest_key_private_pem(&key, &pem, &pem_len) != ATTEST_OK) {
+            fprintf(stderr, "attest: cannot generate %s key\n", attest_alg_name(alg));
+            return 1;
+        }
+        uint64_t t1 = now_us();
+        for (unsigned long i = 0; i < iterations; i++) {
+            sig_len = sizeof(sig);
+            if (attest_key_from_pem(&cold, pem, pem_len) != ATTEST_OK ||
+                attest_sign(&cold, quote, sizeof(quote) - 1, sig, &sig_len) != ATTEST_OK) {
+                fprintf(stderr, "attest: %s signature failed\n", attest_alg_name(alg));
+                return 1;
+            }
+            attest_key_free(&cold);
+        }
+        uint64_t t2 = now_us();
+        for (unsigned long i = 0; i < iterations; i++) {
+            sig_len = sizeof(sig);
+            if (attest_sign(&key, quote, sizeof(quote) - 1, sig, &sig_len) != ATTEST_OK) {
+                fprintf(stderr, "attest: %s signature failed\n", attest_alg_name(alg));
+                return 1;
+            }
+        }
+        uint64_t t3 = now_us();
+        printf("%-12s %12.2f %16.1f %16.1f %10zu\n", attest_alg_name(alg),
+               (double)(t1 - t0) / 1000.0, (double)(t2 - t1) / (double)iterations,
+               (double)(t3 - t2) / (double)iterations, sig_len);
+        free(pem);
+        attest_key_free(&key);
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    struct Agent a;
+    const char *fixed_nonce = NULL;
+    unsigned interval = 0;
+    unsigned long bench_iterations = 0;
+
+    memset(&a, 0, sizeof(a));
+    a.journal_path = env_str("JOURNAL", ATTEST_JOURNAL);
+    a.health_path = env_str("HEALTH_JSON", ATTEST_HEALTH_JSON);
+    a.output_dir = env_str("OUTPUT_DIR", ATTEST_OUTPUT_DIR);
+    a.verifier_url = env_str("VERIFIER_URL", ATTEST_VERIFIER_URL);
+    a.timeout_ms = ATTEST_TIMEOUT_MS;
+    a.images[a.image_count++] = ATTEST_TIER2_IMAGE;
+    a.images[a.image_count++] = ATTEST_TIER3_IMAGE;
+    a.send = true;
+    a.verbose = strcmp(env_str("VERBOSE", "1"), "1") == 0;
+    const char *key_type = env_str("AIK_TYPE", "rsa");
+
+    static const struct option longopts[] = {
+        { "health",   required_argument, NULL, 'H' },
+        { "shm",      required_argument, NULL, 'S' },
+        { "verifier", required_argument, NULL, 'U' },
+        { "no-send",  no_argument,       NULL, 'N' },
+        { "nonce",    required_argument, NULL, 'n' },
+        { "interval", required_argument, NULL, 'i' },
+        { "timeout",  required_argument, NULL, 't' },
+        { "key-type", required_argument, NULL, 'k' },
+        { "bench",    required_argument, NULL, 'b' },
+        { "image",    required_argument, NULL, 'I' },
+        { "no-measure", no_argument,     NULL, 'M' },
+        { "help",     no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "j:o:qvh", longopts, NULL)) != -1) {
+        switch (opt) {
+        case 'j': a.journal_path = optarg; break;
+        case 'o': a.output_dir = optarg; break;
+        case 'H': a.health_path = optarg; break;
+        case 'S': a.shm_path = optarg; break;
+        case 'U': a.verifier_url = optarg; break;
+        case 'N': a.send = false; break;
+        case 'n': fixed_nonce = optarg; break;
+        case 'i': interval = (unsigned)strtoul(optarg, NULL, 10); break;
+        case 't': a.timeout_ms = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'k': key_type = optarg; break;
+        case 'b': bench_iterations = strtoul(optarg, NULL, 10); break;
+        case 'I':
+            if (!a.explicit_images) {
+                a.image_count = 0;
+                a.explicit_images = true;
+            }
+            if (a.image_count < ATTEST_MAX_IMAGES)
+                a.images[a.image_count++] = optarg;
+            break;
+        case 'M': a.image_count = 0; a.explicit_images = true; break;
+        case 'q': a.verbose = false; break;
+        case 'v': a.verbose = true; break;
+        case 'h': usage(argv[0]); return 0;
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    if (bench_iterations > 0)
+        return bench(bench_iterations);
+    int alg = attest_alg_from_name(key_type);
+    if (alg < 0) {
+        fprintf(stderr, "attest: unknown key type: %s\n", key_type);
+        return 1;
+    }
+    if (http_parse_url(a.verifier_url, &a.verifier) != HTTP_OK) {
+        fprintf(stderr, "attest: invalid verifier URL: %s\n", a.verifier_url);
+        return 1;
+    }
+    if (!a.send && !fixed_nonce) {
+        fprintf(stderr, "attest: --no-send needs --nonce\n");
+        return 1;
+    }
+    if (fixed_nonce && (strlen(fixed_nonce) > ATTEST_NONCE_MAX || strpbrk(fixed_nonce, "\n\"\\"))) {
+        fprintf(stderr, "attest: invalid nonce\n");
+        return 1;
+    }
+    if (mkdir(a.output_dir, 0700) != 0 && errno != EEXIST) {
+        fprintf(stderr, "attest: cannot create %s: %s\n", a.output_dir, strerror(errno));
+        return 1;
+    }
+    snprintf(a.priv_path, sizeof(a.priv_path), "%s/aik_private.pem", a.output_dir);
+    snprintf(a.pub_path, sizeof(a.pub_path), "%s/aik_public.pem", a.output_dir);
+    snprintf(a.token_path, sizeof(a.token_path), "%s/eat_token.json", a.output_dir);
+    snprintf(a.cache_path, sizeof(a.cache_path), "%s/measure.cache", a.output_dir);
+    snprintf(a.log_path, sizeof(a.log_path), "%s/event_log", a.output_dir);
+    snprintf(a.state_path, sizeof(a.state_path), "%s/verifier.state", a.output_dir);
+    http_conn_init(&a.conn, &a.verifier);
+    alog(&a, "Output directory: %s", a.output_dir);
+
+    char boot_id[40];
+    read_boot_id(boot_id, sizeof(boot_id));
+    if (measure_cache_load(&a.cache, a.cache_path) != MEASURE_OK)
+        fprintf(stderr, "attest: ignoring unreadable %s\n", a.cache_path);
+    if (event_log_load(&a.log, a.log_path, boot_id) != MEASURE_OK)
+        fprintf(stderr, "attest: ignoring unreadable %s\n", a.log_path);
+
+    bool generated;
+    int ret = attest_key_load(&a.key, a.priv_path, a.pub_path, alg, &generated);
+    if (ret != ATTEST_OK) {
+        fprintf(stderr, "attest: failed to %s AIK in %s\n",
+                ret == ATTEST_ERR_IO ? "store" : "load or generate", a.output_dir);
+        return 1;
+    }
+    alog(&a, generated ? " AIK generated: %s" : "Using existing AIK keys (%s)",
+         a.key.sig_alg);
+    if (!generated && a.key.alg != alg)
+        alog(&a, "Existing %s AIK kept; remove it to switch to %s",
+             attest_alg_name(a.key.alg), attest_alg_name(alg));
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGINT, &sa, NULL);
+
+    int result;
+    for (;;) {
+        result = attest_once(&a, fixed_nonce);
+        if (interval == 0 || stop_requested)
+            break;
+        struct timespec ts = { .tv_sec = interval, .tv_nsec = 0 };
+        while (nanosleep(&ts, &ts) != 0 && !stop_requested)
+            ;
+        if (stop_requested)
+            break;
+    }
+    if (result != 0)
+        fprintf(stderr, "[ATTEST] WARNING: Remote attestation completed with errors\n");
+
+    http_conn_close(&a.conn);
+    attest_key_free(&a.key);
+    return result;
+}
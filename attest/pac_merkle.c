@@ -0,0 +1,260 @@
+#define _GNU_SOURCE
+#include "merkle.h"
+#include "attest_eat.h"
+#include "atomic_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MERKLE_PUBKEY_NAME   "keys/pac_public.pem"
+
+static void usage(const char *prog)
+{
+    printf("PAC Tier Rootfs Manifest Tool\n\n");
+    printf("Usage: %s build DIR [options]\n", prog);
+    printf("       %s sign DIR -k KEY [options]\n", prog);
+    printf("       %s verify DIR [options]\n\n", prog);
+    printf("Builds a Merkle manifest over every file and symlink of a tier rootfs tree,\n");
+    printf("signs its root, and verifies a tree against it before promotion.\n\n");
+    printf("Options:\n");
+    printf("  -m FILE          Manifest (default: DIR/%s)\n", MERKLE_MANIFEST);
+    printf("  -s FILE          Root signature (default: DIR/%s)\n", MERKLE_SIGNATURE);
+    printf("  -k FILE          Private key to sign the root with (sign)\n");
+    printf("  -p FILE          Public key to verify the root with (verify; default:\n");
+    printf("                   $FT_PAC/%s)\n", MERKLE_PUBKEY_NAME);
+    printf("  --early FILE     Mark the files listed as opened during early boot (build)\n");
+    printf("  --lazy           Hash only the files marked early (verify)\n");
+    printf("  --files FILE     Hash only the files listed in FILE (verify)\n");
+    printf("  -t N             Hashing threads (default: one per online CPU)\n");
+    printf("  --deadline MS    Fail verification if it has not finished within MS\n");
+    printf("  -v               Verbose output\n");
+    printf("  -h               Show this help\n\n");
+    printf("Environment: FT_PAC, MERKLE_THREADS\n\n");
+    printf("Exit codes: 0 = success or tree verified, 1 = verification failed,\n");
+    printf("            2 = usage or I/O error\n");
+}
+
+static const char *env_str(const char *name, const char *fallback)
+{
+    const char *v = getenv(name);
+    return v && *v ? v : fallback;
+}
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+static int read_file(const char *path, char **data, size_t *len, size_t max)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return -1;
+    *data = malloc(max);
+    *len = *data ? fread(*data, 1, max, f) : 0;
+    int ok = *data && !ferror(f) && *len < max;
+    fclose(f);
+    if (!ok) {
+        free(*data);
+        *data = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+static int cmd_build(const char *dir, const char *manifest_path, const char *early,
+                     int threads, bool verbose)
+{
+    double start = now_ms();
+    struct MerkleManifest m;
+    int ret = merkle_scan(&m, dir);
+    if (ret != MERKLE_OK) {
+        fprintf(stderr, "attest: cannot scan %s\n", dir);
+        return 2;
+    }
+    if (early && merkle_mark_early(&m, early) != MERKLE_OK) {
+        fprintf(stderr, "attest: cannot apply early file list %s\n", early);
+        merkle_free(&m);
+        return 2;
+    }
+    ret = merkle_hash(&m, dir, threads);
+    if (ret == MERKLE_OK)
+        ret = merkle_save(&m, manifest_path);
+    if (ret != MERKLE_OK) {
+        fprintf(stderr, "attest: cannot build manifest %s\n", manifest_path);
+        merkle_free(&m);
+        return 2;
+    }
+    if (verbose) {
+        size_t early_count = 0;
+        for (size_t i = 0; i < m.count; i++)
+            early_count += m.leaves[i].flags & MERKLE_FLAG_EARLY;
+        fprintf(stderr, "[MERKLE] %zu files (%zu early) in %.1f ms\n", m.count, early_count,
+                now_ms() - start);
+    }
+    merkle_free(&m);
+    return 0;
+}
+
+static int cmd_sign(const char *manifest_path, const char *sig_path, const char *key_path)
+{
+    struct MerkleManifest m;
+    if (merkle_load(&m, manifest_path) != MERKLE_OK) {
+        fprintf(stderr, "attest: cannot load manifest %s\n", manifest_path);
+        return 2;
+    }
+    char *pem = NULL;
+    size_t pem_len = 0;
+    struct AttestKey key;
+    if (read_file(key_path, &pem, &pem_len, 64 * 1024) != 0 ||
+        attest_key_from_pem(&key, pem, pem_len) != ATTEST_OK) {
+        fprintf(stderr, "attest: cannot load private key %s\n", key_path);
+        free(pem);
+        merkle_free(&m);
+        return 2;
+    }
+    free(pem);
+    uint8_t sig[MERKLE_SIG_MAX];
+    size_t sig_len = sizeof(sig);
+    int ret = attest_sign(&key, m.root, MERKLE_DIGEST_LEN, sig, &sig_len);
+    if (ret == ATTEST_OK && atomic_publish(sig_path, sig, sig_len, 0644, ATOMIC_SYNC_DIR) != 0)
+        ret = ATTEST_ERR_IO;
+    if (ret != ATTEST_OK)
+        fprintf(stderr, "attest: cannot sign %s\n", manifest_path);
+    attest_key_free(&key);
+    merkle_free(&m);
+    return ret == ATTEST_OK ? 0 : 2;
+}
+
+static int cmd_verify(const char *dir, const char *manifest_path, const char *sig_path,
+                      const char *pubkey, int select, const char *list, int threads,
+                      int deadline_ms, bool verbose)
+{
+    double start = now_ms();
+    struct MerkleManifest m;
+    int ret = merkle_load(&m, manifest_path);
+    if (ret != MERKLE_OK) {
+        fprintf(stderr, "attest: manifest %s is %s\n", manifest_path,
+                ret == MERKLE_ERR_IO ? "unreadable" : "corrupt");
+        return 1;
+    }
+    char *sig = NULL;
+    size_t sig_len = 0;
+    if (read_file(sig_path, &sig, &sig_len, MERKLE_SIG_MAX + 1) != 0) {
+        fprintf(stderr, "attest: cannot read signature %s\n", sig_path);
+        merkle_free(&m);
+        return 1;
+    }
+    ret = merkle_verify_root(m.root, (const uint8_t *)sig, sig_len, pubkey);
+    free(sig);
+    if (ret != MERKLE_OK) {
+        fprintf(stderr, "attest: manifest root signature %s\n",
+                ret == MERKLE_ERR_MISMATCH ? "does not verify" : "cannot be checked");
+        merkle_free(&m);
+        return 1;
+    }
+    double root_ms = now_ms() - start;
+
+    struct MerkleReport rep;
+    ret = merkle_check(&m, dir, select, list, threads, deadline_ms, &rep);
+    if (ret == MERKLE_ERR_TIMEOUT)
+        fprintf(stderr, "attest: verification of %s exceeded %d ms after %zu files\n",
+                dir, deadline_ms, rep.checked);
+    else if (ret == MERKLE_ERR_MISMATCH)
+        fprintf(stderr, "attest: %s: %zu modified, %zu unlisted (first: %s)\n", dir,
+                rep.failed, rep.unlisted, rep.first_bad);
+    else if (ret != MERKLE_OK)
+        fprintf(stderr, "attest: cannot verify %s\n", dir);
+    if (verbose)
+        fprintf(stderr, "[MERKLE] root %.1f ms, %zu/%zu files, %llu bytes in %.1f ms\n",
+                root_ms, rep.checked, m.count, (unsigned long long)rep.bytes, rep.elapsed_ms);
+    merkle_free(&m);
+    return ret == MERKLE_OK ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    const char *manifest_path = NULL;
+    const char *sig_path = NULL;
+    const char *key_path = NULL;
+    const char *pubkey = NULL;
+    const char *early = NULL;
+    const char *list = NULL;
+    int select = MERKLE_CHECK_ALL;
+    int threads = atoi(env_str("MERKLE_THREADS", "0"));
+    int deadline_ms = 0;
+    bool verbose = false;
+
+    enum { OPT_EARLY = 256, OPT_LAZY, OPT_FILES, OPT_DEADLINE };
+    static const struct option longopts[] = {
+        {"early",    required_argument, NULL, OPT_EARLY},
+        {"lazy",     no_argument,       NULL, OPT_LAZY},
+        {"files",    required_argument, NULL, OPT_FILES},
+        {"deadline", required_argument, NULL, OPT_DEADLINE},
+        {"help",     no_argument,       NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "m:s:k:p:t:vh", longopts, NULL)) != -1) {
+        switch (opt) {
+        case 'm': manifest_path = optarg; break;
+        case 's': sig_path = optarg; break;
+        case 'k': key_path = optarg; break;
+        case 'p': pubkey = optarg; break;
+        case 't': threads = atoi(optarg); break;
+        case 'v': verbose = true; break;
+        case OPT_EARLY: early = optarg; break;
+        case OPT_LAZY: select = MERKLE_CHECK_EARLY; break;
+        case OPT_FILES: select = MERKLE_CHECK_LIST; list = optarg; break;
+        case OPT_DEADLINE: deadline_ms = atoi(optarg); break;
+        case 'h': usage(argv[0]); return 0;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (argc - optind != 2) {
+        usage(argv[0]);
+        return 2;
+    }
+    const char *cmd = argv[optind];
+    const char *dir = argv[optind + 1];
+
+    char manifest_buf[ATOMIC_PATH_MAX], sig_buf[ATOMIC_PATH_MAX], pubkey_buf[ATOMIC_PATH_MAX];
+    if (!manifest_path) {
+        snprintf(manifest_buf, sizeof(manifest_buf), "%s/%s", dir, MERKLE_MANIFEST);
+        manifest_path = manifest_buf;
+    }
+    if (!sig_path) {
+        snprintf(sig_buf, sizeof(sig_buf), "%s/%s", dir, MERKLE_SIGNATURE);
+        sig_path = sig_buf;
+    }
+    if (!pubkey) {
+        const char *ft_pac = getenv("FT_PAC");
+        if (ft_pac)
+            snprintf(pubkey_buf, sizeof(pubkey_buf), "%s/%s", ft_pac, MERKLE_PUBKEY_NAME);
+        else
+            snprintf(pubkey_buf, sizeof(pubkey_buf), "%s/ft-pac/%s", env_str("HOME", ""),
+                     MERKLE_PUBKEY_NAME);
+        pubkey = pubkey_buf;
+    }
+
+    if (strcmp(cmd, "build") == 0)
+        return cmd_build(dir, manifest_path, early, threads, verbose);
+    if (strcmp(cmd, "sign") == 0) {
+        if (!key_path) {
+            fprintf(stderr, "attest: sign needs -k KEY\n");
+            return 2;
+        }
+        return cmd_sign(manifest_path, sig_path, key_path);
+    }
+    if (strcmp(cmd, "verify") == 0)
+        return cmd_verify(dir, manifest_path, sig_path, pubkey, select, list, threads,
+                          deadline_ms, verbose);
+    usage(argv[0]);
+    return 2;
+}
@@ -0,0 +1,643 @@
+#include "attest_eat.h"
+#include "merkle.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <openssl/pem.h>
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_START(name) \
+    printf("\n[TEST] %s...\n", name)
+#define TEST_ASSERT(condition, msg) \
+    do { \
+        if (condition) { \
+            printf("   %s\n", msg); \
+            tests_passed++; \
+        } else { \
+            printf("   FAILED: %s\n", msg); \
+            tests_failed++; \
+        } \
+    } while(0)
+#define TEST_END() \
+    printf("  Done.\n")
+
+static char tmpdir[64];
+static struct AttestKey key;
+
+static void make_inputs(struct AttestInputs *in)
+{
+    memset(in, 0, sizeof(*in));
+    in->tier = 2;
+    in->boot_count = 5;
+    in->health_score = 9;
+    in->timestamp = 1700000000;
+    strcpy(in->clock, "12.34");
+    strcpy(in->device_id, "pac-test-01234567");
+    in->nonce = "00112233445566778899aabbccddeeff";
+}
+
+static bool verify_with(const struct AttestKey *k, const char *data, size_t len,
+                        const uint8_t *sig, size_t sig_len)
+{
+    BIO *bio = BIO_new_mem_buf(k->public_pem, (int)k->public_pem_len);
+    EVP_PKEY *pub = PEM_read_bio_PUBKEY(bio, NULL, NULL, NULL);
+    BIO_free(bio);
+    if (!pub)
+        return false;
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    const EVP_MD *md = k->alg == ATTEST_ALG_ED25519 ? NULL : EVP_sha256();
+    bool ok = EVP_DigestVerifyInit(ctx, NULL, md, NULL, pub) == 1 &&
+              EVP_DigestVerify(ctx, sig, sig_len, (const uint8_t *)data, len) == 1;
+    EVP_MD_CTX_free(ctx);
+    EVP_PKEY_free(pub);
+    return ok;
+}
+
+static bool verify(const char *data, size_t len, const uint8_t *sig, size_t sig_len)
+{
+    return verify_with(&key, data, len, sig, sig_len);
+}
+
+static void test_measure(void)
+{
+    TEST_START("PCR Measurement");
+    struct AttestInputs in;
+    struct AttestMeasurement m;
+    make_inputs(&in);
+    TEST_ASSERT(attest_measure(&in, &m) == ATTEST_OK, "Measurement succeeds");
+    TEST_ASSERT(strcmp(m.pcr_hex[0], "9cccef9a03f923a51bb5286a1559737a8a1b2791100a846f127c786d0c31c421") == 0,
+                "PCR-00 hashes the kernel placeholder without /proc/version");
+    TEST_ASSERT(strcmp(m.pcr_hex[1], "4e1b79eee23edc90b518450486e379c2c9ebc847407d060cb7929e09fbbdbc31") == 0,
+                "PCR-01 matches echo bootloader-config | sha256sum");
+    TEST_ASSERT(strcmp(m.pcr_hex[2], "e370cde0759ca5c16552b13be0a0f967b92451232ea0a289ac0189498598e865") == 0,
+                "PCR-02 covers tier and boot count");
+    TEST_ASSERT(strcmp(m.pcr_hex[3], "4151acaf193b5803da1adf64bf02b5199aed606b6c658d9314f9332d841edd9f") == 0,
+                "PCR-07 covers tier and health score");
+    TEST_ASSERT(strcmp(m.digest_hex, "a35dd3107dc36d38308d0bc0894e78dbd5b683839d5db6ba02647a1d2e56478c") == 0,
+                "PCR digest matches sha256sum of pcrs.txt");
+
+    in.kernel_version = "Linux version 6.1\n";
+    in.kernel_version_len = strlen(in.kernel_version);
+    struct AttestMeasurement k;
+    attest_measure(&in, &k);
+    TEST_ASSERT(strcmp(k.pcr_hex[0], m.pcr_hex[0]) != 0, "PCR-00 follows /proc/version");
+    TEST_ASSERT(strcmp(k.digest_hex, m.digest_hex) != 0, "PCR digest follows PCR-00");
+    TEST_END();
+}
+
+static void test_quote(void)
+{
+    TEST_START("Quote Format");
+    struct AttestInputs in;
+    struct AttestMeasurement m;
+    char quote[ATTEST_QUOTE_MAX];
+    char expect[ATTEST_QUOTE_MAX];
+    make_inputs(&in);
+    attest_measure(&in, &m);
+    int n = attest_quote(&in, &m, quote, sizeof(quote));
+    snprintf(expect, sizeof(expect),
+             "TPM_QUOTE_V1\ntimestamp: 1700000000\nnonce: %s\npcr_digest: %s\ntier: 2\nclock: 12.34\n",
+             in.nonce, m.digest_hex);
+    TEST_ASSERT(n == (int)strlen(expect), "Quote length reported");
+    TEST_ASSERT(strcmp(quote, expect) == 0, "Quote text matches quote_data.txt layout");
+    TEST_ASSERT(attest_quote(&in, &m, quote, 32) == ATTEST_ERR_OVERFLOW, "Short buffer reported");
+    TEST_END();
+}
+
+static void test_key(void)
+{
+    TEST_START("AIK Management");
+    char priv[128], pub[128];
+    struct stat st;
+    bool generated;
+    snprintf(priv, sizeof(priv), "%s/aik_private.pem", tmpdir);
+    snprintf(pub, sizeof(pub), "%s/aik_public.pem", tmpdir);
+
+    TEST_ASSERT(attest_key_load(&key, priv, pub, ATTEST_ALG_RSA2048, &generated) == ATTEST_OK &&
+                generated, "Key generated when none exists");
+    TEST_ASSERT(key.bits == ATTEST_KEY_BITS, "Key is RSA-2048");
+    TEST_ASSERT(strcmp(key.sig_alg, "RSA-2048-SHA256") == 0, "RSA signature label");
+    TEST_ASSERT(stat(priv, &st) == 0 && (st.st_mode & 0777) == 0600, "Private key stored 0600");
+    TEST_ASSERT(access(pub, F_OK) == 0, "Public key stored");
+    TEST_ASSERT(strncmp(key.public_pem, "-----BEGIN PUBLIC KEY-----", 26) == 0,
+                "Public key held as SubjectPublicKeyInfo PEM");
+
+    struct AttestKey again;
+    unlink(pub);
+    TEST_ASSERT(attest_key_load(&again, priv, pub, ATTEST_ALG_ED25519, &generated) == ATTEST_OK &&
+                !generated, "Existing key reused");
+    TEST_ASSERT(again.alg == ATTEST_ALG_RSA2048, "Existing key keeps its type");
+    TEST_ASSERT(again.public_pem_len == key.public_pem_len &&
+                memcmp(again.public_pem, key.public_pem, key.public_pem_len) == 0,
+                "Reloaded key has the same public half");
+    TEST_ASSERT(access(pub, F_OK) == 0, "Missing public key re-derived");
+    attest_key_free(&again);
+    TEST_END();
+}
+
+static void test_sign(void)
+{
+    TEST_START("Quote Signature");
+    const char *quote = "TPM_QUOTE_V1\nnonce: abc\n";
+    uint8_t sig[ATTEST_SIG_MAX];
+    size_t sig_len = sizeof(sig);
+    TEST_ASSERT(attest_sign(&key, quote, strlen(quote), sig, &sig_len) == ATTEST_OK, "Quote signed");
+    TEST_ASSERT(sig_len == 256, "RSA-2048 signature is 256 bytes");
+    TEST_ASSERT(verify(quote, strlen(quote), sig, sig_len), "Signature verifies with the public key");
+    TEST_ASSERT(!verify("TPM_QUOTE_V1\nnonce: abd\n", strlen(quote), sig, sig_len),
+                "Tampered quote rejected");
+    uint8_t sig2[ATTEST_SIG_MAX];
+    size_t sig2_len = sizeof(sig2);
+    TEST_ASSERT(attest_sign(&key, "second", 6, sig2, &sig2_len) == ATTEST_OK &&
+                verify("second", 6, sig2, sig2_len), "Resident context signs again");
+    size_t short_len = 64;
+    TEST_ASSERT(attest_sign(&key, quote, strlen(quote), sig, &short_len) == ATTEST_ERR_OVERFLOW,
+                "Short signature buffer reported");
+    TEST_END();
+}
+
+static void test_key_types(void)
+{
+    TEST_START("AIK Algorithms");
+    static const char *const labels[ATTEST_ALG_COUNT] = {
+        "RSA-2048-SHA256", "ECDSA-P256-SHA256", "Ed25519"
+    };
+    static const size_t max_sig[ATTEST_ALG_COUNT] = { 256, 72, 64 };
+    const char *quote = "TPM_QUOTE_V1\nnonce: abc\n";
+    char msg[96];
+
+    TEST_ASSERT(attest_alg_from_name("rsa") == ATTEST_ALG_RSA2048, "rsa parsed");
+    TEST_ASSERT(attest_alg_from_name("ecdsa-p256") == ATTEST_ALG_P256, "ecdsa-p256 parsed");
+    TEST_ASSERT(attest_alg_from_name("p256") == ATTEST_ALG_P256, "p256 alias parsed");
+    TEST_ASSERT(attest_alg_from_name("ed25519") == ATTEST_ALG_ED25519, "ed25519 parsed");
+    TEST_ASSERT(attest_alg_from_name("dsa") < 0, "Unknown type rejected");
+
+    for (int alg = ATTEST_ALG_P256; alg < ATTEST_ALG_COUNT; alg++) {
+        struct AttestKey k, copy;
+        uint8_t sig[ATTEST_SIG_MAX];
+        size_t sig_len = sizeof(sig);
+        char *pem;
+        size_t pem_len;
+        const char *name = attest_alg_name(alg);
+
+        snprintf(msg, sizeof(msg), "%s key generated", name);
+        TEST_ASSERT(attest_key_generate(&k, alg) == ATTEST_OK && k.alg == alg, msg);
+        snprintf(msg, sizeof(msg), "%s labelled %s", name, labels[alg]);
+        TEST_ASSERT(strcmp(k.sig_alg, labels[alg]) == 0, msg);
+        for (int round = 0; round < 2; round++) {
+            sig_len = sizeof(sig);
+            snprintf(msg, sizeof(msg), "%s signature %d verifies", name, round + 1);
+            TEST_ASSERT(attest_sign(&k, quote, strlen(quote), sig, &sig_len) == ATTEST_OK &&
+                        sig_len <= max_sig[alg] &&
+                        verify_with(&k, quote, strlen(quote), sig, sig_len), msg);
+        }
+        snprintf(msg, sizeof(msg), "%s tampered quote rejected", name);
+        TEST_ASSERT(!verify_with(&k, "TPM_QUOTE_V1\nnonce: abd\n", strlen(quote), sig, sig_len), msg);
+
+        snprintf(msg, sizeof(msg), "%s key round-trips through PEM", name);
+        TEST_ASSERT(attest_key_private_pem(&k, &pem, &pem_len) == ATTEST_OK &&
+                    attest_key_from_pem(&copy, pem, pem_len) == ATTEST_OK && copy.alg == alg &&
+                    strcmp(copy.public_pem, k.public_pem) == 0, msg);
+        free(pem);
+        attest_key_free(&copy);
+        attest_key_free(&k);
+    }
+    TEST_END();
+}
+
+static void write_image(const char *path, size_t size, uint8_t digest[MEASURE_DIGEST_LEN])
+{
+    uint8_t *data = malloc(size + 1);
+    for (size_t i = 0; i < size; i++)
+        data[i] = (uint8_t)(i * 31 + (i >> 12));
+    FILE *f = fopen(path, "wb");
+    fwrite(data, 1, size, f);
+    fclose(f);
+    EVP_Digest(data, size, digest, NULL, EVP_sha256(), NULL);
+    free(data);
+}
+
+static void test_stream(void)
+{
+    TEST_START("Streaming Measurement");
+    char path[128];
+    uint8_t expect[MEASURE_DIGEST_LEN], got[MEASURE_DIGEST_LEN];
+    uint64_t bytes;
+    static const uint8_t empty[MEASURE_DIGEST_LEN] = {
+        0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14, 0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24,
+        0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c, 0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55
+    };
+    snprintf(path, sizeof(path), "%s/stream.img", tmpdir);
+
+    size_t sizes[] = { 0, 100, MEASURE_CHUNK, 3 * MEASURE_CHUNK + 123 };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        char msg[80];
+        write_image(path, sizes[i], expect);
+        int fd = open(path, O_RDONLY);
+        int ret = measure_stream(fd, got, &bytes);
+        close(fd);
+        snprintf(msg, sizeof(msg), "%zu byte image matches one-shot SHA-256", sizes[i]);
+        TEST_ASSERT(ret == MEASURE_OK && bytes == sizes[i] &&
+                    memcmp(got, expect, MEASURE_DIGEST_LEN) == 0, msg);
+    }
+    write_image(path, 0, got);
+    TEST_ASSERT(memcmp(got, empty, MEASURE_DIGEST_LEN) == 0, "Empty image has the SHA-256 empty digest");
+    TEST_END();
+}
+
+static void test_digest_cache(void)
+{
+    TEST_START("Measurement Cache");
+    char dir[96], image[128], root[128], cache_path[128];
+    uint8_t expect[MEASURE_DIGEST_LEN], got[MEASURE_DIGEST_LEN];
+    struct MeasureCache cache, reloaded;
+    bool cached;
+    snprintf(dir, sizeof(dir), "%s/tier2", tmpdir);
+    mkdir(dir, 0755);
+    snprintf(image, sizeof(image), "%s/rootfs.img", dir);
+    snprintf(root, sizeof(root), "%s/verity.roothash", dir);
+    snprintf(cache_path, sizeof(cache_path), "%s/measure.cache", tmpdir);
+    write_image(image, 2 * MEASURE_CHUNK + 7, expect);
+
+    TEST_ASSERT(measure_cache_load(&cache, cache_path) == MEASURE_OK && cache.count == 0,
+                "Missing cache loads empty");
+    TEST_ASSERT(measure_image(&cache, image, got, &cached) == MEASURE_OK && !cached &&
+                memcmp(got, expect, MEASURE_DIGEST_LEN) == 0, "First measurement reads the image");
+    TEST_ASSERT(cache.bytes_hashed == 2 * MEASURE_CHUNK + 7, "Whole image hashed once");
+    memset(got, 0, sizeof(got));
+    TEST_ASSERT(measure_image(&cache, image, got, &cached) == MEASURE_OK && cached &&
+                memcmp(got, expect, MEASURE_DIGEST_LEN) == 0, "Unchanged image served from cache");
+    TEST_ASSERT(cache.bytes_hashed == 2 * MEASURE_CHUNK + 7, "Cache hit reads nothing");
+
+    TEST_ASSERT(measure_cache_save(&cache, cache_path) == MEASURE_OK, "Cache saved");
+    TEST_ASSERT(measure_cache_load(&reloaded, cache_path) == MEASURE_OK && reloaded.count == 1,
+                "Cache reloaded");
+    TEST_ASSERT(measure_image(&reloaded, image, got, &cached) == MEASURE_OK && cached &&
+                memcmp(got, expect, MEASURE_DIGEST_LEN) == 0, "Reloaded cache hits across runs");
+
+    FILE *f = fopen(root, "w");
+    fputs("4392bc1a63ea0fe8c0b8e5f1d6b7a0c3\n", f);
+    fclose(f);
+    TEST_ASSERT(measure_image(&cache, image, got, &cached) == MEASURE_OK && !cached,
+                "New dm-verity root invalidates the digest");
+    struct MeasureKey key;
+    measure_key_for(image, &key);
+    TEST_ASSERT(strcmp(key.verity, "4392bc1a63ea0fe8c0b8e5f1d6b7a0c3") == 0,
+                "Verity root read beside the image");
+
+    struct timespec times[2] = { { 0, UTIME_OMIT }, { 1000000000, 0 } };
+    utimensat(AT_FDCWD, image, times, 0);
+    TEST_ASSERT(measure_image(&cache, image, got, &cached) == MEASURE_OK && !cached,
+                "Changed mtime invalidates the digest");
+
+    write_image(image, 4096, expect);
+    measure_image(&cache, image, got, &cached);
+    TEST_ASSERT(!cached && memcmp(got, expect, MEASURE_DIGEST_LEN) == 0,
+                "Rewritten image re-measured");
+    TEST_ASSERT(cache.count == 1, "Entry replaced, not duplicated");
+    TEST_ASSERT(measure_image(&cache, "/nonexistent/rootfs.img", got, &cached) == MEASURE_ERR_IO,
+                "Missing image reported");
+    TEST_END();
+}
+
+static void test_event_log(void)
+{
+    TEST_START("Event Log");
+    char path[128];
+    struct EventLog log, again;
+    uint8_t d1[MEASURE_DIGEST_LEN], d2[MEASURE_DIGEST_LEN], d3[MEASURE_DIGEST_LEN];
+    uint8_t value[MEASURE_DIGEST_LEN], expect[MEASURE_DIGEST_LEN], buf[MEASURE_DIGEST_LEN * 2];
+    memset(d1, 0x11, sizeof(d1));
+    memset(d2, 0x22, sizeof(d2));
+    memset(d3, 0x33, sizeof(d3));
+    snprintf(path, sizeof(path), "%s/event_log", tmpdir);
+
+    event_log_load(&log, path, "boot-a");
+    TEST_ASSERT(log.count == 0, "Missing log starts empty");
+    TEST_ASSERT(event_log_record(&log, 8, MEASURE_EVENT_IMAGE, d1, "/tier2/rootfs.img") == 1,
+                "First measurement appended");
+    TEST_ASSERT(event_log_record(&log, 8, MEASURE_EVENT_IMAGE, d2, "/tier3/rootfs.img") == 1,
+                "Second image appended");
+    TEST_ASSERT(event_log_record(&log, 8, MEASURE_EVENT_IMAGE, d1, "/tier2/rootfs.img") == 0,
+                "Unchanged measurement not re-extended");
+
+    memset(expect, 0, sizeof(expect));
+    memcpy(buf, expect, MEASURE_DIGEST_LEN);
+    memcpy(buf + MEASURE_DIGEST_LEN, d1, MEASURE_DIGEST_LEN);
+    EVP_Digest(buf, sizeof(buf), expect, NULL, EVP_sha256(), NULL);
+    memcpy(buf, expect, MEASURE_DIGEST_LEN);
+    memcpy(buf + MEASURE_DIGEST_LEN, d2, MEASURE_DIGEST_LEN);
+    EVP_Digest(buf, sizeof(buf), expect, NULL, EVP_sha256(), NULL);
+    TEST_ASSERT(event_log_replay(&log, 8, value) == 2 && memcmp(value, expect, sizeof(value)) == 0,
+                "Replay extends PCR-8 from zero");
+    TEST_ASSERT(event_log_replay(&log, 9, value) == 0, "Other PCRs have no events");
+
+    TEST_ASSERT(event_log_save(&log, path) == MEASURE_OK, "Log written");
+    event_log_load(&again, path, "boot-a");
+    TEST_ASSERT(again.count == 2 && again.persisted == 2 &&
+                memcmp(again.events[1].digest, d2, MEASURE_DIGEST_LEN) == 0 &&
+                strcmp(again.events[1].name, "/tier3/rootfs.img") == 0, "Log reloaded in the same boot");
+
+    TEST_ASSERT(event_log_record(&again, 8, MEASURE_EVENT_IMAGE, d3, "/tier2/rootfs.img") == 1,
+                "Changed image extends again");
+    struct stat before, after;
+    stat(path, &before);
+    TEST_ASSERT(event_log_save(&again, path) == MEASURE_OK, "New event appended");
+    stat(path, &after);
+    TEST_ASSERT(before.st_ino == after.st_ino && after.st_size > before.st_size,
+                "Append keeps the existing log file");
+    event_log_load(&log, path, "boot-a");
+    TEST_ASSERT(log.count == 3 && memcmp(log.events[2].digest, d3, MEASURE_DIGEST_LEN) == 0,
+                "Appended event reloads");
+
+    event_log_load(&log, path, "boot-b");
+    TEST_ASSERT(log.count == 0, "Log from another boot discarded");
+    TEST_END();
+}
+
+static void test_image_pcr(void)
+{
+    TEST_START("Image PCR in Token");
+    struct AttestInputs in;
+    struct AttestMeasurement plain, measured;
+    struct EventLog log;
+    uint8_t digest[MEASURE_DIGEST_LEN], sig[ATTEST_SIG_MAX];
+    char quote[ATTEST_QUOTE_MAX];
+    static char token[ATTEST_TOKEN_MAX];
+    size_t sig_len = sizeof(sig);
+
+    make_inputs(&in);
+    attest_measure(&in, &plain);
+    event_log_load(&log, "/nonexistent", "boot-a");
+    in.events = &log;
+    attest_measure(&in, &measured);
+    TEST_ASSERT(measured.image_events == 0 && strcmp(measured.digest_hex, plain.digest_hex) == 0,
+                "Empty log leaves the shell PCR set unchanged");
+
+    memset(digest, 0x5a, sizeof(digest));
+    event_log_record(&log, MEASURE_PCR_IMAGES, MEASURE_EVENT_IMAGE, digest, "/tier2/rootfs.img");
+    attest_measure(&in, &measured);
+    TEST_ASSERT(measured.image_events == 1, "Image event replayed");
+    TEST_ASSERT(strcmp(measured.digest_hex, plain.digest_hex) != 0, "PCR digest covers PCR-8");
+
+    int qlen = attest_quote(&in, &measured, quote, sizeof(quote));
+    attest_sign(&key, quote, (size_t)qlen, sig, &sig_len);
+    attest_eat_json(&in, &measured, quote, (size_t)qlen, sig, sig_len, &key, token, sizeof(token));
+    char expect[128];
+    snprintf(expect, sizeof(expect), "\"8\":\"%s\"}", measured.image_pcr_hex);
+    TEST_ASSERT(strstr(token, expect) != NULL, "PCR-8 listed with the other PCRs");
+    TEST_ASSERT(strstr(token, "\"event_log\":[{\"pcr\":8,\"type\":\"rootfs-image\",\"digest\":\"5a5a") != NULL &&
+                strstr(token, "\"name\":\"/tier2/rootfs.img\"}]") != NULL, "Event log carried in the token");
+    TEST_END();
+}
+
+static void test_token(void)
+{
+    TEST_START("EAT Token");
+    struct AttestInputs in;
+    struct AttestMeasurement m;
+    char quote[ATTEST_QUOTE_MAX];
+    uint8_t sig[ATTEST_SIG_MAX];
+    size_t sig_len = sizeof(sig);
+    static char token[ATTEST_TOKEN_MAX];
+    make_inputs(&in);
+    attest_measure(&in, &m);
+    int qlen = attest_quote(&in, &m, quote, sizeof(quote));
+    attest_sign(&key, quote, (size_t)qlen, sig, &sig_len);
+
+    int n = attest_eat_json(&in, &m, quote, (size_t)qlen, sig, sig_len, &key, token, sizeof(token));
+    TEST_ASSERT(n > 0 && (size_t)n == strlen(token), "Token serialised");
+    TEST_ASSERT(strncmp(token, "{\"format\":\"pac-eat-v2-signed\",\"timestamp\":1700000000,", 53) == 0,
+                "Token starts like the shell heredoc");
+    TEST_ASSERT(strstr(token, "\"boot_state\":{\"tier\":2,\"boot_count\":5}") != NULL,
+                "Boot state carried");
+    TEST_ASSERT(strstr(token, "\"quote_data\":\"VFBNX1FVT1RFX1YxCnRpbWVzdGFtcDog") != NULL,
+                "Quote data base64 encoded");
+    TEST_ASSERT(strstr(token, "\"signature_algorithm\":\"RSA-2048-SHA256\"") != NULL,
+                "Signature algorithm named");
+    TEST_ASSERT(strstr(token, "\"public_key\":\"LS0tLS1CRUdJTiBQVUJMSUMgS0VZLS0tLS") != NULL,
+                "Public key PEM base64 encoded");
+    TEST_ASSERT(strstr(token, m.digest_hex) != NULL, "PCR digest carried");
+    TEST_ASSERT(strstr(token, "\"7\":\"4151acaf") != NULL, "PCR-07 keyed by index");
+    TEST_ASSERT(strstr(token, "\"health_status\":{\"overall_status\":\"healthy\",\"overall_score\":8}") != NULL,
+                "Default health status without a report");
+    TEST_ASSERT(strstr(token, "\"agent\":\"pac_attestd\"") != NULL, "Agent named in metadata");
+
+    in.health_json = "{\"overall_score\": 9}\n";
+    in.health_json_len = strlen(in.health_json);
+    attest_eat_json(&in, &m, quote, (size_t)qlen, sig, sig_len, &key, token, sizeof(token));
+    TEST_ASSERT(strstr(token, "\"health_status\":{\"overall_score\": 9},\"metadata\"") != NULL,
+                "Health report spliced verbatim");
+    TEST_ASSERT(attest_eat_json(&in, &m, quote, (size_t)qlen, sig, sig_len, &key, token, 256) ==
+                ATTEST_ERR_OVERFLOW, "Short token buffer reported");
+    TEST_END();
+}
+
+static void write_file(const char *dir, const char *name, const char *text)
+{
+    char path[160];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *f = fopen(path, "w");
+    fputs(text, f);
+    fclose(f);
+}
+
+static void make_tree(char *dir, size_t cap)
+{
+    char sub[160];
+    snprintf(dir, cap, "%s/tier3-root", tmpdir);
+    mkdir(dir, 0755);
+    snprintf(sub, sizeof(sub), "%s/sbin", dir);
+    mkdir(sub, 0755);
+    snprintf(sub, sizeof(sub), "%s/etc", dir);
+    mkdir(sub, 0755);
+    write_file(dir, "sbin/init", "#!/bin/sh\nexec /bin/sh\n");
+    write_file(dir, "etc/inittab", "::sysinit:/etc/init.d/rcS\n");
+    write_file(dir, "etc/motd", "tier-3\n");
+    snprintf(sub, sizeof(sub), "%s/sbin/getty", dir);
+    symlink("init", sub);
+    write_file(tmpdir, "early.list", "# opened before switch_root\n/sbin/init\netc/inittab\n");
+}
+
+static void test_merkle_manifest(void)
+{
+    TEST_START("Merkle Manifest");
+    char dir[96], list[128], manifest[128];
+    struct MerkleManifest m, loaded;
+    make_tree(dir, sizeof(dir));
+    snprintf(list, sizeof(list), "%s/early.list", tmpdir);
+    snprintf(manifest, sizeof(manifest), "%s/%s", dir, MERKLE_MANIFEST);
+
+    TEST_ASSERT(merkle_scan(&m, dir) == MERKLE_OK && m.count == 4, "Files and symlinks scanned");
+    TEST_ASSERT(strcmp(m.leaves[0].path, "etc/inittab") == 0 &&
+                strcmp(m.leaves[3].path, "sbin/init") == 0, "Leaves sorted by path");
+    TEST_ASSERT(merkle_mark_early(&m, list) == MERKLE_OK &&
+                (merkle_find(&m, "/sbin/init")->flags & MERKLE_FLAG_EARLY) &&
+                !(merkle_find(&m, "etc/motd")->flags & MERKLE_FLAG_EARLY), "Early files marked");
+    TEST_ASSERT(merkle_hash(&m, dir, 3) == MERKLE_OK, "Tree hashed");
+    uint8_t expect[MERKLE_DIGEST_LEN];
+    EVP_Digest("tier-3\n", 7, expect, NULL, EVP_sha256(), NULL);
+    TEST_ASSERT(memcmp(merkle_find(&m, "etc/motd")->digest, expect, MERKLE_DIGEST_LEN) == 0,
+                "Leaf digest is the file's SHA-256");
+    EVP_Digest("init", 4, expect, NULL, EVP_sha256(), NULL);
+    TEST_ASSERT(memcmp(merkle_find(&m, "sbin/getty")->digest, expect, MERKLE_DIGEST_LEN) == 0,
+                "Symlink leaf hashes its target");
+
+    uint8_t one_thread[MERKLE_DIGEST_LEN];
+    struct MerkleManifest again;
+    merkle_scan(&again, dir);
+    merkle_mark_early(&again, list);
+    merkle_hash(&again, dir, 1);
+    memcpy(one_thread, again.root, MERKLE_DIGEST_LEN);
+    merkle_free(&again);
+    TEST_ASSERT(memcmp(one_thread, m.root, MERKLE_DIGEST_LEN) == 0,
+                "Root independent of thread count");
+
+    TEST_ASSERT(merkle_save(&m, manifest) == MERKLE_OK, "Manifest saved");
+    TEST_ASSERT(merkle_load(&loaded, manifest) == MERKLE_OK && loaded.count == m.count &&
+                memcmp(loaded.root, m.root, MERKLE_DIGEST_LEN) == 0, "Manifest reloaded");
+    merkle_free(&loaded);
+    struct MerkleManifest rescanned;
+    TEST_ASSERT(merkle_scan(&rescanned, dir) == MERKLE_OK && rescanned.count == 4,
+                "Manifest left out of its own tree");
+    merkle_free(&rescanned);
+
+    merkle_find(&m, "etc/motd")->flags |= MERKLE_FLAG_EARLY;
+    uint8_t flagged[MERKLE_DIGEST_LEN];
+    merkle_compute_root(&m, flagged);
+    TEST_ASSERT(memcmp(flagged, m.root, MERKLE_DIGEST_LEN) != 0, "Early flag covered by the root");
+    memcpy(m.root, flagged, MERKLE_DIGEST_LEN);
+    merkle_find(&m, "etc/motd")->flags = 0;
+    char edited[128];
+    snprintf(edited, sizeof(edited), "%s/edited.merkle", tmpdir);
+    merkle_save(&m, edited);
+    TEST_ASSERT(merkle_load(&loaded, edited) == MERKLE_ERR_MISMATCH,
+                "Leaves not matching the header root rejected");
+    write_file(tmpdir, "edited.merkle", "# pac-merkle v1\nroot 00\nfiles 0\n");
+    TEST_ASSERT(merkle_load(&loaded, edited) == MERKLE_ERR_FORMAT, "Malformed manifest rejected");
+    merkle_free(&m);
+    TEST_END();
+}
+
+static void test_merkle_verify(void)
+{
+    TEST_START("Merkle Verification");
+    char dir[96], manifest[128], pub_path[128], list[128];
+    struct MerkleManifest m;
+    struct MerkleReport rep;
+    snprintf(dir, sizeof(dir), "%s/tier3-root", tmpdir);
+    snprintf(manifest, sizeof(manifest), "%s/%s", dir, MERKLE_MANIFEST);
+    snprintf(pub_path, sizeof(pub_path), "%s/tier_public.pem", tmpdir);
+    snprintf(list, sizeof(list), "%s/opened.list", tmpdir);
+    FILE *f = fopen(pub_path, "w");
+    fwrite(key.public_pem, 1, key.public_pem_len, f);
+    fclose(f);
+
+    TEST_ASSERT(merkle_load(&m, manifest) == MERKLE_OK, "Manifest loaded");
+    uint8_t sig[MERKLE_SIG_MAX];
+    size_t sig_len = sizeof(sig);
+    TEST_ASSERT(attest_sign(&key, m.root, MERKLE_DIGEST_LEN, sig, &sig_len) == ATTEST_OK &&
+                merkle_verify_root(m.root, sig, sig_len, pub_path) == MERKLE_OK,
+                "Signed root verifies");
+    sig[0] ^= 1;
+    TEST_ASSERT(merkle_verify_root(m.root, sig, sig_len, pub_path) == MERKLE_ERR_MISMATCH,
+                "Corrupt signature rejected");
+
+    TEST_ASSERT(merkle_check(&m, dir, MERKLE_CHECK_ALL, NULL, 0, 0, &rep) == MERKLE_OK &&
+                rep.checked == 4 && rep.failed == 0, "Untouched tree verifies");
+    write_file(dir, "etc/motd", "tampered\n");
+    TEST_ASSERT(merkle_check(&m, dir, MERKLE_CHECK_ALL, NULL, 0, 0, &rep) == MERKLE_ERR_MISMATCH &&
+                rep.failed == 1 && strcmp(rep.first_bad, "etc/motd") == 0,
+                "Modified file found by full check");
+    TEST_ASSERT(merkle_check(&m, dir, MERKLE_CHECK_EARLY, NULL, 0, 0, &rep) == MERKLE_OK &&
+                rep.checked == 2, "Lazy check hashes only early files");
+    write_file(dir, "etc/motd", "tier-3\n");
+
+    write_file(dir, "etc/inittab", "::sysinit:/bin/evil\n");
+    TEST_ASSERT(merkle_check(&m, dir, MERKLE_CHECK_EARLY, NULL, 0, 0, &rep) == MERKLE_ERR_MISMATCH,
+                "Modified early file fails lazy check");
+    write_file(dir, "etc/inittab", "::sysinit:/etc/init.d/rcS\n");
+
+    write_file(dir, "etc/extra", "x\n");
+    TEST_ASSERT(merkle_check(&m, dir, MERKLE_CHECK_ALL, NULL, 0, 0, &rep) == MERKLE_ERR_MISMATCH &&
+                rep.unlisted == 1, "File missing from the manifest found");
+    char extra[160];
+    snprintf(extra, sizeof(extra), "%s/etc/extra", dir);
+    unlink(extra);
+
+    write_file(tmpdir, "opened.list", "/etc/motd\n");
+    TEST_ASSERT(merkle_check(&m, dir, MERKLE_CHECK_LIST, list, 0, 0, &rep) == MERKLE_OK &&
+                rep.checked == 1, "Listed file verified");
+    write_file(tmpdir, "opened.list", "/etc/motd\n/lib/libc.so\n");
+    TEST_ASSERT(merkle_check(&m, dir, MERKLE_CHECK_LIST, list, 0, 0, &rep) == MERKLE_ERR_MISMATCH,
+                "Listed file absent from the manifest fails closed");
+
+    char sbin[128], real[128];
+    snprintf(sbin, sizeof(sbin), "%s/sbin", dir);
+    snprintf(real, sizeof(real), "%s/sbin.real", tmpdir);
+    rename(sbin, real);
+    symlink(real, sbin);
+    TEST_ASSERT(merkle_check(&m, dir, MERKLE_CHECK_EARLY, NULL, 0, 0, &rep) == MERKLE_ERR_MISMATCH,
+                "Directory swapped for a symlink rejected");
+    unlink(sbin);
+    rename(real, sbin);
+
+    char big[160];
+    snprintf(big, sizeof(big), "%s/etc/big.img", dir);
+    uint8_t digest[MEASURE_DIGEST_LEN];
+    write_image(big, 64 * MERKLE_CHUNK, digest);
+    struct MerkleManifest grown;
+    merkle_scan(&grown, dir);
+    merkle_hash(&grown, dir, 0);
+    TEST_ASSERT(merkle_check(&grown, dir, MERKLE_CHECK_ALL, NULL, 1, 1, &rep) == MERKLE_ERR_TIMEOUT &&
+                rep.timed_out, "Deadline bounds verification time");
+    merkle_free(&grown);
+    unlink(big);
+    merkle_free(&m);
+    TEST_END();
+}
+
+int main(void)
+{
+    printf("PAC Attestation Agent Test Suite\n");
+    snprintf(tmpdir, sizeof(tmpdir), "/tmp/test_attest.XXXXXX");
+    if (!mkdtemp(tmpdir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    test_measure();
+    test_quote();
+    test_key();
+    test_sign();
+    test_key_types();
+    test_token();
+    test_stream();
+    test_digest_cache();
+    test_event_log();
+    test_image_pcr();
+    test_merkle_manifest();
+    test_merkle_verify();
+    attest_key_free(&key);
+    char cmd[96];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", tmpdir);
+    if (system(cmd) != 0)
+        fprintf(stderr, "warning: could not remove %s\n", tmpdir);
+    printf("\n\n");
+    printf("  TEST SUMMARY                                              \n");
+    printf("\n");
+    printf("  Passed: %3d                                               \n", tests_passed);
+    printf("  Failed: %3d                                               \n", tests_failed);
+    printf("\n");
+    if (tests_failed == 0) {
+        printf("\n All tests PASSED! Attestation agent is working correctly.\n\n");
+        return 0;
+    } else {
+        printf("\n Some tests FAILED. Please review the output above.\n\n");
+        return 1;
+    }
+}
@@ -22,6 +22,9 @@ fail() { printf "\n\033[1;31m[ft-pac:ERROR]\033[0m %s\n" "$*" >&2; exit 1; }
 reqf() { [[ -f "$1" ]] || fail "missing file: $1"; }
 reqx() { [[ -x "$1" ]] || fail "missing/executable not found: "$1""; }
 
+NATIVE_BINDIR="${FT}/tier1_initramfs/build/bin"
+NATIVE_BINS="journal_tool pac-journald health_check_tool pac_policyd pac_policy pac_attestd pac_merkle"
+
 copy_runtime_scripts() {
   local target="$1"
   mkdir -p "${target}/usr/bin" "${target}/usr/lib/pac"
@@ -32,11 +35,56 @@ copy_runtime_scripts() {
       chmod +x "${target}/usr/lib/pac/${script}" 2>/dev/null || true
     fi
   done
-  if [[ -f "${FT}/tier1_initramfs/build/bin/journal_tool" ]]; then
-    mkdir -p "${target}/bin"
-    cp -f "${FT}/tier1_initramfs/build/bin/journal_tool" "${target}/bin/" || true
-    chmod +x "${target}/bin/journal_tool" 2>/dev/null || true
+  mkdir -p "${target}/bin" "${target}/etc/pac"
+  for bin in ${NATIVE_BINS}; do
+    reqx "${NATIVE_BINDIR}/${bin}"
+    cp -f "${NATIVE_BINDIR}/${bin}" "${target}/bin/" || fail "cannot install ${bin} into ${target}"
+  done
+  cp -f "${FT}/health_check/health_score.conf" "${target}/etc/pac/" || fail "cannot install health_score.conf"
+}
+
+# Cross-compiles every PAC tool statically for the target into
+# tier1_initramfs/build/bin, which copy_runtime_scripts installs from. The
+# module trees are cleaned before and after so host builds never mix with
+# target objects; the host pac_merkle used for signing is rebuilt last.
+build_native_tools() {
+  local mod
+  mkdir -p "${NATIVE_BINDIR}"
+  for mod in common journal health_check policy attest; do
+    make -C "${FT}/${mod}" clean >/dev/null
+  done
+  for mod in journal health_check policy attest; do
+    make -C "${FT}/${mod}" CROSS_COMPILE="${CROSS}" LDFLAGS="-static -pthread" \
+      BINDIR="${NATIVE_BINDIR}" install-bin || fail "cross-compiling ${mod} failed"
+  done
+  for bin in ${NATIVE_BINS}; do
+    file "${NATIVE_BINDIR}/${bin}" | grep -qi 'ARM aarch64' || fail "${bin} is not aarch64"
+  done
+  for mod in common journal health_check policy attest; do
+    make -C "${FT}/${mod}" clean >/dev/null
+  done
+  # the bundled OpenSSL is built for the target, so sign with the host libcrypto
+  make -C "${FT}/attest" OPENSSL_DIR=/nonexistent pac_merkle || fail "building host pac_merkle failed"
+}
+
+# Signs a Merkle manifest of the tier rootfs so policy_engine.sh can gate
+# promotion on it; files early boot opens are marked for lazy verification
+sign_tier_manifest() {
+  local root="$1"
+  local tool="${FT}/attest/pac_merkle"
+  local key="${FT}/keys/pac_private.pem"
+  reqx "${tool}"
+  if [[ ! -f "${key}" ]]; then
+    mkdir -p "${FT}/keys"
+    openssl genrsa -out "${key}" 2048 2>/dev/null
+    openssl rsa -in "${key}" -pubout -out "${FT}/keys/pac_public.pem" 2>/dev/null
   fi
+  local early="${root}.early"
+  ( cd "${root}" && ls -d sbin/init bin/busybox bin/journal_tool bin/health_check_tool \
+      bin/pac_* usr/lib/pac/*.sh etc/pac/* 2>/dev/null ) > "${early}" || true
+  "${tool}" build "${root}" --early "${early}" -v || fail "cannot build manifest for ${root}"
+  "${tool}" sign "${root}" -k "${key}" || fail "cannot sign manifest for ${root}"
+  rm -f "${early}"
 }
 
 log "Installing packages (sudo)..."
@@ -423,6 +471,10 @@ else
   log "OpenSSL already present in initramfs, skipping build"
 fi
 
+log "Cross-compiling PAC tools for ${ARCH}..."
+build_native_tools
+log " PAC tools installed in ${NATIVE_BINDIR}"
+
 log "Setting up Tier-1 /init (progressive boot)..."
 if [ -f "${FT}/tier1_initramfs/build/init_progressive.sh" ]; then
     cp -f "${FT}/tier1_initramfs/build/init_progressive.sh" "${FT}/tier1_initramfs/rootfs/init"
@@ -698,6 +750,7 @@ chmod +x "${FT}/tier2/rootfs/sbin/init"
 echo "PAC Tier-2 (Reduced functionality with dm-verity)" > "${FT}/tier2/rootfs/etc/motd"
 cd "${FT}"
 
+sign_tier_manifest "${FT}/tier2/rootfs"
 dd if=/dev/zero of="${FT}/tier2/img/tier2.ext4" bs=1M count=64 status=none
 mkfs.ext4 -F "${FT}/tier2/img/tier2.ext4" >/dev/null
 mkdir -p "${FT}/tier2/mnt"
@@ -1048,6 +1101,8 @@ cd "${FT}"
 mkdir -p "${FT}/tier3/rootfs/etc/ima"
 mkdir -p "${FT}/tier3/rootfs/etc/keys"
 
+sign_tier_manifest "${FT}/tier3/rootfs"
+
 log "Creating Tier 3 rootfs image (256MB)..."
 mkdir -p "${FT}/tier3/img"
 dd if=/dev/zero of="${FT}/tier3/img/tier3.ext4" bs=1M count=256 status=none
@@ -1088,6 +1143,17 @@ if [ -f "${FT}/tier3/keys/ima_pub.pem" ]; then
 fi
 log " Tier 3 rootfs created and copied to initramfs"
 
+log "Recording PCR-8 reference measurements for the verifier..."
+T2_IMAGE_SHA=$(sha256sum "${FT}/tier2/img/tier2.ext4" | cut -d' ' -f1) || fail "cannot hash Tier 2 image"
+T3_IMAGE_SHA=$(sha256sum "${FT}/tier3/img/tier3.ext4" | cut -d' ' -f1) || fail "cannot hash Tier 3 image"
+cat > "${FT}/verifier/reference_measurements.json" <<REFS
+{
+  "/tier2/rootfs.img": ["${T2_IMAGE_SHA}"],
+  "/tier3/rootfs.img": ["${T3_IMAGE_SHA}"]
+}
+REFS
+log " Reference digests written to verifier/reference_measurements.json"
+
 log "Packing initramfs.cpio.gz..."
 pushd "${FT}/tier1_initramfs/rootfs" >/dev/null
 find . -mindepth 1 -print0 | cpio --null -ov --format=newc | gzip -9 > "${FT}/tier1_initramfs/img/initramfs.cpio.gz"
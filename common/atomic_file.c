@@ -0,0 +1,186 @@
+#define _GNU_SOURCE
+#include "atomic_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+
+static int split_path(const char *path, char *dir, size_t dir_cap, const char **base)
+{
+    const char *slash = strrchr(path, '/');
+    if (!slash) {
+        snprintf(dir, dir_cap, ".");
+        *base = path;
+    } else if (slash == path) {
+        snprintf(dir, dir_cap, "/");
+        *base = slash + 1;
+    } else {
+        if ((size_t)(slash - path) >= dir_cap)
+            return ATOMIC_ERR_PATH;
+        memcpy(dir, path, (size_t)(slash - path));
+        dir[slash - path] = '\0';
+        *base = slash + 1;
+    }
+    return **base ? ATOMIC_OK : ATOMIC_ERR_PATH;
+}
+
+int atomic_file_open(struct AtomicFile *af, const char *path, mode_t mode)
+{
+    char dir[ATOMIC_PATH_MAX];
+    const char *base;
+    af->fd = -1;
+    if (strlen(path) >= sizeof(af->path) ||
+        split_path(path, dir, sizeof(dir), &base) != ATOMIC_OK)
+        return ATOMIC_ERR_PATH;
+    int n = snprintf(af->tmp, sizeof(af->tmp), "%s/.%s.XXXXXX", dir, base);
+    if (n < 0 || (size_t)n >= sizeof(af->tmp))
+        return ATOMIC_ERR_PATH;
+    strcpy(af->path, path);
+    af->fd = mkostemp(af->tmp, O_CLOEXEC);
+    if (af->fd < 0)
+        return ATOMIC_ERR_IO;
+    if (fchmod(af->fd, mode) != 0) {
+        atomic_file_abort(af);
+        return ATOMIC_ERR_IO;
+    }
+    return ATOMIC_OK;
+}
+
+void atomic_file_abort(struct AtomicFile *af)
+{
+    if (af->fd < 0)
+        return;
+    close(af->fd);
+    unlink(af->tmp);
+    af->fd = -1;
+}
+
+static int sync_dir(const char *path)
+{
+    char dir[ATOMIC_PATH_MAX];
+    const char *base;
+    if (split_path(path, dir, sizeof(dir), &base) != ATOMIC_OK)
+        return ATOMIC_ERR_PATH;
+    int fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return ATOMIC_ERR_IO;
+    int ret = fsync(fd) == 0 ? ATOMIC_OK : ATOMIC_ERR_IO;
+    close(fd);
+    return ret;
+}
+
+int atomic_file_commit(struct AtomicFile *af, unsigned flags)
+{
+    if (af->fd < 0)
+        return ATOMIC_ERR_IO;
+    if (fdatasync(af->fd) != 0) {
+        atomic_file_abort(af);
+        return ATOMIC_ERR_IO;
+    }
+    int ret = close(af->fd);
+    af->fd = -1;
+    if (ret != 0 || rename(af->tmp, af->path) != 0) {
+        unlink(af->tmp);
+        return ATOMIC_ERR_IO;
+    }
+    if (flags & ATOMIC_SYNC_DIR)
+        return sync_dir(af->path);
+    return ATOMIC_OK;
+}
+
+int atomic_publish(const char *path, const void *data, size_t len, mode_t mode,
+                   unsigned flags)
+{
+    struct AtomicFile af;
+    int ret = atomic_file_open(&af, path, mode);
+    if (ret != ATOMIC_OK)
+        return ret;
+    const char *p = data;
+    while (len > 0) {
+        ssize_t n = write(af.fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) {
+            atomic_file_abort(&af);
+            return ATOMIC_ERR_IO;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return atomic_file_commit(&af, flags);
+}
+
+static int64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int has_event_for(const char *buf, ssize_t len, const char *base)
+{
+    const char *p = buf;
+    while (p < buf + len) {
+        const struct inotify_event *ev = (const struct inotify_event *)p;
+        if (ev->len > 0 && strcmp(ev->name, base) == 0)
+            return 1;
+        p += sizeof(*ev) + ev->len;
+    }
+    return 0;
+}
+
+int atomic_wait(const char *path, int timeout_ms)
+{
+    char dir[ATOMIC_PATH_MAX];
+    const char *base;
+    if (split_path(path, dir, sizeof(dir), &base) != ATOMIC_OK)
+        return ATOMIC_ERR_PATH;
+    int fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (fd < 0)
+        return ATOMIC_ERR_IO;
+    if (inotify_add_watch(fd, dir, IN_MOVED_TO | IN_CLOSE_WRITE) < 0) {
+        close(fd);
+        return ATOMIC_ERR_IO;
+    }
+    int64_t deadline = timeout_ms < 0 ? 0 : now_ms() + timeout_ms;
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int ret = ATOMIC_TIMEOUT;
+    for (;;) {
+        int wait = -1;
+        if (timeout_ms >= 0) {
+            int64_t left = deadline - now_ms();
+            if (left <= 0)
+                break;
+            wait = (int)left;
+        }
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        int n = poll(&pfd, 1, wait);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0) {
+            ret = ATOMIC_ERR_IO;
+            break;
+        }
+        if (n == 0)
+            continue;
+        ssize_t got = read(fd, buf, sizeof(buf));
+        if (got < 0 && (errno == EAGAIN || errno == EINTR))
+            continue;
+        if (got <= 0) {
+            ret = ATOMIC_ERR_IO;
+            break;
+        }
+        if (has_event_for(buf, got, base)) {
+            ret = ATOMIC_OK;
+            break;
+        }
+    }
+    close(fd);
+    return ret;
+}
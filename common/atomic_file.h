@@ -0,0 +1,36 @@
+#ifndef ATOMIC_FILE_H
+#define ATOMIC_FILE_H
+#include <stddef.h>
+#include <sys/types.h>
+
+#define ATOMIC_OK            0
+#define ATOMIC_ERR_IO       -1
+#define ATOMIC_ERR_PATH     -2
+#define ATOMIC_TIMEOUT       1
+
+#define ATOMIC_PATH_MAX      256
+
+/* Also fsync the directory so the rename itself survives a power cut */
+#define ATOMIC_SYNC_DIR      0x1
+
+/*
+ * Publishes a file by writing a hidden temporary next to it and renaming it
+ * over the target once its data is on disk. Readers either see the previous
+ * complete file or the new one, never a truncated one. Watchers of the
+ * directory get a single IN_MOVED_TO per publish.
+ */
+struct AtomicFile {
+    int  fd;
+    char path[ATOMIC_PATH_MAX];
+    char tmp[ATOMIC_PATH_MAX];
+};
+
+int atomic_file_open(struct AtomicFile *af, const char *path, mode_t mode);
+int atomic_file_commit(struct AtomicFile *af, unsigned flags);
+void atomic_file_abort(struct AtomicFile *af);
+
+int atomic_publish(const char *path, const void *data, size_t len, mode_t mode,
+                   unsigned flags);
+int atomic_wait(const char *path, int timeout_ms);
+
+#endif
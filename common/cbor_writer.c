@@ -0,0 +1,117 @@
+#include "cbor_writer.h"
+#include <string.h>
+
+#define MAJOR_UINT   0
+#define MAJOR_NINT   1
+#define MAJOR_BYTES  2
+#define MAJOR_TEXT   3
+#define MAJOR_ARRAY  4
+#define MAJOR_MAP    5
+#define MAJOR_SIMPLE 7
+
+#define SIMPLE_FALSE 20
+#define SIMPLE_TRUE  21
+#define SIMPLE_NULL  22
+
+static void put(struct CborWriter *w, const void *data, size_t n)
+{
+    if (w->error)
+        return;
+    if (n > w->cap - w->len) {
+        w->error = CBOR_ERR_OVERFLOW;
+        return;
+    }
+    memcpy(w->buf + w->len, data, n);
+    w->len += n;
+}
+
+/* Shortest head encoding, as deterministic CBOR requires */
+static void head(struct CborWriter *w, uint8_t major, uint64_t v)
+{
+    uint8_t b[9];
+    size_t n;
+    major <<= 5;
+    if (v < 24) {
+        b[0] = major | (uint8_t)v;
+        n = 1;
+    } else if (v <= 0xff) {
+        b[0] = major | 24;
+        b[1] = (uint8_t)v;
+        n = 2;
+    } else if (v <= 0xffff) {
+        b[0] = major | 25;
+        b[1] = (uint8_t)(v >> 8);
+        b[2] = (uint8_t)v;
+        n = 3;
+    } else if (v <= 0xffffffffULL) {
+        b[0] = major | 26;
+        for (int i = 0; i < 4; i++)
+            b[1 + i] = (uint8_t)(v >> (24 - 8 * i));
+        n = 5;
+    } else {
+        b[0] = major | 27;
+        for (int i = 0; i < 8; i++)
+            b[1 + i] = (uint8_t)(v >> (56 - 8 * i));
+        n = 9;
+    }
+    put(w, b, n);
+}
+
+void cbor_init(struct CborWriter *w, uint8_t *buf, size_t cap)
+{
+    w->buf = buf;
+    w->cap = buf ? cap : 0;
+    w->len = 0;
+    w->error = CBOR_OK;
+}
+
+int cbor_finish(const struct CborWriter *w)
+{
+    return w->error ? w->error : (int)w->len;
+}
+
+void cbor_uint(struct CborWriter *w, uint64_t v)
+{
+    head(w, MAJOR_UINT, v);
+}
+
+void cbor_int(struct CborWriter *w, int64_t v)
+{
+    if (v >= 0)
+        head(w, MAJOR_UINT, (uint64_t)v);
+    else
+        head(w, MAJOR_NINT, (uint64_t)(-(v + 1)));
+}
+
+void cbor_bytes(struct CborWriter *w, const void *data, size_t len)
+{
+    head(w, MAJOR_BYTES, len);
+    put(w, data, len);
+}
+
+void cbor_text(struct CborWriter *w, const char *s)
+{
+    size_t len = s ? strlen(s) : 0;
+    head(w, MAJOR_TEXT, len);
+    put(w, s, len);
+}
+
+void cbor_bool(struct CborWriter *w, bool v)
+{
+    head(w, MAJOR_SIMPLE, v ? SIMPLE_TRUE : SIMPLE_FALSE);
+}
+
+void cbor_null(struct CborWriter *w)
+{
+    head(w, MAJOR_SIMPLE, SIMPLE_NULL);
+}
+
+void cbor_map(struct CborWriter *w, size_t pairs)
+{
+    head(w, MAJOR_MAP, pairs);
+}
+
+void cbor_array(struct CborWriter *w, size_t items)
+{
+    head(w, MAJOR_ARRAY, items);
+}
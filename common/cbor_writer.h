@@ -0,0 +1,34 @@
+#ifndef CBOR_WRITER_H
+#define CBOR_WRITER_H
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CBOR_OK             0
+#define CBOR_ERR_OVERFLOW  -1
+
+/*
+ * Encodes definite-length CBOR (RFC 8949) into a caller-owned buffer.
+ * Maps and arrays take their item count up front. Overflow is sticky and
+ * reported by cbor_finish().
+ */
+struct CborWriter {
+    uint8_t *buf;
+    size_t   cap;
+    size_t   len;
+    int      error;
+};
+
+void cbor_init(struct CborWriter *w, uint8_t *buf, size_t cap);
+int cbor_finish(const struct CborWriter *w);
+
+void cbor_uint(struct CborWriter *w, uint64_t v);
+void cbor_int(struct CborWriter *w, int64_t v);
+void cbor_bytes(struct CborWriter *w, const void *data, size_t len);
+void cbor_text(struct CborWriter *w, const char *s);
+void cbor_bool(struct CborWriter *w, bool v);
+void cbor_null(struct CborWriter *w);
+void cbor_map(struct CborWriter *w, size_t pairs);
+void cbor_array(struct CborWriter *w, size_t items);
+
+#endif
@@ -0,0 +1,587 @@
+#define _GNU_SOURCE
+#include "http_client.h"
+#include "atomic_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+int http_parse_url(const char *url, struct HttpUrl *u)
+{
+    memset(u, 0, sizeof(*u));
+    if (strncmp(url, "http://", 7) != 0)
+        return HTTP_ERR_URL;
+    const char *host = url + 7;
+    const char *path = strchr(host, '/');
+    size_t hostlen = path ? (size_t)(path - host) : strlen(host);
+    const char *port = NULL;
+    if (*host == '[') {
+        const char *close = memchr(host, ']', hostlen);
+        if (!close)
+            return HTTP_ERR_URL;
+        if (close + 1 < host + hostlen) {
+            if (close[1] != ':')
+                return HTTP_ERR_URL;
+            port = close + 2;
+        }
+        host++;
+        hostlen = (size_t)(close - host);
+    } else {
+        port = memchr(host, ':', hostlen);
+        if (port) {
+            hostlen = (size_t)(port - host);
+            port++;
+        }
+    }
+    if (hostlen == 0 || hostlen >= sizeof(u->host))
+        return HTTP_ERR_URL;
+    memcpy(u->host, host, hostlen);
+    if (port) {
+        size_t portlen = path ? (size_t)(path - port) : strlen(port);
+        if (portlen == 0 || portlen >= sizeof(u->port) || strspn(port, "0123456789") < portlen)
+            return HTTP_ERR_URL;
+        memcpy(u->port, port, portlen);
+    } else {
+        strcpy(u->port, "80");
+    }
+    if (path) {
+        size_t pathlen = strlen(path);
+        /* a trailing slash would double up when request paths are appended */
+        while (pathlen > 0 && path[pathlen - 1] == '/')
+            pathlen--;
+        if (pathlen >= sizeof(u->path))
+            return HTTP_ERR_URL;
+        memcpy(u->path, path, pathlen);
+    }
+    return HTTP_OK;
+}
+
+const char *http_strerror(int err)
+{
+    switch (err) {
+    case HTTP_OK:           return "ok";
+    case HTTP_ERR_URL:      return "invalid URL";
+    case HTTP_ERR_CONNECT:  return "connection failed";
+    case HTTP_ERR_IO:       return "I/O error";
+    case HTTP_ERR_TIMEOUT:  return "timed out";
+    case HTTP_ERR_PROTOCOL: return "malformed response";
+    case HTTP_ERR_OVERFLOW: return "response too large";
+    case HTTP_ERR_CLOSED:   return "connection closed by server";
+    case HTTP_ERR_BACKOFF:  return "backing off after failures";
+    default:                return "unknown error";
+    }
+}
+
+static int64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int64_t http_now_ms(void)
+{
+    return now_ms();
+}
+
+static int wait_fd(int fd, short events, int64_t deadline)
+{
+    for (;;) {
+        int64_t left = deadline - now_ms();
+        if (left <= 0)
+            return HTTP_ERR_TIMEOUT;
+        struct pollfd pfd = { .fd = fd, .events = events };
+        int n = poll(&pfd, 1, (int)left);
+        if (n > 0)
+            return HTTP_OK;
+        if (n < 0 && errno != EINTR)
+            return HTTP_ERR_IO;
+    }
+}
+
+static int connect_host(const struct HttpUrl *u, int64_t deadline)
+{
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(u->host, u->port, &hints, &res) != 0)
+        return HTTP_ERR_CONNECT;
+    int ret = HTTP_ERR_CONNECT;
+    for (struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+        int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                        ai->ai_protocol);
+        if (fd < 0)
+            continue;
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            ret = fd;
+            break;
+        }
+        if (errno == EINPROGRESS) {
+            int err = 0;
+            socklen_t len = sizeof(err);
+            int w = wait_fd(fd, POLLOUT, deadline);
+            if (w == HTTP_OK && getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0) {
+                ret = fd;
+                break;
+            }
+            if (w == HTTP_ERR_TIMEOUT)
+                ret = HTTP_ERR_TIMEOUT;
+        }
+        close(fd);
+    }
+    freeaddrinfo(res);
+    return ret;
+}
+
+static int send_all(int fd, struct iovec *iov, int iovcnt, int64_t deadline)
+{
+    while (iovcnt > 0) {
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = (size_t)iovcnt;
+        ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN)
+                return HTTP_ERR_IO;
+            int w = wait_fd(fd, POLLOUT, deadline);
+            if (w != HTTP_OK)
+                return w;
+            continue;
+        }
+        while (iovcnt > 0 && (size_t)n >= iov->iov_len) {
+            n -= (ssize_t)iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= (size_t)n;
+        }
+    }
+    return HTTP_OK;
+}
+
+/* Returns the header length once the blank line has arrived, 0 before that */
+static size_t header_end(const char *buf, size_t len)
+{
+    const char *end = memmem(buf, len, "\r\n\r\n", 4);
+    return end ? (size_t)(end - buf) + 4 : 0;
+}
+
+static const char *find_header(const char *buf, size_t hdr_len, const char *name)
+{
+    size_t n = strlen(name);
+    const char *p = memchr(buf, '\n', hdr_len);
+    while (p && (size_t)(p + 1 - buf) + n < hdr_len) {
+        p++;
+        if (strncasecmp(p, name, n) == 0 && p[n] == ':') {
+            p += n + 1;
+            while (*p == ' ' || *p == '\t')
+                p++;
+            return p;
+        }
+        p = memchr(p, '\n', hdr_len - (size_t)(p - buf));
+    }
+    return NULL;
+}
+
+/* Digits only, no sign, no overflow, nothing but blanks before the CRLF */
+static bool parse_content_length(const char *cl, unsigned long long *len)
+{
+    if (!isdigit((unsigned char)*cl))
+        return false;
+    char *end;
+    errno = 0;
+    *len = strtoull(cl, &end, 10);
+    while (*end == ' ' || *end == '\t')
+        end++;
+    return errno == 0 && (*end == '\r' || *end == '\n');
+}
+
+static int parse_response(char *buf, size_t len, size_t hdr_len, struct HttpResponse *resp)
+{
+    int major, minor, status;
+    if (sscanf(buf, "HTTP/%d.%d %d", &major, &minor, &status) != 3 || status < 100 || status > 999)
+        return HTTP_ERR_PROTOCOL;
+    const char *te = find_header(buf, hdr_len, "Transfer-Encoding");
+    if (te && strncasecmp(te, "chunked", 7) == 0)
+        return HTTP_ERR_PROTOCOL;
+    const char *cl = find_header(buf, hdr_len, "Content-Length");
+    size_t body_len = len - hdr_len;
+    if (cl) {
+        unsigned long long want;
+        if (!parse_content_length(cl, &want) || want > body_len)
+            return HTTP_ERR_PROTOCOL;
+        body_len = (size_t)want;
+    }
+    resp->status = status;
+    resp->body = buf + hdr_len;
+    resp->body_len = body_len;
+    buf[hdr_len + body_len] = '\0';
+    return HTTP_OK;
+}
+
+static bool response_complete(const char *buf, size_t len)
+{
+    size_t hdr_len = header_end(buf, len);
+    if (hdr_len == 0)
+        return false;
+    const char *cl = find_header(buf, hdr_len, "Content-Length");
+    unsigned long long want;
+    if (!cl)
+        return false;
+    /* a malformed length ends the read here and parse_response rejects it */
+    return !parse_content_length(cl, &want) || want <= len - hdr_len;
+}
+
+static int build_head(const struct HttpUrl *base, const char *method, const char *path,
+                      const char *content_type, const void *body, size_t body_len,
+                      bool close_conn, char *head, size_t cap)
+{
+    const char *conn = close_conn ? "Connection: close\r\n" : "";
+    int n;
+    if (body)
+        n = snprintf(head, cap,
+                     "%s %s%s HTTP/1.1\r\nHost: %s:%s\r\n%s"
+                     "Content-Type: %s\r\nContent-Length: %zu\r\n\r\n",
+                     method, base->path, path, base->host, base->port, conn,
+                     content_type ? content_type : "application/octet-stream", body_len);
+    else
+        n = snprintf(head, cap, "%s %s%s HTTP/1.1\r\nHost: %s:%s\r\n%s\r\n",
+                     method, base->path, path, base->host, base->port, conn);
+    return n < 0 || (size_t)n >= cap ? -1 : n;
+}
+
+int http_request(const struct HttpUrl *base, const char *method, const char *path,
+                 const char *content_type, const void *body, size_t body_len,
+                 uint32_t timeout_ms, char *buf, size_t cap, struct HttpResponse *resp)
+{
+    memset(resp, 0, sizeof(resp[0]));
+    if (cap < 64)
+        return HTTP_ERR_OVERFLOW;
+    char head[768];
+    int n = build_head(base, method, path, content_type, body, body_len, true,
+                       head, sizeof(head));
+    if (n < 0)
+        return HTTP_ERR_URL;
+    int64_t deadline = now_ms() + timeout_ms;
+    int fd = connect_host(base, deadline);
+    if (fd < 0)
+        return fd;
+    struct iovec iov[2] = {
+        { .iov_base = head, .iov_len = (size_t)n },
+        { .iov_base = (void *)body, .iov_len = body ? body_len : 0 },
+    };
+    int ret = send_all(fd, iov, body && body_len ? 2 : 1, deadline);
+    size_t len = 0;
+    while (ret == HTTP_OK) {
+        if (len == cap - 1) {
+            ret = HTTP_ERR_OVERFLOW;
+            break;
+        }
+        ssize_t got = recv(fd, buf + len, cap - 1 - len, 0);
+        if (got > 0) {
+            len += (size_t)got;
+            if (response_complete(buf, len))
+                break;
+            continue;
+        }
+        if (got == 0)
+            break;
+        if (errno == EINTR)
+            continue;
+        if (errno != EAGAIN) {
+            ret = HTTP_ERR_IO;
+            break;
+        }
+        ret = wait_fd(fd, POLLIN, deadline);
+    }
+    close(fd);
+    if (ret != HTTP_OK)
+        return ret;
+    buf[len] = '\0';
+    size_t hdr_len = header_end(buf, len);
+    if (hdr_len == 0)
+        return HTTP_ERR_PROTOCOL;
+    return parse_response(buf, len, hdr_len, resp);
+}
+
+void http_conn_init(struct HttpConn *c, const struct HttpUrl *url)
+{
+    memset(c, 0, sizeof(*c));
+    c->url = *url;
+    c->fd = -1;
+}
+
+void http_conn_close(struct HttpConn *c)
+{
+    if (c->fd >= 0)
+        close(c->fd);
+    c->fd = -1;
+    c->in_flight = 0;
+    c->served = 0;
+    c->close_after = false;
+    c->spill_len = 0;
+}
+
+bool http_conn_ready(const struct HttpConn *c, int64_t now)
+{
+    return now >= c->retry_at_ms;
+}
+
+static void conn_failed(struct HttpConn *c)
+{
+    int64_t now = now_ms();
+    http_conn_close(c);
+    c->reachable = false;
+    c->failures++;
+    c->last_fail_ms = now;
+    c->backoff_ms = c->backoff_ms ? c->backoff_ms * 2 : HTTP_BACKOFF_MIN_MS;
+    if (c->backoff_ms > HTTP_BACKOFF_MAX_MS)
+        c->backoff_ms = HTTP_BACKOFF_MAX_MS;
+    c->retry_at_ms = now + c->backoff_ms;
+}
+
+static void conn_succeeded(struct HttpConn *c)
+{
+    c->reachable = true;
+    c->failures = 0;
+    c->backoff_ms = 0;
+    c->retry_at_ms = 0;
+    c->last_ok_ms = now_ms();
+}
+
+/* An idle keep-alive socket is unusable once the server closed it or sent anything */
+static bool conn_stale(int fd)
+{
+    char b;
+    ssize_t n = recv(fd, &b, 1, MSG_PEEK | MSG_DONTWAIT);
+    return n >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+}
+
+int http_conn_send(struct HttpConn *c, const char *method, const char *path,
+                   const char *content_type, const void *body, size_t body_len,
+                   uint32_t timeout_ms)
+{
+    int64_t now = now_ms();
+    if (!http_conn_ready(c, now))
+        return HTTP_ERR_BACKOFF;
+    char head[768];
+    int n = build_head(&c->url, method, path, content_type, body, body_len, false,
+                       head, sizeof(head));
+    if (n < 0)
+        return HTTP_ERR_URL;
+    if (c->fd >= 0 && c->in_flight == 0 && (c->close_after || conn_stale(c->fd)))
+        http_conn_close(c);
+    if (c->fd >= 0 && c->close_after)
+        return HTTP_ERR_CLOSED;
+
+    int64_t deadline = now + timeout_ms;
+    int ret = HTTP_ERR_IO;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = c->fd >= 0 && c->in_flight == 0;
+        if (c->fd < 0) {
+            int fd = connect_host(&c->url, deadline);
+            if (fd < 0) {
+                ret = fd;
+                break;
+            }
+            c->fd = fd;
+            c->connects++;
+        }
+        struct iovec iov[2] = {
+            { .iov_base = head, .iov_len = (size_t)n },
+            { .iov_base = (void *)body, .iov_len = body ? body_len : 0 },
+        };
+        ret = send_all(c->fd, iov, body && body_len ? 2 : 1, deadline);
+        if (ret == HTTP_OK) {
+            c->in_flight++;
+            c->requests++;
+            return HTTP_OK;
+        }
+        /* the server may have dropped an idle connection just as it was reused */
+        if (!reused || ret == HTTP_ERR_TIMEOUT)
+            break;
+        http_conn_close(c);
+    }
+    conn_failed(c);
+    return ret;
+}
+
+static bool header_is(const char *buf, size_t hdr_len, const char *name, const char *value)
+{
+    const char *v = find_header(buf, hdr_len, name);
+    return v && strncasecmp(v, value, strlen(value)) == 0;
+}
+
+/*
+ * Reads the response to the oldest request in flight. Bodies must be
+ * framed by Content-Length to keep the connection; a body delimited by
+ * the server closing is accepted but ends the connection.
+ */
+int http_conn_recv(struct HttpConn *c, uint32_t timeout_ms, char *buf, size_t cap,
+                   struct HttpResponse *resp)
+{
+    memset(resp, 0, sizeof(resp[0]));
+    if (c->in_flight == 0 || c->fd < 0)
+        return HTTP_ERR_CLOSED;
+    if (cap < 64 || c->spill_len >= cap)
+        return HTTP_ERR_OVERFLOW;
+    bool reused = c->served > 0;
+    size_t len = c->spill_len;
+    memcpy(buf, c->spill, len);
+    c->spill_len = 0;
+
+    int64_t deadline = now_ms() + timeout_ms;
+    int ret = HTTP_OK;
+    int status = 0, major = 0, minor = 0;
+    size_t hdr_len = 0, total = 0;
+    bool until_close = false;
+    for (;;) {
+        if (!hdr_len && (hdr_len = header_end(buf, len)) != 0) {
+            if (sscanf(buf, "HTTP/%d.%d %d", &major, &minor, &status) != 3 ||
+                status < 100 || status > 999 ||
+                header_is(buf, hdr_len, "Transfer-Encoding", "chunked")) {
+                ret = HTTP_ERR_PROTOCOL;
+                break;
+            }
+            const char *cl = find_header(buf, hdr_len, "Content-Length");
+            unsigned long long want;
+            if (cl) {
+                if (!parse_content_length(cl, &want) || want > cap - 1 - hdr_len) {
+                    ret = HTTP_ERR_PROTOCOL;
+                    break;
+                }
+                total = hdr_len + (size_t)want;
+            } else if (status < 200 || status == 204 || status == 304)
+                total = hdr_len;
+            else
+                until_close = true;
+        }
+        if (hdr_len && !until_close && len >= total)
+            break;
+        if (len == cap - 1) {
+            ret = HTTP_ERR_OVERFLOW;
+            break;
+        }
+        ssize_t got = recv(c->fd, buf + len, cap - 1 - len, 0);
+        if (got > 0) {
+            len += (size_t)got;
+            continue;
+        }
+        if (got == 0) {
+            if (hdr_len && until_close)
+                total = len;
+            else
+                ret = len == 0 ? HTTP_ERR_CLOSED : HTTP_ERR_PROTOCOL;
+            break;
+        }
+        if (errno == EINTR)
+            continue;
+        if (errno != EAGAIN) {
+            ret = HTTP_ERR_IO;
+            break;
+        }
+        ret = wait_fd(c->fd, POLLIN, deadline);
+        if (ret != HTTP_OK)
+            break;
+    }
+    if (ret == HTTP_OK && len - total > HTTP_SPILL_MAX)
+        ret = HTTP_ERR_PROTOCOL;
+    if (ret != HTTP_OK) {
+        /* a reused connection closed before answering is not the server going away */
+        if (ret == HTTP_ERR_OVERFLOW || (ret == HTTP_ERR_CLOSED && reused))
+            http_conn_close(c);
+        else
+            conn_failed(c);
+        return ret;
+    }
+
+    c->spill_len = len - total;
+    memcpy(c->spill, buf + total, c->spill_len);
+    buf[total] = '\0';
+    resp->status = status;
+    resp->body = buf + hdr_len;
+    resp->body_len = total - hdr_len;
+    c->in_flight--;
+    c->served++;
+    conn_succeeded(c);
+    if (until_close || header_is(buf, hdr_len, "Connection", "close") ||
+        (major == 1 && minor == 0 && !header_is(buf, hdr_len, "Connection", "keep-alive")))
+        c->close_after = true;
+    if (c->close_after && c->in_flight == 0)
+        http_conn_close(c);
+    return HTTP_OK;
+}
+
+/* One request and its response; call only with nothing else in flight */
+int http_conn_request(struct HttpConn *c, const char *method, const char *path,
+                      const char *content_type, const void *body, size_t body_len,
+                      uint32_t timeout_ms, char *buf, size_t cap, struct HttpResponse *resp)
+{
+    int ret = HTTP_ERR_CLOSED;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = c->fd >= 0 && c->served > 0;
+        ret = http_conn_send(c, method, path, content_type, body, body_len, timeout_ms);
+        if (ret == HTTP_OK)
+            ret = http_conn_recv(c, timeout_ms, buf, cap, resp);
+        if (ret != HTTP_ERR_CLOSED || !reused)
+            break;
+    }
+    return ret;
+}
+
+/*
+ * Publishes what the last exchanges said about the server so other tools
+ * can judge reachability from live traffic instead of probing it.
+ */
+int http_conn_save_state(const struct HttpConn *c, const char *path)
+{
+    char text[256];
+    int64_t now = now_ms();
+    long long last_ok = c->last_ok_ms ? (long long)time(NULL) - (now - c->last_ok_ms) / 1000 : 0;
+    int n = snprintf(text, sizeof(text),
+                     "reachable=%d\nfailures=%u\nlast_ok=%lld\nretry_in_ms=%lld\n"
+                     "connects=%llu\nrequests=%llu\n",
+                     c->reachable ? 1 : 0, c->failures, last_ok,
+                     c->retry_at_ms > now ? (long long)(c->retry_at_ms - now) : 0LL,
+                     (unsigned long long)c->connects, (unsigned long long)c->requests);
+    return atomic_publish(path, text, (size_t)n, 0644, 0) == ATOMIC_OK ? HTTP_OK : HTTP_ERR_IO;
+}
+
+/* HTTP_ERR_TIMEOUT when the state is older than max_age_s and should not be trusted */
+int http_state_load(const char *path, uint32_t max_age_s, bool *reachable)
+{
+    struct stat st;
+    if (stat(path, &st) != 0)
+        return HTTP_ERR_IO;
+    if (time(NULL) - st.st_mtime > (time_t)max_age_s)
+        return HTTP_ERR_TIMEOUT;
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return HTTP_ERR_IO;
+    char line[64];
+    int ret = HTTP_ERR_PROTOCOL;
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "reachable=", 10) == 0) {
+            *reachable = line[10] == '1';
+            ret = HTTP_OK;
+            break;
+        }
+    }
+    fclose(f);
+    return ret;
+}
@@ -0,0 +1,86 @@
+#ifndef HTTP_CLIENT_H
+#define HTTP_CLIENT_H
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HTTP_OK              0
+#define HTTP_ERR_URL        -1
+#define HTTP_ERR_CONNECT    -2
+#define HTTP_ERR_IO         -3
+#define HTTP_ERR_TIMEOUT    -4
+#define HTTP_ERR_PROTOCOL   -5
+#define HTTP_ERR_OVERFLOW   -6
+#define HTTP_ERR_CLOSED     -7
+#define HTTP_ERR_BACKOFF    -8
+
+#define HTTP_BACKOFF_MIN_MS  1000
+#define HTTP_BACKOFF_MAX_MS  60000
+#define HTTP_SPILL_MAX       2048
+
+struct HttpUrl {
+    char host[128];
+    char port[8];
+    char path[256];
+};
+
+/*
+ * Body points into the caller's response buffer and is NUL terminated.
+ * Only identity-encoded responses are understood; chunked replies are
+ * reported as HTTP_ERR_PROTOCOL.
+ */
+struct HttpResponse {
+    int         status;
+    const char *body;
+    size_t      body_len;
+};
+
+/*
+ * Persistent HTTP/1.1 connection to one server. Several requests may be
+ * sent before their responses are read; responses come back in order and
+ * bytes read past the end of one are kept in spill for the next. Every
+ * exchange also updates a passive view of whether the server is
+ * reachable. After a failure, requests fail with HTTP_ERR_BACKOFF until
+ * retry_at_ms, doubling the wait up to HTTP_BACKOFF_MAX_MS; nothing ever
+ * sleeps on the backoff.
+ */
+struct HttpConn {
+    struct HttpUrl url;
+    int      fd;
+    uint32_t in_flight;
+    uint32_t served;
+    bool     close_after;
+    char     spill[HTTP_SPILL_MAX];
+    size_t   spill_len;
+    uint64_t connects;
+    uint64_t requests;
+    bool     reachable;
+    uint32_t failures;
+    int64_t  last_ok_ms;
+    int64_t  last_fail_ms;
+    uint32_t backoff_ms;
+    int64_t  retry_at_ms;
+};
+
+int http_parse_url(const char *url, struct HttpUrl *u);
+const char *http_strerror(int err);
+int http_request(const struct HttpUrl *base, const char *method, const char *path,
+                 const char *content_type, const void *body, size_t body_len,
+                 uint32_t timeout_ms, char *buf, size_t cap, struct HttpResponse *resp);
+
+int64_t http_now_ms(void);
+void http_conn_init(struct HttpConn *c, const struct HttpUrl *url);
+void http_conn_close(struct HttpConn *c);
+bool http_conn_ready(const struct HttpConn *c, int64_t now_ms);
+int http_conn_send(struct HttpConn *c, const char *method, const char *path,
+                   const char *content_type, const void *body, size_t body_len,
+                   uint32_t timeout_ms);
+int http_conn_recv(struct HttpConn *c, uint32_t timeout_ms, char *buf, size_t cap,
+                   struct HttpResponse *resp);
+int http_conn_request(struct HttpConn *c, const char *method, const char *path,
+                      const char *content_type, const void *body, size_t body_len,
+                      uint32_t timeout_ms, char *buf, size_t cap, struct HttpResponse *resp);
+int http_conn_save_state(const struct HttpConn *c, const char *path);
+int http_state_load(const char *path, uint32_t max_age_s, bool *reachable);
+
+#endif
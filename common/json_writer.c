@@ -0,0 +1,310 @@
+#include "json_writer.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+static void flush(struct JsonWriter *w)
+{
+    size_t off = 0;
+    while (off < w->len) {
+        ssize_t n = write(w->fd, w->buf + off, w->len - off);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) {
+            w->error = JSON_ERR_IO;
+            return;
+        }
+        off += (size_t)n;
+    }
+    w->len = 0;
+}
+
+static void put(struct JsonWriter *w, const char *data, size_t n)
+{
+    if (w->error)
+        return;
+    if (w->fd < 0) {
+        if (n >= w->cap - w->len) {
+            w->error = JSON_ERR_OVERFLOW;
+            return;
+        }
+        memcpy(w->buf + w->len, data, n);
+        w->len += n;
+        w->buf[w->len] = '\0';
+        w->total += n;
+        return;
+    }
+    while (n > 0 && !w->error) {
+        size_t chunk = w->cap - w->len;
+        if (chunk > n)
+            chunk = n;
+        memcpy(w->buf + w->len, data, chunk);
+        w->len += chunk;
+        w->total += chunk;
+        data += chunk;
+        n -= chunk;
+        if (w->len == w->cap)
+            flush(w);
+    }
+}
+
+static void put_str(struct JsonWriter *w, const char *s)
+{
+    put(w, s, strlen(s));
+}
+
+static void newline_indent(struct JsonWriter *w, int level)
+{
+    static const char spaces[] = "                                ";
+    if (w->compact)
+        return;
+    put(w, "\n", 1);
+    size_t n = (size_t)level * 2;
+    while (n > 0) {
+        size_t chunk = n < sizeof(spaces) - 1 ? n : sizeof(spaces) - 1;
+        put(w, spaces, chunk);
+        n -= chunk;
+    }
+}
+
+static void begin_value(struct JsonWriter *w)
+{
+    if (w->after_key) {
+        w->after_key = false;
+        return;
+    }
+    if (w->depth == 0)
+        return;
+    if (w->has_items & (1U << w->depth))
+        put(w, ",", 1);
+    w->has_items |= 1U << w->depth;
+    newline_indent(w, w->depth);
+}
+
+static void init(struct JsonWriter *w, int fd, char *buf, size_t cap, bool compact)
+{
+    memset(w, 0, sizeof(*w));
+    w->buf = buf;
+    w->cap = cap;
+    w->fd = fd;
+    w->compact = compact;
+    if (!buf || cap == 0)
+        w->error = JSON_ERR_OVERFLOW;
+    else if (fd < 0)
+        buf[0] = '\0';
+}
+
+void json_init_buffer(struct JsonWriter *w, char *buf, size_t cap, bool compact)
+{
+    init(w, -1, buf, cap, compact);
+}
+
+void json_init_fd(struct JsonWriter *w, int fd, char *buf, size_t cap, bool compact)
+{
+    init(w, fd, buf, cap, compact);
+    if (fd < 0)
+        w->error = JSON_ERR_IO;
+}
+
+int json_finish(struct JsonWriter *w)
+{
+    if (!w->error && (w->depth != 0 || w->after_key))
+        w->error = JSON_ERR_NESTING;
+    if (!w->compact && w->total > 0)
+        put(w, "\n", 1);
+    if (w->fd >= 0 && !w->error)
+        flush(w);
+    return w->error ? w->error : (int)w->total;
+}
+
+static void container_begin(struct JsonWriter *w, char open)
+{
+    begin_value(w);
+    put(w, &open, 1);
+    if (++w->depth >= JSON_MAX_DEPTH) {
+        w->error = JSON_ERR_NESTING;
+        return;
+    }
+    w->has_items &= ~(1U << w->depth);
+}
+
+static void container_end(struct JsonWriter *w, char close)
+{
+    if (w->depth == 0 || w->after_key) {
+        w->error = JSON_ERR_NESTING;
+        return;
+    }
+    if (w->has_items & (1U << w->depth))
+        newline_indent(w, w->depth - 1);
+    w->depth--;
+    put(w, &close, 1);
+}
+
+void json_object_begin(struct JsonWriter *w)
+{
+    container_begin(w, '{');
+}
+
+void json_object_end(struct JsonWriter *w)
+{
+    container_end(w, '}');
+}
+
+void json_array_begin(struct JsonWriter *w)
+{
+    container_begin(w, '[');
+}
+
+void json_array_end(struct JsonWriter *w)
+{
+    container_end(w, ']');
+}
+
+static void put_escaped(struct JsonWriter *w, const char *s)
+{
+    put(w, "\"", 1);
+    const char *run = s;
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        const char *esc = NULL;
+        char ubuf[8];
+        switch (c) {
+        case '"':  esc = "\\\""; break;
+        case '\\': esc = "\\\\"; break;
+        case '\b': esc = "\\b"; break;
+        case '\f': esc = "\\f"; break;
+        case '\n': esc = "\\n"; break;
+        case '\r': esc = "\\r"; break;
+        case '\t': esc = "\\t"; break;
+        default:
+            if (c < 0x20) {
+                snprintf(ubuf, sizeof(ubuf), "\\u%04x", c);
+                esc = ubuf;
+            }
+            break;
+        }
+        if (!esc)
+            continue;
+        put(w, run, (size_t)(s - run));
+        put_str(w, esc);
+        run = s + 1;
+    }
+    put(w, run, (size_t)(s - run));
+    put(w, "\"", 1);
+}
+
+void json_key(struct JsonWriter *w, const char *key)
+{
+    if (w->depth == 0 || w->after_key) {
+        w->error = JSON_ERR_NESTING;
+        return;
+    }
+    begin_value(w);
+    put_escaped(w, key);
+    put_str(w, w->compact ? ":" : ": ");
+    w->after_key = true;
+}
+
+void json_string(struct JsonWriter *w, const char *s)
+{
+    begin_value(w);
+    put_escaped(w, s ? s : "");
+}
+
+void json_uint(struct JsonWriter *w, uint64_t v)
+{
+    char num[24];
+    int n = snprintf(num, sizeof(num), "%llu", (unsigned long long)v);
+    begin_value(w);
+    put(w, num, (size_t)n);
+}
+
+void json_int(struct JsonWriter *w, int64_t v)
+{
+    char num[24];
+    int n = snprintf(num, sizeof(num), "%lld", (long long)v);
+    begin_value(w);
+    put(w, num, (size_t)n);
+}
+
+void json_bool(struct JsonWriter *w, bool v)
+{
+    begin_value(w);
+    put_str(w, v ? "true" : "false");
+}
+
+void json_null(struct JsonWriter *w)
+{
+    begin_value(w);
+    put_str(w, "null");
+}
+
+void json_hex(struct JsonWriter *w, const uint8_t *data, size_t len)
+{
+    static const char digits[] = "0123456789abcdef";
+    char pair[2];
+    begin_value(w);
+    put(w, "\"", 1);
+    for (size_t i = 0; i < len; i++) {
+        pair[0] = digits[data[i] >> 4];
+        pair[1] = digits[data[i] & 0xf];
+        put(w, pair, 2);
+    }
+    put(w, "\"", 1);
+}
+
+void json_base64(struct JsonWriter *w, const uint8_t *data, size_t len)
+{
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    char quad[4];
+    begin_value(w);
+    put(w, "\"", 1);
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t)data[i] << 16;
+        if (i + 1 < len)
+            v |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < len)
+            v |= data[i + 2];
+        quad[0] = alphabet[(v >> 18) & 0x3f];
+        quad[1] = alphabet[(v >> 12) & 0x3f];
+        quad[2] = i + 1 < len ? alphabet[(v >> 6) & 0x3f] : '=';
+        quad[3] = i + 2 < len ? alphabet[v & 0x3f] : '=';
+        put(w, quad, 4);
+    }
+    put(w, "\"", 1);
+}
+
+void json_raw(struct JsonWriter *w, const char *text, size_t len)
+{
+    while (len > 0 && (text[len - 1] == '\n' || text[len - 1] == '\r' ||
+                       text[len - 1] == ' ' || text[len - 1] == '\t'))
+        len--;
+    begin_value(w);
+    put(w, text, len);
+}
+
+void json_kv_string(struct JsonWriter *w, const char *key, const char *s)
+{
+    json_key(w, key);
+    json_string(w, s);
+}
+
+void json_kv_uint(struct JsonWriter *w, const char *key, uint64_t v)
+{
+    json_key(w, key);
+    json_uint(w, v);
+}
+
+void json_kv_int(struct JsonWriter *w, const char *key, int64_t v)
+{
+    json_key(w, key);
+    json_int(w, v);
+}
+
+void json_kv_bool(struct JsonWriter *w, const char *key, bool v)
+{
+    json_key(w, key);
+    json_bool(w, v);
+}
@@ -0,0 +1,56 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define JSON_OK             0
+#define JSON_ERR_OVERFLOW  -1
+#define JSON_ERR_IO        -2
+#define JSON_ERR_NESTING   -3
+
+#define JSON_MAX_DEPTH      16
+
+/*
+ * Streams JSON into a caller-owned buffer. With an fd the buffer is only a
+ * staging area and is flushed whenever it fills; without one the whole
+ * document must fit. Errors are sticky and reported by json_finish().
+ */
+struct JsonWriter {
+    char    *buf;
+    size_t   cap;
+    size_t   len;
+    size_t   total;
+    int      fd;
+    bool     compact;
+    bool     after_key;
+    int      depth;
+    uint32_t has_items;
+    int      error;
+};
+
+void json_init_buffer(struct JsonWriter *w, char *buf, size_t cap, bool compact);
+void json_init_fd(struct JsonWriter *w, int fd, char *buf, size_t cap, bool compact);
+int json_finish(struct JsonWriter *w);
+
+void json_object_begin(struct JsonWriter *w);
+void json_object_end(struct JsonWriter *w);
+void json_array_begin(struct JsonWriter *w);
+void json_array_end(struct JsonWriter *w);
+void json_key(struct JsonWriter *w, const char *key);
+void json_string(struct JsonWriter *w, const char *s);
+void json_uint(struct JsonWriter *w, uint64_t v);
+void json_int(struct JsonWriter *w, int64_t v);
+void json_bool(struct JsonWriter *w, bool v);
+void json_null(struct JsonWriter *w);
+void json_hex(struct JsonWriter *w, const uint8_t *data, size_t len);
+void json_base64(struct JsonWriter *w, const uint8_t *data, size_t len);
+/* Splices an already serialised JSON value; the caller vouches for its syntax */
+void json_raw(struct JsonWriter *w, const char *text, size_t len);
+
+void json_kv_string(struct JsonWriter *w, const char *key, const char *s);
+void json_kv_uint(struct JsonWriter *w, const char *key, uint64_t v);
+void json_kv_int(struct JsonWriter *w, const char *key, int64_t v);
+void json_kv_bool(struct JsonWriter *w, const char *key, bool v);
+
+#endif
@@ -0,0 +1,615 @@
+#include "atomic_file.h"
+#include "cbor_writer.h"
+#include "http_client.h"
+#include "json_writer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_START(name) \
+    printf("\n[TEST] %s...\n", name)
+#define TEST_ASSERT(condition, msg) \
+    do { \
+        if (condition) { \
+            printf("   %s\n", msg); \
+            tests_passed++; \
+        } else { \
+            printf("   FAILED: %s\n", msg); \
+            tests_failed++; \
+        } \
+    } while(0)
+#define TEST_END() \
+    printf("  Done.\n")
+
+static void write_sample(struct JsonWriter *w)
+{
+    json_object_begin(w);
+    json_kv_uint(w, "count", 3);
+    json_kv_int(w, "delta", -2);
+    json_kv_bool(w, "ok", true);
+    json_key(w, "list");
+    json_array_begin(w);
+    json_uint(w, 1);
+    json_null(w);
+    json_array_end(w);
+    json_key(w, "empty");
+    json_object_begin(w);
+    json_object_end(w);
+    json_object_end(w);
+}
+
+static void test_compact(void)
+{
+    TEST_START("Compact Output");
+    char buf[256];
+    struct JsonWriter w;
+    json_init_buffer(&w, buf, sizeof(buf), true);
+    write_sample(&w);
+    int n = json_finish(&w);
+    const char *expect = "{\"count\":3,\"delta\":-2,\"ok\":true,\"list\":[1,null],\"empty\":{}}";
+    TEST_ASSERT(n == (int)strlen(expect), "Returns document length");
+    TEST_ASSERT(strcmp(buf, expect) == 0, "Compact document matches");
+    TEST_END();
+}
+
+static void test_pretty(void)
+{
+    TEST_START("Pretty Output");
+    char buf[256];
+    struct JsonWriter w;
+    json_init_buffer(&w, buf, sizeof(buf), false);
+    write_sample(&w);
+    TEST_ASSERT(json_finish(&w) > 0, "Document written");
+    const char *expect =
+        "{\n"
+        "  \"count\": 3,\n"
+        "  \"delta\": -2,\n"
+        "  \"ok\": true,\n"
+        "  \"list\": [\n"
+        "    1,\n"
+        "    null\n"
+        "  ],\n"
+        "  \"empty\": {}\n"
+        "}\n";
+    TEST_ASSERT(strcmp(buf, expect) == 0, "Indented document matches");
+    TEST_END();
+}
+
+static void test_escaping(void)
+{
+    TEST_START("String Escaping");
+    char buf[256];
+    struct JsonWriter w;
+    json_init_buffer(&w, buf, sizeof(buf), true);
+    json_object_begin(&w);
+    json_kv_string(&w, "msg", "say \"hi\"\\\n\t\x01 25\xc2\xb0" "C");
+    uint8_t bytes[] = { 0xde, 0xad, 0x01 };
+    json_key(&w, "hex");
+    json_hex(&w, bytes, sizeof(bytes));
+    json_object_end(&w);
+    TEST_ASSERT(json_finish(&w) > 0, "Document written");
+    TEST_ASSERT(strcmp(buf, "{\"msg\":\"say \\\"hi\\\"\\\\\\n\\t\\u0001 25\xc2\xb0" "C\","
+                            "\"hex\":\"dead01\"}") == 0,
+                "Quotes, backslashes and control characters escaped, UTF-8 kept");
+    TEST_END();
+}
+
+static void test_overflow(void)
+{
+    TEST_START("Buffer Overflow");
+    char buf[16];
+    struct JsonWriter w;
+    json_init_buffer(&w, buf, sizeof(buf), true);
+    write_sample(&w);
+    TEST_ASSERT(json_finish(&w) == JSON_ERR_OVERFLOW, "Overflow reported");
+    TEST_ASSERT(strlen(buf) < sizeof(buf), "Buffer stays terminated");
+    json_init_buffer(&w, buf, sizeof(buf), true);
+    json_object_begin(&w);
+    json_key(&w, "a");
+    TEST_ASSERT(json_finish(&w) == JSON_ERR_NESTING, "Unterminated document reported");
+    json_init_buffer(&w, buf, sizeof(buf), true);
+    json_uint(&w, 1);
+    json_object_end(&w);
+    TEST_ASSERT(json_finish(&w) == JSON_ERR_NESTING, "Unbalanced close reported");
+    TEST_END();
+}
+
+static void test_fd_stream(void)
+{
+    TEST_START("Streaming to a File Descriptor");
+    int fds[2];
+    TEST_ASSERT(pipe(fds) == 0, "Pipe created");
+    char stage[8];
+    struct JsonWriter w;
+    json_init_fd(&w, fds[1], stage, sizeof(stage), true);
+    json_array_begin(&w);
+    for (int i = 0; i < 100; i++)
+        json_uint(&w, (uint64_t)i);
+    json_array_end(&w);
+    int n = json_finish(&w);
+    close(fds[1]);
+    char out[512];
+    ssize_t got = read(fds[0], out, sizeof(out) - 1);
+    close(fds[0]);
+    TEST_ASSERT(n > (int)sizeof(stage) && got == n, "Document larger than staging buffer streamed");
+    out[got > 0 ? got : 0] = '\0';
+    TEST_ASSERT(strncmp(out, "[0,1,2,", 7) == 0 && strcmp(out + got - 4, ",99]") == 0,
+                "Streamed content intact");
+    json_init_fd(&w, -1, stage, sizeof(stage), true);
+    TEST_ASSERT(json_finish(&w) == JSON_ERR_IO, "Invalid fd reported");
+    TEST_END();
+}
+
+static bool cbor_equals(const struct CborWriter *w, const uint8_t *expect, size_t len)
+{
+    return cbor_finish(w) == (int)len && memcmp(w->buf, expect, len) == 0;
+}
+
+static void test_cbor_encoding(void)
+{
+    TEST_START("CBOR Encoding");
+    uint8_t buf[64];
+    struct CborWriter w;
+    cbor_init(&w, buf, sizeof(buf));
+    cbor_uint(&w, 10);
+    cbor_uint(&w, 24);
+    cbor_uint(&w, 1000);
+    cbor_uint(&w, 1000000);
+    cbor_uint(&w, 1000000000000ULL);
+    static const uint8_t uints[] = {
+        0x0a, 0x18, 0x18, 0x19, 0x03, 0xe8, 0x1a, 0x00, 0x0f, 0x42, 0x40,
+        0x1b, 0x00, 0x00, 0x00, 0xe8, 0xd4, 0xa5, 0x10, 0x00,
+    };
+    TEST_ASSERT(cbor_equals(&w, uints, sizeof(uints)), "Unsigned integers use shortest heads");
+    cbor_init(&w, buf, sizeof(buf));
+    cbor_int(&w, -1);
+    cbor_int(&w, -100);
+    cbor_int(&w, -70002);
+    static const uint8_t nints[] = { 0x20, 0x38, 0x63, 0x3a, 0x00, 0x01, 0x11, 0x71 };
+    TEST_ASSERT(cbor_equals(&w, nints, sizeof(nints)), "Negative integers encoded");
+    cbor_init(&w, buf, sizeof(buf));
+    cbor_map(&w, 2);
+    cbor_uint(&w, 1);
+    cbor_bool(&w, true);
+    cbor_int(&w, -2);
+    cbor_array(&w, 3);
+    cbor_text(&w, "a");
+    cbor_bytes(&w, "\x01\x02", 2);
+    cbor_null(&w);
+    static const uint8_t nested[] = {
+        0xa2, 0x01, 0xf5, 0x21, 0x83, 0x61, 0x61, 0x42, 0x01, 0x02, 0xf6,
+    };
+    TEST_ASSERT(cbor_equals(&w, nested, sizeof(nested)), "Maps, arrays, text and bytes encoded");
+    cbor_init(&w, buf, 4);
+    cbor_text(&w, "too long");
+    cbor_bool(&w, false);
+    TEST_ASSERT(cbor_finish(&w) == CBOR_ERR_OVERFLOW, "Overflow reported");
+    TEST_END();
+}
+
+#define TEST_ATOMIC_DIR   "/tmp/pac_atomic_test"
+#define TEST_ATOMIC_PATH  TEST_ATOMIC_DIR "/state.json"
+
+static int read_file(const char *path, char *buf, size_t cap)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return -1;
+    size_t n = fread(buf, 1, cap - 1, f);
+    buf[n] = '\0';
+    fclose(f);
+    return (int)n;
+}
+
+static int count_entries(const char *path)
+{
+    DIR *d = opendir(path);
+    if (!d)
+        return -1;
+    int n = 0;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (strcmp(e->d_name, ".") != 0 && strcmp(e->d_name, "..") != 0)
+            n++;
+    }
+    closedir(d);
+    return n;
+}
+
+static void test_atomic_publish(void)
+{
+    TEST_START("Atomic Publish");
+    char buf[64];
+    mkdir(TEST_ATOMIC_DIR, 0755);
+    unlink(TEST_ATOMIC_PATH);
+    TEST_ASSERT(atomic_publish(TEST_ATOMIC_PATH, "first", 5, 0644, 0) == ATOMIC_OK,
+                "First version published");
+    TEST_ASSERT(read_file(TEST_ATOMIC_PATH, buf, sizeof(buf)) == 5 && strcmp(buf, "first") == 0,
+                "First version readable");
+    TEST_ASSERT(atomic_publish(TEST_ATOMIC_PATH, "second!", 7, 0644, ATOMIC_SYNC_DIR) == ATOMIC_OK,
+                "Second version published with directory sync");
+    TEST_ASSERT(read_file(TEST_ATOMIC_PATH, buf, sizeof(buf)) == 7 && strcmp(buf, "second!") == 0,
+                "Second version replaced the first");
+    struct stat st;
+    TEST_ASSERT(stat(TEST_ATOMIC_PATH, &st) == 0 && (st.st_mode & 0777) == 0644,
+                "Requested mode applied");
+
+    struct AtomicFile af;
+    TEST_ASSERT(atomic_file_open(&af, TEST_ATOMIC_PATH, 0644) == ATOMIC_OK, "Temporary opened");
+    TEST_ASSERT(write(af.fd, "partial", 7) == 7, "Partial data written");
+    TEST_ASSERT(read_file(TEST_ATOMIC_PATH, buf, sizeof(buf)) == 7 && strcmp(buf, "second!") == 0,
+                "Readers still see the previous version");
+    atomic_file_abort(&af);
+    TEST_ASSERT(count_entries(TEST_ATOMIC_DIR) == 1, "No temporary files left behind");
+    TEST_ASSERT(atomic_publish(TEST_ATOMIC_DIR "/", "x", 1, 0644, 0) == ATOMIC_ERR_PATH,
+                "Directory path rejected");
+    TEST_ASSERT(atomic_publish("/nonexistent_dir/state", "x", 1, 0644, 0) == ATOMIC_ERR_IO,
+                "Missing directory reported");
+    TEST_END();
+}
+
+static void test_atomic_wait(void)
+{
+    TEST_START("Atomic Publish Notification");
+    TEST_ASSERT(atomic_wait(TEST_ATOMIC_PATH, 50) == ATOMIC_TIMEOUT, "Timeout without a publish");
+    pid_t pid = fork();
+    if (pid == 0) {
+        usleep(50000);
+        _exit(atomic_publish(TEST_ATOMIC_PATH, "third", 5, 0644, 0) == ATOMIC_OK ? 0 : 1);
+    }
+    TEST_ASSERT(atomic_wait(TEST_ATOMIC_PATH, 5000) == ATOMIC_OK, "Woken by the publish");
+    int status = 0;
+    waitpid(pid, &status, 0);
+    char buf[64];
+    TEST_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+                read_file(TEST_ATOMIC_PATH, buf, sizeof(buf)) == 5 && strcmp(buf, "third") == 0,
+                "Published content visible after wake-up");
+    unlink(TEST_ATOMIC_PATH);
+    rmdir(TEST_ATOMIC_DIR);
+    TEST_END();
+}
+
+static void test_base64_raw(void)
+{
+    TEST_START("Base64 and Raw Values");
+    char buf[256];
+    struct JsonWriter w;
+    json_init_buffer(&w, buf, sizeof(buf), true);
+    json_array_begin(&w);
+    json_base64(&w, (const uint8_t *)"", 0);
+    json_base64(&w, (const uint8_t *)"f", 1);
+    json_base64(&w, (const uint8_t *)"fo", 2);
+    json_base64(&w, (const uint8_t *)"foobar", 6);
+    json_raw(&w, "{\"a\":1}\n", 8);
+    json_array_end(&w);
+    TEST_ASSERT(json_finish(&w) > 0 &&
+                strcmp(buf, "[\"\",\"Zg==\",\"Zm8=\",\"Zm9vYmFy\",{\"a\":1}]") == 0,
+                "RFC 4648 vectors and spliced value");
+    TEST_END();
+}
+
+/* Serves one canned response and exits; returns the listening port */
+static int start_http_server(const char *reply, pid_t *pid)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t len = sizeof(addr);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 1) != 0 ||
+        getsockname(fd, (struct sockaddr *)&addr, &len) != 0)
+        return -1;
+    *pid = fork();
+    if (*pid == 0) {
+        int c = accept(fd, NULL, NULL);
+        char req[1024];
+        size_t got = 0;
+        ssize_t n;
+        while (got < sizeof(req) - 1 && (n = read(c, req + got, sizeof(req) - 1 - got)) > 0) {
+            got += (size_t)n;
+            req[got] = '\0';
+            char *end = strstr(req, "\r\n\r\n");
+            if (end && (strstr(req, "GET ") == req || strlen(end + 4) >= 4))
+                break;
+        }
+        int ok = strstr(req, "Host: 127.0.0.1:") != NULL;
+        if (write(c, reply, strlen(reply)) < 0)
+            ok = 0;
+        close(c);
+        _exit(ok ? 0 : 1);
+    }
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+static void test_http_client(void)
+{
+    TEST_START("HTTP Client");
+    struct HttpUrl url;
+    TEST_ASSERT(http_parse_url("http://10.0.2.2:8080", &url) == HTTP_OK &&
+                strcmp(url.host, "10.0.2.2") == 0 && strcmp(url.port, "8080") == 0 &&
+                url.path[0] == '\0', "Host and port parsed");
+    TEST_ASSERT(http_parse_url("http://[::1]/api/", &url) == HTTP_OK && strcmp(url.host, "::1") == 0 &&
+                strcmp(url.port, "80") == 0 && strcmp(url.path, "/api") == 0,
+                "IPv6 literal, default port and path prefix");
+    TEST_ASSERT(http_parse_url("https://verifier", &url) == HTTP_ERR_URL &&
+                http_parse_url("http://host:port", &url) == HTTP_ERR_URL, "Unsupported URLs rejected");
+
+    pid_t pid;
+    int port = start_http_server("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                                 "content-length: 11\r\n\r\n{\"ok\":true}", &pid);
+    char base[64], buf[512];
+    snprintf(base, sizeof(base), "http://127.0.0.1:%d", port);
+    struct HttpResponse resp;
+    int ret = http_parse_url(base, &url) == HTTP_OK
+        ? http_request(&url, "POST", "/verify", "application/json", "{\"x\":1}", 7, 2000,
+                       buf, sizeof(buf), &resp)
+        : HTTP_ERR_URL;
+    int status = 1;
+    waitpid(pid, &status, 0);
+    TEST_ASSERT(ret == HTTP_OK && resp.status == 200 && resp.body_len == 11 &&
+                strcmp(resp.body, "{\"ok\":true}") == 0, "POST response parsed");
+    TEST_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0, "Request carried a Host header");
+
+    port = start_http_server("HTTP/1.0 404 NOT FOUND\r\n\r\nmissing", &pid);
+    snprintf(base, sizeof(base), "http://127.0.0.1:%d", port);
+    http_parse_url(base, &url);
+    ret = http_request(&url, "GET", "/nonce", NULL, NULL, 0, 2000, buf, sizeof(buf), &resp);
+    waitpid(pid, &status, 0);
+    TEST_ASSERT(ret == HTTP_OK && resp.status == 404 && strcmp(resp.body, "missing") == 0,
+                "Body delimited by connection close");
+
+    port = start_http_server("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n0\r\n\r\n", &pid);
+    snprintf(base, sizeof(base), "http://127.0.0.1:%d", port);
+    http_parse_url(base, &url);
+    ret = http_request(&url, "GET", "/", NULL, NULL, 0, 2000, buf, sizeof(buf), &resp);
+    waitpid(pid, &status, 0);
+    TEST_ASSERT(ret == HTTP_ERR_PROTOCOL, "Chunked replies rejected");
+
+    port = start_http_server("", &pid);
+    kill(pid, SIGKILL);
+    waitpid(pid, &status, 0);
+    snprintf(base, sizeof(base), "http://127.0.0.1:%d", port);
+    http_parse_url(base, &url);
+    TEST_ASSERT(http_request(&url, "GET", "/", NULL, NULL, 0, 2000, buf, sizeof(buf), &resp) ==
+                HTTP_ERR_CONNECT, "Closed port reports a connection failure");
+    TEST_END();
+}
+
+/* Reads one request, body included, from c; leftover bytes stay in req */
+static int read_request(int c, char *req, size_t cap, size_t *have)
+{
+    for (;;) {
+        req[*have] = '\0';
+        char *end = strstr(req, "\r\n\r\n");
+        if (end) {
+            const char *cl = strstr(req, "Content-Length: ");
+            size_t body = cl && cl < end ? strtoul(cl + 16, NULL, 10) : 0;
+            size_t used = (size_t)(end + 4 - req) + body;
+            if (*have >= used) {
+                int ok = strstr(req, "Host: 127.0.0.1:") != NULL &&
+                         strstr(req, "Connection: close") == NULL;
+                memmove(req, req + used, *have - used);
+                *have -= used;
+                return ok;
+            }
+        }
+        ssize_t n = read(c, req + *have, cap - 1 - *have);
+        if (n <= 0)
+            return -1;
+        *have += (size_t)n;
+    }
+}
+
+/*
+ * Keep-alive server: accepts conns connections in turn and answers
+ * per_conn requests on each with the next canned reply. With batch set it
+ * waits for all requests of a connection and answers them in one write.
+ */
+static int start_keepalive_server(const char *const *replies, int per_conn, int conns,
+                                  bool batch, pid_t *pid)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t len = sizeof(addr);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 4) != 0 ||
+        getsockname(fd, (struct sockaddr *)&addr, &len) != 0)
+        return -1;
+    *pid = fork();
+    if (*pid == 0) {
+        int ok = 1, next = 0;
+        for (int i = 0; i < conns; i++) {
+            int c = accept(fd, NULL, NULL);
+            char req[2048], out[2048] = "";
+            size_t have = 0;
+            for (int r = 0; r < per_conn; r++) {
+                if (read_request(c, req, sizeof(req), &have) != 1)
+                    ok = 0;
+                if (batch) {
+                    strcat(out, replies[next++]);
+                } else if (write(c, replies[next], strlen(replies[next])) < 0) {
+                    ok = 0;
+                } else {
+                    next++;
+                }
+            }
+            if (batch && write(c, out, strlen(out)) < 0)
+                ok = 0;
+            close(c);
+        }
+        _exit(ok ? 0 : 1);
+    }
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+static void test_http_keepalive(void)
+{
+    TEST_START("HTTP Keep-Alive");
+    static const char *const nonce_verify[] = {
+        "HTTP/1.1 200 OK\r\nContent-Length: 15\r\n\r\n{\"nonce\":\"ab1\"}",
+        "HTTP/1.1 200 OK\r\nContent-Length: 14\r\n\r\n{\"allow\":true}",
+    };
+    struct HttpUrl url;
+    struct HttpConn conn;
+    struct HttpResponse resp;
+    char base[64], buf[512];
+    pid_t pid;
+    int status = 1;
+
+    int port = start_keepalive_server(nonce_verify, 2, 1, false, &pid);
+    snprintf(base, sizeof(base), "http://127.0.0.1:%d", port);
+    http_parse_url(base, &url);
+    http_conn_init(&conn, &url);
+    int ret = http_conn_request(&conn, "GET", "/nonce", NULL, NULL, 0, 2000, buf, sizeof(buf), &resp);
+    TEST_ASSERT(ret == HTTP_OK && strcmp(resp.body, "{\"nonce\":\"ab1\"}") == 0, "Nonce fetched");
+    ret = http_conn_request(&conn, "POST", "/verify", "application/json", "{}", 2, 2000,
+                            buf, sizeof(buf), &resp);
+    TEST_ASSERT(ret == HTTP_OK && strcmp(resp.body, "{\"allow\":true}") == 0,
+                "Token verified on the same connection");
+    TEST_ASSERT(conn.connects == 1 && conn.requests == 2 && conn.reachable,
+                "Two requests, one connection");
+    http_conn_close(&conn);
+    waitpid(pid, &status, 0);
+    TEST_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0, "Requests kept the connection open");
+
+    port = start_keepalive_server(nonce_verify, 2, 1, true, &pid);
+    snprintf(base, sizeof(base), "http://127.0.0.1:%d", port);
+    http_parse_url(base, &url);
+    http_conn_init(&conn, &url);
+    ret = http_conn_send(&conn, "GET", "/nonce", NULL, NULL, 0, 2000);
+    if (ret == HTTP_OK)
+        ret = http_conn_send(&conn, "GET", "/stats", NULL, NULL, 0, 2000);
+    TEST_ASSERT(ret == HTTP_OK && conn.in_flight == 2, "Two requests pipelined");
+    ret = http_conn_recv(&conn, 2000, buf, sizeof(buf), &resp);
+    TEST_ASSERT(ret == HTTP_OK && strcmp(resp.body, "{\"nonce\":\"ab1\"}") == 0 && conn.spill_len > 0,
+                "First response parsed, second kept back");
+    ret = http_conn_recv(&conn, 2000, buf, sizeof(buf), &resp);
+    TEST_ASSERT(ret == HTTP_OK && strcmp(resp.body, "{\"allow\":true}") == 0 && conn.in_flight == 0,
+                "Second response served from the spill");
+    http_conn_close(&conn);
+    waitpid(pid, &status, 0);
+
+    static const char *const closing[] = {
+        "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 2\r\n\r\nok",
+        "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok",
+    };
+    port = start_keepalive_server(closing, 1, 2, false, &pid);
+    snprintf(base, sizeof(base), "http://127.0.0.1:%d", port);
+    http_parse_url(base, &url);
+    http_conn_init(&conn, &url);
+    ret = http_conn_request(&conn, "GET", "/", NULL, NULL, 0, 2000, buf, sizeof(buf), &resp);
+    TEST_ASSERT(ret == HTTP_OK && conn.fd < 0, "Connection: close honoured");
+    ret = http_conn_request(&conn, "GET", "/", NULL, NULL, 0, 2000, buf, sizeof(buf), &resp);
+    TEST_ASSERT(ret == HTTP_OK && conn.connects == 2, "Next request reconnects");
+    http_conn_close(&conn);
+    waitpid(pid, &status, 0);
+
+    static const char *const dropped[] = {
+        "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok",
+        "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok",
+    };
+    port = start_keepalive_server(dropped, 1, 2, false, &pid);
+    snprintf(base, sizeof(base), "http://127.0.0.1:%d", port);
+    http_parse_url(base, &url);
+    http_conn_init(&conn, &url);
+    http_conn_request(&conn, "GET", "/", NULL, NULL, 0, 2000, buf, sizeof(buf), &resp);
+    usleep(50000);
+    ret = http_conn_request(&conn, "GET", "/", NULL, NULL, 0, 2000, buf, sizeof(buf), &resp);
+    TEST_ASSERT(ret == HTTP_OK && conn.connects == 2 && conn.failures == 0,
+                "Idle connection closed by the server is replaced");
+    http_conn_close(&conn);
+    waitpid(pid, &status, 0);
+
+    static const char *const bad_length[] = {
+        "HTTP/1.1 200 OK\r\nContent-Length: -1\r\n\r\nok",
+        "HTTP/1.1 200 OK\r\nContent-Length: 18446744073709551616\r\n\r\nok",
+        "HTTP/1.1 200 OK\r\nContent-Length: 4096\r\n\r\nok",
+    };
+    port = start_keepalive_server(bad_length, 1, 3, false, &pid);
+    snprintf(base, sizeof(base), "http://127.0.0.1:%d", port);
+    http_parse_url(base, &url);
+    http_conn_init(&conn, &url);
+    int rejected = 0;
+    for (int i = 0; i < 3; i++) {
+        conn.retry_at_ms = 0;
+        ret = http_conn_request(&conn, "GET", "/", NULL, NULL, 0, 2000, buf, sizeof(buf), &resp);
+        rejected += ret == HTTP_ERR_PROTOCOL && resp.body_len == 0;
+    }
+    TEST_ASSERT(rejected == 3, "Negative, overflowing and oversized Content-Length rejected");
+    http_conn_close(&conn);
+    waitpid(pid, &status, 0);
+
+    port = start_http_server("", &pid);
+    kill(pid, SIGKILL);
+    waitpid(pid, &status, 0);
+    snprintf(base, sizeof(base), "http://127.0.0.1:%d", port);
+    http_parse_url(base, &url);
+    http_conn_init(&conn, &url);
+    ret = http_conn_request(&conn, "GET", "/nonce", NULL, NULL, 0, 2000, buf, sizeof(buf), &resp);
+    TEST_ASSERT(ret == HTTP_ERR_CONNECT && !conn.reachable && conn.failures == 1 &&
+                conn.backoff_ms == HTTP_BACKOFF_MIN_MS, "Failure starts the backoff");
+    int64_t t0 = http_now_ms();
+    ret = http_conn_request(&conn, "GET", "/nonce", NULL, NULL, 0, 2000, buf, sizeof(buf), &resp);
+    TEST_ASSERT(ret == HTTP_ERR_BACKOFF && conn.connects == 0 && http_now_ms() - t0 < 100,
+                "Backoff refuses without waiting or connecting");
+    conn.retry_at_ms = 0;
+    http_conn_request(&conn, "GET", "/nonce", NULL, NULL, 0, 2000, buf, sizeof(buf), &resp);
+    TEST_ASSERT(conn.failures == 2 && conn.backoff_ms == 2 * HTTP_BACKOFF_MIN_MS,
+                "Backoff doubles");
+    conn.backoff_ms = HTTP_BACKOFF_MAX_MS;
+    conn.retry_at_ms = 0;
+    http_conn_request(&conn, "GET", "/nonce", NULL, NULL, 0, 2000, buf, sizeof(buf), &resp);
+    TEST_ASSERT(conn.backoff_ms == HTTP_BACKOFF_MAX_MS, "Backoff capped");
+
+    char state[64];
+    bool reachable = true;
+    snprintf(state, sizeof(state), "/tmp/test_http_state.%d", (int)getpid());
+    TEST_ASSERT(http_conn_save_state(&conn, state) == HTTP_OK &&
+                http_state_load(state, 60, &reachable) == HTTP_OK && !reachable,
+                "Reachability published");
+    struct timespec old[2] = { { 1000000000, 0 }, { 1000000000, 0 } };
+    utimensat(AT_FDCWD, state, old, 0);
+    TEST_ASSERT(http_state_load(state, 60, &reachable) == HTTP_ERR_TIMEOUT, "Stale state ignored");
+    unlink(state);
+    TEST_END();
+}
+
+int main(void)
+{
+    printf("PAC Common Library Test Suite\n");
+    test_compact();
+    test_pretty();
+    test_escaping();
+    test_overflow();
+    test_fd_stream();
+    test_cbor_encoding();
+    test_atomic_publish();
+    test_atomic_wait();
+    test_base64_raw();
+    test_http_client();
+    test_http_keepalive();
+    printf("\n\n");
+    printf("  TEST SUMMARY                                              \n");
+    printf("\n");
+    printf("  Passed: %3d                                               \n", tests_passed);
+    printf("  Failed: %3d                                               \n", tests_failed);
+    printf("\n");
+    if (tests_failed == 0) {
+        printf("\n All tests PASSED! Common library is working correctly.\n\n");
+        return 0;
+    } else {
+        printf("\n Some tests FAILED. Please review the output above.\n\n");
+        return 1;
+    }
+}
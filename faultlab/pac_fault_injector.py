@@ -185,7 +185,9 @@ class FaultInjector:
                 data = bytearray(f.read())
                 size = len(data)
                 
-                if size != 72:
+                aligned = size >= 40 and data[36:40] == (0xA771A5EC).to_bytes(4, 'little')
+                page_b = 4096 if aligned else 36
+                if not aligned and size < 72:
                     self.log(f" Warning: Expected 72-byte journal, got {size} bytes")
                 
                 
@@ -201,7 +203,7 @@ class FaultInjector:
                         'location': 'page_a_crc'
                     })
                 
-                for byte_offset in range(68, min(72, size)):
+                for byte_offset in range(page_b + 32, min(page_b + 36, size)):
                     old_byte = data[byte_offset]
                     data[byte_offset] = 0xFF  
                     corrupted_positions.append({
@@ -214,7 +216,7 @@ class FaultInjector:
                 f.seek(0)
                 f.write(data)
             
-            self.log(f" ZEROED BOTH journal CRCs (Page A: bytes 32-35, Page B: bytes 68-71)")
+            self.log(f" ZEROED BOTH journal CRCs (Page A: bytes 32-35, Page B: bytes {page_b + 32}-{page_b + 35})")
             self.log(f"  -> All CRC bytes set to 0xFF (GUARANTEED invalid)")
             
             fault_info = {
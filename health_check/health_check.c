@@ -1,42 +1,18 @@
 #include "health_check.h"
+#include "health_score.h"
+#include "atomic_file.h"
+#include "cbor_writer.h"
+#include "json_writer.h"
+#include "net_probe.h"
+#include "sysfs_sampler.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/statvfs.h>
-#include <dirent.h>
 #include <errno.h>
-
-static int read_file_line(const char *path, char *buf, size_t bufsize)
-{
-    FILE *f = fopen(path, "r");
-    if (!f)
-        return -1;
-    if (!fgets(buf, bufsize, f)) {
-        fclose(f);
-        return -1;
-    }
-    size_t len = strlen(buf);
-    if (len > 0 && buf[len-1] == '\n')
-        buf[len-1] = '\0';
-    fclose(f);
-    return 0;
-}
-
-static long read_file_long(const char *path)
-{
-    char buf[64];
-    if (read_file_line(path, buf, sizeof(buf)) < 0)
-        return -1;
-    return atol(buf);
-}
-
-static bool file_exists(const char *path)
-{
-    struct stat st;
-    return (stat(path, &st) == 0);
-}
+#include <pthread.h>
 
 static bool is_char_device(const char *path)
 {
@@ -67,37 +43,34 @@ bool health_check_watchdog(struct HealthCheckResult *result)
     return false;
 }
 
+static pthread_mutex_t sampler_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct SysfsSampler sampler;
+static bool sampler_ready = false;
+
+static void sample_sysfs(struct SysfsSample *sample)
+{
+    pthread_mutex_lock(&sampler_lock);
+    if (!sampler_ready) {
+        sampler_init(&sampler, NULL, SAMPLER_RESCAN_SEC);
+        sampler_ready = true;
+    }
+    sampler_read(&sampler, sample);
+    pthread_mutex_unlock(&sampler_lock);
+}
+
 bool health_check_ecc(uint32_t threshold, struct HealthCheckResult *result)
 {
     memset(result, 0, sizeof(*result));
-    if (!file_exists("/sys/devices/system/edac")) {
+    struct SysfsSample sample;
+    sample_sysfs(&sample);
+    if (!sample.edac_present) {
         result->ok = true;
         snprintf(result->message, sizeof(result->message),
                  "EDAC not available, assuming OK");
         return true;
     }
-    uint32_t ce_total = 0;
-    uint32_t ue_total = 0;
-    DIR *edac_dir = opendir("/sys/devices/system/edac/mc");
-    if (edac_dir) {
-        struct dirent *entry;
-        while ((entry = readdir(edac_dir)) != NULL) {
-            if (strncmp(entry->d_name, "mc", 2) != 0)
-                continue;
-            char path[256];
-            snprintf(path, sizeof(path),
-                     "/sys/devices/system/edac/mc/%s/ce_count", entry->d_name);
-            long ce = read_file_long(path);
-            if (ce >= 0)
-                ce_total += ce;
-            snprintf(path, sizeof(path),
-                     "/sys/devices/system/edac/mc/%s/ue_count", entry->d_name);
-            long ue = read_file_long(path);
-            if (ue >= 0)
-                ue_total += ue;
-        }
-        closedir(edac_dir);
-    }
+    uint32_t ce_total = sample.ce_total;
+    uint32_t ue_total = sample.ue_total;
     result->value = ce_total;
     if (ue_total > 0) {
         result->ok = false;
@@ -143,21 +116,22 @@ bool health_check_storage(uint8_t min_free_pct, struct HealthCheckResult *result
     return false;
 }
 
-bool health_check_network(uint8_t timeout_sec, struct HealthCheckResult *result)
+bool health_check_network_targets(const char *targets, uint32_t timeout_ms,
+                                  struct HealthCheckResult *result)
 {
     memset(result, 0, sizeof(*result));
-    const char *targets[] = {"8.8.8.8", "1.1.1.1", NULL};
-    for (int i = 0; targets[i] != NULL; i++) {
-        char cmd[256];
-        snprintf(cmd, sizeof(cmd),
-                 "ping -c 1 -W %u %s >/dev/null 2>&1",
-                 timeout_sec, targets[i]);
-        if (system(cmd) == 0) {
-            result->ok = true;
-            snprintf(result->message, sizeof(result->message),
-                     "Network reachable (tested: %s)", targets[i]);
-            return true;
-        }
+    struct NetProbeTarget list[NET_PROBE_MAX_TARGETS];
+    int count = targets && *targets
+        ? net_probe_parse_targets(targets, list, NET_PROBE_MAX_TARGETS)
+        : net_probe_default_targets(list, NET_PROBE_MAX_TARGETS);
+    struct NetProbeResult probe;
+    if (count > 0 && net_probe_first(list, count, timeout_ms, &probe) >= 0) {
+        result->ok = true;
+        result->value = probe.rtt_ms;
+        snprintf(result->message, sizeof(result->message),
+                 "Network reachable (tested: %s via %s, %ums)",
+                 list[probe.target].host, probe.method, probe.rtt_ms);
+        return true;
     }
     result->ok = false;
     snprintf(result->message, sizeof(result->message),
@@ -165,6 +139,11 @@ bool health_check_network(uint8_t timeout_sec, struct HealthCheckResult *result)
     return false;
 }
 
+bool health_check_network(uint8_t timeout_sec, struct HealthCheckResult *result)
+{
+    return health_check_network_targets(NULL, timeout_sec * 1000U, result);
+}
+
 bool health_check_memory(uint32_t min_free_kb, struct HealthCheckResult *result)
 {
     memset(result, 0, sizeof(*result));
@@ -213,55 +192,10 @@ bool health_check_memory(uint32_t min_free_kb, struct HealthCheckResult *result)
 bool health_check_temperature(uint8_t max_celsius, struct HealthCheckResult *result)
 {
     memset(result, 0, sizeof(*result));
-    uint8_t max_temp = 0;
-    bool temp_found = false;
-    DIR *thermal_dir = opendir("/sys/class/thermal");
-    if (thermal_dir) {
-        struct dirent *entry;
-        while ((entry = readdir(thermal_dir)) != NULL) {
-            if (strncmp(entry->d_name, "thermal_zone", 12) != 0)
-                continue;
-            char path[256];
-            snprintf(path, sizeof(path),
-                     "/sys/class/thermal/%s/temp", entry->d_name);
-            long temp_millic = read_file_long(path);
-            if (temp_millic > 0) {
-                uint8_t temp_c = temp_millic / 1000;
-                if (temp_c > max_temp)
-                    max_temp = temp_c;
-                temp_found = true;
-            }
-        }
-        closedir(thermal_dir);
-    }
-    DIR *hwmon_dir = opendir("/sys/class/hwmon");
-    if (hwmon_dir) {
-        struct dirent *entry;
-        while ((entry = readdir(thermal_dir)) != NULL) {
-            char hwmon_path[256];
-            snprintf(hwmon_path, sizeof(hwmon_path),
-                     "/sys/class/hwmon/%s", entry->d_name);
-            DIR *sensor_dir = opendir(hwmon_path);
-            if (!sensor_dir)
-                continue;
-            struct dirent *sensor;
-            while ((sensor = readdir(sensor_dir)) != NULL) {
-                if (strstr(sensor->d_name, "temp") && strstr(sensor->d_name, "_input")) {
-                    char path[512];
-                    snprintf(path, sizeof(path), "%s/%s", hwmon_path, sensor->d_name);
-                    long temp_millic = read_file_long(path);
-                    if (temp_millic > 0) {
-                        uint8_t temp_c = temp_millic / 1000;
-                        if (temp_c > max_temp)
-                            max_temp = temp_c;
-                        temp_found = true;
-                    }
-                }
-            }
-            closedir(sensor_dir);
-        }
-        closedir(hwmon_dir);
-    }
+    struct SysfsSample sample;
+    sample_sysfs(&sample);
+    uint8_t max_temp = sample.max_temp_c;
+    bool temp_found = sample.temp_found;
     if (!temp_found) {
         result->ok = true;
         snprintf(result->message, sizeof(result->message),
@@ -281,6 +215,340 @@ bool health_check_temperature(uint8_t max_celsius, struct HealthCheckResult *res
     return false;
 }
 
+typedef bool (*check_fn)(const struct HealthConfig *config, struct HealthCheckResult *result);
+
+struct check_task {
+    struct check_pool *pool;
+    check_fn run;
+    struct HealthCheckResult result;
+    struct timespec deadline;
+    bool done;
+    bool expired;
+    bool busy;
+    bool abandoned;
+};
+
+/*
+ * Shared between the caller and the check threads. A check that misses its
+ * deadline keeps running detached; the last reference frees the pool. The
+ * config, targets and scoring are copies so an overdue check never reads
+ * caller memory that has since been freed or reloaded.
+ */
+struct check_pool {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct HealthConfig config;
+    struct HealthScoreConfig scoring;
+    char *targets;
+    int refs;
+    int pending;
+    struct check_task tasks[];
+};
+
+/*
+ * Checks still running past an earlier deadline. Such a check is not
+ * started again until it returns, so a wedged probe costs one thread rather
+ * than one per sample in --daemon mode.
+ */
+#define OVERDUE_SLOTS 16
+
+static pthread_mutex_t overdue_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct {
+    check_fn run;
+    int count;
+} overdue[OVERDUE_SLOTS];
+
+static bool overdue_adjust(check_fn run, int delta)
+{
+    bool ok = false;
+    pthread_mutex_lock(&overdue_lock);
+    for (int i = 0; i < OVERDUE_SLOTS && !ok; i++) {
+        if (overdue[i].run == run && overdue[i].count > 0) {
+            overdue[i].count += delta;
+            ok = true;
+        }
+    }
+    for (int i = 0; i < OVERDUE_SLOTS && !ok && delta > 0; i++) {
+        if (overdue[i].count == 0) {
+            overdue[i].run = run;
+            overdue[i].count = delta;
+            ok = true;
+        }
+    }
+    pthread_mutex_unlock(&overdue_lock);
+    return ok;
+}
+
+static bool overdue_busy(check_fn run)
+{
+    bool busy = false;
+    pthread_mutex_lock(&overdue_lock);
+    for (int i = 0; i < OVERDUE_SLOTS; i++) {
+        if (overdue[i].run == run && overdue[i].count > 0)
+            busy = true;
+    }
+    pthread_mutex_unlock(&overdue_lock);
+    return busy;
+}
+
+static void deadline_after(struct timespec *ts, const struct timespec *start, uint32_t ms)
+{
+    ts->tv_sec = start->tv_sec + ms / 1000;
+    ts->tv_nsec = start->tv_nsec + (long)(ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static bool deadline_passed(const struct timespec *now, const struct timespec *deadline)
+{
+    return now->tv_sec > deadline->tv_sec ||
+           (now->tv_sec == deadline->tv_sec && now->tv_nsec >= deadline->tv_nsec);
+}
+
+static void pool_put(struct check_pool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    bool last = --pool->refs == 0;
+    pthread_mutex_unlock(&pool->lock);
+    if (last) {
+        pthread_cond_destroy(&pool->cond);
+        pthread_mutex_destroy(&pool->lock);
+        free(pool->targets);
+        free(pool);
+    }
+}
+
+static void *check_thread(void *arg)
+{
+    struct check_task *task = arg;
+    struct check_pool *pool = task->pool;
+    struct HealthCheckResult result;
+    memset(&result, 0, sizeof(result));
+    task->run(&pool->config, &result);
+    pthread_mutex_lock(&pool->lock);
+    task->result = result;
+    task->done = true;
+    bool abandoned = task->abandoned;
+    check_fn run = task->run;
+    pool->pending--;
+    pthread_cond_signal(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+    if (abandoned)
+        overdue_adjust(run, -1);
+    pool_put(pool);
+    return NULL;
+}
+
+int health_check_execute(const struct HealthConfig *config, const struct HealthCheck *checks,
+                         int count, struct HealthCheckResult *results)
+{
+    if (!config || !checks || !results || count <= 0)
+        return HEALTH_ERROR;
+    struct check_pool *pool = calloc(1, sizeof(*pool) + (size_t)count * sizeof(pool->tasks[0]));
+    if (!pool)
+        return HEALTH_ERROR;
+    pool->config = *config;
+    if (config->network_targets) {
+        pool->targets = strdup(config->network_targets);
+        if (!pool->targets) {
+            free(pool);
+            return HEALTH_ERROR;
+        }
+        pool->config.network_targets = pool->targets;
+    }
+    if (config->scoring) {
+        pool->scoring = *config->scoring;
+        pool->config.scoring = &pool->scoring;
+    }
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pool->refs = 1;
+    struct timespec start, global, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    deadline_after(&global, &start, config->total_timeout_ms);
+    for (int i = 0; i < count; i++) {
+        struct check_task *task = &pool->tasks[i];
+        uint32_t ms = checks[i].timeout_ms ? checks[i].timeout_ms : config->check_timeout_ms;
+        task->pool = pool;
+        task->run = checks[i].run;
+        deadline_after(&task->deadline, &start, ms);
+        if (deadline_passed(&task->deadline, &global))
+            task->deadline = global;
+    }
+    pthread_mutex_lock(&pool->lock);
+    for (int i = 0; i < count; i++) {
+        struct check_task *task = &pool->tasks[i];
+        if (overdue_busy(task->run)) {
+            task->busy = true;
+            continue;
+        }
+        pthread_t tid;
+        pthread_attr_t tattr;
+        pthread_attr_init(&tattr);
+        pthread_attr_setdetachstate(&tattr, PTHREAD_CREATE_DETACHED);
+        pool->refs++;
+        pool->pending++;
+        if (pthread_create(&tid, &tattr, check_thread, task) != 0) {
+            pool->refs--;
+            pool->pending--;
+            pthread_mutex_unlock(&pool->lock);
+            task->run(&pool->config, &task->result);
+            pthread_mutex_lock(&pool->lock);
+            task->done = true;
+        }
+        pthread_attr_destroy(&tattr);
+    }
+    for (;;) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        struct timespec next = global;
+        int waiting = 0;
+        for (int i = 0; i < count; i++) {
+            struct check_task *task = &pool->tasks[i];
+            if (task->done || task->expired || task->busy)
+                continue;
+            if (deadline_passed(&now, &task->deadline)) {
+                task->expired = true;
+                continue;
+            }
+            waiting++;
+            if (deadline_passed(&next, &task->deadline))
+                next = task->deadline;
+        }
+        if (waiting == 0)
+            break;
+        pthread_cond_timedwait(&pool->cond, &pool->lock, &next);
+    }
+    int timed_out = 0;
+    for (int i = 0; i < count; i++) {
+        struct check_task *task = &pool->tasks[i];
+        memset(&results[i], 0, sizeof(results[i]));
+        if (task->done) {
+            results[i] = task->result;
+            continue;
+        }
+        timed_out++;
+        results[i].ok = false;
+        if (task->busy) {
+            snprintf(results[i].message, sizeof(results[i].message),
+                     "%s check still running from an earlier run", checks[i].name);
+            continue;
+        }
+        task->abandoned = overdue_adjust(task->run, 1);
+        snprintf(results[i].message, sizeof(results[i].message),
+                 "%s check timed out", checks[i].name);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    pool_put(pool);
+    return timed_out;
+}
+
+static const char *const inject_dirs[] = { "/host_tmp", "/tmp" };
+
+/* Fault-injection files stand in for hardware that QEMU does not model */
+static bool inject_present(const char *name)
+{
+    char path[64];
+    for (size_t i = 0; i < sizeof(inject_dirs) / sizeof(inject_dirs[0]); i++) {
+        snprintf(path, sizeof(path), "%s/%s", inject_dirs[i], name);
+        if (access(path, F_OK) == 0)
+            return true;
+    }
+    return false;
+}
+
+static bool inject_read(const char *name, uint32_t *value)
+{
+    char path[64], buf[32];
+    for (size_t i = 0; i < sizeof(inject_dirs) / sizeof(inject_dirs[0]); i++) {
+        snprintf(path, sizeof(path), "%s/%s", inject_dirs[i], name);
+        FILE *f = fopen(path, "r");
+        if (!f)
+            continue;
+        uint32_t v = 0;
+        if (fgets(buf, sizeof(buf), f)) {
+            for (char *p = buf; *p; p++) {
+                if (*p >= '0' && *p <= '9')
+                    v = v * 10 + (uint32_t)(*p - '0');
+            }
+        }
+        fclose(f);
+        *value = v;
+        return true;
+    }
+    return false;
+}
+
+static bool run_watchdog(const struct HealthConfig *config, struct HealthCheckResult *result)
+{
+    if (config->simulate && inject_present("inject_watchdog_fault")) {
+        memset(result, 0, sizeof(*result));
+        snprintf(result->message, sizeof(result->message),
+                 "Watchdog timeout detected (simulated fault injection)");
+        return false;
+    }
+    if (health_check_watchdog(result) || !config->simulate)
+        return result->ok;
+    result->ok = true;
+    snprintf(result->message, sizeof(result->message),
+             "Watchdog OK (simulated - no hardware watchdog)");
+    return true;
+}
+
+static bool run_ecc(const struct HealthConfig *config, struct HealthCheckResult *result)
+{
+    uint32_t errors;
+    if (!config->simulate || !inject_read("inject_ecc_errors", &errors))
+        return health_check_ecc(config->ecc_threshold, result);
+    memset(result, 0, sizeof(*result));
+    result->value = errors;
+    result->ok = errors < config->ecc_threshold;
+    snprintf(result->message, sizeof(result->message),
+             "ECC errors %s threshold: %u (max: %u, simulated)",
+             result->ok ? "within" : "exceed", errors, config->ecc_threshold);
+    return result->ok;
+}
+
+static bool run_storage(const struct HealthConfig *config, struct HealthCheckResult *result)
+{
+    if (!config->simulate || !inject_present("inject_storage_fault"))
+        return health_check_storage(config->storage_min_free_pct, result);
+    memset(result, 0, sizeof(*result));
+    snprintf(result->message, sizeof(result->message),
+             "Storage failure detected (simulated fault injection)");
+    return false;
+}
+
+static bool run_network(const struct HealthConfig *config, struct HealthCheckResult *result)
+{
+    return health_check_network_targets(config->network_targets,
+                                        config->network_timeout_sec * 1000U, result);
+}
+
+static bool run_memory(const struct HealthConfig *config, struct HealthCheckResult *result)
+{
+    return health_check_memory(config->mem_min_free_kb, result);
+}
+
+static bool run_temperature(const struct HealthConfig *config, struct HealthCheckResult *result)
+{
+    uint32_t celsius;
+    if (!config->simulate || !inject_read("inject_temperature", &celsius))
+        return health_check_temperature(config->temp_max_celsius, result);
+    memset(result, 0, sizeof(*result));
+    result->value = celsius;
+    result->ok = celsius <= config->temp_max_celsius;
+    snprintf(result->message, sizeof(result->message),
+             "Temperature %s: %u°C (max: %u°C, simulated)",
+             result->ok ? "normal" : "critical", celsius, config->temp_max_celsius);
+    return result->ok;
+}
+
 int health_check_run(const struct HealthConfig *config, struct HealthReport *report)
 {
     if (!report)
@@ -290,28 +558,26 @@ int health_check_run(const struct HealthConfig *config, struct HealthReport *rep
         config = &default_config;
     health_report_clear(report);
     report->timestamp = time(NULL);
-    health_check_watchdog(&report->watchdog);
-    health_check_ecc(config->ecc_threshold, &report->ecc);
-    health_check_storage(config->storage_min_free_pct, &report->storage);
-    health_check_network(config->network_timeout_sec, &report->network);
-    health_check_memory(config->mem_min_free_kb, &report->memory);
-    health_check_temperature(config->temp_max_celsius, &report->temperature);
-    report->overall_score = 0;
-    if (report->watchdog.ok) report->overall_score++;
-    if (report->ecc.ok) report->overall_score++;
-    if (report->storage.ok) report->overall_score++;
-    if (report->network.ok) report->overall_score++;
-    if (report->memory.ok) report->overall_score++;
-    if (report->temperature.ok) report->overall_score++;
-    report->max_score = 6;
-    const char *status = health_score_to_status(report->overall_score, report->max_score);
-    strncpy(report->overall_status, status, sizeof(report->overall_status) - 1);
-    if (report->overall_score >= 5)
-        return HEALTH_OK;
-    else if (report->overall_score >= 3)
-        return HEALTH_DEGRADED;
-    else
-        return HEALTH_CRITICAL;
+    uint32_t network_ms = config->network_timeout_sec * 1000U + 500U;
+    const struct HealthCheck checks[] = {
+        { "watchdog",    run_watchdog,    0 },
+        { "ecc",         run_ecc,         0 },
+        { "storage",     run_storage,     0 },
+        { "network",     run_network,     network_ms },
+        { "memory",      run_memory,      0 },
+        { "temperature", run_temperature, 0 },
+    };
+    struct HealthCheckResult *slots[] = {
+        &report->watchdog, &report->ecc, &report->storage,
+        &report->network, &report->memory, &report->temperature,
+    };
+    struct HealthCheckResult results[6];
+    if (health_check_execute(config, checks, 6, results) < 0)
+        return HEALTH_ERROR;
+    for (int i = 0; i < 6; i++)
+        *slots[i] = results[i];
+    struct HealthScoreConfig default_scoring = HEALTH_SCORE_CONFIG_DEFAULT;
+    return health_score_apply(config->scoring ? config->scoring : &default_scoring, report);
 }
 
 void health_report_print(const struct HealthReport *report)
@@ -320,8 +586,8 @@ void health_report_print(const struct HealthReport *report)
     printf("  PAC Health Check Report                                  \n");
     printf("\n\n");
     printf("Timestamp: %ld\n", (long)report->timestamp);
-    printf("Overall Status: %s (%u/%u checks passed)\n\n",
-           report->overall_status, report->overall_score, report->max_score);
+    printf("Overall Status: %s (score %u/%u, tier %u eligible)\n\n",
+           report->overall_status, report->overall_score, report->max_score, report->max_tier);
     printf("Individual Checks:\n");
     printf("  [%s] Watchdog:    %s\n",
            report->watchdog.ok ? "" : "", report->watchdog.message);
@@ -338,62 +604,125 @@ void health_report_print(const struct HealthReport *report)
     printf("\n");
 }
 
+static void write_check(struct JsonWriter *w, const char *name,
+                        const struct HealthCheckResult *result)
+{
+    json_key(w, name);
+    json_object_begin(w);
+    json_kv_bool(w, "ok", result->ok);
+    json_kv_string(w, "message", result->message);
+    json_kv_uint(w, "value", result->value);
+    json_object_end(w);
+}
+
+/* Compact output drops the legacy_format block, which only repeats the ok flags */
+void health_report_write_json(const struct HealthReport *report, struct JsonWriter *w)
+{
+    json_object_begin(w);
+    json_kv_int(w, "timestamp", (int64_t)report->timestamp);
+    json_kv_uint(w, "overall_score", report->overall_score);
+    json_kv_uint(w, "max_score", report->max_score);
+    json_kv_uint(w, "max_tier", report->max_tier);
+    json_kv_string(w, "overall_status", report->overall_status);
+    json_key(w, "checks");
+    json_object_begin(w);
+    write_check(w, "watchdog", &report->watchdog);
+    write_check(w, "ecc", &report->ecc);
+    write_check(w, "storage", &report->storage);
+    write_check(w, "network", &report->network);
+    write_check(w, "memory", &report->memory);
+    write_check(w, "temperature", &report->temperature);
+    json_object_end(w);
+    if (!w->compact) {
+        json_key(w, "legacy_format");
+        json_object_begin(w);
+        json_kv_uint(w, "wdt_ok", report->watchdog.ok);
+        json_kv_uint(w, "ecc_ok", report->ecc.ok);
+        json_kv_uint(w, "storage_ok", report->storage.ok);
+        json_kv_uint(w, "net_ok", report->network.ok);
+        json_kv_uint(w, "mem_ok", report->memory.ok);
+        json_kv_uint(w, "temp_ok", report->temperature.ok);
+        json_object_end(w);
+    }
+    json_object_end(w);
+}
+
 int health_report_to_json(const struct HealthReport *report, char *buffer, size_t bufsize)
 {
-    return snprintf(buffer, bufsize,
-        "{\n"
-        "  \"timestamp\": %ld,\n"
-        "  \"overall_score\": %u,\n"
-        "  \"max_score\": %u,\n"
-        "  \"overall_status\": \"%s\",\n"
-        "  \"checks\": {\n"
-        "    \"watchdog\": {\"ok\": %s, \"message\": \"%s\"},\n"
-        "    \"ecc\": {\"ok\": %s, \"message\": \"%s\"},\n"
-        "    \"storage\": {\"ok\": %s, \"message\": \"%s\"},\n"
-        "    \"network\": {\"ok\": %s, \"message\": \"%s\"},\n"
-        "    \"memory\": {\"ok\": %s, \"message\": \"%s\"},\n"
-        "    \"temperature\": {\"ok\": %s, \"message\": \"%s\"}\n"
-        "  },\n"
-        "  \"legacy_format\": {\n"
-        "    \"wdt_ok\": %d,\n"
-        "    \"ecc_ok\": %d,\n"
-        "    \"storage_ok\": %d,\n"
-        "    \"net_ok\": %d,\n"
-        "    \"mem_ok\": %d,\n"
-        "    \"temp_ok\": %d\n"
-        "  }\n"
-        "}\n",
-        (long)report->timestamp,
-        report->overall_score,
-        report->max_score,
-        report->overall_status,
-        report->watchdog.ok ? "true" : "false", report->watchdog.message,
-        report->ecc.ok ? "true" : "false", report->ecc.message,
-        report->storage.ok ? "true" : "false", report->storage.message,
-        report->network.ok ? "true" : "false", report->network.message,
-        report->memory.ok ? "true" : "false", report->memory.message,
-        report->temperature.ok ? "true" : "false", report->temperature.message,
-        report->watchdog.ok ? 1 : 0,
-        report->ecc.ok ? 1 : 0,
-        report->storage.ok ? 1 : 0,
-        report->network.ok ? 1 : 0,
-        report->memory.ok ? 1 : 0,
-        report->temperature.ok ? 1 : 0
-    );
+    struct JsonWriter w;
+    json_init_buffer(&w, buffer, bufsize, false);
+    health_report_write_json(report, &w);
+    int len = json_finish(&w);
+    return len < 0 ? -1 : len;
+}
+
+int health_report_to_fd(const struct HealthReport *report, int fd, bool compact)
+{
+    char stage[512];
+    struct JsonWriter w;
+    json_init_fd(&w, fd, stage, sizeof(stage), compact);
+    health_report_write_json(report, &w);
+    int len = json_finish(&w);
+    return len < 0 ? -1 : len;
+}
+
+/* Values and messages are arrays in watchdog, ecc, storage, network, memory, temperature order */
+int health_report_to_cbor(const struct HealthReport *report, uint8_t *buffer, size_t bufsize,
+                          bool compact)
+{
+    const struct HealthCheckResult *checks[] = {
+        &report->watchdog, &report->ecc, &report->storage,
+        &report->network, &report->memory, &report->temperature,
+    };
+    struct CborWriter w;
+    cbor_init(&w, buffer, bufsize);
+    cbor_map(&w, compact ? 12 : 13);
+    cbor_uint(&w, HEALTH_CBOR_WDT_OK);
+    cbor_bool(&w, report->watchdog.ok);
+    cbor_uint(&w, HEALTH_CBOR_ECC_OK);
+    cbor_bool(&w, report->ecc.ok);
+    cbor_uint(&w, HEALTH_CBOR_STORAGE_OK);
+    cbor_bool(&w, report->storage.ok);
+    cbor_uint(&w, HEALTH_CBOR_NET_OK);
+    cbor_bool(&w, report->network.ok);
+    cbor_uint(&w, HEALTH_CBOR_MEM_OK);
+    cbor_bool(&w, report->memory.ok);
+    cbor_uint(&w, HEALTH_CBOR_TEMP_OK);
+    cbor_bool(&w, report->temperature.ok);
+    cbor_uint(&w, HEALTH_CBOR_SCORE);
+    cbor_uint(&w, report->overall_score);
+    cbor_uint(&w, HEALTH_CBOR_MAX_SCORE);
+    cbor_uint(&w, report->max_score);
+    cbor_uint(&w, HEALTH_CBOR_STATUS);
+    cbor_text(&w, report->overall_status);
+    cbor_uint(&w, HEALTH_CBOR_TIMESTAMP);
+    cbor_int(&w, (int64_t)report->timestamp);
+    cbor_uint(&w, HEALTH_CBOR_MAX_TIER);
+    cbor_uint(&w, report->max_tier);
+    cbor_uint(&w, HEALTH_CBOR_VALUES);
+    cbor_array(&w, 6);
+    for (int i = 0; i < 6; i++)
+        cbor_uint(&w, checks[i]->value);
+    if (!compact) {
+        cbor_uint(&w, HEALTH_CBOR_MESSAGES);
+        cbor_array(&w, 6);
+        for (int i = 0; i < 6; i++)
+            cbor_text(&w, checks[i]->message);
+    }
+    int len = cbor_finish(&w);
+    return len < 0 ? -1 : len;
 }
 
 int health_report_to_file(const struct HealthReport *report, const char *filename)
 {
-    char buffer[4096];
-    int len = health_report_to_json(report, buffer, sizeof(buffer));
-    if (len < 0 || len >= (int)sizeof(buffer))
+    struct AtomicFile af;
+    if (atomic_file_open(&af, filename, 0644) != ATOMIC_OK)
         return -1;
-    FILE *f = fopen(filename, "w");
-    if (!f)
+    if (health_report_to_fd(report, af.fd, false) < 0) {
+        atomic_file_abort(&af);
         return -1;
-    fputs(buffer, f);
-    fclose(f);
-    return 0;
+    }
+    return atomic_file_commit(&af, 0) == ATOMIC_OK ? 0 : -1;
 }
 
 void health_config_default(struct HealthConfig *config)
@@ -409,10 +738,8 @@ void health_report_clear(struct HealthReport *report)
 
 const char *health_score_to_status(uint8_t score, uint8_t max)
 {
-    if (score >= (max * 5) / 6)  
-        return "healthy";
-    else if (score >= max / 2)    
-        return "degraded";
-    else
+    struct HealthScoreConfig defaults = HEALTH_SCORE_CONFIG_DEFAULT;
+    if (max == 0)
         return "critical";
-}
\ No newline at end of file
+    return health_score_status(&defaults, (uint8_t)(score * HEALTH_SCORE_SCALE / max));
+}
@@ -1,9 +1,13 @@
 #ifndef HEALTH_CHECK_H
 #define HEALTH_CHECK_H
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <time.h>
 
+struct HealthScoreConfig;
+struct JsonWriter;
+
 struct HealthCheckResult {
     bool ok;                    
     char message[256];          
@@ -20,6 +24,7 @@ struct HealthReport {
     struct HealthCheckResult temperature;
     uint8_t  overall_score;     
     uint8_t  max_score;         
+    uint8_t  max_tier;
     char     overall_status[32];
 };
 
@@ -30,6 +35,17 @@ struct HealthConfig {
     uint8_t  network_timeout_sec;   
     uint8_t  temp_max_celsius;      
     bool     verbose;               
+    uint32_t check_timeout_ms;
+    uint32_t total_timeout_ms;
+    const char *network_targets;
+    bool     simulate;
+    const struct HealthScoreConfig *scoring;
+};
+
+struct HealthCheck {
+    const char *name;
+    bool (*run)(const struct HealthConfig *config, struct HealthCheckResult *result);
+    uint32_t timeout_ms;
 };
 
 #define HEALTH_CONFIG_DEFAULT { \
@@ -38,23 +54,52 @@ struct HealthConfig {
     .storage_min_free_pct = 5, \
     .network_timeout_sec = 2, \
     .temp_max_celsius = 85, \
-    .verbose = false \
+    .verbose = false, \
+    .check_timeout_ms = 3000, \
+    .total_timeout_ms = 5000, \
+    .network_targets = NULL, \
+    .simulate = false, \
+    .scoring = NULL \
 }
 
+/* Integer keys of the -70002 health claim map; 1-4 match the original EAT layout */
+#define HEALTH_CLAIM_KEY          (-70002)
+#define HEALTH_CBOR_WDT_OK        1
+#define HEALTH_CBOR_ECC_OK        2
+#define HEALTH_CBOR_STORAGE_OK    3
+#define HEALTH_CBOR_NET_OK        4
+#define HEALTH_CBOR_MEM_OK        5
+#define HEALTH_CBOR_TEMP_OK       6
+#define HEALTH_CBOR_SCORE         7
+#define HEALTH_CBOR_MAX_SCORE     8
+#define HEALTH_CBOR_STATUS        9
+#define HEALTH_CBOR_TIMESTAMP     10
+#define HEALTH_CBOR_MAX_TIER      11
+#define HEALTH_CBOR_VALUES        12
+#define HEALTH_CBOR_MESSAGES      13
+
 #define HEALTH_OK           0
 #define HEALTH_DEGRADED     1
 #define HEALTH_CRITICAL     2
 #define HEALTH_ERROR       -1
 
 int health_check_run(const struct HealthConfig *config, struct HealthReport *report);
+int health_check_execute(const struct HealthConfig *config, const struct HealthCheck *checks,
+                         int count, struct HealthCheckResult *results);
 bool health_check_watchdog(struct HealthCheckResult *result);
 bool health_check_ecc(uint32_t threshold, struct HealthCheckResult *result);
 bool health_check_storage(uint8_t min_free_pct, struct HealthCheckResult *result);
 bool health_check_network(uint8_t timeout_sec, struct HealthCheckResult *result);
+bool health_check_network_targets(const char *targets, uint32_t timeout_ms,
+                                  struct HealthCheckResult *result);
 bool health_check_memory(uint32_t min_free_kb, struct HealthCheckResult *result);
 bool health_check_temperature(uint8_t max_celsius, struct HealthCheckResult *result);
 void health_report_print(const struct HealthReport *report);
 int health_report_to_json(const struct HealthReport *report, char *buffer, size_t bufsize);
+void health_report_write_json(const struct HealthReport *report, struct JsonWriter *w);
+int health_report_to_fd(const struct HealthReport *report, int fd, bool compact);
+int health_report_to_cbor(const struct HealthReport *report, uint8_t *buffer, size_t bufsize,
+                          bool compact);
 int health_report_to_file(const struct HealthReport *report, const char *filename);
 void health_config_default(struct HealthConfig *config);
 void health_report_clear(struct HealthReport *report);
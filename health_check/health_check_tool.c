@@ -1,33 +1,262 @@
 #include "health_check.h"
+#include "health_score.h"
+#include "health_shm.h"
+#include "health_trend.h"
+#include "atomic_file.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <getopt.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
 
 static void usage(const char *prog)
 {
     printf("PAC Health Check Tool\n\n");
     printf("Usage: %s [options]\n\n", prog);
     printf("Options:\n");
-    printf("  -o FILE    Output JSON to file (default: /tmp/health.json)\n");
+    printf("  -o FILE    Output report to file, - for stdout\n");
+    printf("             (default: /tmp/health.json, /tmp/health.cbor for CBOR)\n");
+    printf("  --format=F Report encoding: json (default) or cbor, the integer-keyed\n");
+    printf("             map carried in the -70002 EAT claim\n");
+    printf("  --compact  Emit JSON without whitespace or the legacy_format block, or\n");
+    printf("             CBOR without the check messages\n");
     printf("  -v         Verbose output (print to stdout)\n");
     printf("  -q         Quiet mode (no output, exit code only)\n");
+    printf("  -n LIST    Network targets, host[:port],... (default: VERIFIER_URL host,\n");
+    printf("             then 8.8.8.8:53,1.1.1.1:53)\n");
+    printf("  -t MS      Per-check deadline in milliseconds (default: 3000)\n");
+    printf("  -T MS      Deadline for the whole run in milliseconds (default: 5000)\n");
+    printf("  -c FILE    Scoring weights and thresholds (default: %s)\n",
+           HEALTH_SCORE_CONFIG_PATH);
+    printf("  -s         Honour /tmp and /host_tmp fault-injection files and treat a\n");
+    printf("             missing hardware watchdog as simulated\n");
+    printf("  --thresholds       Print the tier and attestation score thresholds\n");
+    printf("                     as shell variables and exit\n");
     printf("  -h         Show this help\n\n");
+    printf("Daemon Mode:\n");
+    printf("  --daemon           Sample continuously and publish to shared memory\n");
+    printf("  --interval-ms N    Sample period in milliseconds (default: 1000)\n");
+    printf("  --shm PATH         Shared report segment (default: %s)\n", HEALTH_SHM_PATH);
+    printf("  --snapshot         Print the latest published report as shell variables\n");
+    printf("                     and exit with its result code\n");
+    printf("  --ecc-rate N       Alarm when correctable ECC errors grow faster than\n");
+    printf("                     N per minute (default: 1)\n");
+    printf("  --temp-rate N      Alarm when temperature rises faster than N C per\n");
+    printf("                     minute (default: 5)\n\n");
     printf("Exit Codes:\n");
-    printf("  0  - Healthy (5-6/6 checks pass)\n");
-    printf("  1  - Degraded (3-4/6 checks pass)\n");
-    printf("  2  - Critical (0-2/6 checks pass)\n");
+    printf("  0  - Healthy (weighted score at or above the healthy threshold)\n");
+    printf("  1  - Degraded or marginal\n");
+    printf("  2  - Critical\n");
     printf("  255 - Error\n\n");
 }
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_stop(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+
+static uint64_t monotonic_ms(const struct timespec *ts)
+{
+    return (uint64_t)ts->tv_sec * 1000 + (uint64_t)ts->tv_nsec / 1000000;
+}
+
+static int run_daemon(const struct HealthConfig *config, const struct TrendConfig *trend_config,
+                      const char *shm_path, uint32_t interval_ms, bool verbose)
+{
+    struct HealthShm *shm = health_shm_create(shm_path, interval_ms);
+    if (!shm)
+        return 255;
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_stop;
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGINT, &sa, NULL);
+    if (verbose)
+        printf("Publishing health every %u ms to %s\n", interval_ms, shm_path);
+    struct HealthTrend trend;
+    trend_init(&trend, trend_config->alpha);
+    uint32_t prev_alarms = 0;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (!stop_requested) {
+        struct HealthReport report;
+        int result = health_check_run(config, &report);
+        struct timespec sampled;
+        clock_gettime(CLOCK_MONOTONIC, &sampled);
+        trend_update(&trend, &report, monotonic_ms(&sampled));
+        struct HealthTrendSummary summary;
+        trend_evaluate(&trend, trend_config, &summary);
+        health_shm_publish(shm, &report, result, &summary);
+        if (verbose)
+            printf("%ld: %s (%u/%u)\n", (long)report.timestamp, report.overall_status,
+                   report.overall_score, report.max_score);
+        if (summary.alarms & ~prev_alarms) {
+            char names[64];
+            trend_alarm_names(summary.alarms, names, sizeof(names));
+            fprintf(stderr, "health: trend alarm %s (ecc %.1f/min, temp %.1f C/min)\n",
+                    names, summary.ecc_ce_per_min, summary.temp_c_per_min);
+        }
+        prev_alarms = summary.alarms;
+        next.tv_sec += interval_ms / 1000;
+        next.tv_nsec += (long)(interval_ms % 1000) * 1000000L;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000L;
+        }
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        /* a sample that overran its period starts the next one immediately */
+        if (now.tv_sec > next.tv_sec ||
+            (now.tv_sec == next.tv_sec && now.tv_nsec > next.tv_nsec))
+            next = now;
+        while (!stop_requested &&
+               clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) != 0)
+            ;
+    }
+    health_shm_detach(shm);
+    return 0;
+}
+
+static void print_thresholds(const struct HealthScoreConfig *scoring)
+{
+    printf("HEALTH_MIN_T2=%u\nHEALTH_MIN_T3=%u\nHEALTH_MIN_ATTEST=%u\n",
+           scoring->min_tier2, scoring->min_tier3, scoring->min_attest);
+}
+
+static int print_snapshot(const char *shm_path, const struct HealthScoreConfig *scoring)
+{
+    struct HealthShm *shm = health_shm_attach(shm_path);
+    struct HealthSnapshot snap;
+    if (!shm || health_shm_snapshot(shm, &snap) != 0) {
+        fprintf(stderr, "Error: No health report published at %s\n", shm_path);
+        health_shm_detach(shm);
+        return 255;
+    }
+    health_shm_detach(shm);
+    const struct HealthReport *r = &snap.report;
+    printf("HEALTH_SCORE=%u\n", r->overall_score);
+    printf("HEALTH_MAX_SCORE=%u\n", r->max_score);
+    printf("HEALTH_STATUS=%s\n", r->overall_status);
+    printf("HEALTH_MAX_TIER=%u\n", r->max_tier);
+    print_thresholds(scoring);
+    printf("HEALTH_TIMESTAMP=%ld\n", (long)r->timestamp);
+    printf("HEALTH_AGE_MS=%u\n", snap.age_ms);
+    printf("HEALTH_INTERVAL_MS=%u\n", snap.interval_ms);
+    printf("HEALTH_SAMPLES=%lu\n", (unsigned long)snap.samples);
+    printf("WDT_OK=%d\nECC_OK=%d\nSTORAGE_OK=%d\nNET_OK=%d\nMEM_OK=%d\nTEMP_OK=%d\n",
+           r->watchdog.ok, r->ecc.ok, r->storage.ok, r->network.ok,
+           r->memory.ok, r->temperature.ok);
+    printf("ECC_ERRORS=%u\nTEMPERATURE=%u\n", r->ecc.value, r->temperature.value);
+    char names[64];
+    trend_alarm_names(snap.trend.alarms, names, sizeof(names));
+    printf("TREND_ALARMS=%u\nTREND_ALARM_NAMES=\"%s\"\n", snap.trend.alarms, names);
+    printf("ECC_RATE_PER_MIN=%.2f\nTEMP_RATE_PER_MIN=%.2f\nSTORAGE_RATE_PER_MIN=%.2f\n",
+           snap.trend.ecc_ce_per_min, snap.trend.temp_c_per_min,
+           snap.trend.storage_pct_per_min);
+    return snap.result;
+}
+
+static int write_all(int fd, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int encode_report(const struct HealthReport *report, int fd, bool compact, bool cbor)
+{
+    if (!cbor)
+        return health_report_to_fd(report, fd, compact);
+    uint8_t buf[2048];
+    int len = health_report_to_cbor(report, buf, sizeof(buf), compact);
+    if (len >= 0 && write_all(fd, buf, (size_t)len) < 0)
+        return -1;
+    return len;
+}
+
+static int write_report(const struct HealthReport *report, const char *path, bool compact,
+                        bool cbor)
+{
+    if (strcmp(path, "-") == 0)
+        return encode_report(report, STDOUT_FILENO, compact, cbor);
+    struct AtomicFile af;
+    if (atomic_file_open(&af, path, 0644) != ATOMIC_OK)
+        return -1;
+    int len = encode_report(report, af.fd, compact, cbor);
+    if (len < 0) {
+        atomic_file_abort(&af);
+        return -1;
+    }
+    return atomic_file_commit(&af, 0) == ATOMIC_OK ? len : -1;
+}
+
 int main(int argc, char *argv[])
 {
-    const char *output_file = "/tmp/health.json";
+    const char *output_file = NULL;
     bool verbose = false;
     bool quiet = false;
     struct HealthConfig config = HEALTH_CONFIG_DEFAULT;
+    bool daemon_mode = false;
+    bool snapshot = false;
+    const char *shm_path = HEALTH_SHM_PATH;
+    uint32_t interval_ms = 1000;
+    struct TrendConfig trend_config = TREND_CONFIG_DEFAULT;
+    const char *score_path = NULL;
+    bool thresholds = false;
+    bool compact = false;
+    bool cbor = false;
+    static const struct option long_opts[] = {
+        { "daemon",      no_argument,       NULL, 'D' },
+        { "interval-ms", required_argument, NULL, 'I' },
+        { "shm",         required_argument, NULL, 'S' },
+        { "snapshot",    no_argument,       NULL, 'P' },
+        { "ecc-rate",    required_argument, NULL, 'E' },
+        { "temp-rate",   required_argument, NULL, 'R' },
+        { "simulate",    no_argument,       NULL, 's' },
+        { "thresholds",  no_argument,       NULL, 'L' },
+        { "compact",     no_argument,       NULL, 'C' },
+        { "format",      required_argument, NULL, 'F' },
+        { "help",        no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
     int opt;
-    while ((opt = getopt(argc, argv, "o:vqh")) != -1) {
+    while ((opt = getopt_long(argc, argv, "o:vqn:t:T:c:sh", long_opts, NULL)) != -1) {
         switch (opt) {
+        case 'D':
+            daemon_mode = true;
+            break;
+        case 'I':
+            interval_ms = (uint32_t)strtoul(optarg, NULL, 10);
+            if (interval_ms == 0) {
+                fprintf(stderr, "Error: --interval-ms must be positive\n");
+                return 255;
+            }
+            break;
+        case 'S':
+            shm_path = optarg;
+            break;
+        case 'P':
+            snapshot = true;
+            break;
+        case 'E':
+            trend_config.ecc_ce_per_min = strtod(optarg, NULL);
+            break;
+        case 'R':
+            trend_config.temp_c_per_min = strtod(optarg, NULL);
+            break;
         case 'o':
             output_file = optarg;
             break;
@@ -39,6 +268,37 @@ int main(int argc, char *argv[])
             quiet = true;
             verbose = false;
             break;
+        case 'n':
+            config.network_targets = optarg;
+            break;
+        case 't':
+            config.check_timeout_ms = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+        case 'T':
+            config.total_timeout_ms = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+        case 'c':
+            score_path = optarg;
+            break;
+        case 's':
+            config.simulate = true;
+            break;
+        case 'L':
+            thresholds = true;
+            break;
+        case 'C':
+            compact = true;
+            break;
+        case 'F':
+            if (strcmp(optarg, "json") == 0) {
+                cbor = false;
+            } else if (strcmp(optarg, "cbor") == 0) {
+                cbor = true;
+            } else {
+                fprintf(stderr, "Error: Unknown format: %s\n", optarg);
+                return 255;
+            }
+            break;
         case 'h':
             usage(argv[0]);
             return 0;
@@ -47,21 +307,45 @@ int main(int argc, char *argv[])
             return 255;
         }
     }
+    struct HealthScoreConfig scoring;
+    int loaded = health_score_load(&scoring, score_path);
+    if (loaded < 0 || (loaded > 0 && score_path)) {
+        fprintf(stderr, "Error: Invalid scoring config: %s\n",
+                score_path ? score_path : HEALTH_SCORE_CONFIG_PATH);
+        return 255;
+    }
+    config.scoring = &scoring;
+    if (thresholds) {
+        print_thresholds(&scoring);
+        return 0;
+    }
+    if (snapshot)
+        return print_snapshot(shm_path, &scoring);
+    if (daemon_mode) {
+        if (config.total_timeout_ms > interval_ms)
+            config.total_timeout_ms = interval_ms;
+        return run_daemon(&config, &trend_config, shm_path, interval_ms, verbose);
+    }
+    if (!output_file)
+        output_file = cbor ? "/tmp/health.cbor" : "/tmp/health.json";
     struct HealthReport report;
     int result = health_check_run(&config, &report);
     if (result == HEALTH_ERROR) {
         fprintf(stderr, "Error: Health check failed\n");
         return 255;
     }
-    if (health_report_to_file(&report, output_file) < 0) {
+    bool to_stdout = strcmp(output_file, "-") == 0;
+    if (write_report(&report, output_file, compact, cbor) < 0) {
         fprintf(stderr, "Error: Failed to write output file: %s\n", output_file);
         return 255;
     }
+    if (to_stdout)
+        return result;
     if (verbose) {
         health_report_print(&report);
     } else if (!quiet) {
-        printf("Health check complete: %s (%u/%u checks passed)\n",
-               report.overall_status, report.overall_score, report.max_score);
+        printf("Health check complete: %s (score %u/%u, tier %u eligible)\n",
+               report.overall_status, report.overall_score, report.max_score, report.max_tier);
         printf("Report written to: %s\n", output_file);
     }
     return result;
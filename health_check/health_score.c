@@ -0,0 +1,181 @@
+#include "health_score.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+static const char *const check_names[HEALTH_CHECK_COUNT] = {
+    "watchdog", "ecc", "storage", "network", "memory", "temperature",
+};
+
+const char *health_check_name(int id)
+{
+    return id >= 0 && id < HEALTH_CHECK_COUNT ? check_names[id] : "unknown";
+}
+
+int health_check_lookup(const char *name)
+{
+    for (int i = 0; i < HEALTH_CHECK_COUNT; i++) {
+        if (strcmp(name, check_names[i]) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static const struct HealthCheckResult *report_check(const struct HealthReport *report, int id)
+{
+    switch (id) {
+    case HEALTH_CHECK_WATCHDOG:    return &report->watchdog;
+    case HEALTH_CHECK_ECC:         return &report->ecc;
+    case HEALTH_CHECK_STORAGE:     return &report->storage;
+    case HEALTH_CHECK_NETWORK:     return &report->network;
+    case HEALTH_CHECK_MEMORY:      return &report->memory;
+    default:                       return &report->temperature;
+    }
+}
+
+static int parse_checks(char *list, uint8_t *mask)
+{
+    *mask = 0;
+    for (char *name = strtok(list, ", \t"); name; name = strtok(NULL, ", \t")) {
+        int id = health_check_lookup(name);
+        if (id < 0)
+            return -1;
+        *mask |= HEALTH_CHECK_BIT(id);
+    }
+    return 0;
+}
+
+static uint8_t *threshold_slot(struct HealthScoreConfig *config, const char *name)
+{
+    if (strcmp(name, "healthy") == 0)  return &config->healthy;
+    if (strcmp(name, "degraded") == 0) return &config->degraded;
+    if (strcmp(name, "marginal") == 0) return &config->marginal;
+    if (strcmp(name, "tier2") == 0)    return &config->min_tier2;
+    if (strcmp(name, "tier3") == 0)    return &config->min_tier3;
+    if (strcmp(name, "attest") == 0)   return &config->min_attest;
+    return NULL;
+}
+
+static int parse_line(struct HealthScoreConfig *config, char *line)
+{
+    char key[16], name[16], rest[128];
+    rest[0] = '\0';
+    int n = sscanf(line, "%15s %15s %127[^\n]", key, name, rest);
+    if (n < 1 || key[0] == '#')
+        return 0;
+    if (n < 3)
+        return -1;
+    char *end;
+    if (strcmp(key, "weight") == 0) {
+        int id = health_check_lookup(name);
+        unsigned long w = strtoul(rest, &end, 10);
+        if (id < 0 || end == rest || w > 255)
+            return -1;
+        config->weight[id] = (uint8_t)w;
+        return 0;
+    }
+    if (strcmp(key, "require") == 0) {
+        if (strcmp(name, "tier2") == 0)
+            return parse_checks(rest, &config->require_tier2);
+        if (strcmp(name, "tier3") == 0)
+            return parse_checks(rest, &config->require_tier3);
+        return -1;
+    }
+    if (strcmp(key, "threshold") == 0) {
+        uint8_t *slot = threshold_slot(config, name);
+        unsigned long v = strtoul(rest, &end, 10);
+        if (!slot || end == rest || v > HEALTH_SCORE_SCALE)
+            return -1;
+        *slot = (uint8_t)v;
+        return 0;
+    }
+    return -1;
+}
+
+int health_score_load(struct HealthScoreConfig *config, const char *path)
+{
+    struct HealthScoreConfig defaults = HEALTH_SCORE_CONFIG_DEFAULT;
+    *config = defaults;
+    if (!path)
+        path = HEALTH_SCORE_CONFIG_PATH;
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        if (errno == ENOENT)
+            return 1;
+        fprintf(stderr, "health: cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    char line[256];
+    int lineno = 0;
+    int ret = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        if (parse_line(config, line) != 0) {
+            fprintf(stderr, "health: %s:%d: invalid entry\n", path, lineno);
+            ret = -1;
+            break;
+        }
+    }
+    fclose(f);
+    unsigned total = 0;
+    for (int i = 0; i < HEALTH_CHECK_COUNT; i++)
+        total += config->weight[i];
+    if (ret == 0 && total == 0) {
+        fprintf(stderr, "health: %s: all weights are zero\n", path);
+        ret = -1;
+    }
+    if (ret != 0)
+        *config = defaults;
+    return ret;
+}
+
+const char *health_score_status(const struct HealthScoreConfig *config, uint8_t score)
+{
+    if (score >= config->healthy)
+        return "healthy";
+    if (score >= config->degraded)
+        return "degraded";
+    if (score >= config->marginal)
+        return "marginal";
+    return "critical";
+}
+
+static bool requirements_met(const struct HealthReport *report, uint8_t mask)
+{
+    for (int i = 0; i < HEALTH_CHECK_COUNT; i++) {
+        if ((mask & HEALTH_CHECK_BIT(i)) && !report_check(report, i)->ok)
+            return false;
+    }
+    return true;
+}
+
+int health_score_apply(const struct HealthScoreConfig *config, struct HealthReport *report)
+{
+    unsigned total = 0, passed = 0;
+    for (int i = 0; i < HEALTH_CHECK_COUNT; i++) {
+        total += config->weight[i];
+        if (report_check(report, i)->ok)
+            passed += config->weight[i];
+    }
+    if (total == 0)
+        return HEALTH_ERROR;
+    report->overall_score = (uint8_t)(passed * HEALTH_SCORE_SCALE / total);
+    report->max_score = HEALTH_SCORE_SCALE;
+    memset(report->overall_status, 0, sizeof(report->overall_status));
+    strncpy(report->overall_status, health_score_status(config, report->overall_score),
+            sizeof(report->overall_status) - 1);
+    report->max_tier = 1;
+    if (report->overall_score >= config->min_tier2 &&
+        requirements_met(report, config->require_tier2)) {
+        report->max_tier = 2;
+        if (report->overall_score >= config->min_tier3 &&
+            requirements_met(report, config->require_tier3))
+            report->max_tier = 3;
+    }
+    if (report->overall_score >= config->healthy)
+        return HEALTH_OK;
+    if (report->overall_score >= config->marginal)
+        return HEALTH_DEGRADED;
+    return HEALTH_CRITICAL;
+}
@@ -0,0 +1,52 @@
+#ifndef HEALTH_SCORE_H
+#define HEALTH_SCORE_H
+#include "health_check.h"
+#include <stdint.h>
+
+#define HEALTH_SCORE_SCALE        10
+#define HEALTH_SCORE_CONFIG_PATH  "/etc/pac/health_score.conf"
+
+#define HEALTH_CHECK_WATCHDOG     0
+#define HEALTH_CHECK_ECC          1
+#define HEALTH_CHECK_STORAGE      2
+#define HEALTH_CHECK_NETWORK      3
+#define HEALTH_CHECK_MEMORY       4
+#define HEALTH_CHECK_TEMPERATURE  5
+#define HEALTH_CHECK_COUNT        6
+
+#define HEALTH_CHECK_BIT(id)      (1U << (id))
+
+/* Thresholds are on the 0..HEALTH_SCORE_SCALE scale every layer compares against */
+struct HealthScoreConfig {
+    uint8_t weight[HEALTH_CHECK_COUNT];
+    uint8_t require_tier2;
+    uint8_t require_tier3;
+    uint8_t healthy;
+    uint8_t degraded;
+    uint8_t marginal;
+    uint8_t min_tier2;
+    uint8_t min_tier3;
+    uint8_t min_attest;
+};
+
+#define HEALTH_SCORE_CONFIG_DEFAULT { \
+    .weight = { 2, 2, 2, 1, 3, 2 }, \
+    .require_tier2 = HEALTH_CHECK_BIT(HEALTH_CHECK_MEMORY) | \
+                     HEALTH_CHECK_BIT(HEALTH_CHECK_STORAGE), \
+    .require_tier3 = HEALTH_CHECK_BIT(HEALTH_CHECK_WATCHDOG) | \
+                     HEALTH_CHECK_BIT(HEALTH_CHECK_ECC), \
+    .healthy = 8, \
+    .degraded = 5, \
+    .marginal = 3, \
+    .min_tier2 = 6, \
+    .min_tier3 = 9, \
+    .min_attest = 5 \
+}
+
+int health_score_load(struct HealthScoreConfig *config, const char *path);
+int health_score_apply(const struct HealthScoreConfig *config, struct HealthReport *report);
+const char *health_score_status(const struct HealthScoreConfig *config, uint8_t score);
+const char *health_check_name(int id);
+int health_check_lookup(const char *name);
+
+#endif
@@ -0,0 +1,123 @@
+#include "health_shm.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#define SNAPSHOT_RETRIES 64
+
+static uint64_t monotonic_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static struct HealthShm *map_segment(int fd, int prot)
+{
+    void *p = mmap(NULL, sizeof(struct HealthShm), prot, MAP_SHARED, fd, 0);
+    close(fd);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+struct HealthShm *health_shm_create(const char *path, uint32_t interval_ms)
+{
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "health: cannot open %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    if (ftruncate(fd, sizeof(struct HealthShm)) != 0) {
+        fprintf(stderr, "health: cannot size %s: %s\n", path, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+    struct HealthShm *shm = map_segment(fd, PROT_READ | PROT_WRITE);
+    if (!shm) {
+        fprintf(stderr, "health: cannot map %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    __atomic_store_n(&shm->seq, __atomic_load_n(&shm->seq, __ATOMIC_RELAXED) | 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    shm->version = HEALTH_SHM_VERSION;
+    shm->size = sizeof(struct HealthShm);
+    shm->interval_ms = interval_ms;
+    shm->pid = (int32_t)getpid();
+    shm->samples = 0;
+    shm->magic = HEALTH_SHM_MAGIC;
+    return shm;
+}
+
+struct HealthShm *health_shm_attach(const char *path)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return NULL;
+    off_t size = lseek(fd, 0, SEEK_END);
+    if (size < (off_t)sizeof(struct HealthShm)) {
+        close(fd);
+        return NULL;
+    }
+    struct HealthShm *shm = map_segment(fd, PROT_READ);
+    if (shm && (shm->magic != HEALTH_SHM_MAGIC || shm->version != HEALTH_SHM_VERSION ||
+                shm->size != sizeof(struct HealthShm))) {
+        health_shm_detach(shm);
+        return NULL;
+    }
+    return shm;
+}
+
+void health_shm_detach(struct HealthShm *shm)
+{
+    if (shm)
+        munmap(shm, sizeof(*shm));
+}
+
+void health_shm_publish(struct HealthShm *shm, const struct HealthReport *report, int result,
+                        const struct HealthTrendSummary *trend)
+{
+    uint64_t seq = __atomic_load_n(&shm->seq, __ATOMIC_RELAXED);
+    if (!(seq & 1))
+        __atomic_store_n(&shm->seq, ++seq, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&shm->report, report, sizeof(*report));
+    if (trend)
+        shm->trend = *trend;
+    else
+        memset(&shm->trend, 0, sizeof(shm->trend));
+    shm->result = result;
+    shm->samples++;
+    shm->published_ms = monotonic_ms();
+    __atomic_store_n(&shm->seq, seq + 1, __ATOMIC_RELEASE);
+}
+
+int health_shm_snapshot(const struct HealthShm *shm, struct HealthSnapshot *snap)
+{
+    for (int i = 0; i < SNAPSHOT_RETRIES; i++) {
+        uint64_t before = __atomic_load_n(&shm->seq, __ATOMIC_ACQUIRE);
+        if (before & 1) {
+            sched_yield();
+            continue;
+        }
+        memcpy(&snap->report, &shm->report, sizeof(snap->report));
+        snap->trend = shm->trend;
+        snap->result = shm->result;
+        snap->samples = shm->samples;
+        snap->interval_ms = shm->interval_ms;
+        snap->pid = shm->pid;
+        uint64_t published = shm->published_ms;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&shm->seq, __ATOMIC_RELAXED) != before)
+            continue;
+        if (snap->samples == 0)
+            return -1;
+        uint64_t now = monotonic_ms();
+        snap->age_ms = now > published ? (uint32_t)(now - published) : 0;
+        return 0;
+    }
+    return -1;
+}
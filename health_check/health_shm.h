@@ -0,0 +1,47 @@
+#ifndef HEALTH_SHM_H
+#define HEALTH_SHM_H
+#include "health_check.h"
+#include "health_trend.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HEALTH_SHM_MAGIC    0xA7714EA1
+#define HEALTH_SHM_VERSION  3
+#define HEALTH_SHM_PATH     "/tmp/pac-health.shm"
+
+/*
+ * seq is a seqlock: odd while the daemon is copying a report in. Readers
+ * retry until they see the same even value before and after their copy.
+ */
+struct HealthShm {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t interval_ms;
+    int32_t  pid;
+    int32_t  result;
+    uint64_t seq;
+    uint64_t samples;
+    uint64_t published_ms;
+    struct HealthReport report;
+    struct HealthTrendSummary trend;
+};
+
+struct HealthSnapshot {
+    struct HealthReport report;
+    struct HealthTrendSummary trend;
+    int      result;
+    uint64_t samples;
+    uint32_t age_ms;
+    uint32_t interval_ms;
+    int      pid;
+};
+
+struct HealthShm *health_shm_create(const char *path, uint32_t interval_ms);
+struct HealthShm *health_shm_attach(const char *path);
+void health_shm_detach(struct HealthShm *shm);
+void health_shm_publish(struct HealthShm *shm, const struct HealthReport *report, int result,
+                        const struct HealthTrendSummary *trend);
+int health_shm_snapshot(const struct HealthShm *shm, struct HealthSnapshot *snap);
+
+#endif
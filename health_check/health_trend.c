@@ -0,0 +1,115 @@
+#include "health_trend.h"
+#include <stdio.h>
+#include <string.h>
+
+void trend_init(struct HealthTrend *trend, double alpha)
+{
+    memset(trend, 0, sizeof(*trend));
+    trend->alpha = alpha > 0.0 && alpha <= 1.0 ? alpha : 0.2;
+}
+
+/* Least-squares slope over the window, so one noisy sample cannot fire an alarm */
+static double window_slope_per_min(const struct MetricTrend *m)
+{
+    if (m->count < 2)
+        return 0.0;
+    uint32_t oldest = (m->head + TREND_WINDOW - m->count) % TREND_WINDOW;
+    uint64_t t0 = m->t_ms[oldest];
+    double sum_t = 0, sum_v = 0, sum_tt = 0, sum_tv = 0;
+    for (uint32_t i = 0; i < m->count; i++) {
+        uint32_t idx = (oldest + i) % TREND_WINDOW;
+        double t = (double)(m->t_ms[idx] - t0) / 60000.0;
+        double v = m->value[idx];
+        sum_t += t;
+        sum_v += v;
+        sum_tt += t * t;
+        sum_tv += t * v;
+    }
+    double n = (double)m->count;
+    double denom = n * sum_tt - sum_t * sum_t;
+    if (denom <= 0.0)
+        return 0.0;
+    return (n * sum_tv - sum_t * sum_v) / denom;
+}
+
+void trend_push(struct MetricTrend *m, uint64_t t_ms, double value, double alpha)
+{
+    m->t_ms[m->head] = t_ms;
+    m->value[m->head] = value;
+    m->head = (m->head + 1) % TREND_WINDOW;
+    if (m->count < TREND_WINDOW)
+        m->count++;
+    m->ewma = m->count == 1 ? value : alpha * value + (1.0 - alpha) * m->ewma;
+    m->min = m->max = value;
+    for (uint32_t i = 0; i < m->count; i++) {
+        double v = m->value[(m->head + TREND_WINDOW - 1 - i) % TREND_WINDOW];
+        if (v < m->min)
+            m->min = v;
+        if (v > m->max)
+            m->max = v;
+    }
+    m->rate_per_min = window_slope_per_min(m);
+}
+
+void trend_update(struct HealthTrend *trend, const struct HealthReport *report, uint64_t t_ms)
+{
+    trend_push(&trend->metric[TREND_ECC_CE], t_ms, report->ecc.value, trend->alpha);
+    trend_push(&trend->metric[TREND_STORAGE_FREE], t_ms, report->storage.value, trend->alpha);
+    trend_push(&trend->metric[TREND_MEM_AVAIL], t_ms, report->memory.value, trend->alpha);
+    /* a zero reading means no sensor was found, not a cold board */
+    if (report->temperature.value > 0)
+        trend_push(&trend->metric[TREND_TEMP], t_ms, report->temperature.value, trend->alpha);
+}
+
+static bool span_ok(const struct MetricTrend *m, uint32_t min_span_ms)
+{
+    if (m->count < 2)
+        return false;
+    uint32_t oldest = (m->head + TREND_WINDOW - m->count) % TREND_WINDOW;
+    uint32_t newest = (m->head + TREND_WINDOW - 1) % TREND_WINDOW;
+    return m->t_ms[newest] - m->t_ms[oldest] >= min_span_ms;
+}
+
+uint32_t trend_evaluate(const struct HealthTrend *trend, const struct TrendConfig *config,
+                        struct HealthTrendSummary *summary)
+{
+    const struct MetricTrend *ecc = &trend->metric[TREND_ECC_CE];
+    const struct MetricTrend *temp = &trend->metric[TREND_TEMP];
+    const struct MetricTrend *storage = &trend->metric[TREND_STORAGE_FREE];
+    uint32_t alarms = 0;
+    if (span_ok(ecc, config->min_span_ms) && ecc->rate_per_min > config->ecc_ce_per_min)
+        alarms |= TREND_ALARM_ECC_RATE;
+    if (span_ok(temp, config->min_span_ms) && temp->rate_per_min > config->temp_c_per_min)
+        alarms |= TREND_ALARM_TEMP_RISE;
+    if (span_ok(storage, config->min_span_ms) &&
+        -storage->rate_per_min > config->storage_pct_per_min)
+        alarms |= TREND_ALARM_STORAGE_DROP;
+    if (summary) {
+        summary->alarms = alarms;
+        summary->ecc_ce_per_min = (float)ecc->rate_per_min;
+        summary->temp_c_per_min = (float)temp->rate_per_min;
+        summary->storage_pct_per_min = (float)storage->rate_per_min;
+    }
+    return alarms;
+}
+
+int trend_alarm_names(uint32_t alarms, char *buf, size_t len)
+{
+    static const struct { uint32_t bit; const char *name; } names[] = {
+        { TREND_ALARM_ECC_RATE,     "ecc_rate" },
+        { TREND_ALARM_TEMP_RISE,    "temp_rise" },
+        { TREND_ALARM_STORAGE_DROP, "storage_drop" },
+    };
+    size_t off = 0;
+    if (len)
+        buf[0] = '\0';
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (!(alarms & names[i].bit))
+            continue;
+        int n = snprintf(buf + off, len - off, "%s%s", off ? "," : "", names[i].name);
+        if (n < 0 || (size_t)n >= len - off)
+            return -1;
+        off += (size_t)n;
+    }
+    return (int)off;
+}
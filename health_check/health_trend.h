@@ -0,0 +1,66 @@
+#ifndef HEALTH_TREND_H
+#define HEALTH_TREND_H
+#include "health_check.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define TREND_WINDOW 32
+
+#define TREND_ECC_CE        0
+#define TREND_STORAGE_FREE  1
+#define TREND_MEM_AVAIL     2
+#define TREND_TEMP          3
+#define TREND_METRICS       4
+
+#define TREND_ALARM_ECC_RATE      (1 << 0)
+#define TREND_ALARM_TEMP_RISE     (1 << 1)
+#define TREND_ALARM_STORAGE_DROP  (1 << 2)
+
+struct MetricTrend {
+    uint64_t t_ms[TREND_WINDOW];
+    double   value[TREND_WINDOW];
+    uint32_t head;
+    uint32_t count;
+    double   min;
+    double   max;
+    double   ewma;
+    double   rate_per_min;
+};
+
+struct HealthTrend {
+    struct MetricTrend metric[TREND_METRICS];
+    double alpha;
+};
+
+struct TrendConfig {
+    double   ecc_ce_per_min;
+    double   temp_c_per_min;
+    double   storage_pct_per_min;
+    uint32_t min_span_ms;
+    double   alpha;
+};
+
+#define TREND_CONFIG_DEFAULT { \
+    .ecc_ce_per_min = 1.0, \
+    .temp_c_per_min = 5.0, \
+    .storage_pct_per_min = 2.0, \
+    .min_span_ms = 10000, \
+    .alpha = 0.2 \
+}
+
+struct HealthTrendSummary {
+    uint32_t alarms;
+    float    ecc_ce_per_min;
+    float    temp_c_per_min;
+    float    storage_pct_per_min;
+};
+
+void trend_init(struct HealthTrend *trend, double alpha);
+void trend_push(struct MetricTrend *m, uint64_t t_ms, double value, double alpha);
+void trend_update(struct HealthTrend *trend, const struct HealthReport *report, uint64_t t_ms);
+uint32_t trend_evaluate(const struct HealthTrend *trend, const struct TrendConfig *config,
+                        struct HealthTrendSummary *summary);
+int trend_alarm_names(uint32_t alarms, char *buf, size_t len);
+
+#endif
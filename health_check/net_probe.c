@@ -0,0 +1,257 @@
+#include "net_probe.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/ip_icmp.h>
+#include <arpa/inet.h>
+
+#define PROBE_ICMP_ID 0x7ac0
+
+static uint32_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static int parse_target(const char *spec, size_t len, struct NetProbeTarget *target)
+{
+    if (len == 0 || len >= sizeof(target->host))
+        return -1;
+    memcpy(target->host, spec, len);
+    target->host[len] = '\0';
+    target->port = NET_PROBE_DEFAULT_PORT;
+    char *colon = strrchr(target->host, ':');
+    if (colon) {
+        long port = strtol(colon + 1, NULL, 10);
+        if (port <= 0 || port > 65535)
+            return -1;
+        target->port = (uint16_t)port;
+        *colon = '\0';
+    }
+    return target->host[0] ? 0 : -1;
+}
+
+int net_probe_parse_targets(const char *list, struct NetProbeTarget *targets, int max)
+{
+    int count = 0;
+    const char *p = list;
+    while (p && *p && count < max) {
+        const char *end = strchr(p, ',');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        while (len > 0 && (*p == ' ' || *p == '\t')) {
+            p++;
+            len--;
+        }
+        if (parse_target(p, len, &targets[count]) == 0)
+            count++;
+        p = end ? end + 1 : NULL;
+    }
+    return count;
+}
+
+int net_probe_target_from_url(const char *url, struct NetProbeTarget *target)
+{
+    uint16_t port = 80;
+    const char *host = strstr(url, "://");
+    if (host) {
+        if (strncmp(url, "https", 5) == 0)
+            port = 443;
+        host += 3;
+    } else {
+        host = url;
+    }
+    size_t len = strcspn(host, "/?#");
+    if (parse_target(host, len, target) < 0)
+        return -1;
+    if (!memchr(host, ':', len))
+        target->port = port;
+    return 0;
+}
+
+/* The verifier host from VERIFIER_URL goes first: it is the peer that matters */
+int net_probe_default_targets(struct NetProbeTarget *targets, int max)
+{
+    int count = 0;
+    const char *url = getenv("VERIFIER_URL");
+    if (max > 0 && url && *url && net_probe_target_from_url(url, &targets[0]) == 0)
+        count++;
+    return count + net_probe_parse_targets(NET_PROBE_DEFAULT_TARGETS,
+                                           targets + count, max - count);
+}
+
+static uint16_t icmp_checksum(const void *data, size_t len)
+{
+    const uint16_t *p = data;
+    uint32_t sum = 0;
+    for (; len > 1; len -= 2)
+        sum += *p++;
+    if (len)
+        sum += *(const uint8_t *)p;
+    sum = (sum >> 16) + (sum & 0xffff);
+    sum += sum >> 16;
+    return (uint16_t)~sum;
+}
+
+/* Unprivileged datagram ICMP first, raw ICMP when running as root */
+static int icmp_open(bool *raw)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, IPPROTO_ICMP);
+    *raw = false;
+    if (fd < 0) {
+        fd = socket(AF_INET, SOCK_RAW | SOCK_NONBLOCK, IPPROTO_ICMP);
+        *raw = true;
+    }
+    return fd;
+}
+
+static bool icmp_send(int fd, const struct sockaddr_in *addr, uint16_t seq)
+{
+    struct icmphdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.type = ICMP_ECHO;
+    hdr.un.echo.id = htons(PROBE_ICMP_ID);
+    hdr.un.echo.sequence = htons(seq);
+    hdr.checksum = icmp_checksum(&hdr, sizeof(hdr));
+    return sendto(fd, &hdr, sizeof(hdr), 0, (const struct sockaddr *)addr,
+                  sizeof(*addr)) == (ssize_t)sizeof(hdr);
+}
+
+/* Returns the probe sequence of an echo reply, or -1 */
+static int icmp_recv(int fd, bool raw)
+{
+    uint8_t buf[512];
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n <= 0)
+        return -1;
+    size_t off = 0;
+    if (raw) {
+        const struct iphdr *ip = (const struct iphdr *)buf;
+        off = (size_t)ip->ihl * 4;
+    }
+    if ((size_t)n < off + sizeof(struct icmphdr))
+        return -1;
+    const struct icmphdr *hdr = (const struct icmphdr *)(buf + off);
+    if (hdr->type != ICMP_ECHOREPLY)
+        return -1;
+    /* datagram sockets rewrite the id to the socket's port */
+    if (raw && ntohs(hdr->un.echo.id) != PROBE_ICMP_ID)
+        return -1;
+    return ntohs(hdr->un.echo.sequence);
+}
+
+static int tcp_start(const struct sockaddr_in *addr)
+{
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (const struct sockaddr *)addr, sizeof(*addr)) == 0 ||
+        errno == EINPROGRESS)
+        return fd;
+    close(fd);
+    return -1;
+}
+
+static bool resolve(const char *host, struct sockaddr_in *addr)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    if (inet_pton(AF_INET, host, &addr->sin_addr) == 1)
+        return true;
+    struct addrinfo hints, *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    if (getaddrinfo(host, NULL, &hints, &res) != 0 || !res)
+        return false;
+    addr->sin_addr = ((struct sockaddr_in *)res->ai_addr)->sin_addr;
+    freeaddrinfo(res);
+    return true;
+}
+
+int net_probe_first(const struct NetProbeTarget *targets, int count, uint32_t timeout_ms,
+                    struct NetProbeResult *result)
+{
+    if (count > NET_PROBE_MAX_TARGETS)
+        count = NET_PROBE_MAX_TARGETS;
+    struct pollfd fds[NET_PROBE_MAX_TARGETS + 1];
+    int owner[NET_PROBE_MAX_TARGETS + 1];
+    int nfds = 0;
+    uint32_t start = now_ms();
+    bool raw = false;
+    int icmp = icmp_open(&raw);
+    if (icmp >= 0) {
+        fds[nfds].fd = icmp;
+        fds[nfds].events = POLLIN;
+        owner[nfds++] = -1;
+    }
+    for (int i = 0; i < count; i++) {
+        struct sockaddr_in addr;
+        if (!resolve(targets[i].host, &addr))
+            continue;
+        if (icmp >= 0)
+            icmp_send(icmp, &addr, (uint16_t)i);
+        addr.sin_port = htons(targets[i].port);
+        int fd = tcp_start(&addr);
+        if (fd < 0)
+            continue;
+        fds[nfds].fd = fd;
+        fds[nfds].events = POLLOUT;
+        owner[nfds++] = i;
+    }
+    int winner = -1;
+    const char *method = NULL;
+    while (winner < 0 && nfds > 0) {
+        uint32_t elapsed = now_ms() - start;
+        if (elapsed >= timeout_ms)
+            break;
+        if (poll(fds, (nfds_t)nfds, (int)(timeout_ms - elapsed)) <= 0)
+            continue;
+        for (int j = 0; j < nfds && winner < 0; j++) {
+            if (!fds[j].revents || fds[j].fd < 0)
+                continue;
+            if (owner[j] < 0) {
+                int seq;
+                while ((seq = icmp_recv(fds[j].fd, raw)) >= 0) {
+                    if (seq < count) {
+                        winner = seq;
+                        method = "icmp";
+                        break;
+                    }
+                }
+                continue;
+            }
+            int err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt(fds[j].fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            /* a refused connection still proves the host answered */
+            if (err == 0 || err == ECONNREFUSED) {
+                winner = owner[j];
+                method = "tcp";
+            } else {
+                close(fds[j].fd);
+                fds[j].fd = -1;
+            }
+        }
+    }
+    for (int j = 0; j < nfds; j++) {
+        if (fds[j].fd >= 0)
+            close(fds[j].fd);
+    }
+    if (winner < 0)
+        return -1;
+    if (result) {
+        result->target = winner;
+        snprintf(result->method, sizeof(result->method), "%s", method);
+        result->rtt_ms = now_ms() - start;
+    }
+    return winner;
+}
@@ -0,0 +1,28 @@
+#ifndef NET_PROBE_H
+#define NET_PROBE_H
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define NET_PROBE_MAX_TARGETS   8
+#define NET_PROBE_DEFAULT_PORT  53
+#define NET_PROBE_DEFAULT_TARGETS "8.8.8.8:53,1.1.1.1:53"
+
+struct NetProbeTarget {
+    char     host[64];
+    uint16_t port;
+};
+
+struct NetProbeResult {
+    int      target;
+    char     method[8];
+    uint32_t rtt_ms;
+};
+
+int net_probe_parse_targets(const char *list, struct NetProbeTarget *targets, int max);
+int net_probe_target_from_url(const char *url, struct NetProbeTarget *target);
+int net_probe_default_targets(struct NetProbeTarget *targets, int max);
+int net_probe_first(const struct NetProbeTarget *targets, int count, uint32_t timeout_ms,
+                    struct NetProbeResult *result);
+
+#endif
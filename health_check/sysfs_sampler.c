@@ -0,0 +1,239 @@
+#include "sysfs_sampler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+
+static void close_fds(struct SysfsSampler *s)
+{
+    for (int i = 0; i < s->n_edac; i++) {
+        close(s->ce_fd[i]);
+        close(s->ue_fd[i]);
+    }
+    for (int i = 0; i < s->n_temp; i++)
+        close(s->temp_fd[i]);
+    s->n_edac = 0;
+    s->n_temp = 0;
+}
+
+static int path_at_root(const struct SysfsSampler *s, const char *path, char *full, size_t size)
+{
+    int n = snprintf(full, size, "%s%s", s->root, path);
+    if (n < 0 || (size_t)n >= size) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    return 0;
+}
+
+static int open_at_root(const struct SysfsSampler *s, const char *path)
+{
+    char full[512];
+    if (path_at_root(s, path, full, sizeof(full)) != 0)
+        return -1;
+    return open(full, O_RDONLY | O_CLOEXEC);
+}
+
+static DIR *opendir_at_root(const struct SysfsSampler *s, const char *path)
+{
+    char full[512];
+    if (path_at_root(s, path, full, sizeof(full)) != 0)
+        return NULL;
+    return opendir(full);
+}
+
+static void add_temp(struct SysfsSampler *s, const char *path)
+{
+    if (s->n_temp == SAMPLER_MAX_TEMP)
+        return;
+    int fd = open_at_root(s, path);
+    if (fd >= 0)
+        s->temp_fd[s->n_temp++] = fd;
+}
+
+static void scan_edac(struct SysfsSampler *s)
+{
+    DIR *probe = opendir_at_root(s, "/sys/devices/system/edac");
+    s->edac_present = probe != NULL;
+    if (probe)
+        closedir(probe);
+    DIR *dir = opendir_at_root(s, "/sys/devices/system/edac/mc");
+    if (!dir)
+        return;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && s->n_edac < SAMPLER_MAX_EDAC) {
+        if (strncmp(entry->d_name, "mc", 2) != 0)
+            continue;
+        char ce_path[512], ue_path[512];
+        int n = snprintf(ce_path, sizeof(ce_path), "/sys/devices/system/edac/mc/%s/ce_count",
+                         entry->d_name);
+        int m = snprintf(ue_path, sizeof(ue_path), "/sys/devices/system/edac/mc/%s/ue_count",
+                         entry->d_name);
+        if (n < 0 || (size_t)n >= sizeof(ce_path) || m < 0 || (size_t)m >= sizeof(ue_path))
+            continue;
+        int ce = open_at_root(s, ce_path);
+        int ue = open_at_root(s, ue_path);
+        if (ce < 0 || ue < 0) {
+            if (ce >= 0)
+                close(ce);
+            if (ue >= 0)
+                close(ue);
+            continue;
+        }
+        s->ce_fd[s->n_edac] = ce;
+        s->ue_fd[s->n_edac] = ue;
+        s->n_edac++;
+    }
+    closedir(dir);
+}
+
+static void scan_temp(struct SysfsSampler *s)
+{
+    DIR *dir = opendir_at_root(s, "/sys/class/thermal");
+    if (dir) {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (strncmp(entry->d_name, "thermal_zone", 12) != 0)
+                continue;
+            char path[512];
+            int n = snprintf(path, sizeof(path), "/sys/class/thermal/%s/temp", entry->d_name);
+            if (n > 0 && (size_t)n < sizeof(path))
+                add_temp(s, path);
+        }
+        closedir(dir);
+    }
+    dir = opendir_at_root(s, "/sys/class/hwmon");
+    if (!dir)
+        return;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.')
+            continue;
+        char hwmon_path[512];
+        int n = snprintf(hwmon_path, sizeof(hwmon_path), "/sys/class/hwmon/%s", entry->d_name);
+        if (n < 0 || (size_t)n >= sizeof(hwmon_path))
+            continue;
+        DIR *sensor_dir = opendir_at_root(s, hwmon_path);
+        if (!sensor_dir)
+            continue;
+        struct dirent *sensor;
+        while ((sensor = readdir(sensor_dir)) != NULL) {
+            if (strstr(sensor->d_name, "temp") && strstr(sensor->d_name, "_input")) {
+                char path[1024];
+                int len = snprintf(path, sizeof(path), "%s/%s", hwmon_path, sensor->d_name);
+                if (len > 0 && (size_t)len < sizeof(path))
+                    add_temp(s, path);
+            }
+        }
+        closedir(sensor_dir);
+    }
+    closedir(dir);
+}
+
+int sampler_rescan(struct SysfsSampler *s)
+{
+    close_fds(s);
+    scan_edac(s);
+    scan_temp(s);
+    s->last_scan = time(NULL);
+    s->stale = false;
+    s->scans++;
+    return s->n_edac + s->n_temp;
+}
+
+static int uevent_open(void)
+{
+    int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                    NETLINK_KOBJECT_UEVENT);
+    if (fd < 0)
+        return -1;
+    struct sockaddr_nl addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = 1;
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Only device add/remove can change the file set; attribute changes cannot */
+static bool uevent_hotplug(int fd)
+{
+    char buf[2048];
+    bool hotplug = false;
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf) - 1, 0)) > 0) {
+        buf[n] = '\0';
+        if (strncmp(buf, "add@", 4) == 0 || strncmp(buf, "remove@", 7) == 0)
+            hotplug = true;
+    }
+    return hotplug;
+}
+
+int sampler_init(struct SysfsSampler *s, const char *root, uint32_t rescan_sec)
+{
+    memset(s, 0, sizeof(*s));
+    snprintf(s->root, sizeof(s->root), "%s", root ? root : "");
+    s->rescan_sec = rescan_sec ? rescan_sec : SAMPLER_RESCAN_SEC;
+    s->uevent_fd = root && *root ? -1 : uevent_open();
+    sampler_rescan(s);
+    return 0;
+}
+
+void sampler_close(struct SysfsSampler *s)
+{
+    close_fds(s);
+    if (s->uevent_fd >= 0)
+        close(s->uevent_fd);
+    s->uevent_fd = -1;
+}
+
+static long read_counter(int fd, bool *failed)
+{
+    char buf[32];
+    ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0) {
+        *failed = true;
+        return -1;
+    }
+    buf[n] = '\0';
+    return atol(buf);
+}
+
+int sampler_read(struct SysfsSampler *s, struct SysfsSample *sample)
+{
+    if ((s->uevent_fd >= 0 && uevent_hotplug(s->uevent_fd)) || s->stale ||
+        time(NULL) - s->last_scan >= (time_t)s->rescan_sec)
+        sampler_rescan(s);
+    memset(sample, 0, sizeof(*sample));
+    sample->edac_present = s->edac_present;
+    bool failed = false;
+    for (int i = 0; i < s->n_edac; i++) {
+        long ce = read_counter(s->ce_fd[i], &failed);
+        long ue = read_counter(s->ue_fd[i], &failed);
+        if (ce >= 0)
+            sample->ce_total += ce;
+        if (ue >= 0)
+            sample->ue_total += ue;
+    }
+    for (int i = 0; i < s->n_temp; i++) {
+        long millic = read_counter(s->temp_fd[i], &failed);
+        if (millic > 0) {
+            uint8_t temp_c = millic / 1000;
+            if (temp_c > sample->max_temp_c)
+                sample->max_temp_c = temp_c;
+            sample->temp_found = true;
+        }
+    }
+    /* a vanished device shows up as a read error; pick it up next time */
+    if (failed)
+        s->stale = true;
+    return 0;
+}
@@ -0,0 +1,39 @@
+#ifndef SYSFS_SAMPLER_H
+#define SYSFS_SAMPLER_H
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#define SAMPLER_MAX_EDAC        16
+#define SAMPLER_MAX_TEMP        32
+#define SAMPLER_RESCAN_SEC      60
+
+struct SysfsSampler {
+    char     root[128];
+    bool     edac_present;
+    int      ce_fd[SAMPLER_MAX_EDAC];
+    int      ue_fd[SAMPLER_MAX_EDAC];
+    int      n_edac;
+    int      temp_fd[SAMPLER_MAX_TEMP];
+    int      n_temp;
+    int      uevent_fd;
+    uint32_t rescan_sec;
+    time_t   last_scan;
+    bool     stale;
+    uint32_t scans;
+};
+
+struct SysfsSample {
+    bool     edac_present;
+    uint32_t ce_total;
+    uint32_t ue_total;
+    bool     temp_found;
+    uint8_t  max_temp_c;
+};
+
+int sampler_init(struct SysfsSampler *s, const char *root, uint32_t rescan_sec);
+void sampler_close(struct SysfsSampler *s);
+int sampler_rescan(struct SysfsSampler *s);
+int sampler_read(struct SysfsSampler *s, struct SysfsSample *sample);
+
+#endif
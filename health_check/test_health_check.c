@@ -0,0 +1,611 @@
+#include "health_check.h"
+#include "net_probe.h"
+#include "sysfs_sampler.h"
+#include "health_score.h"
+#include "health_shm.h"
+#include "health_trend.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_START(name) \
+    printf("\n[TEST] %s...\n", name)
+#define TEST_ASSERT(condition, msg) \
+    do { \
+        if (condition) { \
+            printf("   %s\n", msg); \
+            tests_passed++; \
+        } else { \
+            printf("   FAILED: %s\n", msg); \
+            tests_failed++; \
+        } \
+    } while(0)
+#define TEST_END() \
+    printf("  Done.\n")
+
+static long elapsed_ms(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000 + (now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+static bool check_sleep(uint32_t ms, struct HealthCheckResult *result)
+{
+    usleep(ms * 1000);
+    result->ok = true;
+    result->value = ms;
+    snprintf(result->message, sizeof(result->message), "slept %u ms", ms);
+    return true;
+}
+
+static bool check_fast(const struct HealthConfig *config, struct HealthCheckResult *result)
+{
+    (void)config;
+    return check_sleep(10, result);
+}
+
+static bool check_200(const struct HealthConfig *config, struct HealthCheckResult *result)
+{
+    (void)config;
+    return check_sleep(200, result);
+}
+
+static bool check_hang(const struct HealthConfig *config, struct HealthCheckResult *result)
+{
+    (void)config;
+    return check_sleep(2000, result);
+}
+
+static void test_parallel_latency(void)
+{
+    TEST_START("Checks Run Concurrently");
+    struct HealthConfig config = HEALTH_CONFIG_DEFAULT;
+    const struct HealthCheck checks[] = {
+        { "a", check_200, 0 }, { "b", check_200, 0 },
+        { "c", check_200, 0 }, { "d", check_fast, 0 },
+    };
+    struct HealthCheckResult results[4];
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int timed_out = health_check_execute(&config, checks, 4, results);
+    long ms = elapsed_ms(&start);
+    TEST_ASSERT(timed_out == 0, "No check timed out");
+    TEST_ASSERT(results[0].ok && results[0].value == 200 && results[3].value == 10,
+                "Results land in their slots");
+    TEST_ASSERT(ms < 600, "Latency is the slowest check, not the sum");
+    TEST_END();
+}
+
+static void test_check_deadline(void)
+{
+    TEST_START("Per-Check Deadline");
+    struct HealthConfig config = HEALTH_CONFIG_DEFAULT;
+    config.check_timeout_ms = 1000;
+    const struct HealthCheck checks[] = {
+        { "hang", check_hang, 100 }, { "fast", check_fast, 0 },
+    };
+    struct HealthCheckResult results[2];
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int timed_out = health_check_execute(&config, checks, 2, results);
+    long ms = elapsed_ms(&start);
+    TEST_ASSERT(timed_out == 1, "One check timed out");
+    TEST_ASSERT(!results[0].ok && strstr(results[0].message, "timed out"),
+                "Hung check reported as failed");
+    TEST_ASSERT(results[1].ok, "Other check unaffected");
+    TEST_ASSERT(ms >= 100 && ms < 1000, "Returned at the check deadline");
+    TEST_END();
+}
+
+static void test_global_deadline(void)
+{
+    TEST_START("Global Deadline");
+    struct HealthConfig config = HEALTH_CONFIG_DEFAULT;
+    config.check_timeout_ms = 5000;
+    config.total_timeout_ms = 150;
+    const struct HealthCheck checks[] = {
+        { "hang", check_hang, 0 }, { "slow", check_200, 0 }, { "fast", check_fast, 0 },
+    };
+    struct HealthCheckResult results[3];
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int timed_out = health_check_execute(&config, checks, 3, results);
+    long ms = elapsed_ms(&start);
+    TEST_ASSERT(timed_out == 2, "Checks past the global deadline timed out");
+    TEST_ASSERT(results[2].ok, "Fast check completed");
+    TEST_ASSERT(ms >= 150 && ms < 1000, "Returned at the global deadline");
+    TEST_END();
+}
+
+static volatile int overdue_config_ok = -1;
+
+static bool check_300(const struct HealthConfig *config, struct HealthCheckResult *result)
+{
+    check_sleep(300, result);
+    overdue_config_ok = config->network_targets &&
+                        strcmp(config->network_targets, "10.0.2.2:80") == 0 &&
+                        config->scoring && config->scoring->healthy == 8;
+    return result->ok;
+}
+
+static void test_overdue_check(void)
+{
+    TEST_START("Overdue Check Isolation");
+    struct HealthConfig config = HEALTH_CONFIG_DEFAULT;
+    struct HealthScoreConfig scoring = HEALTH_SCORE_CONFIG_DEFAULT;
+    char *targets = strdup("10.0.2.2:80");
+    config.network_targets = targets;
+    config.scoring = &scoring;
+    const struct HealthCheck checks[] = {
+        { "slow", check_300, 50 }, { "fast", check_fast, 0 },
+    };
+    struct HealthCheckResult results[2];
+    TEST_ASSERT(health_check_execute(&config, checks, 2, results) == 1, "Slow check overdue");
+    /* the overdue thread must not see the caller's config change underneath it */
+    memset(targets, 0, strlen(targets));
+    free(targets);
+    scoring.healthy = 0;
+    config.network_targets = "192.0.2.1:80";
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    TEST_ASSERT(health_check_execute(&config, checks, 2, results) == 1 && results[1].ok,
+                "Second run still reports the slow check");
+    TEST_ASSERT(strstr(results[0].message, "earlier run") != NULL && elapsed_ms(&start) < 50,
+                "Overdue check not started again");
+    usleep(400 * 1000);
+    TEST_ASSERT(overdue_config_ok == 1, "Overdue check kept its own config copy");
+    config.check_timeout_ms = 1000;
+    const struct HealthCheck relaxed[] = { { "slow", check_300, 0 } };
+    TEST_ASSERT(health_check_execute(&config, relaxed, 1, results) == 0 && results[0].ok,
+                "Check runs again once the overdue thread returns");
+    TEST_END();
+}
+
+static void test_probe_targets(void)
+{
+    TEST_START("Network Probe Targets");
+    struct NetProbeTarget targets[NET_PROBE_MAX_TARGETS];
+    int n = net_probe_parse_targets("10.0.2.2:8080, 8.8.8.8,bad:0", targets, NET_PROBE_MAX_TARGETS);
+    TEST_ASSERT(n == 2, "Invalid entries skipped");
+    TEST_ASSERT(strcmp(targets[0].host, "10.0.2.2") == 0 && targets[0].port == 8080,
+                "Explicit port parsed");
+    TEST_ASSERT(targets[1].port == NET_PROBE_DEFAULT_PORT, "Default port applied");
+    TEST_ASSERT(net_probe_target_from_url("https://verifier.local/verify", &targets[0]) == 0 &&
+                strcmp(targets[0].host, "verifier.local") == 0 && targets[0].port == 443,
+                "URL without port uses scheme default");
+    setenv("VERIFIER_URL", "http://10.0.2.2:8080", 1);
+    n = net_probe_default_targets(targets, NET_PROBE_MAX_TARGETS);
+    TEST_ASSERT(n == 3 && strcmp(targets[0].host, "10.0.2.2") == 0,
+                "Verifier host probed first");
+    unsetenv("VERIFIER_URL");
+    TEST_END();
+}
+
+static void test_probe_local(void)
+{
+    TEST_START("Network Probe Reachability");
+    int lfd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    bool listening = lfd >= 0 && bind(lfd, (struct sockaddr *)&addr, sizeof(addr)) == 0 &&
+                     listen(lfd, 4) == 0 &&
+                     getsockname(lfd, (struct sockaddr *)&addr, &len) == 0;
+    TEST_ASSERT(listening, "Local listener ready");
+    char list[64];
+    snprintf(list, sizeof(list), "192.0.2.1:9,127.0.0.1:%u", ntohs(addr.sin_port));
+    struct HealthCheckResult result;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bool ok = health_check_network_targets(list, 2000, &result);
+    long ms = elapsed_ms(&start);
+    TEST_ASSERT(ok && strstr(result.message, "127.0.0.1"), "First reply wins");
+    TEST_ASSERT(ms < 1000, "Does not wait for the unreachable target");
+    if (lfd >= 0)
+        close(lfd);
+    TEST_END();
+}
+
+#define TEST_SYSFS_ROOT "/tmp/test_health_sysfs"
+
+static void write_sysfs(const char *path, const char *value)
+{
+    char full[256];
+    snprintf(full, sizeof(full), TEST_SYSFS_ROOT "%s", path);
+    FILE *f = fopen(full, "w");
+    if (f) {
+        fputs(value, f);
+        fclose(f);
+    }
+}
+
+static void make_sysfs_dir(const char *path)
+{
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "mkdir -p " TEST_SYSFS_ROOT "%s", path);
+    if (system(cmd) != 0)
+        printf("   (mkdir %s failed)\n", path);
+}
+
+static void test_sysfs_sampler(void)
+{
+    TEST_START("Incremental Sysfs Sampler");
+    if (system("rm -rf " TEST_SYSFS_ROOT) != 0)
+        printf("   (cleanup failed)\n");
+    make_sysfs_dir("/sys/devices/system/edac/mc/mc0");
+    make_sysfs_dir("/sys/class/thermal/thermal_zone0");
+    make_sysfs_dir("/sys/class/hwmon/hwmon0");
+    write_sysfs("/sys/devices/system/edac/mc/mc0/ce_count", "3\n");
+    write_sysfs("/sys/devices/system/edac/mc/mc0/ue_count", "0\n");
+    write_sysfs("/sys/class/thermal/thermal_zone0/temp", "45000\n");
+    write_sysfs("/sys/class/hwmon/hwmon0/temp1_input", "52000\n");
+    struct SysfsSampler sampler;
+    sampler_init(&sampler, TEST_SYSFS_ROOT, 3600);
+    TEST_ASSERT(sampler.n_edac == 1 && sampler.n_temp == 2, "Discovered EDAC and sensor files");
+    struct SysfsSample sample;
+    sampler_read(&sampler, &sample);
+    TEST_ASSERT(sample.edac_present && sample.ce_total == 3 && sample.ue_total == 0,
+                "ECC counters sampled");
+    TEST_ASSERT(sample.temp_found && sample.max_temp_c == 52, "Hottest sensor reported");
+    write_sysfs("/sys/devices/system/edac/mc/mc0/ce_count", "12\n");
+    write_sysfs("/sys/class/thermal/thermal_zone0/temp", "91000\n");
+    sampler_read(&sampler, &sample);
+    TEST_ASSERT(sample.ce_total == 12 && sample.max_temp_c == 91, "Re-read through cached fds");
+    TEST_ASSERT(sampler.scans == 1, "No rescan between samples");
+    make_sysfs_dir("/sys/class/thermal/thermal_zone1");
+    write_sysfs("/sys/class/thermal/thermal_zone1/temp", "99000\n");
+    sampler_read(&sampler, &sample);
+    TEST_ASSERT(sample.max_temp_c == 91, "New sensor ignored until rescan");
+    sampler_rescan(&sampler);
+    sampler_read(&sampler, &sample);
+    TEST_ASSERT(sampler.n_temp == 3 && sample.max_temp_c == 99, "Rescan picks up new sensor");
+    sampler_close(&sampler);
+    if (system("rm -rf " TEST_SYSFS_ROOT) != 0)
+        printf("   (cleanup failed)\n");
+    TEST_END();
+}
+
+#define TEST_SHM_PATH "/tmp/test_health.shm"
+
+static volatile bool shm_writer_stop = false;
+
+static void fill_report(struct HealthReport *report, uint32_t k)
+{
+    memset(report, 0, sizeof(*report));
+    report->timestamp = k;
+    report->overall_score = k % 7;
+    report->ecc.value = k;
+    report->temperature.value = k;
+    snprintf(report->memory.message, sizeof(report->memory.message), "sample %u", k);
+}
+
+static void *shm_writer(void *arg)
+{
+    struct HealthShm *shm = arg;
+    struct HealthReport report;
+    for (uint32_t k = 1; !shm_writer_stop; k++) {
+        fill_report(&report, k);
+        health_shm_publish(shm, &report, (int)(k % 3), NULL);
+    }
+    return NULL;
+}
+
+static void test_health_shm(void)
+{
+    TEST_START("Shared-Memory Health Report");
+    unlink(TEST_SHM_PATH);
+    struct HealthShm *writer = health_shm_create(TEST_SHM_PATH, 100);
+    TEST_ASSERT(writer != NULL, "Create report segment");
+    struct HealthShm *reader = health_shm_attach(TEST_SHM_PATH);
+    TEST_ASSERT(reader != NULL, "Attach reader");
+    if (!writer || !reader) {
+        health_shm_detach(writer);
+        health_shm_detach(reader);
+        TEST_END();
+        return;
+    }
+    struct HealthSnapshot snap;
+    TEST_ASSERT(health_shm_snapshot(reader, &snap) != 0, "No snapshot before first publish");
+    struct HealthReport report;
+    fill_report(&report, 42);
+    health_shm_publish(writer, &report, HEALTH_DEGRADED, NULL);
+    TEST_ASSERT(health_shm_snapshot(reader, &snap) == 0 && snap.report.ecc.value == 42 &&
+                snap.result == HEALTH_DEGRADED && snap.interval_ms == 100,
+                "Snapshot returns published report");
+    pthread_t tid;
+    shm_writer_stop = false;
+    pthread_create(&tid, NULL, shm_writer, writer);
+    int torn = 0, taken = 0;
+    for (int i = 0; i < 20000; i++) {
+        if (health_shm_snapshot(reader, &snap) != 0)
+            continue;
+        taken++;
+        uint32_t k = (uint32_t)snap.report.timestamp;
+        char expect[32];
+        snprintf(expect, sizeof(expect), "sample %u", k);
+        if (snap.report.ecc.value != k || snap.report.temperature.value != k ||
+            snap.report.overall_score != k % 7 || strcmp(snap.report.memory.message, expect) != 0)
+            torn++;
+    }
+    shm_writer_stop = true;
+    pthread_join(tid, NULL);
+    TEST_ASSERT(taken > 0, "Snapshots taken during concurrent publishing");
+    TEST_ASSERT(torn == 0, "No torn snapshots");
+    health_shm_detach(reader);
+    health_shm_detach(writer);
+    unlink(TEST_SHM_PATH);
+    TEST_END();
+}
+
+static void test_trend_alarms(void)
+{
+    TEST_START("Trend Statistics and Rate Alarms");
+    struct TrendConfig config = TREND_CONFIG_DEFAULT;
+    struct HealthTrend trend;
+    trend_init(&trend, config.alpha);
+    struct HealthReport report;
+    memset(&report, 0, sizeof(report));
+    report.storage.value = 50;
+    report.temperature.value = 40;
+    for (uint32_t i = 0; i < 10; i++) {
+        report.ecc.value = 3;
+        trend_update(&trend, &report, (uint64_t)i * 5000);
+    }
+    struct HealthTrendSummary summary;
+    TEST_ASSERT(trend_evaluate(&trend, &config, &summary) == 0, "Steady metrics raise no alarm");
+    const struct MetricTrend *ecc = &trend.metric[TREND_ECC_CE];
+    TEST_ASSERT(ecc->min == 3 && ecc->max == 3 && ecc->ewma > 2.999 && ecc->ewma < 3.001, "Min/max/EWMA track steady value");
+
+    /* 2 new CEs and +1 C every 5 s: 24 CE/min and 12 C/min, well below the hard limits */
+    for (uint32_t i = 10; i < 20; i++) {
+        report.ecc.value = 3 + (i - 9) * 2;
+        report.temperature.value = 40 + (i - 9);
+        trend_update(&trend, &report, (uint64_t)i * 5000);
+    }
+    uint32_t alarms = trend_evaluate(&trend, &config, &summary);
+    TEST_ASSERT(alarms & TREND_ALARM_ECC_RATE, "ECC CE rate alarm raised");
+    TEST_ASSERT(alarms & TREND_ALARM_TEMP_RISE, "Temperature rise alarm raised");
+    TEST_ASSERT(!(alarms & TREND_ALARM_STORAGE_DROP), "Storage unchanged, no alarm");
+    TEST_ASSERT(summary.ecc_ce_per_min > 1.0f && summary.temp_c_per_min > 5.0f,
+                "Summary carries per-minute rates");
+    TEST_ASSERT(ecc->max == 23 && ecc->min == 3, "Window min/max follow the ramp");
+
+    for (uint32_t i = 20; i < 20 + TREND_WINDOW; i++) {
+        trend_update(&trend, &report, (uint64_t)i * 5000);
+    }
+    TEST_ASSERT(ecc->count == TREND_WINDOW, "Window is bounded");
+    TEST_ASSERT(ecc->min == 23 && ecc->rate_per_min > -0.001 && ecc->rate_per_min < 0.001, "Old samples age out of the window");
+    TEST_ASSERT(trend_evaluate(&trend, &config, &summary) == 0, "Alarms clear once rates settle");
+
+    struct HealthTrend fresh;
+    trend_init(&fresh, config.alpha);
+    report.ecc.value = 0;
+    trend_update(&fresh, &report, 0);
+    report.ecc.value = 100;
+    trend_update(&fresh, &report, 1000);
+    TEST_ASSERT(trend_evaluate(&fresh, &config, NULL) == 0,
+                "No alarm before the minimum span is observed");
+
+    char names[64];
+    trend_alarm_names(TREND_ALARM_ECC_RATE | TREND_ALARM_TEMP_RISE, names, sizeof(names));
+    TEST_ASSERT(strcmp(names, "ecc_rate,temp_rise") == 0, "Alarm names are listed");
+    TEST_END();
+}
+
+static void set_all_checks(struct HealthReport *report, bool ok)
+{
+    memset(report, 0, sizeof(*report));
+    report->watchdog.ok = report->ecc.ok = report->storage.ok = ok;
+    report->network.ok = report->memory.ok = report->temperature.ok = ok;
+}
+
+#define TEST_SCORE_CONF "/tmp/test_health_score.conf"
+
+static void test_scoring_engine(void)
+{
+    TEST_START("Weighted Scoring Engine");
+    struct HealthScoreConfig config;
+    TEST_ASSERT(health_score_load(&config, "/nonexistent/health_score.conf") == 1 &&
+                config.min_tier3 == 9 && config.weight[HEALTH_CHECK_MEMORY] == 3,
+                "Missing config falls back to defaults");
+    struct HealthReport report;
+    set_all_checks(&report, true);
+    int ret = health_score_apply(&config, &report);
+    TEST_ASSERT(ret == HEALTH_OK && report.overall_score == 10 && report.max_score == 10 &&
+                report.max_tier == 3, "All checks pass: 10/10, tier 3");
+    report.network.ok = false;
+    health_score_apply(&config, &report);
+    TEST_ASSERT(report.overall_score == 9 && report.max_tier == 3,
+                "Low-weight network loss keeps tier 3");
+    report.network.ok = true;
+    report.watchdog.ok = false;
+    health_score_apply(&config, &report);
+    TEST_ASSERT(report.overall_score == 8 && report.max_tier == 2 &&
+                strcmp(report.overall_status, "healthy") == 0,
+                "Required tier 3 check failing caps the tier");
+    report.watchdog.ok = true;
+    report.memory.ok = false;
+    ret = health_score_apply(&config, &report);
+    TEST_ASSERT(ret == HEALTH_DEGRADED && report.overall_score == 7 && report.max_tier == 1,
+                "Required tier 2 check failing caps the tier");
+    set_all_checks(&report, false);
+    report.memory.ok = true;
+    ret = health_score_apply(&config, &report);
+    TEST_ASSERT(ret == HEALTH_CRITICAL && strcmp(report.overall_status, "critical") == 0 &&
+                report.overall_score == 2, "Mostly failing run is critical");
+
+    FILE *f = fopen(TEST_SCORE_CONF, "w");
+    fputs("# test\nweight network 0\nweight memory 1\nrequire tier3 temperature\n"
+          "threshold tier3 10\n", f);
+    fclose(f);
+    TEST_ASSERT(health_score_load(&config, TEST_SCORE_CONF) == 0 &&
+                config.weight[HEALTH_CHECK_NETWORK] == 0 && config.min_tier3 == 10 &&
+                config.require_tier3 == HEALTH_CHECK_BIT(HEALTH_CHECK_TEMPERATURE),
+                "Config file overrides weights, requirements and thresholds");
+    set_all_checks(&report, true);
+    report.network.ok = false;
+    health_score_apply(&config, &report);
+    TEST_ASSERT(report.overall_score == 10 && report.max_tier == 3, "Zero-weight check is ignored");
+    f = fopen(TEST_SCORE_CONF, "w");
+    fputs("weight bogus 2\n", f);
+    fclose(f);
+    TEST_ASSERT(health_score_load(&config, TEST_SCORE_CONF) < 0 && config.min_tier3 == 9,
+                "Invalid config rejected, defaults kept");
+    unlink(TEST_SCORE_CONF);
+    TEST_ASSERT(strcmp(health_score_to_status(5, 6), "healthy") == 0 &&
+                strcmp(health_score_to_status(3, 6), "degraded") == 0,
+                "Legacy status helper uses the same bands");
+    TEST_END();
+}
+
+static void test_simulated_faults(void)
+{
+    TEST_START("Simulated Fault Injection");
+    if (access("/tmp/inject_temperature", F_OK) == 0 || access("/tmp/inject_ecc_errors", F_OK) == 0 ||
+        access("/host_tmp", F_OK) == 0) {
+        printf("  Skipped: fault-injection files already present\n");
+        TEST_END();
+        return;
+    }
+    FILE *f = fopen("/tmp/inject_temperature", "w");
+    fputs("95\n", f);
+    fclose(f);
+    f = fopen("/tmp/inject_ecc_errors", "w");
+    fputs("3\n", f);
+    fclose(f);
+    struct HealthConfig config = HEALTH_CONFIG_DEFAULT;
+    config.network_targets = "127.0.0.1:1";
+    config.simulate = true;
+    struct HealthReport report;
+    health_check_run(&config, &report);
+    TEST_ASSERT(!report.temperature.ok && report.temperature.value == 95,
+                "Injected temperature overrides sensors");
+    TEST_ASSERT(report.ecc.ok && report.ecc.value == 3, "Injected ECC count is scored");
+    TEST_ASSERT(report.watchdog.ok, "Missing watchdog is simulated");
+    config.simulate = false;
+    health_check_run(&config, &report);
+    TEST_ASSERT(report.temperature.value != 95, "Injection ignored without simulate");
+    unlink("/tmp/inject_temperature");
+    unlink("/tmp/inject_ecc_errors");
+    TEST_END();
+}
+
+static void test_report_json(void)
+{
+    TEST_START("Report JSON Serialisation");
+    struct HealthReport report;
+    set_all_checks(&report, true);
+    snprintf(report.network.message, sizeof(report.network.message),
+             "host \"gw\"\nunreachable\\");
+    char buf[4096];
+    int len = health_report_to_json(&report, buf, sizeof(buf));
+    TEST_ASSERT(len > 0 && (size_t)len == strlen(buf), "Pretty report fits");
+    TEST_ASSERT(strstr(buf, "host \\\"gw\\\"\\nunreachable\\\\") != NULL,
+                "Message contents escaped");
+    TEST_ASSERT(strstr(buf, "legacy_format") != NULL, "Pretty report keeps legacy block");
+    TEST_ASSERT(health_report_to_json(&report, buf, 64) == -1, "Truncation reported, not hidden");
+    int fds[2];
+    TEST_ASSERT(pipe(fds) == 0, "Pipe created");
+    int compact_len = health_report_to_fd(&report, fds[1], true);
+    close(fds[1]);
+    ssize_t got = read(fds[0], buf, sizeof(buf) - 1);
+    close(fds[0]);
+    buf[got > 0 ? got : 0] = '\0';
+    TEST_ASSERT(compact_len > 0 && got == compact_len && compact_len < len,
+                "Compact report streamed and smaller");
+    TEST_ASSERT(strstr(buf, "legacy_format") == NULL && strchr(buf, '\n') == NULL,
+                "Compact report has no legacy block or newlines");
+    TEST_END();
+}
+
+static void test_report_cbor(void)
+{
+    TEST_START("Report CBOR Encoding");
+    struct HealthReport report;
+    set_all_checks(&report, true);
+    report.network.ok = false;
+    report.overall_score = 9;
+    report.max_score = 10;
+    report.max_tier = 3;
+    strcpy(report.overall_status, "healthy");
+    report.memory.value = 70000;
+    strcpy(report.memory.message, "Memory healthy");
+    uint8_t buf[2048];
+    int full = health_report_to_cbor(&report, buf, sizeof(buf), false);
+    static const uint8_t prefix[] = {
+        0xad, 0x01, 0xf5, 0x02, 0xf5, 0x03, 0xf5, 0x04, 0xf4, 0x05, 0xf5, 0x06, 0xf5,
+        0x07, 0x09, 0x08, 0x0a, 0x09, 0x67, 'h', 'e', 'a', 'l', 't', 'h', 'y',
+    };
+    TEST_ASSERT(full > (int)sizeof(prefix) && memcmp(buf, prefix, sizeof(prefix)) == 0,
+                "Claim map starts with the ok flags, score and status");
+    static const uint8_t values[] = { 0x0c, 0x86, 0x00, 0x00, 0x00, 0x00, 0x1a, 0x00, 0x01, 0x11, 0x70, 0x00 };
+    bool found = false;
+    for (int i = 0; i + (int)sizeof(values) <= full && !found; i++)
+        found = memcmp(buf + i, values, sizeof(values)) == 0;
+    TEST_ASSERT(found, "Check values carried as an array");
+    int compact = health_report_to_cbor(&report, buf, sizeof(buf), true);
+    TEST_ASSERT(compact > 0 && compact < full && buf[0] == 0xac, "Compact map omits messages");
+    char json[4096];
+    TEST_ASSERT(compact < health_report_to_json(&report, json, sizeof(json)) / 10,
+                "CBOR is an order of magnitude smaller than JSON");
+    TEST_ASSERT(health_report_to_cbor(&report, buf, 16, false) == -1, "Overflow reported");
+    TEST_END();
+}
+
+static void test_full_run(void)
+{
+    TEST_START("Full Health Run");
+    struct HealthConfig config = HEALTH_CONFIG_DEFAULT;
+    config.network_timeout_sec = 1;
+    struct HealthReport report;
+    int ret = health_check_run(&config, &report);
+    TEST_ASSERT(ret >= HEALTH_OK && ret <= HEALTH_CRITICAL, "Run returns a health level");
+    TEST_ASSERT(report.max_score == HEALTH_SCORE_SCALE && report.overall_score <= HEALTH_SCORE_SCALE &&
+                report.max_tier >= 1 && report.max_tier <= 3, "Score in range");
+    TEST_ASSERT(report.memory.message[0] != '\0' && report.network.message[0] != '\0',
+                "Every check reported");
+    TEST_END();
+}
+
+int main(void)
+{
+    printf("PAC Health Check Test Suite\n");
+    test_parallel_latency();
+    test_check_deadline();
+    test_global_deadline();
+    test_overdue_check();
+    test_probe_targets();
+    test_probe_local();
+    test_sysfs_sampler();
+    test_trend_alarms();
+    test_health_shm();
+    test_scoring_engine();
+    test_simulated_faults();
+    test_report_json();
+    test_report_cbor();
+    test_full_run();
+    printf("\n\n");
+    printf("  TEST SUMMARY                                              \n");
+    printf("\n");
+    printf("  Passed: %3d                                               \n", tests_passed);
+    printf("  Failed: %3d                                               \n", tests_failed);
+    printf("\n");
+    if (tests_failed == 0) {
+        printf("\n All tests PASSED! Health checks are working correctly.\n\n");
+        return 0;
+    } else {
+        printf("\n Some tests FAILED. Please review the output above.\n\n");
+        return 1;
+    }
+}
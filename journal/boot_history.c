@@ -0,0 +1,282 @@
+#include "boot_history.h"
+#include "crc32.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#define HISTORY_HEADER_SIZE ((off_t)sizeof(struct HistoryHeader))
+#define HISTORY_RECORD_SIZE sizeof(struct HistoryEvent)
+#define HISTORY_READ_CHUNK  64
+
+static struct {
+    int fd;
+    int pending;
+    off_t size;
+    size_t max_bytes;
+    char path[4096];
+    struct HistoryEvent batch[HISTORY_BATCH_MAX];
+} history_state = { -1, 0, 0, HISTORY_MAX_BYTES, "", {{0}} };
+
+static const char *reason_names[] = {
+    [HISTORY_REASON_BOOT]      = "boot",
+    [HISTORY_REASON_PROMOTE]   = "promote",
+    [HISTORY_REASON_STAY]      = "stay",
+    [HISTORY_REASON_DEMOTE]    = "demote",
+    [HISTORY_REASON_EMERGENCY] = "emergency",
+    [HISTORY_REASON_MANUAL]    = "manual",
+};
+
+#define REASON_COUNT (int)(sizeof(reason_names) / sizeof(reason_names[0]))
+
+static uint32_t event_crc(const struct HistoryEvent *ev)
+{
+    return crc32_compute(ev, offsetof(struct HistoryEvent, crc32));
+}
+
+static bool header_valid(const struct HistoryHeader *hdr)
+{
+    return hdr->magic == HISTORY_MAGIC && hdr->version == HISTORY_VERSION &&
+           hdr->record_size == HISTORY_RECORD_SIZE;
+}
+
+int history_path_for(const char *journal_path, char *buf, size_t len)
+{
+    int n = snprintf(buf, len, "%s%s", journal_path, HISTORY_SUFFIX);
+    if (n < 0 || (size_t)n >= len)
+        return JOURNAL_ERR_INVALID;
+    return JOURNAL_OK;
+}
+
+const char *history_reason_name(uint8_t reason)
+{
+    if (reason < REASON_COUNT && reason_names[reason])
+        return reason_names[reason];
+    return "unknown";
+}
+
+int history_reason_from_name(const char *name)
+{
+    for (int i = 0; i < REASON_COUNT; i++) {
+        if (reason_names[i] && strcasecmp(name, reason_names[i]) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static int rotated_path(const char *path, char *buf, size_t len)
+{
+    int n = snprintf(buf, len, "%s%s", path, HISTORY_ROTATED_SUFFIX);
+    if (n < 0 || (size_t)n >= len)
+        return JOURNAL_ERR_INVALID;
+    return JOURNAL_OK;
+}
+
+/* The header of a new log is not synced here; the first flush covers it */
+static int open_log(const char *path)
+{
+    int fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0600);
+    if (fd < 0) {
+        fprintf(stderr, "history: open failed: %s\n", strerror(errno));
+        return JOURNAL_ERR_IO;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        fprintf(stderr, "history: stat failed: %s\n", strerror(errno));
+        close(fd);
+        return JOURNAL_ERR_IO;
+    }
+    struct HistoryHeader hdr;
+    off_t size = st.st_size;
+    if (size < HISTORY_HEADER_SIZE) {
+        hdr.magic = HISTORY_MAGIC;
+        hdr.version = HISTORY_VERSION;
+        hdr.record_size = HISTORY_RECORD_SIZE;
+        if (ftruncate(fd, 0) != 0 || write(fd, &hdr, sizeof(hdr)) != (ssize_t)sizeof(hdr)) {
+            fprintf(stderr, "history: failed to write header: %s\n", strerror(errno));
+            close(fd);
+            return JOURNAL_ERR_IO;
+        }
+        size = HISTORY_HEADER_SIZE;
+    } else {
+        if (pread(fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr) || !header_valid(&hdr)) {
+            fprintf(stderr, "history: %s is not a boot history log\n", path);
+            close(fd);
+            return JOURNAL_ERR_CORRUPT;
+        }
+        off_t tail = (size - HISTORY_HEADER_SIZE) % (off_t)HISTORY_RECORD_SIZE;
+        if (tail != 0 && ftruncate(fd, size - tail) != 0) {
+            fprintf(stderr, "history: failed to drop torn tail: %s\n", strerror(errno));
+            close(fd);
+            return JOURNAL_ERR_IO;
+        }
+        size -= tail;
+    }
+    history_state.fd = fd;
+    history_state.size = size;
+    return JOURNAL_OK;
+}
+
+int history_open(const char *path)
+{
+    if (history_state.fd >= 0) {
+        fprintf(stderr, "history: already open\n");
+        return JOURNAL_ERR_INVALID;
+    }
+    char old[sizeof(history_state.path) + sizeof(HISTORY_ROTATED_SUFFIX)];
+    if (strlen(path) >= sizeof(history_state.path) ||
+        rotated_path(path, old, sizeof(old)) != JOURNAL_OK) {
+        fprintf(stderr, "history: path too long\n");
+        return JOURNAL_ERR_INVALID;
+    }
+    int ret = open_log(path);
+    if (ret != JOURNAL_OK)
+        return ret;
+    strcpy(history_state.path, path);
+    history_state.pending = 0;
+    return JOURNAL_OK;
+}
+
+void history_set_max_bytes(size_t max_bytes)
+{
+    history_state.max_bytes = max_bytes;
+}
+
+/* Moves the full log to <path>.1, replacing the previous generation */
+static int history_rotate(void)
+{
+    char old[sizeof(history_state.path) + sizeof(HISTORY_ROTATED_SUFFIX)];
+    rotated_path(history_state.path, old, sizeof(old));
+    if (rename(history_state.path, old) != 0) {
+        fprintf(stderr, "history: rotate failed: %s\n", strerror(errno));
+        return JOURNAL_ERR_IO;
+    }
+    close(history_state.fd);
+    history_state.fd = -1;
+    return open_log(history_state.path);
+}
+
+int history_append(uint64_t boot_count, uint8_t from_tier, uint8_t to_tier,
+                   uint8_t reason, uint8_t health_score)
+{
+    if (history_state.fd < 0) {
+        fprintf(stderr, "history: not open\n");
+        return JOURNAL_ERR_INVALID;
+    }
+    if (history_state.pending == HISTORY_BATCH_MAX) {
+        int ret = history_flush();
+        if (ret != JOURNAL_OK)
+            return ret;
+    }
+    struct HistoryEvent *ev = &history_state.batch[history_state.pending++];
+    ev->boot_count = boot_count;
+    ev->timestamp = (uint64_t)time(NULL);
+    ev->from_tier = from_tier;
+    ev->to_tier = to_tier;
+    ev->reason = reason;
+    ev->health_score = health_score;
+    ev->crc32 = event_crc(ev);
+    return JOURNAL_OK;
+}
+
+int history_flush(void)
+{
+    if (history_state.fd < 0) {
+        fprintf(stderr, "history: not open\n");
+        return JOURNAL_ERR_INVALID;
+    }
+    if (history_state.pending == 0)
+        return JOURNAL_OK;
+    size_t len = (size_t)history_state.pending * HISTORY_RECORD_SIZE;
+    if (history_state.max_bytes && history_state.size > HISTORY_HEADER_SIZE &&
+        (size_t)history_state.size + len > history_state.max_bytes) {
+        int ret = history_rotate();
+        if (ret != JOURNAL_OK)
+            return ret;
+    }
+    ssize_t n = write(history_state.fd, history_state.batch, len);
+    if (n != (ssize_t)len) {
+        if (n < 0)
+            fprintf(stderr, "history: write failed: %s\n", strerror(errno));
+        else
+            fprintf(stderr, "history: short write: wrote %zd, expected %zu\n", n, len);
+        return JOURNAL_ERR_IO;
+    }
+    history_state.size += (off_t)len;
+    if (fdatasync(history_state.fd) != 0) {
+        fprintf(stderr, "history: fdatasync failed: %s\n", strerror(errno));
+        return JOURNAL_ERR_IO;
+    }
+    history_state.pending = 0;
+    return JOURNAL_OK;
+}
+
+void history_close(void)
+{
+    if (history_state.fd < 0)
+        return;
+    history_flush();
+    close(history_state.fd);
+    history_state.fd = -1;
+    history_state.pending = 0;
+}
+
+static int read_log(const char *path, uint64_t since, history_visit_fn visit, void *arg,
+                    int *count)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "history: open failed: %s\n", strerror(errno));
+        return JOURNAL_ERR_IO;
+    }
+    struct HistoryHeader hdr;
+    if (read(fd, &hdr, sizeof(hdr)) != (ssize_t)sizeof(hdr) || !header_valid(&hdr)) {
+        fprintf(stderr, "history: %s is not a boot history log\n", path);
+        close(fd);
+        return JOURNAL_ERR_CORRUPT;
+    }
+    struct HistoryEvent chunk[HISTORY_READ_CHUNK];
+    ssize_t n;
+    while ((n = read(fd, chunk, sizeof(chunk))) > 0) {
+        int records = (int)(n / (ssize_t)HISTORY_RECORD_SIZE);
+        for (int i = 0; i < records; i++) {
+            if (chunk[i].crc32 != event_crc(&chunk[i]) || chunk[i].boot_count < since)
+                continue;
+            (*count)++;
+            if (visit && visit(&chunk[i], arg) != 0) {
+                close(fd);
+                return 1;
+            }
+        }
+        if (n % (ssize_t)HISTORY_RECORD_SIZE)
+            break;
+    }
+    if (n < 0) {
+        fprintf(stderr, "history: read failed: %s\n", strerror(errno));
+        close(fd);
+        return JOURNAL_ERR_IO;
+    }
+    close(fd);
+    return 0;
+}
+
+/* Visits the rotated generation, if any, before the live log */
+int history_read(const char *path, uint64_t since, history_visit_fn visit, void *arg)
+{
+    char old[4096 + sizeof(HISTORY_ROTATED_SUFFIX)];
+    int count = 0;
+    if (rotated_path(path, old, sizeof(old)) != JOURNAL_OK)
+        return JOURNAL_ERR_INVALID;
+    if (access(old, F_OK) == 0) {
+        int ret = read_log(old, since, visit, arg, &count);
+        if (ret != 0)
+            return ret < 0 ? ret : count;
+    }
+    int ret = read_log(path, since, visit, arg, &count);
+    return ret < 0 ? ret : count;
+}
@@ -0,0 +1,52 @@
+#ifndef BOOT_HISTORY_H
+#define BOOT_HISTORY_H
+
+#include "boot_journal.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HISTORY_MAGIC       0xA771E7E7
+#define HISTORY_VERSION     1
+#define HISTORY_BATCH_MAX   32
+#define HISTORY_SUFFIX      ".hist"
+#define HISTORY_ROTATED_SUFFIX ".1"
+#define HISTORY_MAX_BYTES   (64 * 1024)
+
+#define HISTORY_REASON_BOOT      0
+#define HISTORY_REASON_PROMOTE   1
+#define HISTORY_REASON_STAY      2
+#define HISTORY_REASON_DEMOTE    3
+#define HISTORY_REASON_EMERGENCY 4
+#define HISTORY_REASON_MANUAL    5
+
+struct HistoryHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+} __attribute__((packed));
+
+struct HistoryEvent {
+    uint64_t boot_count;
+    uint64_t timestamp;
+    uint8_t  from_tier;
+    uint8_t  to_tier;
+    uint8_t  reason;
+    uint8_t  health_score;
+    uint32_t crc32;
+} __attribute__((packed));
+
+typedef int (*history_visit_fn)(const struct HistoryEvent *ev, void *arg);
+
+int history_open(const char *path);
+int history_append(uint64_t boot_count, uint8_t from_tier, uint8_t to_tier,
+                   uint8_t reason, uint8_t health_score);
+int history_flush(void);
+void history_set_max_bytes(size_t max_bytes);
+void history_close(void);
+int history_read(const char *path, uint64_t since, history_visit_fn visit, void *arg);
+int history_path_for(const char *journal_path, char *buf, size_t len);
+const char *history_reason_name(uint8_t reason);
+int history_reason_from_name(const char *name);
+
+#endif
@@ -1,53 +1,63 @@
+#define _GNU_SOURCE
 #include "boot_journal.h"
+#include "crc32.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <time.h>
+#include <stdarg.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 
-static uint32_t crc32_table[256];
-static bool crc32_table_initialized = false;
+static bool journal_verbose = true;
 static struct {
     char *path;
     int fd;
     bool initialized;
-} journal_state = {NULL, -1, false};
+    bool ring;
+    uint32_t ring_slots;
+    uint32_t ring_next;
+    uint64_t ring_seq;
+    uint8_t *map;
+    size_t map_len;
+    bool aligned;
+    bool dsync;
+} journal_state = {NULL, -1, false, false, 0, 0, 0, NULL, 0, false, false};
 
 #define PAGE_SIZE sizeof(struct BootRecord)
 #define PAGE_A_OFFSET 0
-#define PAGE_B_OFFSET PAGE_SIZE
+#define PAGE_B_OFFSET (journal_state.aligned ? (off_t)JOURNAL_SECTOR_SIZE : (off_t)PAGE_SIZE)
 #define JOURNAL_FILE_SIZE (PAGE_SIZE * 2)
+#define ALIGNED_FILE_SIZE (JOURNAL_SECTOR_SIZE * 2)
+#define RING_HEADER_SIZE sizeof(struct JournalRingHeader)
+#define RING_SLOT_SIZE sizeof(struct JournalSlot)
+#define RING_SLOT_OFFSET(idx) ((off_t)(RING_HEADER_SIZE + (off_t)(idx) * RING_SLOT_SIZE))
+#define EXT_HEADER_SIZE sizeof(struct JournalExtHeader)
+#define EXT_PAYLOAD_MAX (JOURNAL_EXT_SIZE - EXT_HEADER_SIZE)
+#define EXT_STRIDE ((size_t)(journal_state.aligned ? JOURNAL_SECTOR_SIZE : JOURNAL_EXT_SIZE))
 
-static void crc32_init_table(void)
+_Static_assert(sizeof(struct BootRecord) <= 64, "hot record must fit one cache line");
+
+static void journal_info(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+static void journal_info(const char *fmt, ...)
 {
-    uint32_t poly = 0xEDB88320;
-    for (uint32_t i = 0; i < 256; i++) {
-        uint32_t crc = i;
-        for (int j = 0; j < 8; j++) {
-            if (crc & 1)
-                crc = (crc >> 1) ^ poly;
-            else
-                crc >>= 1;
-        }
-        crc32_table[i] = crc;
-    }
-    crc32_table_initialized = true;
+    if (!journal_verbose)
+        return;
+    va_list ap;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
 }
 
-static uint32_t crc32_compute(const void *data, size_t len)
+void journal_set_verbose(bool verbose)
 {
-    const uint8_t *buf = (const uint8_t *)data;
-    uint32_t crc = 0xFFFFFFFF;
-    if (!crc32_table_initialized)
-        crc32_init_table();
-    for (size_t i = 0; i < len; i++) {
-        crc = (crc >> 8) ^ crc32_table[(crc ^ buf[i]) & 0xFF];
-    }
-    return ~crc;
+    journal_verbose = verbose;
 }
 
 static uint32_t record_calculate_crc(const struct BootRecord *rec)
@@ -56,35 +66,96 @@ static uint32_t record_calculate_crc(const struct BootRecord *rec)
     return crc32_compute(rec, crc_len);
 }
 
-static int read_page(int fd, off_t offset, struct BootRecord *rec)
+static int map_file(void)
+{
+    struct stat st;
+    if (fstat(journal_state.fd, &st) != 0) {
+        fprintf(stderr, "journal: fstat failed: %s\n", strerror(errno));
+        return JOURNAL_ERR_IO;
+    }
+    if (st.st_size <= 0) {
+        fprintf(stderr, "journal: cannot map empty journal\n");
+        return JOURNAL_ERR_IO;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     journal_state.fd, 0);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "journal: mmap failed: %s\n", strerror(errno));
+        return JOURNAL_ERR_IO;
+    }
+    if (journal_state.map)
+        munmap(journal_state.map, journal_state.map_len);
+    journal_state.map = map;
+    journal_state.map_len = st.st_size;
+    return JOURNAL_OK;
+}
+
+static bool map_covers(off_t offset, size_t len)
+{
+    if ((size_t)offset + len <= journal_state.map_len)
+        return true;
+    return map_file() == JOURNAL_OK && (size_t)offset + len <= journal_state.map_len;
+}
+
+static int map_read(off_t offset, void *buf, size_t len)
 {
+    if (!map_covers(offset, len)) {
+        fprintf(stderr, "journal: read beyond mapped journal at %ld\n", (long)offset);
+        return JOURNAL_ERR_IO;
+    }
+    memcpy(buf, journal_state.map + offset, len);
+    return JOURNAL_OK;
+}
+
+static int map_write(off_t offset, const void *buf, size_t len)
+{
+    if (!map_covers(offset, len)) {
+        fprintf(stderr, "journal: write beyond mapped journal at %ld\n", (long)offset);
+        return JOURNAL_ERR_IO;
+    }
+    memcpy(journal_state.map + offset, buf, len);
+    size_t pagesz = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = (size_t)offset & ~(pagesz - 1);
+    if (msync(journal_state.map + start, (size_t)offset + len - start, MS_SYNC) != 0) {
+        fprintf(stderr, "journal: msync failed: %s\n", strerror(errno));
+        return JOURNAL_ERR_IO;
+    }
+    return JOURNAL_OK;
+}
+
+static int read_block(int fd, off_t offset, void *buf, size_t len)
+{
+    if (journal_state.map && fd == journal_state.fd)
+        return map_read(offset, buf, len);
     if (lseek(fd, offset, SEEK_SET) != offset) {
         fprintf(stderr, "journal: lseek failed: %s\n", strerror(errno));
         return JOURNAL_ERR_IO;
     }
-    ssize_t n = read(fd, rec, PAGE_SIZE);
-    if (n != PAGE_SIZE) {
+    ssize_t n = read(fd, buf, len);
+    if (n != (ssize_t)len) {
         if (n < 0)
             fprintf(stderr, "journal: read failed: %s\n", strerror(errno));
         else
-            fprintf(stderr, "journal: short read: got %zd, expected %zu\n", n, PAGE_SIZE);
+            fprintf(stderr, "journal: short read: got %zd, expected %zu\n", n, len);
         return JOURNAL_ERR_IO;
     }
     return JOURNAL_OK;
 }
 
-static int write_page(int fd, off_t offset, const struct BootRecord *rec)
+static int write_block(int fd, off_t offset, const void *buf, size_t len)
 {
+    if (journal_state.map && fd == journal_state.fd)
+        return map_write(offset, buf, len);
     if (lseek(fd, offset, SEEK_SET) != offset) {
         fprintf(stderr, "journal: lseek failed: %s\n", strerror(errno));
         return JOURNAL_ERR_IO;
     }
-    ssize_t n = write(fd, rec, PAGE_SIZE);
-    if (n != PAGE_SIZE) {
+    ssize_t n = write(fd, buf, len);
+    if (n != (ssize_t)len) {
         if (n < 0)
             fprintf(stderr, "journal: write failed: %s\n", strerror(errno));
         else
-            fprintf(stderr, "journal: short write: wrote %zd, expected %zu\n", n, PAGE_SIZE);
+            fprintf(stderr, "journal: short write: wrote %zd, expected %zu\n", n, len);
         return JOURNAL_ERR_IO;
     }
     if (fsync(fd) != 0) {
@@ -94,6 +165,215 @@ static int write_page(int fd, off_t offset, const struct BootRecord *rec)
     return JOURNAL_OK;
 }
 
+static int read_sector(int fd, off_t offset, struct BootRecord *rec)
+{
+    void *buf;
+    if (posix_memalign(&buf, JOURNAL_SECTOR_SIZE, JOURNAL_SECTOR_SIZE) != 0)
+        return JOURNAL_ERR_NOMEM;
+    ssize_t n = pread(fd, buf, JOURNAL_SECTOR_SIZE, offset);
+    if (n < (ssize_t)PAGE_SIZE) {
+        if (n < 0)
+            fprintf(stderr, "journal: sector read failed: %s\n", strerror(errno));
+        else
+            fprintf(stderr, "journal: short sector read at %ld: got %zd\n", (long)offset, n);
+        free(buf);
+        return JOURNAL_ERR_IO;
+    }
+    memcpy(rec, buf, PAGE_SIZE);
+    free(buf);
+    return JOURNAL_OK;
+}
+
+static int write_sector(int fd, off_t offset, const struct BootRecord *rec)
+{
+    void *buf;
+    if (posix_memalign(&buf, JOURNAL_SECTOR_SIZE, JOURNAL_SECTOR_SIZE) != 0)
+        return JOURNAL_ERR_NOMEM;
+    memset(buf, 0, JOURNAL_SECTOR_SIZE);
+    memcpy(buf, rec, PAGE_SIZE);
+    uint32_t magic = JOURNAL_ALIGNED_MAGIC;
+    memcpy((uint8_t *)buf + PAGE_SIZE, &magic, sizeof(magic));
+    ssize_t n = pwrite(fd, buf, JOURNAL_SECTOR_SIZE, offset);
+    free(buf);
+    if (n != JOURNAL_SECTOR_SIZE) {
+        if (n < 0)
+            fprintf(stderr, "journal: sector write failed: %s\n", strerror(errno));
+        else
+            fprintf(stderr, "journal: short sector write: wrote %zd\n", n);
+        return JOURNAL_ERR_IO;
+    }
+    if (!journal_state.dsync && fsync(fd) != 0) {
+        fprintf(stderr, "journal: fsync failed: %s\n", strerror(errno));
+        return JOURNAL_ERR_IO;
+    }
+    return JOURNAL_OK;
+}
+
+static int read_page(int fd, off_t offset, struct BootRecord *rec)
+{
+    if (journal_state.aligned && !journal_state.map)
+        return read_sector(fd, offset, rec);
+    return read_block(fd, offset, rec, PAGE_SIZE);
+}
+
+static int write_page(int fd, off_t offset, const struct BootRecord *rec)
+{
+    if (journal_state.aligned && !journal_state.map)
+        return write_sector(fd, offset, rec);
+    return write_block(fd, offset, rec, PAGE_SIZE);
+}
+
+static bool probe_aligned(int fd, off_t size)
+{
+    const off_t sectors[] = { 0, JOURNAL_SECTOR_SIZE };
+    for (int i = 0; i < 2; i++) {
+        uint32_t magic;
+        off_t off = sectors[i] + (off_t)PAGE_SIZE;
+        if (size < off + (off_t)sizeof(magic))
+            continue;
+        if (pread(fd, &magic, sizeof(magic), off) == (ssize_t)sizeof(magic) &&
+            magic == JOURNAL_ALIGNED_MAGIC)
+            return true;
+    }
+    return false;
+}
+
+static int reopen_direct(const char *path)
+{
+    int fd = open(path, O_RDWR | O_DIRECT | O_DSYNC);
+    if (fd < 0 && errno == EINVAL) {
+        journal_info("journal: O_DIRECT unsupported for %s, using O_DSYNC\n", path);
+        fd = open(path, O_RDWR | O_DSYNC);
+    }
+    if (fd < 0) {
+        fprintf(stderr, "journal: reopen failed: %s\n", strerror(errno));
+        return JOURNAL_ERR_IO;
+    }
+    close(journal_state.fd);
+    journal_state.fd = fd;
+    journal_state.dsync = true;
+    return JOURNAL_OK;
+}
+
+static uint32_t ring_header_crc(const struct JournalRingHeader *hdr)
+{
+    return crc32_compute(hdr, offsetof(struct JournalRingHeader, crc32));
+}
+
+static uint32_t ring_slot_crc(const struct JournalSlot *slot)
+{
+    return crc32_compute(slot, offsetof(struct JournalSlot, crc32));
+}
+
+static bool ring_header_valid(const struct JournalRingHeader *hdr)
+{
+    if (hdr->magic != JOURNAL_RING_MAGIC)
+        return false;
+    if (hdr->crc32 != ring_header_crc(hdr))
+        return false;
+    if (hdr->slot_size != RING_SLOT_SIZE)
+        return false;
+    return hdr->slots >= 2 && hdr->slots <= JOURNAL_RING_SLOTS_MAX;
+}
+
+static bool ring_slot_valid(const struct JournalSlot *slot)
+{
+    if (slot->magic != JOURNAL_RING_MAGIC)
+        return false;
+    if (slot->crc32 != ring_slot_crc(slot))
+        return false;
+    return journal_validate(&slot->rec);
+}
+
+static bool probe_ring_header(int fd, off_t size, struct JournalRingHeader *hdr)
+{
+    if (size < (off_t)RING_HEADER_SIZE)
+        return false;
+    if (lseek(fd, 0, SEEK_SET) != 0)
+        return false;
+    if (read(fd, hdr, RING_HEADER_SIZE) != (ssize_t)RING_HEADER_SIZE)
+        return false;
+    return ring_header_valid(hdr);
+}
+
+static int ring_append(const struct BootRecord *rec)
+{
+    struct JournalSlot slot;
+    memset(&slot, 0, sizeof(slot));
+    slot.seq = journal_state.ring_seq + 1;
+    memcpy(&slot.rec, rec, sizeof(slot.rec));
+    slot.magic = JOURNAL_RING_MAGIC;
+    slot.crc32 = ring_slot_crc(&slot);
+    uint32_t idx = journal_state.ring_next;
+    if (write_block(journal_state.fd, RING_SLOT_OFFSET(idx), &slot, RING_SLOT_SIZE) != JOURNAL_OK)
+        return JOURNAL_ERR_IO;
+    journal_state.ring_seq = slot.seq;
+    journal_state.ring_next = (idx + 1) % journal_state.ring_slots;
+    return JOURNAL_OK;
+}
+
+static bool ring_scan(struct BootRecord *rec, uint32_t *best_idx, uint64_t *best_seq)
+{
+    bool found = false;
+    for (uint32_t i = 0; i < journal_state.ring_slots; i++) {
+        struct JournalSlot slot;
+        if (journal_state.map) {
+            if (!map_covers(RING_SLOT_OFFSET(i), RING_SLOT_SIZE))
+                continue;
+            memcpy(&slot, journal_state.map + RING_SLOT_OFFSET(i), RING_SLOT_SIZE);
+        } else if (pread(journal_state.fd, &slot, RING_SLOT_SIZE, RING_SLOT_OFFSET(i)) !=
+                   (ssize_t)RING_SLOT_SIZE) {
+            continue;
+        }
+        if (!ring_slot_valid(&slot))
+            continue;
+        if (!found || slot.seq > *best_seq) {
+            found = true;
+            *best_idx = i;
+            *best_seq = slot.seq;
+            if (rec)
+                memcpy(rec, &slot.rec, sizeof(*rec));
+        }
+    }
+    return found;
+}
+
+static void ring_sync_position(void)
+{
+    uint32_t idx = 0;
+    uint64_t seq = 0;
+    if (ring_scan(NULL, &idx, &seq)) {
+        journal_state.ring_next = (idx + 1) % journal_state.ring_slots;
+        journal_state.ring_seq = seq;
+    } else {
+        journal_state.ring_next = 0;
+        journal_state.ring_seq = 0;
+    }
+}
+
+static int ring_create(int fd, uint32_t slots)
+{
+    struct JournalRingHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = JOURNAL_RING_MAGIC;
+    hdr.slots = slots;
+    hdr.slot_size = RING_SLOT_SIZE;
+    hdr.crc32 = ring_header_crc(&hdr);
+    if (ftruncate(fd, 0) != 0 || ftruncate(fd, RING_SLOT_OFFSET(slots)) != 0) {
+        fprintf(stderr, "journal: ftruncate failed: %s\n", strerror(errno));
+        return JOURNAL_ERR_IO;
+    }
+    if (write_block(fd, 0, &hdr, RING_HEADER_SIZE) != JOURNAL_OK)
+        return JOURNAL_ERR_IO;
+    journal_state.ring = true;
+    journal_state.ring_slots = slots;
+    journal_state.ring_next = 0;
+    journal_state.ring_seq = 0;
+    struct BootRecord rec;
+    journal_create_default(&rec);
+    return ring_append(&rec);
+}
+
 bool journal_validate(const struct BootRecord *rec)
 {
     if (rec->trailer != JOURNAL_MAGIC) {
@@ -127,7 +407,7 @@ void journal_create_default(struct BootRecord *rec)
     rec->crc32 = record_calculate_crc(rec);
 }
 
-int journal_init(const char *path)
+static int journal_open(const char *path, uint32_t ring_slots, bool aligned)
 {
     if (!path) {
         fprintf(stderr, "journal: path is NULL\n");
@@ -152,7 +432,58 @@ int journal_init(const char *path)
         journal_state.path = NULL;
         return JOURNAL_ERR_IO;
     }
-    if (!exists || st.st_size < JOURNAL_FILE_SIZE) {
+    bool fresh = !exists || st.st_size < (off_t)JOURNAL_FILE_SIZE;
+    struct JournalRingHeader hdr;
+    if (exists && probe_ring_header(journal_state.fd, st.st_size, &hdr)) {
+        journal_state.ring = true;
+        journal_state.ring_slots = hdr.slots;
+        if (st.st_size < RING_SLOT_OFFSET(hdr.slots) &&
+            ftruncate(journal_state.fd, RING_SLOT_OFFSET(hdr.slots)) != 0) {
+            fprintf(stderr, "journal: ftruncate failed: %s\n", strerror(errno));
+        }
+        ring_sync_position();
+        journal_info("journal: opened existing ring journal at %s (%u slots)\n",
+               path, hdr.slots);
+    } else if (ring_slots > 0 && fresh) {
+        if (ring_create(journal_state.fd, ring_slots) != JOURNAL_OK) {
+            close(journal_state.fd);
+            free(journal_state.path);
+            journal_state.path = NULL;
+            journal_state.fd = -1;
+            journal_state.ring = false;
+            return JOURNAL_ERR_IO;
+        }
+        journal_info("journal: created new ring journal at %s (%u slots)\n",
+               path, ring_slots);
+    } else if ((exists && probe_aligned(journal_state.fd, st.st_size)) || (aligned && fresh)) {
+        bool create = !exists || !probe_aligned(journal_state.fd, st.st_size);
+        journal_state.aligned = true;
+        int ret = reopen_direct(path);
+        if (ret == JOURNAL_OK && create) {
+            struct BootRecord rec;
+            journal_create_default(&rec);
+            if (ftruncate(journal_state.fd, ALIGNED_FILE_SIZE) != 0 ||
+                write_page(journal_state.fd, PAGE_A_OFFSET, &rec) != JOURNAL_OK ||
+                write_page(journal_state.fd, PAGE_B_OFFSET, &rec) != JOURNAL_OK) {
+                fprintf(stderr, "journal: failed to create aligned journal\n");
+                ret = JOURNAL_ERR_IO;
+            }
+        }
+        if (ret != JOURNAL_OK) {
+            close(journal_state.fd);
+            free(journal_state.path);
+            journal_state.path = NULL;
+            journal_state.fd = -1;
+            journal_state.aligned = false;
+            journal_state.dsync = false;
+            return JOURNAL_ERR_IO;
+        }
+        if (create) {
+            journal_info("journal: created new aligned journal at %s\n", path);
+        } else {
+            journal_info("journal: opened existing aligned journal at %s\n", path);
+        }
+    } else if (fresh) {
         struct BootRecord rec;
         journal_create_default(&rec);
         if (write_page(journal_state.fd, PAGE_A_OFFSET, &rec) != JOURNAL_OK) {
@@ -169,20 +500,114 @@ int journal_init(const char *path)
             journal_state.fd = -1;
             return JOURNAL_ERR_IO;
         }
-        printf("journal: created new journal at %s\n", path);
+        journal_info("journal: created new journal at %s\n", path);
     } else {
-        printf("journal: opened existing journal at %s\n", path);
+        if (ring_slots > 0 || aligned)
+            journal_info("journal: %s is a dual-page journal, keeping legacy layout\n", path);
+        journal_info("journal: opened existing journal at %s\n", path);
     }
     journal_state.initialized = true;
     return JOURNAL_OK;
 }
 
-int journal_recover(struct BootRecord *rec)
+int journal_init(const char *path)
+{
+    return journal_open(path, 0, false);
+}
+
+int journal_init_aligned(const char *path)
+{
+    return journal_open(path, 0, true);
+}
+
+bool journal_is_aligned(void)
+{
+    return journal_state.initialized && journal_state.aligned;
+}
+
+int journal_init_ring(const char *path, uint32_t slots)
+{
+    if (slots < 2 || slots > JOURNAL_RING_SLOTS_MAX) {
+        fprintf(stderr, "journal: invalid ring size %u (2-%u)\n",
+                slots, JOURNAL_RING_SLOTS_MAX);
+        return JOURNAL_ERR_INVALID;
+    }
+    return journal_open(path, slots, false);
+}
+
+int journal_init_mmap(const char *path)
+{
+    int ret = journal_open(path, 0, false);
+    if (ret != JOURNAL_OK)
+        return ret;
+    ret = map_file();
+    if (ret != JOURNAL_OK) {
+        journal_close();
+        return ret;
+    }
+    journal_info("journal: mapped %zu bytes of %s\n", journal_state.map_len, path);
+    return JOURNAL_OK;
+}
+
+bool journal_is_mapped(void)
 {
+    return journal_state.initialized && journal_state.map != NULL;
+}
+
+bool journal_is_ring(void)
+{
+    return journal_state.initialized && journal_state.ring;
+}
+
+static int ring_recover(struct BootRecord *rec)
+{
+    uint32_t idx = 0;
+    uint64_t seq = 0;
+    if (ring_scan(rec, &idx, &seq)) {
+        journal_state.ring_next = (idx + 1) % journal_state.ring_slots;
+        journal_state.ring_seq = seq;
+        journal_info("journal: recovered from slot %u (seq=%lu)\n",
+               idx, (unsigned long)seq);
+        return JOURNAL_OK;
+    }
+    fprintf(stderr, "journal: no valid ring slots, creating default\n");
+    journal_create_default(rec);
+    return ring_append(rec);
+}
+
+int journal_read_history(struct BootRecord *recs, int max)
+{
+    if (!recs || max <= 0) {
+        fprintf(stderr, "journal: invalid history buffer\n");
+        return JOURNAL_ERR_INVALID;
+    }
     if (!journal_state.initialized || journal_state.fd < 0) {
         fprintf(stderr, "journal: not initialized\n");
         return JOURNAL_ERR_INVALID;
     }
+    if (!journal_state.ring) {
+        return journal_recover(&recs[0]) == JOURNAL_OK ? 1 : JOURNAL_ERR_IO;
+    }
+    int count = 0;
+    uint64_t prev_seq = 0;
+    uint32_t idx = journal_state.ring_next;
+    for (uint32_t n = 0; n < journal_state.ring_slots && count < max; n++) {
+        idx = (idx + journal_state.ring_slots - 1) % journal_state.ring_slots;
+        struct JournalSlot slot;
+        if (read_block(journal_state.fd, RING_SLOT_OFFSET(idx), &slot, RING_SLOT_SIZE) != JOURNAL_OK)
+            break;
+        if (!ring_slot_valid(&slot))
+            continue;
+        if (count > 0 && slot.seq >= prev_seq)
+            break;
+        prev_seq = slot.seq;
+        memcpy(&recs[count++], &slot.rec, sizeof(slot.rec));
+    }
+    return count;
+}
+
+static int pages_recover(struct BootRecord *rec)
+{
     struct BootRecord page_a, page_b;
     bool a_valid = false, b_valid = false;
     if (read_page(journal_state.fd, PAGE_A_OFFSET, &page_a) == JOURNAL_OK) {
@@ -194,22 +619,22 @@ int journal_recover(struct BootRecord *rec)
     if (a_valid && b_valid) {
         if (page_a.boot_count >= page_b.boot_count) {
             memcpy(rec, &page_a, sizeof(*rec));
-            printf("journal: recovered from page A (boot_count=%lu)\n", 
+            journal_info("journal: recovered from page A (boot_count=%lu)\n", 
                    (unsigned long)page_a.boot_count);
         } else {
             memcpy(rec, &page_b, sizeof(*rec));
-            printf("journal: recovered from page B (boot_count=%lu)\n", 
+            journal_info("journal: recovered from page B (boot_count=%lu)\n", 
                    (unsigned long)page_b.boot_count);
         }
         return JOURNAL_OK;
     } else if (a_valid) {
         memcpy(rec, &page_a, sizeof(*rec));
-        printf("journal: recovered from page A only\n");
+        journal_info("journal: recovered from page A only\n");
         write_page(journal_state.fd, PAGE_B_OFFSET, &page_a);
         return JOURNAL_OK;
     } else if (b_valid) {
         memcpy(rec, &page_b, sizeof(*rec));
-        printf("journal: recovered from page B only\n");
+        journal_info("journal: recovered from page B only\n");
         write_page(journal_state.fd, PAGE_A_OFFSET, &page_b);
         return JOURNAL_OK;
     } else {
@@ -221,6 +646,29 @@ int journal_recover(struct BootRecord *rec)
     }
 }
 
+static int commit_record(const struct BootRecord *rec)
+{
+    if (journal_state.ring)
+        return ring_append(rec);
+    if (write_page(journal_state.fd, PAGE_A_OFFSET, rec) != JOURNAL_OK) {
+        return JOURNAL_ERR_IO;
+    }
+    if (write_page(journal_state.fd, PAGE_B_OFFSET, rec) != JOURNAL_OK) {
+        fprintf(stderr, "journal: warning - page B write failed\n");
+        return JOURNAL_ERR_IO;
+    }
+    return JOURNAL_OK;
+}
+
+int journal_recover(struct BootRecord *rec)
+{
+    if (!journal_state.initialized || journal_state.fd < 0) {
+        fprintf(stderr, "journal: not initialized\n");
+        return JOURNAL_ERR_INVALID;
+    }
+    return journal_state.ring ? ring_recover(rec) : pages_recover(rec);
+}
+
 int journal_read(struct BootRecord *rec)
 {
     if (!rec) {
@@ -246,6 +694,7 @@ int journal_write(const struct BootRecord *rec)
     }
     struct BootRecord updated;
     memcpy(&updated, rec, sizeof(updated));
+    updated.version = JOURNAL_VERSION;
     updated.timestamp = (uint64_t)time(NULL);
     updated.trailer = JOURNAL_MAGIC;
     updated.crc32 = record_calculate_crc(&updated);
@@ -253,16 +702,68 @@ int journal_write(const struct BootRecord *rec)
         fprintf(stderr, "journal: record validation failed before write\n");
         return JOURNAL_ERR_INVALID;
     }
-    if (write_page(journal_state.fd, PAGE_A_OFFSET, &updated) != JOURNAL_OK) {
-        return JOURNAL_ERR_IO;
+    return commit_record(&updated);
+}
+
+int journal_txn_begin(struct JournalTxn *txn)
+{
+    if (!txn) {
+        fprintf(stderr, "journal: txn is NULL\n");
+        return JOURNAL_ERR_INVALID;
     }
-    if (write_page(journal_state.fd, PAGE_B_OFFSET, &updated) != JOURNAL_OK) {
-        fprintf(stderr, "journal: warning - page B write failed\n");
-        return JOURNAL_ERR_IO;
+    txn->active = false;
+    int ret = journal_read(&txn->rec);
+    if (ret != JOURNAL_OK)
+        return ret;
+    txn->active = true;
+    return JOURNAL_OK;
+}
+
+int journal_txn_apply(struct JournalTxn *txn, const char *ops)
+{
+    if (!txn || !txn->active || !ops) {
+        fprintf(stderr, "journal: no active transaction\n");
+        return JOURNAL_ERR_INVALID;
+    }
+    char buf[256];
+    if (strlen(ops) >= sizeof(buf)) {
+        fprintf(stderr, "journal: operation list too long\n");
+        return JOURNAL_ERR_INVALID;
+    }
+    strcpy(buf, ops);
+    struct BootRecord staged = txn->rec;
+    char *save = NULL;
+    for (char *op = strtok_r(buf, ";", &save); op; op = strtok_r(NULL, ";", &save)) {
+        while (*op == ' ')
+            op++;
+        if (*op == '\0')
+            continue;
+        if (journal_apply_op(&staged, op) != JOURNAL_OK) {
+            fprintf(stderr, "journal: invalid operation: %s\n", op);
+            return JOURNAL_ERR_INVALID;
+        }
     }
+    txn->rec = staged;
     return JOURNAL_OK;
 }
 
+int journal_txn_commit(struct JournalTxn *txn)
+{
+    if (!txn || !txn->active) {
+        fprintf(stderr, "journal: no active transaction\n");
+        return JOURNAL_ERR_INVALID;
+    }
+    int ret = journal_write(&txn->rec);
+    txn->active = false;
+    return ret;
+}
+
+void journal_txn_abort(struct JournalTxn *txn)
+{
+    if (txn)
+        txn->active = false;
+}
+
 const char *journal_get_path(void)
 {
     return journal_state.path;
@@ -270,6 +771,11 @@ const char *journal_get_path(void)
 
 void journal_close(void)
 {
+    if (journal_state.map) {
+        munmap(journal_state.map, journal_state.map_len);
+        journal_state.map = NULL;
+        journal_state.map_len = 0;
+    }
     if (journal_state.fd >= 0) {
         close(journal_state.fd);
         journal_state.fd = -1;
@@ -279,6 +785,12 @@ void journal_close(void)
         journal_state.path = NULL;
     }
     journal_state.initialized = false;
+    journal_state.aligned = false;
+    journal_state.dsync = false;
+    journal_state.ring = false;
+    journal_state.ring_slots = 0;
+    journal_state.ring_next = 0;
+    journal_state.ring_seq = 0;
 }
 
 void journal_print(const struct BootRecord *rec)
@@ -346,3 +858,343 @@ bool journal_has_flag(const struct BootRecord *rec, uint32_t flag)
 {
     return (rec->flags & flag) != 0;
 }
+
+static const char *const journal_field_names[] = {
+    "version", "tier", "tries_t2", "tries_t3", "rollback_idx",
+    "flags", "boot_count", "timestamp", NULL
+};
+
+const char *journal_field_name(int index)
+{
+    if (index < 0 || index >= (int)(sizeof(journal_field_names) / sizeof(journal_field_names[0])))
+        return NULL;
+    return journal_field_names[index];
+}
+
+uint32_t journal_flag_from_name(const char *name)
+{
+    if (!name)
+        return 0;
+    if (strcasecmp(name, "emergency") == 0)
+        return FLAG_EMERGENCY;
+    if (strcasecmp(name, "quarantine") == 0)
+        return FLAG_QUARANTINE;
+    if (strcasecmp(name, "brownout") == 0)
+        return FLAG_BROWNOUT;
+    if (strcasecmp(name, "dirty") == 0)
+        return FLAG_DIRTY;
+    if (strcasecmp(name, "network_gated") == 0)
+        return FLAG_NETWORK_GATED;
+    return 0;
+}
+
+int journal_field_get(const struct BootRecord *rec, const char *name, uint64_t *value)
+{
+    if (!rec || !name || !value)
+        return JOURNAL_ERR_INVALID;
+    if (strcmp(name, "version") == 0)
+        *value = rec->version;
+    else if (strcmp(name, "tier") == 0)
+        *value = rec->tier;
+    else if (strcmp(name, "tries_t2") == 0)
+        *value = rec->tries_t2;
+    else if (strcmp(name, "tries_t3") == 0)
+        *value = rec->tries_t3;
+    else if (strcmp(name, "rollback_idx") == 0)
+        *value = rec->rollback_idx;
+    else if (strcmp(name, "flags") == 0)
+        *value = rec->flags;
+    else if (strcmp(name, "boot_count") == 0)
+        *value = rec->boot_count;
+    else if (strcmp(name, "timestamp") == 0)
+        *value = rec->timestamp;
+    else
+        return JOURNAL_ERR_INVALID;
+    return JOURNAL_OK;
+}
+
+int journal_field_set(struct BootRecord *rec, const char *name, uint64_t value)
+{
+    if (!rec || !name)
+        return JOURNAL_ERR_INVALID;
+    if (strcmp(name, "tier") == 0) {
+        if (value < TIER_1 || value > TIER_3)
+            return JOURNAL_ERR_INVALID;
+        rec->tier = (uint8_t)value;
+    } else if (strcmp(name, "tries_t2") == 0 && value <= UINT8_MAX) {
+        rec->tries_t2 = (uint8_t)value;
+    } else if (strcmp(name, "tries_t3") == 0 && value <= UINT8_MAX) {
+        rec->tries_t3 = (uint8_t)value;
+    } else if (strcmp(name, "rollback_idx") == 0 && value <= UINT8_MAX) {
+        rec->rollback_idx = (uint8_t)value;
+    } else if (strcmp(name, "flags") == 0 && value <= UINT32_MAX) {
+        rec->flags = (uint32_t)value;
+    } else if (strcmp(name, "boot_count") == 0) {
+        rec->boot_count = value;
+    } else {
+        return JOURNAL_ERR_INVALID;
+    }
+    return JOURNAL_OK;
+}
+
+int journal_apply_op(struct BootRecord *rec, const char *op)
+{
+    if (!rec || !op)
+        return JOURNAL_ERR_INVALID;
+    char name[32];
+    const char *eq = strchr(op, '=');
+    size_t name_len = eq ? (size_t)(eq - op) : strlen(op);
+    if (name_len == 0 || name_len >= sizeof(name))
+        return JOURNAL_ERR_INVALID;
+    memcpy(name, op, name_len);
+    name[name_len] = '\0';
+    const char *arg = eq ? eq + 1 : NULL;
+    if (strcmp(name, "inc-boot") == 0 && !arg) {
+        rec->boot_count++;
+        return JOURNAL_OK;
+    }
+    if (strcmp(name, "reset-tries") == 0 && !arg) {
+        journal_reset_tries(rec);
+        return JOURNAL_OK;
+    }
+    if (!arg || *arg == '\0')
+        return JOURNAL_ERR_INVALID;
+    if (strcmp(name, "set-flag") == 0 || strcmp(name, "clear-flag") == 0) {
+        uint32_t flag = journal_flag_from_name(arg);
+        if (flag == 0)
+            return JOURNAL_ERR_INVALID;
+        if (name[0] == 's')
+            journal_set_flag(rec, flag);
+        else
+            journal_clear_flag(rec, flag);
+        return JOURNAL_OK;
+    }
+    char *end;
+    errno = 0;
+    unsigned long long value = strtoull(arg, &end, 0);
+    if (errno != 0 || *end != '\0')
+        return JOURNAL_ERR_INVALID;
+    if (strcmp(name, "dec-tries") == 0)
+        return journal_decrement_tries(rec, (uint8_t)value) < 0 ? JOURNAL_ERR_INVALID : JOURNAL_OK;
+    return journal_field_set(rec, name, value);
+}
+
+static off_t ext_offset(int copy)
+{
+    off_t base;
+    if (journal_state.ring)
+        base = RING_SLOT_OFFSET(journal_state.ring_slots);
+    else if (journal_state.aligned)
+        base = ALIGNED_FILE_SIZE;
+    else
+        base = JOURNAL_FILE_SIZE;
+    return base + (off_t)copy * (off_t)EXT_STRIDE;
+}
+
+static bool ext_valid(uint8_t *area)
+{
+    struct JournalExtHeader hdr;
+    memcpy(&hdr, area, sizeof(hdr));
+    if (hdr.magic != JOURNAL_EXT_MAGIC || hdr.len > EXT_PAYLOAD_MAX)
+        return false;
+    uint32_t crc = hdr.crc32;
+    memset(area + offsetof(struct JournalExtHeader, crc32), 0, sizeof(crc));
+    bool ok = crc32_compute(area, EXT_HEADER_SIZE + hdr.len) == crc;
+    memcpy(area + offsetof(struct JournalExtHeader, crc32), &crc, sizeof(crc));
+    return ok;
+}
+
+/* Loads the newest valid extension copy into area; *slot is -1 if none */
+static int ext_load(uint8_t *area, int *slot, uint32_t *seq)
+{
+    void *buf;
+    if (posix_memalign(&buf, JOURNAL_SECTOR_SIZE, EXT_STRIDE) != 0)
+        return JOURNAL_ERR_NOMEM;
+    *slot = -1;
+    *seq = 0;
+    memset(area, 0, JOURNAL_EXT_SIZE);
+    for (int copy = 0; copy < 2; copy++) {
+        if (pread(journal_state.fd, buf, EXT_STRIDE, ext_offset(copy)) < (ssize_t)JOURNAL_EXT_SIZE)
+            continue;
+        struct JournalExtHeader hdr;
+        memcpy(&hdr, buf, sizeof(hdr));
+        if (!ext_valid(buf) || (*slot >= 0 && hdr.seq <= *seq))
+            continue;
+        memcpy(area, buf, JOURNAL_EXT_SIZE);
+        *slot = copy;
+        *seq = hdr.seq;
+    }
+    free(buf);
+    return JOURNAL_OK;
+}
+
+static int ext_store(const uint8_t *payload, uint16_t len, int slot, uint32_t seq, bool sync)
+{
+    void *buf;
+    if (posix_memalign(&buf, JOURNAL_SECTOR_SIZE, EXT_STRIDE) != 0)
+        return JOURNAL_ERR_NOMEM;
+    memset(buf, 0, EXT_STRIDE);
+    struct JournalExtHeader hdr = { JOURNAL_EXT_MAGIC, seq + 1, len, 0, 0 };
+    memcpy(buf, &hdr, sizeof(hdr));
+    memcpy((uint8_t *)buf + EXT_HEADER_SIZE, payload, len);
+    hdr.crc32 = crc32_compute(buf, EXT_HEADER_SIZE + len);
+    memcpy(buf, &hdr, sizeof(hdr));
+    int target = slot == 0 ? 1 : 0;
+    ssize_t n = pwrite(journal_state.fd, buf, EXT_STRIDE, ext_offset(target));
+    free(buf);
+    if (n != (ssize_t)EXT_STRIDE) {
+        fprintf(stderr, "journal: extension write failed: %s\n",
+                n < 0 ? strerror(errno) : "short write");
+        return JOURNAL_ERR_IO;
+    }
+    if (sync && !journal_state.dsync && fsync(journal_state.fd) != 0) {
+        fprintf(stderr, "journal: fsync failed: %s\n", strerror(errno));
+        return JOURNAL_ERR_IO;
+    }
+    return JOURNAL_OK;
+}
+
+/* Loads the newest extension payload; *len is 0 when there is none */
+static int ext_load_payload(uint8_t *payload, uint16_t *len, int *slot, uint32_t *seq)
+{
+    if (!journal_state.initialized || journal_state.fd < 0) {
+        fprintf(stderr, "journal: not initialized\n");
+        return JOURNAL_ERR_INVALID;
+    }
+    uint8_t area[JOURNAL_EXT_SIZE];
+    int ret = ext_load(area, slot, seq);
+    if (ret != JOURNAL_OK)
+        return ret;
+    struct JournalExtHeader hdr;
+    memcpy(&hdr, area, sizeof(hdr));
+    *len = *slot < 0 ? 0 : hdr.len;
+    memcpy(payload, area + EXT_HEADER_SIZE, *len);
+    return JOURNAL_OK;
+}
+
+static int ext_find(const uint8_t *payload, uint16_t plen, uint8_t type, void *buf, size_t max)
+{
+    const uint8_t *p = payload;
+    const uint8_t *end = p + plen;
+    while (p + 2 <= end && p + 2 + p[1] <= end) {
+        if (p[0] == type) {
+            size_t len = p[1] < max ? p[1] : max;
+            memcpy(buf, p + 2, len);
+            return (int)len;
+        }
+        p += 2 + p[1];
+    }
+    return 0;
+}
+
+/* Replaces the type entry in payload with buf, or drops it when len is 0 */
+static int ext_replace(uint8_t *payload, uint16_t *plen, uint8_t type, const void *buf, size_t len)
+{
+    uint8_t old[EXT_PAYLOAD_MAX];
+    memcpy(old, payload, *plen);
+    size_t out = 0;
+    const uint8_t *p = old;
+    const uint8_t *end = old + *plen;
+    while (p + 2 <= end && p + 2 + p[1] <= end) {
+        if (p[0] != type) {
+            memcpy(payload + out, p, 2 + p[1]);
+            out += 2 + p[1];
+        }
+        p += 2 + p[1];
+    }
+    if (len > 0) {
+        if (out + 2 + len > EXT_PAYLOAD_MAX) {
+            fprintf(stderr, "journal: extension area full\n");
+            return JOURNAL_ERR_NOMEM;
+        }
+        payload[out++] = type;
+        payload[out++] = (uint8_t)len;
+        memcpy(payload + out, buf, len);
+        out += len;
+    }
+    *plen = (uint16_t)out;
+    return JOURNAL_OK;
+}
+
+int journal_ext_get(uint8_t type, void *buf, size_t max)
+{
+    uint8_t payload[EXT_PAYLOAD_MAX];
+    uint16_t plen;
+    int slot;
+    uint32_t seq;
+    int ret = ext_load_payload(payload, &plen, &slot, &seq);
+    if (ret != JOURNAL_OK)
+        return ret;
+    return ext_find(payload, plen, type, buf, max);
+}
+
+int journal_ext_set(uint8_t type, const void *buf, size_t len)
+{
+    if (type == 0 || len > UINT8_MAX) {
+        fprintf(stderr, "journal: invalid extension %u (len %zu)\n", type, len);
+        return JOURNAL_ERR_INVALID;
+    }
+    uint8_t payload[EXT_PAYLOAD_MAX];
+    uint16_t plen;
+    int slot;
+    uint32_t seq;
+    int ret = ext_load_payload(payload, &plen, &slot, &seq);
+    if (ret == JOURNAL_OK)
+        ret = ext_replace(payload, &plen, type, buf, len);
+    if (ret != JOURNAL_OK)
+        return ret;
+    return ext_store(payload, plen, slot, seq, true);
+}
+
+int journal_ext_record_tier(uint8_t tier, uint64_t when)
+{
+    uint64_t times[3] = {0};
+    if (tier < TIER_1 || tier > TIER_3)
+        return JOURNAL_ERR_INVALID;
+    int ret = journal_ext_get(JOURNAL_EXT_TIER_TIMES, times, sizeof(times));
+    if (ret < 0)
+        return ret;
+    times[tier - 1] = when;
+    return journal_ext_set(JOURNAL_EXT_TIER_TIMES, times, sizeof(times));
+}
+
+int journal_ext_push_health(uint8_t score)
+{
+    uint8_t scores[JOURNAL_HEALTH_HISTORY_MAX];
+    int n = journal_ext_get(JOURNAL_EXT_HEALTH_HISTORY, scores + 1, sizeof(scores) - 1);
+    if (n < 0)
+        return n;
+    scores[0] = score;
+    return journal_ext_set(JOURNAL_EXT_HEALTH_HISTORY, scores, (size_t)n + 1);
+}
+
+/*
+ * Pushes score and, for a tier change, stamps the entry time in one extension
+ * write.  It is left unsynced: the boot history log holds the same event
+ * durably, and a lost write only leaves the older copy current.
+ */
+int journal_ext_record_transition(uint8_t score, uint8_t from, uint8_t to, uint64_t when)
+{
+    if (to < TIER_1 || to > TIER_3)
+        return JOURNAL_ERR_INVALID;
+    uint8_t payload[EXT_PAYLOAD_MAX];
+    uint16_t plen;
+    int slot;
+    uint32_t seq;
+    int ret = ext_load_payload(payload, &plen, &slot, &seq);
+    if (ret != JOURNAL_OK)
+        return ret;
+    uint8_t scores[JOURNAL_HEALTH_HISTORY_MAX];
+    int n = ext_find(payload, plen, JOURNAL_EXT_HEALTH_HISTORY, scores + 1, sizeof(scores) - 1);
+    scores[0] = score;
+    ret = ext_replace(payload, &plen, JOURNAL_EXT_HEALTH_HISTORY, scores, (size_t)n + 1);
+    if (ret == JOURNAL_OK && to != from) {
+        uint64_t times[3] = {0};
+        ext_find(payload, plen, JOURNAL_EXT_TIER_TIMES, times, sizeof(times));
+        times[to - 1] = when;
+        ret = ext_replace(payload, &plen, JOURNAL_EXT_TIER_TIMES, times, sizeof(times));
+    }
+    if (ret != JOURNAL_OK)
+        return ret;
+    return ext_store(payload, plen, slot, seq, false);
+}
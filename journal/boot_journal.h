@@ -1,11 +1,24 @@
 #ifndef BOOT_JOURNAL_H
 #define BOOT_JOURNAL_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
 #define JOURNAL_MAGIC       0xA771A771  
+#define JOURNAL_RING_MAGIC  0xA771B007
+#define JOURNAL_RING_SLOTS_DEFAULT 16
+#define JOURNAL_RING_SLOTS_MAX     1024
+#define JOURNAL_ALIGNED_MAGIC 0xA771A5EC
+#define JOURNAL_SECTOR_SIZE   4096
 #define JOURNAL_VERSION     1
+#define JOURNAL_EXT_MAGIC   0xA771E0E0
+#define JOURNAL_EXT_SIZE    512
+#define JOURNAL_EXT_TIER_TIMES     1
+#define JOURNAL_EXT_HEALTH_HISTORY 2
+#define JOURNAL_EXT_ATTEST_NONCE   3
+#define JOURNAL_HEALTH_HISTORY_MAX 16
+#define JOURNAL_NONCE_MAX          64
 #define TIER_1              1
 #define TIER_2              2
 #define TIER_3              3
@@ -30,6 +43,33 @@ struct BootRecord {
     uint32_t trailer;        
 } __attribute__((packed));
 
+struct JournalRingHeader {
+    uint32_t magic;
+    uint32_t slots;
+    uint32_t slot_size;
+    uint32_t crc32;
+} __attribute__((packed));
+
+struct JournalSlot {
+    uint64_t seq;
+    struct BootRecord rec;
+    uint32_t crc32;
+    uint32_t magic;
+} __attribute__((packed));
+
+struct JournalExtHeader {
+    uint32_t magic;
+    uint32_t seq;
+    uint16_t len;
+    uint16_t reserved;
+    uint32_t crc32;
+} __attribute__((packed));
+
+struct JournalTxn {
+    struct BootRecord rec;
+    bool active;
+};
+
 #define JOURNAL_OK           0
 #define JOURNAL_ERR_IO      -1
 #define JOURNAL_ERR_CORRUPT -2
@@ -37,11 +77,29 @@ struct BootRecord {
 #define JOURNAL_ERR_NOMEM   -4
 
 int journal_init(const char *path);
+int journal_init_ring(const char *path, uint32_t slots);
+bool journal_is_ring(void);
+int journal_init_mmap(const char *path);
+int journal_init_aligned(const char *path);
+bool journal_is_aligned(void);
+bool journal_is_mapped(void);
+int journal_read_history(struct BootRecord *recs, int max);
 int journal_read(struct BootRecord *rec);
 int journal_write(const struct BootRecord *rec);
 int journal_recover(struct BootRecord *rec);
 const char *journal_get_path(void);
 void journal_close(void);
+void journal_set_verbose(bool verbose);
+int journal_txn_begin(struct JournalTxn *txn);
+int journal_txn_apply(struct JournalTxn *txn, const char *ops);
+int journal_txn_commit(struct JournalTxn *txn);
+void journal_txn_abort(struct JournalTxn *txn);
+int journal_apply_op(struct BootRecord *rec, const char *op);
+int journal_ext_get(uint8_t type, void *buf, size_t max);
+int journal_ext_set(uint8_t type, const void *buf, size_t len);
+int journal_ext_record_tier(uint8_t tier, uint64_t when);
+int journal_ext_push_health(uint8_t score);
+int journal_ext_record_transition(uint8_t score, uint8_t from, uint8_t to, uint64_t when);
 void journal_create_default(struct BootRecord *rec);
 bool journal_validate(const struct BootRecord *rec);
 void journal_print(const struct BootRecord *rec);
@@ -50,5 +108,9 @@ void journal_reset_tries(struct BootRecord *rec);
 void journal_set_flag(struct BootRecord *rec, uint32_t flag);
 void journal_clear_flag(struct BootRecord *rec, uint32_t flag);
 bool journal_has_flag(const struct BootRecord *rec, uint32_t flag);
+uint32_t journal_flag_from_name(const char *name);
+const char *journal_field_name(int index);
+int journal_field_get(const struct BootRecord *rec, const char *name, uint64_t *value);
+int journal_field_set(struct BootRecord *rec, const char *name, uint64_t value);
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include "crc32.h"
+#include <string.h>
+#if defined(__aarch64__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+#endif
+
+#define CRC32_POLY 0xEDB88320
+
+typedef uint32_t (*crc32_fn)(uint32_t crc, const uint8_t *buf, size_t len);
+
+struct Crc32Backend {
+    const char *name;
+    crc32_fn fn;
+    bool available;
+};
+
+static uint32_t crc32_tables[8][256];
+
+static uint32_t crc32_bytewise(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        crc = (crc >> 8) ^ crc32_tables[0][(crc ^ buf[i]) & 0xFF];
+    return crc;
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+static uint32_t crc32_slice8(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    while (len && ((uintptr_t)buf & 7)) {
+        crc = (crc >> 8) ^ crc32_tables[0][(crc ^ *buf++) & 0xFF];
+        len--;
+    }
+    while (len >= 8) {
+        uint32_t lo, hi;
+        memcpy(&lo, buf, 4);
+        memcpy(&hi, buf + 4, 4);
+        lo ^= crc;
+        crc = crc32_tables[7][lo & 0xFF] ^
+              crc32_tables[6][(lo >> 8) & 0xFF] ^
+              crc32_tables[5][(lo >> 16) & 0xFF] ^
+              crc32_tables[4][lo >> 24] ^
+              crc32_tables[3][hi & 0xFF] ^
+              crc32_tables[2][(hi >> 8) & 0xFF] ^
+              crc32_tables[1][(hi >> 16) & 0xFF] ^
+              crc32_tables[0][hi >> 24];
+        buf += 8;
+        len -= 8;
+    }
+    return crc32_bytewise(crc, buf, len);
+}
+#define CRC32_SLICE8_AVAILABLE true
+#else
+#define crc32_slice8 crc32_bytewise
+#define CRC32_SLICE8_AVAILABLE false
+#endif
+
+#if defined(__aarch64__)
+__attribute__((target("+crc")))
+static uint32_t crc32_armv8(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    while (len && ((uintptr_t)buf & 7)) {
+        crc = __crc32b(crc, *buf++);
+        len--;
+    }
+    while (len >= 8) {
+        uint64_t v;
+        memcpy(&v, buf, 8);
+        crc = __crc32d(crc, v);
+        buf += 8;
+        len -= 8;
+    }
+    while (len--)
+        crc = __crc32b(crc, *buf++);
+    return crc;
+}
+#endif
+
+static struct Crc32Backend backends[] = {
+#if defined(__aarch64__)
+    { "armv8", crc32_armv8, false },
+#endif
+    { "slice8", crc32_slice8, CRC32_SLICE8_AVAILABLE },
+    { "bytewise", crc32_bytewise, true },
+};
+
+static crc32_fn crc32_active = crc32_bytewise;
+static const char *crc32_active_name = "bytewise";
+
+__attribute__((constructor))
+static void crc32_init(void)
+{
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int j = 0; j < 8; j++)
+            crc = (crc & 1) ? (crc >> 1) ^ CRC32_POLY : crc >> 1;
+        crc32_tables[0][i] = crc;
+    }
+    for (int k = 1; k < 8; k++) {
+        for (int i = 0; i < 256; i++) {
+            uint32_t prev = crc32_tables[k - 1][i];
+            crc32_tables[k][i] = (prev >> 8) ^ crc32_tables[0][prev & 0xFF];
+        }
+    }
+#if defined(__aarch64__)
+    backends[0].available = (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#endif
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+        if (backends[i].available) {
+            crc32_active = backends[i].fn;
+            crc32_active_name = backends[i].name;
+            break;
+        }
+    }
+}
+
+uint32_t crc32_compute(const void *data, size_t len)
+{
+    return ~crc32_active(0xFFFFFFFF, (const uint8_t *)data, len);
+}
+
+const char *crc32_backend_name(void)
+{
+    return crc32_active_name;
+}
+
+bool crc32_set_backend(const char *name)
+{
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+        if (strcmp(backends[i].name, name) == 0 && backends[i].available) {
+            crc32_active = backends[i].fn;
+            crc32_active_name = backends[i].name;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,12 @@
+#ifndef JOURNAL_CRC32_H
+#define JOURNAL_CRC32_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+uint32_t crc32_compute(const void *data, size_t len);
+const char *crc32_backend_name(void);
+bool crc32_set_backend(const char *name);
+
+#endif
@@ -0,0 +1,148 @@
+#include "boot_journal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#define BENCH_WRITES  200
+#define BENCH_TRIALS  200
+#define TORN_MIN_TAIL 30
+#define TORN_MAX_TAIL 55
+#define TEAR_SECTOR   512
+
+enum { LAYOUT_DUAL, LAYOUT_ALIGNED };
+static const char *layout_names[] = { "dual-page", "aligned" };
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static int open_layout(const char *path, int layout, bool fresh)
+{
+    if (fresh)
+        unlink(path);
+    return layout == LAYOUT_ALIGNED ? journal_init_aligned(path) : journal_init(path);
+}
+
+static void bench_latency(const char *path, int layout)
+{
+    double samples[BENCH_WRITES];
+    struct BootRecord rec;
+    if (open_layout(path, layout, true) != JOURNAL_OK) {
+        printf("  %-10s  open failed\n", layout_names[layout]);
+        return;
+    }
+    journal_read(&rec);
+    for (int i = 0; i < BENCH_WRITES; i++) {
+        rec.boot_count++;
+        double start = now_sec();
+        journal_write(&rec);
+        samples[i] = (now_sec() - start) * 1e6;
+    }
+    journal_close();
+    qsort(samples, BENCH_WRITES, sizeof(samples[0]), cmp_double);
+    double total = 0;
+    for (int i = 0; i < BENCH_WRITES; i++)
+        total += samples[i];
+    printf("  %-10s %10.1f %10.1f %10.1f\n", layout_names[layout],
+           total / BENCH_WRITES, samples[BENCH_WRITES / 2],
+           samples[BENCH_WRITES * 99 / 100]);
+}
+
+/* faultlab torn_write: the tail of the file is lost mid-write */
+static void tear_tail(const char *path)
+{
+    struct stat st;
+    if (stat(path, &st) != 0)
+        return;
+    off_t cut = TORN_MIN_TAIL + rand() % (TORN_MAX_TAIL - TORN_MIN_TAIL + 1);
+    if (truncate(path, st.st_size > cut ? st.st_size - cut : 0) != 0)
+        perror("truncate");
+}
+
+/* Power loss during the next page A update garbles its device sector */
+static void tear_sector(const char *path)
+{
+    uint8_t junk[TEAR_SECTOR];
+    int fd = open(path, O_WRONLY);
+    if (fd < 0)
+        return;
+    for (size_t i = 0; i < sizeof(junk); i++)
+        junk[i] = (uint8_t)rand();
+    if (pwrite(fd, junk, sizeof(junk), 0) != (ssize_t)sizeof(junk))
+        perror("pwrite");
+    close(fd);
+}
+
+static int survival(const char *path, int layout, void (*tear)(const char *))
+{
+    int survived = 0;
+    for (int t = 0; t < BENCH_TRIALS; t++) {
+        struct BootRecord rec;
+        if (open_layout(path, layout, true) != JOURNAL_OK)
+            continue;
+        journal_read(&rec);
+        rec.tier = TIER_3;
+        rec.boot_count = 1000 + t;
+        journal_write(&rec);
+        journal_close();
+        tear(path);
+        if (open_layout(path, layout, false) != JOURNAL_OK)
+            continue;
+        if (journal_read(&rec) == JOURNAL_OK && rec.boot_count == (uint64_t)(1000 + t))
+            survived++;
+        journal_close();
+    }
+    return survived;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *dir = argc > 1 ? argv[1] : ".";
+    char path[512];
+    snprintf(path, sizeof(path), "%s/journal_bench.dat", dir);
+    journal_set_verbose(false);
+    srand(1);
+
+    printf("PAC Journal Layout Benchmark (%s)\n\n", path);
+    printf("  %-10s %10s %10s %10s\n", "layout", "avg us", "p50 us", "p99 us");
+    bench_latency(path, LAYOUT_DUAL);
+    bench_latency(path, LAYOUT_ALIGNED);
+
+    /* recovery noise is expected while tearing; keep the report readable */
+    int saved_stderr = dup(STDERR_FILENO);
+    int devnull = open("/dev/null", O_WRONLY);
+    if (devnull >= 0)
+        dup2(devnull, STDERR_FILENO);
+    int tail[2], sector[2];
+    for (int l = LAYOUT_DUAL; l <= LAYOUT_ALIGNED; l++) {
+        tail[l] = survival(path, l, tear_tail);
+        sector[l] = survival(path, l, tear_sector);
+    }
+    if (saved_stderr >= 0) {
+        dup2(saved_stderr, STDERR_FILENO);
+        close(saved_stderr);
+    }
+    if (devnull >= 0)
+        close(devnull);
+    unlink(path);
+
+    printf("\n  Torn-write survival (%d trials, last committed record recovered)\n", BENCH_TRIALS);
+    printf("  %-10s %14s %14s\n", "layout", "torn_write", "sector tear");
+    for (int l = LAYOUT_DUAL; l <= LAYOUT_ALIGNED; l++)
+        printf("  %-10s %9d/%-4d %9d/%-4d\n", layout_names[l],
+               tail[l], BENCH_TRIALS, sector[l], BENCH_TRIALS);
+    return 0;
+}
@@ -1,7 +1,11 @@
 #include "boot_journal.h"
+#include "boot_history.h"
+#include "json_writer.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 static void usage(const char *prog)
 {
@@ -9,36 +13,320 @@ static void usage(const char *prog)
     printf("Usage: %s <command> [args...] <journal_file>\n\n", prog);
     printf("Commands:\n");
     printf("  read <file>                    - Display journal contents\n");
+    printf("  get <fields> [--format=F] <file> - Print fields (comma list or 'all')\n");
+    printf("                                   F: shell (default), json, raw\n");
     printf("  set-tier <tier> <file>         - Set boot tier (1, 2, or 3)\n");
     printf("  dec-tries <tier> <file>        - Decrement tier attempt counter\n");
     printf("  reset-tries <file>             - Reset all attempt counters\n");
     printf("  set-flag <flag> <file>         - Set status flag\n");
     printf("  clear-flag <flag> <file>       - Clear status flag\n");
     printf("  inc-boot <file>                - Increment boot counter\n");
+    printf("  apply '<op>;<op>...' <file>    - Commit several operations as one write\n");
+    printf("                                   ops: <field>=<n>, dec-tries=<tier>,\n");
+    printf("                                   set-flag=<f>, clear-flag=<f>,\n");
+    printf("                                   reset-tries, inc-boot\n");
+    printf("  ext <file>                     - Display record extensions\n");
+    printf("  history [--since N] [--json] <file>\n");
+    printf("                                 - Stream boot history events\n");
+    printf("  history-add <from> <to> <reason> <score> <file>\n");
+    printf("                                 - Record a tier transition\n");
+    printf("                                   reasons: boot, promote, stay, demote,\n");
+    printf("                                   emergency, manual\n");
     printf("  init <file>                    - Initialize new journal\n");
+    printf("  init-ring <slots> <file>       - Initialize new ring-buffer journal\n");
+    printf("  init-aligned <file>            - Initialize new sector-aligned journal\n");
     printf("\n");
     printf("Flags: emergency, quarantine, brownout, dirty, network_gated\n");
+    printf("Fields: version, tier, tries_t2, tries_t3, rollback_idx, flags,\n");
+    printf("        boot_count, timestamp\n");
     printf("\n");
     printf("Examples:\n");
     printf("  %s read /var/pac/journal.dat\n", prog);
     printf("  %s set-tier 2 /var/pac/journal.dat\n", prog);
     printf("  %s set-flag brownout /var/pac/journal.dat\n", prog);
+    printf("  %s apply 'tier=3;dec-tries=3;clear-flag=dirty;inc-boot' /var/pac/journal.dat\n", prog);
+    printf("  eval \"$(%s get tier,flags /var/pac/journal.dat)\"\n", prog);
+    printf("  %s history --since 100 /var/pac/journal.dat\n", prog);
+    printf("  %s history --json /var/pac/journal.dat\n", prog);
     printf("\n");
 }
 
 static uint32_t parse_flag(const char *flag_str)
 {
-    if (strcmp(flag_str, "emergency") == 0)
-        return FLAG_EMERGENCY;
-    if (strcmp(flag_str, "quarantine") == 0)
-        return FLAG_QUARANTINE;
-    if (strcmp(flag_str, "brownout") == 0)
-        return FLAG_BROWNOUT;
-    if (strcmp(flag_str, "dirty") == 0)
-        return FLAG_DIRTY;
-    if (strcmp(flag_str, "network_gated") == 0)
-        return FLAG_NETWORK_GATED;
-    fprintf(stderr, "Unknown flag: %s\n", flag_str);
+    uint32_t flag = journal_flag_from_name(flag_str);
+    if (flag == 0)
+        fprintf(stderr, "Unknown flag: %s\n", flag_str);
+    return flag;
+}
+
+enum OutputFormat {
+    FORMAT_SHELL,
+    FORMAT_JSON,
+    FORMAT_RAW
+};
+
+#define MAX_GET_FIELDS 16
+
+static int print_event(const struct HistoryEvent *ev, void *arg)
+{
+    (void)arg;
+    printf("boot=%lu time=%lu from=%u to=%u reason=%s score=%u\n",
+           (unsigned long)ev->boot_count, (unsigned long)ev->timestamp,
+           ev->from_tier, ev->to_tier, history_reason_name(ev->reason),
+           ev->health_score);
+    return 0;
+}
+
+static int cmd_ext(int argc, char *argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s ext <file>\n", argv[0]);
+        return 1;
+    }
+    journal_set_verbose(false);
+    struct BootRecord rec;
+    if (journal_init(argv[2]) != JOURNAL_OK || journal_read(&rec) != JOURNAL_OK) {
+        fprintf(stderr, "Failed to read journal\n");
+        journal_close();
+        return 1;
+    }
+    uint64_t times[3] = {0};
+    uint8_t scores[JOURNAL_HEALTH_HISTORY_MAX];
+    uint8_t nonce[JOURNAL_NONCE_MAX];
+    int ret = journal_ext_get(JOURNAL_EXT_TIER_TIMES, times, sizeof(times));
+    if (ret < 0) {
+        journal_close();
+        return 1;
+    }
+    printf("Record version: %u\n", (unsigned)rec.version);
+    for (int t = 0; t < 3; t++)
+        printf("  Tier-%d entered: %lu\n", t + 1, (unsigned long)times[t]);
+    int n = journal_ext_get(JOURNAL_EXT_HEALTH_HISTORY, scores, sizeof(scores));
+    printf("  Health history:");
+    for (int i = 0; i < n; i++)
+        printf(" %u", scores[i]);
+    printf("\n");
+    n = journal_ext_get(JOURNAL_EXT_ATTEST_NONCE, nonce, sizeof(nonce));
+    printf("  Attestation nonce: ");
+    for (int i = 0; i < n; i++)
+        printf("%02x", nonce[i]);
+    printf("%s\n", n > 0 ? "" : "(none)");
+    journal_close();
+    return 0;
+}
+
+static int json_event(const struct HistoryEvent *ev, void *arg)
+{
+    struct JsonWriter *w = arg;
+    json_object_begin(w);
+    json_kv_uint(w, "boot", ev->boot_count);
+    json_kv_uint(w, "time", ev->timestamp);
+    json_kv_uint(w, "from", ev->from_tier);
+    json_kv_uint(w, "to", ev->to_tier);
+    json_kv_string(w, "reason", history_reason_name(ev->reason));
+    json_kv_uint(w, "score", ev->health_score);
+    json_object_end(w);
+    return w->error ? -1 : 0;
+}
+
+static int cmd_history(int argc, char *argv[])
+{
+    uint64_t since = 0;
+    bool json = false;
+    int i;
+    for (i = 2; i < argc - 1; i++) {
+        if (strcmp(argv[i], "--since") == 0 && i + 1 < argc - 1)
+            since = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--json") == 0)
+            json = true;
+        else
+            break;
+    }
+    if (argc < 3 || i != argc - 1) {
+        fprintf(stderr, "Usage: %s history [--since N] [--json] <file>\n", argv[0]);
+        return 1;
+    }
+    char path[4096];
+    if (history_path_for(argv[argc - 1], path, sizeof(path)) != JOURNAL_OK) {
+        fprintf(stderr, "Journal path too long\n");
+        return 1;
+    }
+    if (!json)
+        return history_read(path, since, print_event, NULL) < 0 ? 1 : 0;
+    char stage[1024];
+    struct JsonWriter w;
+    json_init_fd(&w, STDOUT_FILENO, stage, sizeof(stage), true);
+    json_array_begin(&w);
+    int ret = history_read(path, since, json_event, &w);
+    json_array_end(&w);
+    if (json_finish(&w) < 0 || ret < 0)
+        return 1;
+    printf("\n");
+    return 0;
+}
+
+static int cmd_history_add(int argc, char *argv[])
+{
+    if (argc != 7) {
+        fprintf(stderr, "Usage: %s history-add <from> <to> <reason> <score> <file>\n", argv[0]);
+        return 1;
+    }
+    int from = atoi(argv[2]);
+    int to = atoi(argv[3]);
+    int reason = history_reason_from_name(argv[4]);
+    int score = atoi(argv[5]);
+    if (from < TIER_1 || from > TIER_3 || to < TIER_1 || to > TIER_3) {
+        fprintf(stderr, "Invalid tier transition: %d -> %d\n", from, to);
+        return 1;
+    }
+    if (reason < 0) {
+        fprintf(stderr, "Unknown reason: %s\n", argv[4]);
+        return 1;
+    }
+    if (score < 0 || score > 255) {
+        fprintf(stderr, "Invalid health score: %d\n", score);
+        return 1;
+    }
+    const char *journal_path = argv[6];
+    char path[4096];
+    if (history_path_for(journal_path, path, sizeof(path)) != JOURNAL_OK) {
+        fprintf(stderr, "Journal path too long\n");
+        return 1;
+    }
+    struct BootRecord rec;
+    journal_set_verbose(false);
+    if (journal_init(journal_path) != JOURNAL_OK || journal_read(&rec) != JOURNAL_OK) {
+        fprintf(stderr, "Failed to read journal\n");
+        journal_close();
+        return 1;
+    }
+    journal_ext_record_transition((uint8_t)score, (uint8_t)from, (uint8_t)to, (uint64_t)time(NULL));
+    journal_close();
+    if (history_open(path) != JOURNAL_OK)
+        return 1;
+    int ret = history_append(rec.boot_count, (uint8_t)from, (uint8_t)to,
+                             (uint8_t)reason, (uint8_t)score);
+    if (ret == JOURNAL_OK)
+        ret = history_flush();
+    history_close();
+    return ret == JOURNAL_OK ? 0 : 1;
+}
+
+static int cmd_get(int argc, char *argv[])
+{
+    enum OutputFormat format = FORMAT_SHELL;
+    char *field_list = NULL;
+    for (int i = 2; i < argc - 1; i++) {
+        if (strncmp(argv[i], "--format=", 9) == 0) {
+            const char *f = argv[i] + 9;
+            if (strcmp(f, "shell") == 0)
+                format = FORMAT_SHELL;
+            else if (strcmp(f, "json") == 0)
+                format = FORMAT_JSON;
+            else if (strcmp(f, "raw") == 0)
+                format = FORMAT_RAW;
+            else {
+                fprintf(stderr, "Unknown format: %s\n", f);
+                return 1;
+            }
+        } else if (!field_list) {
+            field_list = argv[i];
+        } else {
+            fprintf(stderr, "Usage: %s get <fields> [--format=shell|json|raw] <file>\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!field_list || argc < 4) {
+        fprintf(stderr, "Usage: %s get <fields> [--format=shell|json|raw] <file>\n", argv[0]);
+        return 1;
+    }
+    const char *fields[MAX_GET_FIELDS];
+    int nfields = 0;
+    struct BootRecord rec;
+    uint64_t value;
+    journal_create_default(&rec);
+    if (strcmp(field_list, "all") == 0) {
+        for (const char *name; (name = journal_field_name(nfields)) != NULL; )
+            fields[nfields++] = name;
+    } else {
+        for (char *tok = strtok(field_list, ","); tok; tok = strtok(NULL, ",")) {
+            if (nfields == MAX_GET_FIELDS) {
+                fprintf(stderr, "Too many fields (max %d)\n", MAX_GET_FIELDS);
+                return 1;
+            }
+            if (journal_field_get(&rec, tok, &value) != JOURNAL_OK) {
+                fprintf(stderr, "Unknown field: %s\n", tok);
+                return 1;
+            }
+            fields[nfields++] = tok;
+        }
+    }
+    const char *path = argv[argc - 1];
+    journal_set_verbose(false);
+    if (journal_init(path) != JOURNAL_OK) {
+        fprintf(stderr, "Failed to open journal: %s\n", path);
+        return 1;
+    }
+    if (journal_read(&rec) != JOURNAL_OK) {
+        fprintf(stderr, "Failed to read journal\n");
+        journal_close();
+        return 1;
+    }
+    journal_close();
+    if (format == FORMAT_JSON) {
+        char stage[512];
+        struct JsonWriter w;
+        json_init_fd(&w, STDOUT_FILENO, stage, sizeof(stage), true);
+        json_object_begin(&w);
+        for (int i = 0; i < nfields; i++) {
+            journal_field_get(&rec, fields[i], &value);
+            json_kv_uint(&w, fields[i], value);
+        }
+        json_object_end(&w);
+        if (json_finish(&w) < 0)
+            return 1;
+        printf("\n");
+        return 0;
+    }
+    for (int i = 0; i < nfields; i++) {
+        journal_field_get(&rec, fields[i], &value);
+        if (format == FORMAT_SHELL)
+            printf("%s=%llu\n", fields[i], (unsigned long long)value);
+        else
+            printf("%llu\n", (unsigned long long)value);
+    }
+    return 0;
+}
+
+static int cmd_apply(int argc, char *argv[])
+{
+    if (argc != 4) {
+        fprintf(stderr, "Usage: %s apply '<op>;<op>...' <file>\n", argv[0]);
+        return 1;
+    }
+    const char *path = argv[3];
+    if (journal_init(path) != JOURNAL_OK) {
+        fprintf(stderr, "Failed to open journal: %s\n", path);
+        return 1;
+    }
+    struct JournalTxn txn;
+    if (journal_txn_begin(&txn) != JOURNAL_OK) {
+        fprintf(stderr, "Failed to read journal\n");
+        journal_close();
+        return 1;
+    }
+    if (journal_txn_apply(&txn, argv[2]) != JOURNAL_OK) {
+        journal_txn_abort(&txn);
+        journal_close();
+        return 1;
+    }
+    if (journal_txn_commit(&txn) != JOURNAL_OK) {
+        fprintf(stderr, "Failed to write journal\n");
+        journal_close();
+        return 1;
+    }
+    printf("Applied: %s\n", argv[2]);
+    journal_close();
     return 0;
 }
 
@@ -66,6 +354,63 @@ int main(int argc, char *argv[])
         journal_close();
         return 0;
     }
+    if (strcmp(cmd, "init-ring") == 0) {
+        if (argc != 4) {
+            fprintf(stderr, "Usage: %s init-ring <slots> <file>\n", argv[0]);
+            return 1;
+        }
+        int slots = atoi(argv[2]);
+        const char *path = argv[3];
+        if (slots < 2 || slots > JOURNAL_RING_SLOTS_MAX) {
+            fprintf(stderr, "Invalid slot count: %d (must be 2-%d)\n",
+                    slots, JOURNAL_RING_SLOTS_MAX);
+            return 1;
+        }
+        if (journal_init_ring(path, (uint32_t)slots) != JOURNAL_OK) {
+            fprintf(stderr, "Failed to initialize ring journal\n");
+            return 1;
+        }
+        struct BootRecord rec;
+        journal_read(&rec);
+        printf("Initialized %s journal at %s\n",
+               journal_is_ring() ? "ring" : "dual-page", path);
+        journal_print(&rec);
+        journal_close();
+        return 0;
+    }
+    if (strcmp(cmd, "init-aligned") == 0) {
+        if (argc != 3) {
+            fprintf(stderr, "Usage: %s init-aligned <file>\n", argv[0]);
+            return 1;
+        }
+        if (journal_init_aligned(argv[2]) != JOURNAL_OK) {
+            fprintf(stderr, "Failed to initialize aligned journal\n");
+            return 1;
+        }
+        struct BootRecord rec;
+        journal_read(&rec);
+        printf("Initialized %s journal at %s\n",
+               journal_is_aligned() ? "aligned" :
+               journal_is_ring() ? "ring" : "dual-page", argv[2]);
+        journal_print(&rec);
+        journal_close();
+        return 0;
+    }
+    if (strcmp(cmd, "get") == 0) {
+        return cmd_get(argc, argv);
+    }
+    if (strcmp(cmd, "apply") == 0) {
+        return cmd_apply(argc, argv);
+    }
+    if (strcmp(cmd, "ext") == 0) {
+        return cmd_ext(argc, argv);
+    }
+    if (strcmp(cmd, "history") == 0) {
+        return cmd_history(argc, argv);
+    }
+    if (strcmp(cmd, "history-add") == 0) {
+        return cmd_history_add(argc, argv);
+    }
     if (argc < 3) {
         usage(argv[0]);
         return 1;
@@ -0,0 +1,413 @@
+#include "boot_journal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <poll.h>
+#include <getopt.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#define DEFAULT_SOCKET_PATH "/tmp/pac-journald.sock"
+#define MAX_CLIENTS         16
+#define LINE_MAX_LEN        256
+#define MAX_ARGS            16
+
+struct Client {
+    int fd;
+    size_t len;
+    char buf[LINE_MAX_LEN];
+};
+
+static volatile sig_atomic_t running = 1;
+static struct BootRecord cached;
+static struct stat cached_st;
+static bool cache_valid = false;
+
+static void usage(const char *prog)
+{
+    printf("PAC Journal Daemon\n\n");
+    printf("Usage: %s [options] <journal_file>\n", prog);
+    printf("       %s [-s socket] -q '<request>'\n\n", prog);
+    printf("Options:\n");
+    printf("  -s PATH    Unix socket path (default: %s)\n", DEFAULT_SOCKET_PATH);
+    printf("  -q REQ     Send one request to a running daemon and print the reply\n");
+    printf("  -h         Show this help\n\n");
+    printf("Requests (one per line, replies end with ok/fail/err):\n");
+    printf("  get [field ...]                - Print field=value lines\n");
+    printf("  set <field> <value>            - Set a field and commit\n");
+    printf("  cas <field> <expected> <value> - Set only if field == expected\n");
+    printf("  set-flag <flag> | clear-flag <flag>\n");
+    printf("  apply <op;op;...>              - Apply journal_tool ops as one write\n");
+    printf("  dec-tries <tier> | reset-tries | inc-boot | reload\n\n");
+    printf("Fields: version, tier, tries_t2, tries_t3, rollback_idx, flags,\n");
+    printf("        boot_count, timestamp\n\n");
+}
+
+static void handle_signal(int sig)
+{
+    (void)sig;
+    running = 0;
+}
+
+static bool journal_changed(void)
+{
+    struct stat st;
+    if (stat(journal_get_path(), &st) != 0)
+        return true;
+    return st.st_ino != cached_st.st_ino ||
+           st.st_size != cached_st.st_size ||
+           st.st_mtim.tv_sec != cached_st.st_mtim.tv_sec ||
+           st.st_mtim.tv_nsec != cached_st.st_mtim.tv_nsec;
+}
+
+static int refresh_cache(bool force)
+{
+    if (cache_valid && !force && !journal_changed())
+        return JOURNAL_OK;
+    if (journal_recover(&cached) != JOURNAL_OK) {
+        cache_valid = false;
+        return JOURNAL_ERR_IO;
+    }
+    stat(journal_get_path(), &cached_st);
+    cache_valid = true;
+    return JOURNAL_OK;
+}
+
+static int commit(const struct BootRecord *rec)
+{
+    if (journal_write(rec) != JOURNAL_OK)
+        return JOURNAL_ERR_IO;
+    return refresh_cache(true);
+}
+
+static void reply(int fd, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void reply(int fd, const char *fmt, ...)
+{
+    char out[LINE_MAX_LEN];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(out, sizeof(out), fmt, ap);
+    va_end(ap);
+    if (n < 0)
+        return;
+    if (n >= (int)sizeof(out))
+        n = sizeof(out) - 1;
+    if (write(fd, out, n) != n)
+        fprintf(stderr, "journald: reply failed: %s\n", strerror(errno));
+}
+
+static bool parse_u64(const char *str, uint64_t *value)
+{
+    char *end;
+    errno = 0;
+    unsigned long long v = strtoull(str, &end, 0);
+    if (errno != 0 || end == str || *end != '\0')
+        return false;
+    *value = v;
+    return true;
+}
+
+static void handle_request(int fd, char *line)
+{
+    char *argv[MAX_ARGS];
+    int argc = 0;
+    for (char *tok = strtok(line, " \t\r"); tok && argc < MAX_ARGS; tok = strtok(NULL, " \t\r"))
+        argv[argc++] = tok;
+    if (argc == 0)
+        return;
+    if (refresh_cache(false) != JOURNAL_OK) {
+        reply(fd, "err journal unavailable\n");
+        return;
+    }
+    struct BootRecord rec = cached;
+    uint64_t value, expected;
+    const char *cmd = argv[0];
+    if (strcmp(cmd, "get") == 0) {
+        for (int i = 0; ; i++) {
+            const char *name = argc > 1 ? (i < argc - 1 ? argv[i + 1] : NULL)
+                                        : journal_field_name(i);
+            if (!name)
+                break;
+            if (journal_field_get(&rec, name, &value) != JOURNAL_OK) {
+                reply(fd, "err unknown field %s\n", name);
+                return;
+            }
+            reply(fd, "%s=%llu\n", name, (unsigned long long)value);
+        }
+        reply(fd, "ok\n");
+    } else if (strcmp(cmd, "set") == 0 && argc == 3) {
+        if (!parse_u64(argv[2], &value) ||
+            journal_field_set(&rec, argv[1], value) != JOURNAL_OK) {
+            reply(fd, "err invalid %s=%s\n", argv[1], argv[2]);
+            return;
+        }
+        reply(fd, commit(&rec) == JOURNAL_OK ? "ok\n" : "err write failed\n");
+    } else if (strcmp(cmd, "cas") == 0 && argc == 4) {
+        uint64_t current;
+        if (!parse_u64(argv[2], &expected) || !parse_u64(argv[3], &value) ||
+            journal_field_get(&rec, argv[1], &current) != JOURNAL_OK) {
+            reply(fd, "err invalid cas on %s\n", argv[1]);
+            return;
+        }
+        if (current != expected) {
+            reply(fd, "fail %s=%llu\n", argv[1], (unsigned long long)current);
+            return;
+        }
+        if (journal_field_set(&rec, argv[1], value) != JOURNAL_OK) {
+            reply(fd, "err invalid %s=%s\n", argv[1], argv[3]);
+            return;
+        }
+        reply(fd, commit(&rec) == JOURNAL_OK ? "ok\n" : "err write failed\n");
+    } else if ((strcmp(cmd, "set-flag") == 0 || strcmp(cmd, "clear-flag") == 0) && argc == 2) {
+        uint32_t flag = journal_flag_from_name(argv[1]);
+        if (flag == 0) {
+            reply(fd, "err unknown flag %s\n", argv[1]);
+            return;
+        }
+        if (cmd[0] == 's')
+            journal_set_flag(&rec, flag);
+        else
+            journal_clear_flag(&rec, flag);
+        reply(fd, commit(&rec) == JOURNAL_OK ? "ok\n" : "err write failed\n");
+    } else if (strcmp(cmd, "dec-tries") == 0 && argc == 2) {
+        int tier = atoi(argv[1]);
+        int remaining = journal_decrement_tries(&rec, (uint8_t)tier);
+        if (remaining < 0) {
+            reply(fd, "err invalid tier %s\n", argv[1]);
+            return;
+        }
+        if (commit(&rec) != JOURNAL_OK) {
+            reply(fd, "err write failed\n");
+            return;
+        }
+        reply(fd, "tries_t%d=%d\nok\n", tier, remaining);
+    } else if (strcmp(cmd, "reset-tries") == 0 && argc == 1) {
+        journal_reset_tries(&rec);
+        reply(fd, commit(&rec) == JOURNAL_OK ? "ok\n" : "err write failed\n");
+    } else if (strcmp(cmd, "inc-boot") == 0 && argc == 1) {
+        rec.boot_count++;
+        if (commit(&rec) != JOURNAL_OK) {
+            reply(fd, "err write failed\n");
+            return;
+        }
+        reply(fd, "boot_count=%llu\nok\n", (unsigned long long)rec.boot_count);
+    } else if (strcmp(cmd, "apply") == 0 && argc == 2) {
+        struct JournalTxn txn = { .rec = rec, .active = true };
+        if (journal_txn_apply(&txn, argv[1]) != JOURNAL_OK) {
+            reply(fd, "err invalid operations %s\n", argv[1]);
+            return;
+        }
+        reply(fd, commit(&txn.rec) == JOURNAL_OK ? "ok\n" : "err write failed\n");
+    } else if (strcmp(cmd, "reload") == 0 && argc == 1) {
+        reply(fd, refresh_cache(true) == JOURNAL_OK ? "ok\n" : "err reload failed\n");
+    } else {
+        reply(fd, "err bad request %s\n", cmd);
+    }
+}
+
+static bool client_read(struct Client *c)
+{
+    ssize_t n = read(c->fd, c->buf + c->len, sizeof(c->buf) - 1 - c->len);
+    if (n <= 0)
+        return false;
+    c->len += n;
+    c->buf[c->len] = '\0';
+    char *start = c->buf;
+    char *nl;
+    while ((nl = strchr(start, '\n')) != NULL) {
+        *nl = '\0';
+        handle_request(c->fd, start);
+        start = nl + 1;
+    }
+    c->len = strlen(start);
+    memmove(c->buf, start, c->len + 1);
+    if (c->len == sizeof(c->buf) - 1) {
+        reply(c->fd, "err request too long\n");
+        return false;
+    }
+    return true;
+}
+
+static int open_listener(const char *sock_path)
+{
+    struct sockaddr_un addr;
+    if (strlen(sock_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "journald: socket path too long: %s\n", sock_path);
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        fprintf(stderr, "journald: socket failed: %s\n", strerror(errno));
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, sock_path, sizeof(addr.sun_path) - 1);
+    unlink(sock_path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, MAX_CLIENTS) < 0) {
+        fprintf(stderr, "journald: bind %s failed: %s\n", sock_path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    chmod(sock_path, 0600);
+    return fd;
+}
+
+static int serve(const char *sock_path)
+{
+    int listen_fd = open_listener(sock_path);
+    if (listen_fd < 0)
+        return 1;
+    struct Client clients[MAX_CLIENTS];
+    for (int i = 0; i < MAX_CLIENTS; i++)
+        clients[i].fd = -1;
+    printf("journald: serving %s on %s\n", journal_get_path(), sock_path);
+    while (running) {
+        struct pollfd pfds[MAX_CLIENTS + 1];
+        int idx[MAX_CLIENTS + 1];
+        int nfds = 0;
+        pfds[nfds].fd = listen_fd;
+        pfds[nfds].events = POLLIN;
+        idx[nfds++] = -1;
+        for (int i = 0; i < MAX_CLIENTS; i++) {
+            if (clients[i].fd < 0)
+                continue;
+            pfds[nfds].fd = clients[i].fd;
+            pfds[nfds].events = POLLIN;
+            idx[nfds++] = i;
+        }
+        if (poll(pfds, nfds, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "journald: poll failed: %s\n", strerror(errno));
+            break;
+        }
+        for (int p = 1; p < nfds; p++) {
+            if (!pfds[p].revents)
+                continue;
+            struct Client *c = &clients[idx[p]];
+            if (!client_read(c)) {
+                close(c->fd);
+                c->fd = -1;
+            }
+        }
+        if (pfds[0].revents & POLLIN) {
+            int cfd = accept(listen_fd, NULL, NULL);
+            if (cfd < 0)
+                continue;
+            int slot = -1;
+            for (int i = 0; i < MAX_CLIENTS && slot < 0; i++) {
+                if (clients[i].fd < 0)
+                    slot = i;
+            }
+            if (slot < 0) {
+                reply(cfd, "err too many clients\n");
+                close(cfd);
+                continue;
+            }
+            clients[slot].fd = cfd;
+            clients[slot].len = 0;
+        }
+    }
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (clients[i].fd >= 0)
+            close(clients[i].fd);
+    }
+    close(listen_fd);
+    unlink(sock_path);
+    printf("journald: stopped\n");
+    return 0;
+}
+
+static int query(const char *sock_path, const char *request)
+{
+    struct sockaddr_un addr;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        fprintf(stderr, "journald: socket failed: %s\n", strerror(errno));
+        return 1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, sock_path, sizeof(addr.sun_path) - 1);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        fprintf(stderr, "journald: connect %s failed: %s\n", sock_path, strerror(errno));
+        close(fd);
+        return 1;
+    }
+    dprintf(fd, "%s\n", request);
+    FILE *in = fdopen(fd, "r");
+    if (!in) {
+        close(fd);
+        return 1;
+    }
+    char line[LINE_MAX_LEN];
+    int status = 1;
+    while (fgets(line, sizeof(line), in)) {
+        if (strcmp(line, "ok\n") == 0) {
+            status = 0;
+            break;
+        }
+        if (strncmp(line, "err ", 4) == 0 || strncmp(line, "fail ", 5) == 0) {
+            fputs(line, stderr);
+            break;
+        }
+        fputs(line, stdout);
+    }
+    fclose(in);
+    return status;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *sock_path = DEFAULT_SOCKET_PATH;
+    const char *request = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:q:h")) != -1) {
+        switch (opt) {
+        case 's':
+            sock_path = optarg;
+            break;
+        case 'q':
+            request = optarg;
+            break;
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (request)
+        return query(sock_path, request);
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (journal_init_mmap(argv[optind]) != JOURNAL_OK &&
+        journal_init(argv[optind]) != JOURNAL_OK) {
+        fprintf(stderr, "Failed to open journal: %s\n", argv[optind]);
+        return 1;
+    }
+    if (refresh_cache(true) != JOURNAL_OK) {
+        fprintf(stderr, "Failed to read journal\n");
+        journal_close();
+        return 1;
+    }
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_signal;
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGINT, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+    int ret = serve(sock_path);
+    journal_close();
+    return ret;
+}
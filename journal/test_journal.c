@@ -1,11 +1,23 @@
 #include "boot_journal.h"
+#include "crc32.h"
+#include "boot_history.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
 #include <string.h>
 #include <unistd.h>
 #include <assert.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
 #define TEST_JOURNAL_PATH "/tmp/test_boot_journal.dat"
+#define TEST_JOURNALD "./pac-journald"
+#define TEST_JOURNALD_SOCKET "/tmp/test_pac_journald.sock"
+#define TEST_RING_SLOTS 4
+#define TEST_HISTORY_PATH TEST_JOURNAL_PATH HISTORY_SUFFIX
 
 static int tests_passed = 0;
 static int tests_failed = 0;
@@ -128,6 +140,325 @@ static void test_try_counters(void)
     TEST_END();
 }
 
+static void test_field_access(void)
+{
+    TEST_START("Field Access");
+    struct BootRecord rec;
+    uint64_t value = 0;
+    journal_create_default(&rec);
+    rec.boot_count = 12;
+    TEST_ASSERT(journal_field_get(&rec, "tier", &value) == JOURNAL_OK && value == TIER_1,
+                "Get tier");
+    TEST_ASSERT(journal_field_get(&rec, "boot_count", &value) == JOURNAL_OK && value == 12,
+                "Get boot count");
+    TEST_ASSERT(journal_field_get(&rec, "bogus", &value) == JOURNAL_ERR_INVALID,
+                "Unknown field rejected");
+    TEST_ASSERT(journal_field_set(&rec, "tier", TIER_3) == JOURNAL_OK && rec.tier == TIER_3,
+                "Set tier");
+    TEST_ASSERT(journal_field_set(&rec, "tier", 7) == JOURNAL_ERR_INVALID && rec.tier == TIER_3,
+                "Out-of-range tier rejected");
+    TEST_ASSERT(journal_field_set(&rec, "version", 2) == JOURNAL_ERR_INVALID,
+                "Read-only field rejected");
+    int count = 0;
+    while (journal_field_name(count) != NULL)
+        count++;
+    TEST_ASSERT(count == 8, "All fields enumerated");
+    TEST_ASSERT(journal_flag_from_name("BROWNOUT") == FLAG_BROWNOUT, "Flag name is case-insensitive");
+    TEST_END();
+}
+
+static void test_transactions(void)
+{
+    TEST_START("Multi-Operation Transactions");
+    cleanup_test_journal();
+    journal_init(TEST_JOURNAL_PATH);
+    struct JournalTxn txn;
+    int ret = journal_txn_begin(&txn);
+    TEST_ASSERT(ret == JOURNAL_OK, "Begin transaction");
+    journal_set_flag(&txn.rec, FLAG_DIRTY);
+    ret = journal_txn_apply(&txn, "tier=3;dec-tries=3;clear-flag=dirty;inc-boot");
+    TEST_ASSERT(ret == JOURNAL_OK, "Apply operation list");
+    ret = journal_txn_commit(&txn);
+    TEST_ASSERT(ret == JOURNAL_OK, "Commit transaction");
+    struct BootRecord rec;
+    journal_read(&rec);
+    TEST_ASSERT(rec.tier == TIER_3, "Tier committed");
+    TEST_ASSERT(rec.tries_t3 == DEFAULT_TRIES_T3 - 1, "T3 tries committed");
+    TEST_ASSERT(!journal_has_flag(&rec, FLAG_DIRTY), "Dirty flag cleared");
+    TEST_ASSERT(rec.boot_count == 1, "Boot count committed");
+    journal_txn_begin(&txn);
+    ret = journal_txn_apply(&txn, "tier=2;set-flag=bogus");
+    TEST_ASSERT(ret == JOURNAL_ERR_INVALID, "Invalid operation rejects whole list");
+    TEST_ASSERT(txn.rec.tier == TIER_3, "Staged record untouched by rejected list");
+    journal_txn_abort(&txn);
+    TEST_ASSERT(journal_txn_commit(&txn) == JOURNAL_ERR_INVALID, "Aborted transaction cannot commit");
+    TEST_END();
+}
+
+static void test_mmap_mode(void)
+{
+    TEST_START("Memory-Mapped Access");
+    cleanup_test_journal();
+    int ret = journal_init_mmap(TEST_JOURNAL_PATH);
+    TEST_ASSERT(ret == JOURNAL_OK, "Initialize mapped journal");
+    TEST_ASSERT(journal_is_mapped(), "Mapping active");
+    struct BootRecord rec;
+    journal_read(&rec);
+    rec.tier = TIER_2;
+    rec.boot_count = 55;
+    ret = journal_write(&rec);
+    TEST_ASSERT(ret == JOURNAL_OK, "Write through mapping");
+    journal_close();
+    journal_init(TEST_JOURNAL_PATH);
+    TEST_ASSERT(!journal_is_mapped(), "Plain open is not mapped");
+    struct BootRecord read_back;
+    journal_read(&read_back);
+    TEST_ASSERT(read_back.boot_count == 55, "Mapped write visible to fd reader");
+    journal_close();
+    cleanup_test_journal();
+    journal_init_ring(TEST_JOURNAL_PATH, TEST_RING_SLOTS);
+    journal_close();
+    journal_init_mmap(TEST_JOURNAL_PATH);
+    TEST_ASSERT(journal_is_ring() && journal_is_mapped(), "Ring journal mapped");
+    for (int i = 0; i < TEST_RING_SLOTS + 1; i++) {
+        journal_read(&rec);
+        rec.boot_count++;
+        journal_write(&rec);
+    }
+    journal_read(&read_back);
+    TEST_ASSERT(read_back.boot_count == TEST_RING_SLOTS + 1, "Mapped ring wraps correctly");
+    TEST_END();
+}
+
+static void test_aligned_layout(void)
+{
+    TEST_START("Sector-Aligned Layout");
+    cleanup_test_journal();
+    int ret = journal_init_aligned(TEST_JOURNAL_PATH);
+    TEST_ASSERT(ret == JOURNAL_OK, "Initialize aligned journal");
+    TEST_ASSERT(journal_is_aligned(), "Aligned layout active");
+    struct BootRecord rec;
+    journal_read(&rec);
+    rec.tier = TIER_3;
+    rec.boot_count = 77;
+    TEST_ASSERT(journal_write(&rec) == JOURNAL_OK, "Write aligned record");
+    journal_close();
+    FILE *fp = fopen(TEST_JOURNAL_PATH, "rb");
+    long size = -1;
+    if (fp) {
+        fseek(fp, 0, SEEK_END);
+        size = ftell(fp);
+        fclose(fp);
+    }
+    TEST_ASSERT(size == 2 * JOURNAL_SECTOR_SIZE, "File holds two sectors");
+    journal_init(TEST_JOURNAL_PATH);
+    TEST_ASSERT(journal_is_aligned(), "Plain open detects aligned layout");
+    struct BootRecord read_back;
+    journal_read(&read_back);
+    TEST_ASSERT(read_back.boot_count == 77 && read_back.tier == TIER_3,
+                "Aligned record persists");
+    journal_close();
+    TEST_ASSERT(truncate(TEST_JOURNAL_PATH, JOURNAL_SECTOR_SIZE + 20) == 0,
+                "Tear page B sector");
+    journal_init(TEST_JOURNAL_PATH);
+    TEST_ASSERT(journal_is_aligned(), "Torn file still detected as aligned");
+    journal_read(&read_back);
+    TEST_ASSERT(read_back.boot_count == 77, "Recovered from page A");
+    journal_close();
+    cleanup_test_journal();
+    journal_init(TEST_JOURNAL_PATH);
+    journal_close();
+    journal_init_aligned(TEST_JOURNAL_PATH);
+    TEST_ASSERT(!journal_is_aligned(), "Existing dual-page journal keeps layout");
+    TEST_END();
+}
+
+static void test_record_version(void)
+{
+    TEST_START("Record Version Compatibility");
+    cleanup_test_journal();
+    journal_init(TEST_JOURNAL_PATH);
+    journal_ext_push_health(4);
+    struct BootRecord rec;
+    journal_read(&rec);
+    rec.boot_count = 41;
+    journal_write(&rec);
+    journal_close();
+    FILE *f = fopen(TEST_JOURNAL_PATH, "rb");
+    struct BootRecord pages[2];
+    memset(pages, 0, sizeof(pages));
+    if (f) {
+        TEST_ASSERT(fread(pages, sizeof(pages[0]), 2, f) == 2, "Read raw pages");
+        fclose(f);
+    }
+    /* older tools reject any other version, so extensions must not bump it */
+    TEST_ASSERT(pages[0].version == JOURNAL_VERSION && pages[1].version == JOURNAL_VERSION &&
+                JOURNAL_VERSION == 1, "Records stay version 1 alongside extensions");
+    struct BootRecord future = pages[0];
+    future.version = JOURNAL_VERSION + 1;
+    future.crc32 = crc32_compute(&future, offsetof(struct BootRecord, crc32));
+    TEST_ASSERT(!journal_validate(&future), "Unknown version rejected");
+    TEST_END();
+}
+
+static void test_extensions(void)
+{
+    TEST_START("Record Extensions");
+    cleanup_test_journal();
+    journal_init(TEST_JOURNAL_PATH);
+    uint8_t nonce[JOURNAL_NONCE_MAX];
+    TEST_ASSERT(journal_ext_get(JOURNAL_EXT_ATTEST_NONCE, nonce, sizeof(nonce)) == 0,
+                "Fresh journal has no extensions");
+    for (int i = 0; i < 20; i++)
+        journal_ext_push_health((uint8_t)i);
+    uint8_t scores[JOURNAL_HEALTH_HISTORY_MAX];
+    int n = journal_ext_get(JOURNAL_EXT_HEALTH_HISTORY, scores, sizeof(scores));
+    TEST_ASSERT(n == JOURNAL_HEALTH_HISTORY_MAX && scores[0] == 19 && scores[1] == 18,
+                "Health history keeps newest scores first");
+    TEST_ASSERT(journal_ext_record_tier(TIER_3, 1234) == JOURNAL_OK, "Record tier entry time");
+    memset(nonce, 0xAB, 32);
+    TEST_ASSERT(journal_ext_set(JOURNAL_EXT_ATTEST_NONCE, nonce, 32) == JOURNAL_OK,
+                "Cache attestation nonce");
+    struct BootRecord rec;
+    journal_read(&rec);
+    rec.boot_count = 9;
+    journal_write(&rec);
+    journal_close();
+    journal_init(TEST_JOURNAL_PATH);
+    uint64_t times[3] = {0};
+    journal_ext_get(JOURNAL_EXT_TIER_TIMES, times, sizeof(times));
+    TEST_ASSERT(times[2] == 1234 && times[0] == 0, "Tier times persist across reopen");
+    memset(nonce, 0, sizeof(nonce));
+    TEST_ASSERT(journal_ext_get(JOURNAL_EXT_ATTEST_NONCE, nonce, sizeof(nonce)) == 32 &&
+                nonce[31] == 0xAB, "Nonce persists across reopen");
+    journal_read(&rec);
+    TEST_ASSERT(rec.boot_count == 9, "Hot record unaffected by extensions");
+    FILE *f = fopen(TEST_JOURNAL_PATH, "r+b");
+    if (f) {
+        /* tear both extension copies' payload bytes; newest copy must be rejected */
+        uint8_t junk[8] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+        fseek(f, 2 * sizeof(struct BootRecord) + 24, SEEK_SET);
+        fwrite(junk, sizeof(junk), 1, f);
+        fseek(f, 2 * sizeof(struct BootRecord) + JOURNAL_EXT_SIZE + 24, SEEK_SET);
+        fwrite(junk, sizeof(junk), 1, f);
+        fclose(f);
+    }
+    TEST_ASSERT(journal_ext_get(JOURNAL_EXT_ATTEST_NONCE, nonce, sizeof(nonce)) == 0,
+                "Corrupt extension area ignored");
+    journal_read(&rec);
+    TEST_ASSERT(rec.boot_count == 9, "Hot record survives extension corruption");
+    journal_ext_set(JOURNAL_EXT_ATTEST_NONCE, NULL, 0);
+    cleanup_test_journal();
+    journal_init_aligned(TEST_JOURNAL_PATH);
+    TEST_ASSERT(journal_ext_record_tier(TIER_2, 99) == JOURNAL_OK, "Aligned journal extension write");
+    times[1] = 0;
+    journal_ext_get(JOURNAL_EXT_TIER_TIMES, times, sizeof(times));
+    TEST_ASSERT(times[1] == 99, "Aligned journal extension read");
+    TEST_ASSERT(journal_ext_record_transition(7, TIER_2, TIER_3, 555) == JOURNAL_OK &&
+                journal_ext_record_transition(8, TIER_3, TIER_3, 777) == JOURNAL_OK,
+                "Record transitions");
+    journal_ext_get(JOURNAL_EXT_TIER_TIMES, times, sizeof(times));
+    n = journal_ext_get(JOURNAL_EXT_HEALTH_HISTORY, scores, sizeof(scores));
+    TEST_ASSERT(times[1] == 99 && times[2] == 555 && n == 2 && scores[0] == 8 && scores[1] == 7,
+                "Transition updates health and entry time together");
+    cleanup_test_journal();
+    journal_init_ring(TEST_JOURNAL_PATH, TEST_RING_SLOTS);
+    journal_ext_push_health(5);
+    n = journal_ext_get(JOURNAL_EXT_HEALTH_HISTORY, scores, sizeof(scores));
+    TEST_ASSERT(n == 1 && scores[0] == 5, "Ring journal extension round-trip");
+    TEST_END();
+}
+
+static int count_visit(const struct HistoryEvent *ev, void *arg)
+{
+    struct HistoryEvent *last = arg;
+    *last = *ev;
+    return 0;
+}
+
+static void test_boot_history(void)
+{
+    TEST_START("Boot History Log");
+    unlink(TEST_HISTORY_PATH);
+    char path[256];
+    TEST_ASSERT(history_path_for(TEST_JOURNAL_PATH, path, sizeof(path)) == JOURNAL_OK &&
+                strcmp(path, TEST_HISTORY_PATH) == 0, "History path derived from journal");
+    TEST_ASSERT(history_open(TEST_HISTORY_PATH) == JOURNAL_OK, "Open history log");
+    for (int i = 1; i <= HISTORY_BATCH_MAX + 8; i++)
+        history_append(i, TIER_1, TIER_2, HISTORY_REASON_PROMOTE, 6);
+    history_append(100, TIER_2, TIER_1, HISTORY_REASON_DEMOTE, 2);
+    history_close();
+    struct HistoryEvent last;
+    memset(&last, 0, sizeof(last));
+    int n = history_read(TEST_HISTORY_PATH, 0, count_visit, &last);
+    TEST_ASSERT(n == HISTORY_BATCH_MAX + 9, "All batched events persisted");
+    TEST_ASSERT(last.boot_count == 100 && last.reason == HISTORY_REASON_DEMOTE &&
+                last.to_tier == TIER_1 && last.health_score == 2, "Last event intact");
+    n = history_read(TEST_HISTORY_PATH, HISTORY_BATCH_MAX + 1, NULL, NULL);
+    TEST_ASSERT(n == 9, "Since filter skips older boots");
+    FILE *fp = fopen(TEST_HISTORY_PATH, "ab");
+    if (fp) {
+        fwrite("torn", 1, 4, fp);
+        fclose(fp);
+    }
+    TEST_ASSERT(history_read(TEST_HISTORY_PATH, 0, NULL, NULL) == HISTORY_BATCH_MAX + 9,
+                "Torn tail ignored by reader");
+    TEST_ASSERT(history_open(TEST_HISTORY_PATH) == JOURNAL_OK, "Reopen after torn tail");
+    history_append(101, TIER_1, TIER_1, HISTORY_REASON_STAY, 3);
+    history_close();
+    n = history_read(TEST_HISTORY_PATH, 101, count_visit, &last);
+    TEST_ASSERT(n == 1 && last.reason == HISTORY_REASON_STAY, "Append realigned after torn tail");
+    TEST_ASSERT(history_reason_from_name("emergency") == HISTORY_REASON_EMERGENCY &&
+                strcmp(history_reason_name(HISTORY_REASON_PROMOTE), "promote") == 0,
+                "Reason names round-trip");
+    unlink(TEST_HISTORY_PATH);
+    unlink(TEST_HISTORY_PATH HISTORY_ROTATED_SUFFIX);
+    size_t cap = sizeof(struct HistoryHeader) + 10 * sizeof(struct HistoryEvent);
+    history_set_max_bytes(cap);
+    for (int i = 1; i <= 25; i++) {
+        history_open(TEST_HISTORY_PATH);
+        history_append(i, TIER_1, TIER_1, HISTORY_REASON_STAY, 5);
+        history_close();
+    }
+    history_set_max_bytes(HISTORY_MAX_BYTES);
+    struct stat st;
+    TEST_ASSERT(stat(TEST_HISTORY_PATH, &st) == 0 && (size_t)st.st_size <= cap &&
+                stat(TEST_HISTORY_PATH HISTORY_ROTATED_SUFFIX, &st) == 0 &&
+                (size_t)st.st_size <= cap, "History log rotates at size cap");
+    memset(&last, 0, sizeof(last));
+    n = history_read(TEST_HISTORY_PATH, 0, count_visit, &last);
+    TEST_ASSERT(n == 15 && last.boot_count == 25, "Reader spans rotated generation in order");
+    TEST_ASSERT(history_read(TEST_HISTORY_PATH, 20, NULL, NULL) == 6,
+                "Since filter applies across rotation");
+    unlink(TEST_HISTORY_PATH);
+    unlink(TEST_HISTORY_PATH HISTORY_ROTATED_SUFFIX);
+    TEST_END();
+}
+
+static void test_crc32_backends(void)
+{
+    TEST_START("CRC32 Backends");
+    const char *names[] = { "bytewise", "slice8", "armv8" };
+    const char *check = "123456789";
+    uint8_t buf[1031];
+    for (size_t i = 0; i < sizeof(buf); i++)
+        buf[i] = (uint8_t)(i * 31 + 3);
+    const char *default_backend = crc32_backend_name();
+    crc32_set_backend("bytewise");
+    uint32_t expected = crc32_compute(buf + 1, sizeof(buf) - 1);
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (!crc32_set_backend(names[i])) {
+            printf("   (%s backend not available)\n", names[i]);
+            continue;
+        }
+        TEST_ASSERT(crc32_compute(check, 9) == 0xCBF43926, "Check value matches");
+        TEST_ASSERT(crc32_compute(buf + 1, sizeof(buf) - 1) == expected,
+                    "Unaligned buffer matches bytewise result");
+    }
+    crc32_set_backend(default_backend);
+    TEST_END();
+}
+
 static void test_corruption_recovery(void)
 {
     TEST_START("Corruption Recovery");
@@ -221,6 +552,185 @@ static void test_boot_scenario(void)
     TEST_END();
 }
 
+static void test_ring_journal(void)
+{
+    TEST_START("Ring Journal Append/Recover");
+    cleanup_test_journal();
+    int ret = journal_init_ring(TEST_JOURNAL_PATH, TEST_RING_SLOTS);
+    TEST_ASSERT(ret == JOURNAL_OK, "Initialize ring journal");
+    TEST_ASSERT(journal_is_ring(), "Ring mode active");
+    struct BootRecord rec;
+    journal_read(&rec);
+    TEST_ASSERT(rec.tier == TIER_1, "Fresh ring starts in Tier 1");
+    for (int i = 0; i < 10; i++) {
+        rec.boot_count++;
+        rec.tier = (i % 3) + 1;
+        journal_write(&rec);
+    }
+    journal_close();
+    ret = journal_init(TEST_JOURNAL_PATH);
+    TEST_ASSERT(ret == JOURNAL_OK, "Re-open ring journal with journal_init");
+    TEST_ASSERT(journal_is_ring(), "Ring layout detected on open");
+    struct BootRecord read_back;
+    journal_read(&read_back);
+    TEST_ASSERT(read_back.boot_count == 10, "Newest boot count recovered after wrap");
+    TEST_ASSERT(read_back.tier == rec.tier, "Newest tier recovered after wrap");
+    struct BootRecord history[TEST_RING_SLOTS + 2];
+    int n = journal_read_history(history, TEST_RING_SLOTS + 2);
+    TEST_ASSERT(n == TEST_RING_SLOTS, "History holds one record per slot");
+    TEST_ASSERT(n > 1 && history[0].boot_count == 10 && history[1].boot_count == 9,
+                "History is ordered newest first");
+    TEST_END();
+}
+
+static void test_ring_torn_slot(void)
+{
+    TEST_START("Ring Journal Torn Slot Fallback");
+    cleanup_test_journal();
+    journal_init_ring(TEST_JOURNAL_PATH, TEST_RING_SLOTS);
+    struct BootRecord rec;
+    journal_read(&rec);
+    rec.tier = TIER_2;
+    rec.boot_count = 7;
+    journal_write(&rec);
+    rec.tier = TIER_3;
+    rec.boot_count = 8;
+    journal_write(&rec);
+    journal_close();
+    FILE *f = fopen(TEST_JOURNAL_PATH, "r+b");
+    TEST_ASSERT(f != NULL, "Open ring journal for corruption");
+    if (f) {
+        long newest = sizeof(struct JournalRingHeader) + 2 * sizeof(struct JournalSlot);
+        fseek(f, newest + offsetof(struct JournalSlot, crc32), SEEK_SET);
+        uint32_t bad_crc = 0xDEADBEEF;
+        fwrite(&bad_crc, sizeof(bad_crc), 1, f);
+        fclose(f);
+    }
+    journal_init(TEST_JOURNAL_PATH);
+    struct BootRecord recovered;
+    int ret = journal_read(&recovered);
+    TEST_ASSERT(ret == JOURNAL_OK, "Recovery succeeded");
+    TEST_ASSERT(recovered.tier == TIER_2, "Fell back to previous tier");
+    TEST_ASSERT(recovered.boot_count == 7, "Fell back to previous boot count");
+    recovered.boot_count = 9;
+    journal_write(&recovered);
+    journal_read(&recovered);
+    TEST_ASSERT(recovered.boot_count == 9, "Write after fallback supersedes torn slot");
+    TEST_END();
+}
+
+static pid_t start_journald(void)
+{
+    unlink(TEST_JOURNALD_SOCKET);
+    pid_t pid = fork();
+    if (pid == 0) {
+        freopen("/dev/null", "w", stdout);
+        execl(TEST_JOURNALD, TEST_JOURNALD, "-s", TEST_JOURNALD_SOCKET, TEST_JOURNAL_PATH,
+              (char *)NULL);
+        _exit(127);
+    }
+    struct timespec pause = { 0, 10 * 1000 * 1000 };
+    for (int i = 0; pid > 0 && i < 200 && access(TEST_JOURNALD_SOCKET, F_OK) != 0; i++)
+        nanosleep(&pause, NULL);
+    return pid;
+}
+
+static int journald_connect(void)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, TEST_JOURNALD_SOCKET, sizeof(addr.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+/* Sends one request line and collects the reply up to its ok/fail/err line */
+static const char *journald_request(int fd, const char *request, char *out, size_t cap)
+{
+    size_t len = 0;
+    out[0] = '\0';
+    if (write(fd, request, strlen(request)) != (ssize_t)strlen(request) || write(fd, "\n", 1) != 1)
+        return out;
+    while (len < cap - 1) {
+        ssize_t n = read(fd, out + len, cap - 1 - len);
+        if (n <= 0)
+            break;
+        len += (size_t)n;
+        out[len] = '\0';
+        const char *last = len > 1 ? out + len - 2 : out;
+        while (last > out && last[-1] != '\n')
+            last--;
+        if (out[len - 1] == '\n' && (strncmp(last, "ok", 2) == 0 ||
+                                     strncmp(last, "fail ", 5) == 0 ||
+                                     strncmp(last, "err ", 4) == 0))
+            break;
+    }
+    return out;
+}
+
+static void test_journald_protocol(void)
+{
+    TEST_START("Journal Daemon Protocol");
+    cleanup_test_journal();
+    journal_init(TEST_JOURNAL_PATH);
+    journal_close();
+    pid_t pid = start_journald();
+    int fd = journald_connect();
+    TEST_ASSERT(fd >= 0, "Connect to pac-journald socket");
+    if (fd < 0) {
+        if (pid > 0) {
+            kill(pid, SIGTERM);
+            waitpid(pid, NULL, 0);
+        }
+        TEST_END();
+        return;
+    }
+    char out[512];
+    journald_request(fd, "get tier tries_t2", out, sizeof(out));
+    TEST_ASSERT(strcmp(out, "tier=1\ntries_t2=3\nok\n") == 0, "get returns requested fields");
+    journald_request(fd, "get", out, sizeof(out));
+    TEST_ASSERT(strstr(out, "boot_count=0\n") && strstr(out, "flags=0\n"), "get with no fields returns all");
+    journald_request(fd, "get bogus", out, sizeof(out));
+    TEST_ASSERT(strncmp(out, "err unknown field bogus", 23) == 0, "Unknown field rejected");
+    journald_request(fd, "set tier 2", out, sizeof(out));
+    TEST_ASSERT(strcmp(out, "ok\n") == 0, "set commits");
+    journald_request(fd, "cas tier 1 3", out, sizeof(out));
+    TEST_ASSERT(strcmp(out, "fail tier=2\n") == 0, "cas with stale expectation fails");
+    journald_request(fd, "cas tier 2 3", out, sizeof(out));
+    TEST_ASSERT(strcmp(out, "ok\n") == 0, "cas with current value commits");
+    journald_request(fd, "apply tier=2;dec-tries=3;set-flag=dirty", out, sizeof(out));
+    TEST_ASSERT(strcmp(out, "ok\n") == 0, "apply commits operation list");
+    journald_request(fd, "apply tier=1;set-flag=bogus", out, sizeof(out));
+    TEST_ASSERT(strncmp(out, "err invalid operations", 22) == 0, "apply rejects bad list");
+    journald_request(fd, "frobnicate", out, sizeof(out));
+    TEST_ASSERT(strncmp(out, "err bad request", 15) == 0, "Unknown request rejected");
+
+    struct BootRecord rec;
+    journal_init(TEST_JOURNAL_PATH);
+    journal_read(&rec);
+    TEST_ASSERT(rec.tier == TIER_2, "Daemon writes reach the journal file");
+    TEST_ASSERT(rec.tries_t3 == DEFAULT_TRIES_T3 - 1, "Rejected apply left record untouched");
+    TEST_ASSERT(journal_has_flag(&rec, FLAG_DIRTY), "Flag from apply committed");
+    rec.boot_count = 7;
+    journal_write(&rec);
+    journal_close();
+    journald_request(fd, "get boot_count", out, sizeof(out));
+    TEST_ASSERT(strcmp(out, "boot_count=7\nok\n") == 0, "External write picked up by daemon");
+
+    close(fd);
+    kill(pid, SIGTERM);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    TEST_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0, "Daemon exits cleanly on SIGTERM");
+    TEST_ASSERT(access(TEST_JOURNALD_SOCKET, F_OK) != 0, "Socket removed on exit");
+    TEST_END();
+}
+
 int main(void)
 {
     printf("\n");
@@ -231,9 +741,20 @@ int main(void)
     test_read_write();
     test_flags();
     test_try_counters();
+    test_field_access();
+    test_transactions();
+    test_crc32_backends();
+    test_mmap_mode();
+    test_aligned_layout();
+    test_boot_history();
+    test_record_version();
+    test_extensions();
     test_corruption_recovery();
     test_persistence();
     test_boot_scenario();
+    test_ring_journal();
+    test_ring_torn_slot();
+    test_journald_protocol();
     cleanup_test_journal();
     printf("\n\n");
     printf("  TEST SUMMARY                                              \n");
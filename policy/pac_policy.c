@@ -0,0 +1,401 @@
+#define _GNU_SOURCE
+#include "policy_rules.h"
+#include "boot_history.h"
+#include "health_check.h"
+#include "health_shm.h"
+#include "atomic_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define POLICY_JOURNAL     "/var/pac/journal.dat"
+#define POLICY_HEALTH_JSON "/tmp/health.json"
+#define POLICY_JSON_MAX    (64 * 1024)
+
+struct SigContext {
+    const char *tier2_root;
+    const char *tier3_root;
+    char verify_script[ATOMIC_PATH_MAX];
+    const char *merkle_tool;
+    char pubkey[ATOMIC_PATH_MAX];
+    const char *merkle_mode;
+    const char *merkle_deadline;
+};
+
+static void usage(const char *prog)
+{
+    printf("PAC Policy Evaluator\n\n");
+    printf("Usage: %s [options]\n\n", prog);
+    printf("Compiles policy.conf into a rule table and evaluates it against the boot\n");
+    printf("journal and the latest health report, as policy_engine.sh does.\n\n");
+    printf("Options:\n");
+    printf("  -j FILE        Boot journal (default: %s)\n", POLICY_JOURNAL);
+    printf("  -c FILE        Policy configuration (default: %s)\n", POLICY_CONF_PATH);
+    printf("  --health FILE  Health report JSON (default: %s)\n", POLICY_HEALTH_JSON);
+    printf("  --shm PATH     Read health from the health daemon segment instead\n");
+    printf("  --explain      Trace every rule considered to stderr\n");
+    printf("  --dump         Print the compiled rule table and exit\n");
+    printf("  --dry-run      Decide without updating the journal or history\n");
+    printf("  --bench N      Time N evaluations of the decision and report ns/decision\n");
+    printf("  -v             Verbose output\n");
+    printf("  -h             Show this help\n\n");
+    printf("Environment: JOURNAL, HEALTH_JSON, POLICY_CONFIG and the POLICY_* settings,\n");
+    printf("TIER2_ROOT, TIER3_ROOT, FT_PAC, PAC_MERKLE, PAC_PUBKEY, MERKLE_MODE and\n");
+    printf("MERKLE_DEADLINE_MS (same meaning as in policy_engine.sh)\n\n");
+    printf("Exit codes: 0 = promoted or healthy, 1 = stayed or demoted,\n");
+    printf("            2 = emergency, 255 = evaluation failure\n");
+}
+
+static const char *env_str(const char *name, const char *fallback)
+{
+    const char *v = getenv(name);
+    return v && *v ? v : fallback;
+}
+
+static bool file_exists(const char *root, const char *name)
+{
+    char path[ATOMIC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", root, name);
+    return access(path, F_OK) == 0;
+}
+
+static bool run_verify(char *const argv[], bool quiet)
+{
+    pid_t pid = fork();
+    if (pid < 0)
+        return false;
+    if (pid == 0) {
+        freopen("/dev/null", "w", stdout);
+        if (quiet)
+            freopen("/dev/null", "w", stderr);
+        execv(argv[0], argv);
+        _exit(127);
+    }
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR)
+            return false;
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/* Same order of preference as verify_tier{2,3}_signatures in policy_engine.sh */
+static bool verify_signature(uint8_t tier, void *arg)
+{
+    struct SigContext *ctx = arg;
+    const char *root = tier == TIER_2 ? ctx->tier2_root : ctx->tier3_root;
+    if (access(ctx->merkle_tool, X_OK) == 0 && file_exists(root, "manifest.merkle")) {
+        bool lazy = strcmp(ctx->merkle_mode, "lazy") == 0;
+        char *argv[] = {
+            (char *)ctx->merkle_tool, "verify", (char *)root, "-p", ctx->pubkey,
+            "--deadline", (char *)ctx->merkle_deadline, lazy ? "--lazy" : NULL, NULL
+        };
+        bool ok = run_verify(argv, false);
+        if (!ok)
+            fprintf(stderr, "[POLICY] WARNING: Tier-%u manifest verification failed\n", tier);
+        return ok;
+    }
+    if (access(ctx->verify_script, X_OK) == 0 && file_exists(root, "manifest.sig")) {
+        char arg[4];
+        snprintf(arg, sizeof(arg), "%u", tier);
+        char *argv[] = { ctx->verify_script, arg, NULL };
+        bool ok = run_verify(argv, true);
+        if (!ok)
+            fprintf(stderr, "[POLICY] WARNING: Tier-%u RSA signature verification failed\n", tier);
+        return ok;
+    }
+    return file_exists(root, ".verified");
+}
+
+static char *read_text(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return NULL;
+    char *buf = malloc(POLICY_JSON_MAX);
+    if (buf) {
+        size_t n = fread(buf, 1, POLICY_JSON_MAX - 1, f);
+        buf[n] = '\0';
+    }
+    fclose(f);
+    return buf;
+}
+
+/* Value of the first "key" at or after from: a number, true or false */
+static const char *json_number(const char *from, const char *key, unsigned long *out)
+{
+    char quoted[64];
+    snprintf(quoted, sizeof(quoted), "\"%s\"", key);
+    const char *p = from ? strstr(from, quoted) : NULL;
+    if (!p)
+        return NULL;
+    p += strlen(quoted);
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r' || *p == ':')
+        p++;
+    if (strncmp(p, "true", 4) == 0)
+        *out = 1;
+    else if (strncmp(p, "false", 5) == 0)
+        *out = 0;
+    else {
+        char *end;
+        *out = strtoul(p, &end, 10);
+        if (end == p)
+            return NULL;
+    }
+    return p;
+}
+
+/*
+ * Reads the fields policy_engine.sh takes from health.json: overall_score and
+ * the legacy_format ok flags, or the checks block when the report is compact.
+ */
+static void load_health_json(const char *path, struct PolicyFacts *facts, bool verbose)
+{
+    static const struct { const char *legacy; const char *check; } keys[] = {
+        { "wdt_ok", "watchdog" }, { "ecc_ok", "ecc" }, { "storage_ok", "storage" },
+        { "net_ok", "network" }, { "mem_ok", "memory" },
+    };
+    bool *slots[] = { &facts->wdt_ok, &facts->ecc_ok, &facts->storage_ok, &facts->net_ok,
+                      &facts->mem_ok };
+    char *text = read_text(path);
+    if (!text) {
+        fprintf(stderr, "[POLICY] WARNING: Health check results not found at %s\n", path);
+        return;
+    }
+    unsigned long v;
+    if (json_number(text, "overall_score", &v))
+        facts->health_score = v > UINT8_MAX ? UINT8_MAX : (uint8_t)v;
+    const char *legacy = strstr(text, "\"legacy_format\"");
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+        const char *found = legacy ? json_number(legacy, keys[i].legacy, &v) : NULL;
+        if (!found) {
+            char quoted[32];
+            snprintf(quoted, sizeof(quoted), "\"%s\"", keys[i].check);
+            found = json_number(strstr(text, quoted), "ok", &v);
+        }
+        *slots[i] = found && v == 1;
+    }
+    if (verbose)
+        fprintf(stderr, "[POLICY] Health: score=%u, WDT=%d, ECC=%d, STORAGE=%d, NET=%d, MEM=%d\n",
+                facts->health_score, facts->wdt_ok, facts->ecc_ok, facts->storage_ok,
+                facts->net_ok, facts->mem_ok);
+    free(text);
+}
+
+static int load_health_shm(const char *path, struct PolicyFacts *facts)
+{
+    struct HealthShm *shm = health_shm_attach(path);
+    if (!shm) {
+        fprintf(stderr, "policy: no health segment at %s\n", path);
+        return -1;
+    }
+    struct HealthSnapshot snap;
+    int ret = health_shm_snapshot(shm, &snap);
+    health_shm_detach(shm);
+    if (ret != 0) {
+        fprintf(stderr, "policy: health segment %s has no sample\n", path);
+        return -1;
+    }
+    facts->health_score = snap.report.overall_score;
+    facts->wdt_ok = snap.report.watchdog.ok;
+    facts->ecc_ok = snap.report.ecc.ok;
+    facts->storage_ok = snap.report.storage.ok;
+    facts->net_ok = snap.report.network.ok;
+    facts->mem_ok = snap.report.memory.ok;
+    return 0;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void bench(const struct PolicyProgram *prog, const struct PolicyFacts *facts,
+                  unsigned long iterations)
+{
+    struct PolicyVerdict v;
+    uint64_t start = now_ns();
+    for (unsigned long i = 0; i < iterations; i++)
+        policy_run(prog, facts, &v, NULL);
+    uint64_t elapsed = now_ns() - start;
+    printf("%lu decisions in %.3f ms (%.1f ns/decision, rule %d)\n", iterations,
+           (double)elapsed / 1e6, (double)elapsed / (double)iterations, v.rule);
+}
+
+static int apply_verdict(const char *journal_path, const struct PolicyFacts *facts,
+                         const struct PolicyVerdict *v)
+{
+    struct JournalTxn txn;
+    if (journal_init(journal_path) != JOURNAL_OK || journal_txn_begin(&txn) != JOURNAL_OK) {
+        fprintf(stderr, "policy: cannot open journal %s\n", journal_path);
+        journal_close();
+        return -1;
+    }
+    if (journal_txn_apply(&txn, v->ops) != JOURNAL_OK) {
+        journal_txn_abort(&txn);
+        journal_close();
+        return -1;
+    }
+    int ret = journal_txn_commit(&txn);
+    journal_close();
+    if (ret != JOURNAL_OK) {
+        fprintf(stderr, "policy: failed to write journal %s\n", journal_path);
+        return -1;
+    }
+    uint8_t from = facts->rec.tier >= TIER_1 && facts->rec.tier <= TIER_3 ? facts->rec.tier : TIER_1;
+    char path[ATOMIC_PATH_MAX + 8];
+    if (history_path_for(journal_path, path, sizeof(path)) == JOURNAL_OK &&
+        history_open(path) == JOURNAL_OK) {
+        history_append(facts->rec.boot_count, from, v->to_tier,
+                       policy_decision_history(v->decision), facts->health_score);
+        history_flush();
+        history_close();
+    }
+    return 0;
+}
+
+static void report_verdict(const struct PolicyVerdict *v, bool verbose)
+{
+    switch (v->decision) {
+    case POLICY_D_DEMOTE:
+        fprintf(stderr, "[POLICY] WARNING: Demoting from Tier-%u to Tier-%u: %s\n",
+                v->from_tier, v->to_tier, v->reason);
+        break;
+    case POLICY_D_EMERGENCY:
+        fprintf(stderr, "[POLICY] ERROR: Entering emergency mode: %s\n", v->reason);
+        break;
+    case POLICY_D_HOLD:
+        fprintf(stderr, "[POLICY] ERROR: System in emergency mode - manual intervention required\n");
+        break;
+    default:
+        if (verbose)
+            fprintf(stderr, "[POLICY] Rule %d: %s -> %s\n", v->rule,
+                    policy_decision_name(v->decision), v->action);
+        break;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *journal_path = env_str("JOURNAL", POLICY_JOURNAL);
+    const char *config_path = env_str("POLICY_CONFIG", POLICY_CONF_PATH);
+    const char *health_path = env_str("HEALTH_JSON", POLICY_HEALTH_JSON);
+    const char *shm_path = NULL;
+    bool explain = false, dump = false, dry_run = false, verbose = false;
+    unsigned long bench_iterations = 0;
+    static const struct option long_opts[] = {
+        { "health",  required_argument, NULL, 'H' },
+        { "shm",     required_argument, NULL, 'S' },
+        { "explain", no_argument,       NULL, 'E' },
+        { "dump",    no_argument,       NULL, 'D' },
+        { "dry-run", no_argument,       NULL, 'n' },
+        { "bench",   required_argument, NULL, 'B' },
+        { "help",    no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "j:c:vh", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'j': journal_path = optarg; break;
+        case 'c': config_path = optarg; break;
+        case 'H': health_path = optarg; break;
+        case 'S': shm_path = optarg; break;
+        case 'E': explain = true; break;
+        case 'D': dump = true; break;
+        case 'n': dry_run = true; break;
+        case 'B': bench_iterations = strtoul(optarg, NULL, 10); break;
+        case 'v': verbose = true; break;
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    struct PolicyConf conf = POLICY_CONF_DEFAULT;
+    policy_conf_env(&conf);
+    int ret = policy_conf_load(&conf, config_path);
+    if (ret < 0)
+        return 255;
+    if (verbose)
+        fprintf(stderr, "[POLICY] %s policy configuration%s%s\n",
+                ret == 0 ? "Loaded" : "Using default", ret == 0 ? " from " : "",
+                ret == 0 ? config_path : "");
+    struct PolicyProgram prog;
+    if (policy_compile(&conf, &prog) < 0)
+        return 255;
+    if (dump) {
+        policy_program_dump(&prog, stdout);
+        return 0;
+    }
+
+    struct PolicyFacts facts;
+    memset(&facts, 0, sizeof(facts));
+    journal_set_verbose(false);
+    ret = journal_init(journal_path);
+    if (ret == JOURNAL_OK)
+        ret = journal_read(&facts.rec);
+    journal_close();
+    if (ret != JOURNAL_OK) {
+        fprintf(stderr, "policy: cannot read journal %s\n", journal_path);
+        return 255;
+    }
+    if (shm_path) {
+        if (load_health_shm(shm_path, &facts) != 0)
+            return 255;
+    } else {
+        load_health_json(health_path, &facts, verbose);
+    }
+    struct SigContext sig = {
+        .tier2_root = env_str("TIER2_ROOT", "/tier2-root"),
+        .tier3_root = env_str("TIER3_ROOT", "/tier3-root"),
+        .merkle_tool = env_str("PAC_MERKLE", "/bin/pac_merkle"),
+        .merkle_mode = env_str("MERKLE_MODE", "lazy"),
+        .merkle_deadline = env_str("MERKLE_DEADLINE_MS", "2000"),
+    };
+    const char *ft_pac = getenv("FT_PAC");
+    if (ft_pac) {
+        snprintf(sig.verify_script, sizeof(sig.verify_script),
+                 "%s/scripts/verify_tier_signature.sh", ft_pac);
+        snprintf(sig.pubkey, sizeof(sig.pubkey), "%s/keys/pac_public.pem", ft_pac);
+    } else {
+        snprintf(sig.verify_script, sizeof(sig.verify_script),
+                 "%s/ft-pac/scripts/verify_tier_signature.sh", env_str("HOME", ""));
+        snprintf(sig.pubkey, sizeof(sig.pubkey), "%s/ft-pac/keys/pac_public.pem",
+                 env_str("HOME", ""));
+    }
+    if (getenv("PAC_PUBKEY") && *getenv("PAC_PUBKEY"))
+        snprintf(sig.pubkey, sizeof(sig.pubkey), "%s", getenv("PAC_PUBKEY"));
+    facts.verify_sig = verify_signature;
+    facts.sig_arg = &sig;
+
+    struct PolicyVerdict verdict;
+    ret = policy_run(&prog, &facts, &verdict, explain ? stderr : NULL);
+    if (ret < 0) {
+        fprintf(stderr, "policy: no rule matched tier %u\n", facts.rec.tier);
+        return 255;
+    }
+    if (bench_iterations > 0) {
+        /* signature checks may fork; the loop times the rule table alone */
+        facts.verify_sig = NULL;
+        bench(&prog, &facts, bench_iterations);
+        return 0;
+    }
+    report_verdict(&verdict, verbose);
+    if (verbose)
+        fprintf(stderr, "[POLICY] Journal ops: %s\n", verdict.ops);
+    if (!dry_run && apply_verdict(journal_path, &facts, &verdict) != 0)
+        return 255;
+    printf("DECISION=%s ACTION=%s REASON=%s\n", policy_decision_name(verdict.decision),
+           verdict.action, verdict.reason);
+    return verdict.exit_code;
+}
@@ -0,0 +1,796 @@
+#define _GNU_SOURCE
+#include "policy_fsm.h"
+#include "boot_history.h"
+#include "health_check.h"
+#include "health_score.h"
+#include "health_shm.h"
+#include "atomic_file.h"
+#include "http_client.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <getopt.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <sys/inotify.h>
+#include <sys/signalfd.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <sys/wait.h>
+#include <sys/reboot.h>
+
+#define POLICYD_JOURNAL        "/var/pac/journal.dat"
+#define POLICYD_STATE          "/var/pac/policyd.state"
+#define POLICYD_LOG            "/var/pac/policy_monitor.log"
+#define POLICYD_ATTEST         "/usr/lib/pac/attest_agent.sh"
+#define POLICYD_NETWORK_SETUP  "/usr/lib/pac/setup_network.sh"
+#define POLICYD_SANITY_LOG     "/var/pac/attest_sanity.log"
+#define POLICYD_VERIFIER_URL   "http://10.0.2.2:8080"
+#define POLICYD_VERIFIER_STATE "/tmp/pac_attestation/verifier.state"
+#define POLICYD_TIER2_IMAGE    "/tier2/rootfs.img"
+#define POLICYD_TIER3_IMAGE    "/tier3/rootfs.img"
+#define POLICYD_IMA_VIOLATIONS "/sys/kernel/security/ima/violations"
+#define POLICYD_HEALTH_POLL_MS 1000
+
+struct Daemon {
+    struct PolicyConfig config;
+    struct PolicyCounters counters;
+    struct HealthScoreConfig scoring;
+    struct HealthConfig health;
+    const char *journal_path;
+    const char *shm_path;
+    const char *score_path;
+    const char *state_path;
+    const char *attest_script;
+    const char *network_script;
+    struct HttpUrl verifier;
+    bool have_verifier;
+    const char *verifier_state;
+    uint32_t verifier_state_max_age;
+    bool no_reboot;
+    bool verbose;
+    int log_fd;
+    struct HealthShm *shm;
+    uint64_t shm_samples;
+    uint32_t shm_interval_ms;
+    bool health_valid;
+    uint8_t health_score;
+    uint8_t tier;
+    int epfd;
+    int tick_fd;
+    int probe_fd;
+    int health_fd;
+    int direct_fd;
+    bool direct_busy;
+    bool reload_pending;
+    int direct_result;
+    struct HealthReport direct_report;
+    int inotify_fd;
+    int signal_fd;
+    char journal_dir[ATOMIC_PATH_MAX];
+    const char *journal_base;
+    bool journal_seen;
+    uint32_t journal_crc;
+    int last_state;
+    int last_action;
+    char last_reason[160];
+    char last_status[512];
+};
+
+static uint64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static void plog(struct Daemon *d, const char *fmt, ...)
+{
+    char msg[320];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    fprintf(stderr, "[POLICYD] %s\n", msg);
+    if (d->log_fd >= 0)
+        dprintf(d->log_fd, "%llu %s\n", (unsigned long long)(now_ms() / 1000), msg);
+}
+
+static void usage(const char *prog)
+{
+    printf("PAC Policy Daemon\n\n");
+    printf("Usage: %s [options]\n\n", prog);
+    printf("Event-driven replacement for the policy_monitor.sh loop: promotes and\n");
+    printf("degrades tiers as soon as health, verifier or journal state changes.\n\n");
+    printf("Options:\n");
+    printf("  -j FILE       Boot journal (default: %s)\n", POLICYD_JOURNAL);
+    printf("  --shm PATH    Health daemon segment (default: %s)\n", HEALTH_SHM_PATH);
+    printf("  -c FILE       Health score configuration (default: %s)\n",
+           HEALTH_SCORE_CONFIG_PATH);
+    printf("  --state FILE  Published decision state (default: %s)\n", POLICYD_STATE);
+    printf("  --log FILE    Append log lines here (default: %s)\n", POLICYD_LOG);
+    printf("  --once        Evaluate once, print the decision and exit without acting\n");
+    printf("  --no-reboot   Update the journal but do not reboot after a transition\n");
+    printf("  -v            Verbose output\n");
+    printf("  -h            Show this help\n\n");
+    printf("Environment: MONITOR_INTERVAL, MIN_TIER3_TIME, VERIFIER_FAIL_THRESHOLD,\n");
+    printf("HEALTH_FAIL_THRESHOLD, MIN_HEALTH_SCORE_T2, MIN_HEALTH_SCORE_T3, VERIFIER_URL,\n");
+    printf("ATTEST_SCRIPT, NETWORK_SETUP_SCRIPT, VERIFIER_STATE, VERIFIER_STATE_MAX_AGE\n");
+    printf("(same meaning as in policy_monitor.sh)\n\n");
+    printf("Exit codes: 0 = clean shutdown, 1 = usage error, 255 = setup failure\n");
+}
+
+static void env_u32(const char *name, uint32_t scale, uint32_t *out)
+{
+    const char *v = getenv(name);
+    if (!v || !*v)
+        return;
+    char *end;
+    unsigned long n = strtoul(v, &end, 10);
+    if (*end || n > UINT32_MAX / scale) {
+        fprintf(stderr, "policy: ignoring invalid %s=%s\n", name, v);
+        return;
+    }
+    *out = (uint32_t)n * scale;
+}
+
+static void env_u8(const char *name, uint8_t *out)
+{
+    uint32_t v = *out;
+    env_u32(name, 1, &v);
+    if (v > UINT8_MAX)
+        fprintf(stderr, "policy: ignoring invalid %s=%u\n", name, v);
+    else
+        *out = (uint8_t)v;
+}
+
+static const char *env_str(const char *name, const char *fallback)
+{
+    const char *v = getenv(name);
+    return v && *v ? v : fallback;
+}
+
+static void load_config(struct Daemon *d)
+{
+    if (health_score_load(&d->scoring, d->score_path) < 0)
+        fprintf(stderr, "policy: using default health scoring\n");
+    struct PolicyConfig defaults = POLICY_CONFIG_DEFAULT;
+    d->config = defaults;
+    d->config.min_score_t2 = d->scoring.min_tier2;
+    d->config.min_score_t3 = d->scoring.min_tier3;
+    env_u32("MONITOR_INTERVAL", 1000, &d->config.interval_ms);
+    env_u32("MIN_TIER3_TIME", 1000, &d->config.min_tier3_ms);
+    env_u8("VERIFIER_FAIL_THRESHOLD", &d->config.verifier_fail_threshold);
+    env_u8("HEALTH_FAIL_THRESHOLD", &d->config.health_fail_threshold);
+    env_u8("MIN_HEALTH_SCORE_T2", &d->config.min_score_t2);
+    env_u8("MIN_HEALTH_SCORE_T3", &d->config.min_score_t3);
+    if (d->config.interval_ms == 0)
+        d->config.interval_ms = 1000;
+    health_config_default(&d->health);
+    d->health.simulate = true;
+    d->health.scoring = &d->scoring;
+    d->have_verifier = http_parse_url(env_str("VERIFIER_URL", POLICYD_VERIFIER_URL),
+                                      &d->verifier) == HTTP_OK;
+    d->verifier_state = env_str("VERIFIER_STATE", POLICYD_VERIFIER_STATE);
+    d->verifier_state_max_age = 120;
+    env_u32("VERIFIER_STATE_MAX_AGE", 1, &d->verifier_state_max_age);
+}
+
+static uint8_t snapshot_score(const struct Daemon *d, const struct HealthReport *report,
+                              uint32_t alarms)
+{
+    if (report->max_score == 0)
+        return 0;
+    uint8_t score = (uint8_t)(report->overall_score * HEALTH_SCORE_SCALE / report->max_score);
+    /* rate alarms fire before the hard thresholds do; treat them as low health */
+    if (alarms && score >= d->config.min_score_t2 && d->config.min_score_t2 > 0)
+        score = d->config.min_score_t2 - 1;
+    return score;
+}
+
+static void set_health(struct Daemon *d, uint8_t score)
+{
+    d->health_valid = true;
+    d->health_score = score;
+    policy_note_health(&d->config, &d->counters, score);
+}
+
+static void arm_timer(int fd, uint32_t period_ms)
+{
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    its.it_interval.tv_sec = period_ms / 1000;
+    its.it_interval.tv_nsec = (long)(period_ms % 1000) * 1000000L;
+    its.it_value = its.it_interval;
+    timerfd_settime(fd, 0, &its, NULL);
+}
+
+/* Returns true when the health daemon published a sample we have not seen */
+static bool poll_health_shm(struct Daemon *d)
+{
+    if (!d->shm) {
+        d->shm = health_shm_attach(d->shm_path);
+        if (!d->shm)
+            return false;
+    }
+    struct HealthSnapshot snap;
+    if (health_shm_snapshot(d->shm, &snap) != 0)
+        return false;
+    if (snap.interval_ms > 0 && snap.interval_ms != d->shm_interval_ms) {
+        d->shm_interval_ms = snap.interval_ms;
+        if (d->health_fd >= 0)
+            arm_timer(d->health_fd, snap.interval_ms);
+    }
+    if (snap.age_ms > snap.interval_ms * 3) {
+        if (d->health_valid && d->verbose)
+            plog(d, "Health snapshot stale (age %ums)", snap.age_ms);
+        d->health_valid = false;
+        return false;
+    }
+    if (snap.samples == d->shm_samples)
+        return false;
+    d->shm_samples = snap.samples;
+    set_health(d, snapshot_score(d, &snap.report, snap.trend.alarms));
+    return true;
+}
+
+/* Without a health daemon the checks run in-process instead of through health_check.sh */
+static void run_health_direct(struct Daemon *d)
+{
+    struct HealthReport report;
+    if (health_check_run(&d->health, &report) == HEALTH_ERROR) {
+        d->health_valid = false;
+        return;
+    }
+    set_health(d, snapshot_score(d, &report, 0));
+}
+
+/* The checks can take seconds, so the loop hands them to a worker and hears back on direct_fd */
+static void *direct_worker(void *arg)
+{
+    struct Daemon *d = arg;
+    d->direct_result = health_check_run(&d->health, &d->direct_report);
+    uint64_t one = 1;
+    if (write(d->direct_fd, &one, sizeof(one)) != sizeof(one))
+        fprintf(stderr, "policy: cannot signal health result\n");
+    return NULL;
+}
+
+static void start_health_direct(struct Daemon *d)
+{
+    if (d->direct_busy)
+        return;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_t tid;
+    d->direct_busy = pthread_create(&tid, &attr, direct_worker, d) == 0;
+    pthread_attr_destroy(&attr);
+    if (!d->direct_busy)
+        run_health_direct(d);
+}
+
+static bool finish_health_direct(struct Daemon *d)
+{
+    uint64_t count;
+    if (read(d->direct_fd, &count, sizeof(count)) != sizeof(count) || !d->direct_busy)
+        return false;
+    d->direct_busy = false;
+    if (d->direct_result == HEALTH_ERROR) {
+        d->health_valid = false;
+        return true;
+    }
+    set_health(d, snapshot_score(d, &d->direct_report, 0));
+    return true;
+}
+
+static void probe_verifier(struct Daemon *d)
+{
+    if (!d->have_verifier)
+        return;
+    /*
+     * Live attestation traffic is the better signal while pac_attestd keeps
+     * it fresh; otherwise only a 2xx from the verifier's /health counts, so
+     * a host that is up with the verifier process down reads as unreachable.
+     */
+    bool up;
+    if (http_state_load(d->verifier_state, d->verifier_state_max_age, &up) != HTTP_OK) {
+        char buf[512];
+        struct HttpResponse resp;
+        uint32_t timeout = d->config.probe_interval_ms / 2;
+        up = http_request(&d->verifier, "GET", "/health", NULL, NULL, 0,
+                          timeout < 1000 ? timeout : 1000, buf, sizeof(buf), &resp) == HTTP_OK &&
+             resp.status >= 200 && resp.status < 300;
+    }
+    bool was_up = d->counters.verifier_up;
+    policy_note_verifier(&d->counters, now_ms(), up);
+    if (up != was_up || (!up && d->verbose))
+        plog(d, "Verifier %s (failures: %u/%u)", up ? "reachable" : "unreachable",
+             d->counters.verifier_fail, d->config.verifier_fail_threshold);
+}
+
+static int read_journal(const struct Daemon *d, struct BootRecord *rec)
+{
+    journal_set_verbose(false);
+    int ret = journal_init(d->journal_path);
+    if (ret == JOURNAL_OK)
+        ret = journal_read(rec);
+    journal_close();
+    return ret;
+}
+
+static int read_meminfo_pct(void)
+{
+    FILE *f = fopen("/proc/meminfo", "r");
+    if (!f)
+        return -1;
+    char line[128];
+    unsigned long total = 0, avail = 0;
+    while (fgets(line, sizeof(line), f)) {
+        sscanf(line, "MemTotal: %lu", &total);
+        sscanf(line, "MemAvailable: %lu", &avail);
+    }
+    fclose(f);
+    return total > 0 ? (int)(avail * 100 / total) : -1;
+}
+
+static uint32_t read_ima_violations(void)
+{
+    FILE *f = fopen(POLICYD_IMA_VIOLATIONS, "r");
+    if (!f)
+        return 0;
+    unsigned long n = 0;
+    if (fscanf(f, "%lu", &n) != 1)
+        n = 0;
+    fclose(f);
+    return (uint32_t)n;
+}
+
+static int gather_inputs(struct Daemon *d, struct PolicyInputs *in)
+{
+    memset(in, 0, sizeof(*in));
+    in->now_ms = now_ms();
+    if (read_journal(d, &in->rec) != JOURNAL_OK)
+        return -1;
+    d->journal_seen = true;
+    d->journal_crc = in->rec.crc32;
+    d->tier = in->rec.tier;
+    in->health_valid = d->health_valid;
+    in->health_score = d->health_score;
+    in->t2_image = access(POLICYD_TIER2_IMAGE, F_OK) == 0;
+    in->t3_image = access(POLICYD_TIER3_IMAGE, F_OK) == 0;
+    in->ima_violations = read_ima_violations();
+    struct statvfs vfs;
+    if (statvfs("/var", &vfs) == 0) {
+        in->var_known = true;
+        in->var_free_kb = (uint64_t)vfs.f_bavail * vfs.f_frsize / 1024;
+    }
+    in->mem_avail_pct = read_meminfo_pct();
+    return 0;
+}
+
+static int run_script(struct Daemon *d, const char *path, const char *verbose, const char *out)
+{
+    if (access(path, R_OK) != 0) {
+        plog(d, "Script missing: %s", path);
+        return -1;
+    }
+    pid_t pid = fork();
+    if (pid < 0)
+        return -1;
+    if (pid == 0) {
+        sigset_t none;
+        sigemptyset(&none);
+        sigprocmask(SIG_SETMASK, &none, NULL);
+        int fd = open(out, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+        }
+        setenv("VERBOSE", verbose, 1);
+        execl("/bin/sh", "sh", path, (char *)NULL);
+        _exit(127);
+    }
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR)
+            return -1;
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static bool file_contains(const char *path, const char *const *needles)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return false;
+    char line[512];
+    bool found = false;
+    while (!found && fgets(line, sizeof(line), f)) {
+        for (int i = 0; needles[i] && !found; i++)
+            found = strstr(line, needles[i]) != NULL;
+    }
+    fclose(f);
+    return found;
+}
+
+static void decrement_tries(struct Daemon *d, uint8_t tier)
+{
+    struct BootRecord rec;
+    journal_set_verbose(false);
+    if (journal_init(d->journal_path) == JOURNAL_OK && journal_read(&rec) == JOURNAL_OK &&
+        journal_decrement_tries(&rec, tier) >= 0 && journal_write(&rec) == JOURNAL_OK)
+        plog(d, "Tier %u promotion attempts decremented", tier);
+    else
+        plog(d, "Failed to decrement Tier %u attempts", tier);
+    journal_close();
+}
+
+static void record_history(struct Daemon *d, uint8_t from, uint8_t to, uint8_t reason,
+                           uint64_t boot_count)
+{
+    char path[ATOMIC_PATH_MAX + 8];
+    if (history_path_for(d->journal_path, path, sizeof(path)) != JOURNAL_OK ||
+        history_open(path) != JOURNAL_OK)
+        return;
+    history_append(boot_count, from, to, reason, d->health_valid ? d->health_score : 0);
+    history_flush();
+    history_close();
+}
+
+static int transition(struct Daemon *d, uint8_t tier, uint8_t reason)
+{
+    struct BootRecord rec;
+    journal_set_verbose(false);
+    if (journal_init(d->journal_path) != JOURNAL_OK || journal_read(&rec) != JOURNAL_OK) {
+        journal_close();
+        plog(d, "Failed to read journal for Tier %u transition", tier);
+        return -1;
+    }
+    uint8_t from = rec.tier;
+    rec.tier = tier;
+    if (journal_write(&rec) != JOURNAL_OK) {
+        journal_close();
+        plog(d, "Failed to update journal to Tier %u", tier);
+        return -1;
+    }
+    if (d->health_valid)
+        journal_ext_push_health(d->health_score);
+    journal_ext_record_tier(tier, (uint64_t)time(NULL));
+    journal_close();
+    record_history(d, from, tier, reason, rec.boot_count);
+    plog(d, "%s to Tier %u (journal updated)",
+         reason == HISTORY_REASON_PROMOTE ? "PROMOTED" : "DEGRADED", tier);
+    memset(&d->counters, 0, sizeof(d->counters));
+    if (d->no_reboot)
+        return 0;
+    plog(d, "Rebooting to apply Tier %u rootfs...", tier);
+    sync();
+    if (reboot(RB_AUTOBOOT) != 0)
+        plog(d, "Reboot failed: %s", strerror(errno));
+    return 0;
+}
+
+static void promote_t2(struct Daemon *d)
+{
+    plog(d, "Attempting Tier 2 promotion...");
+    if (run_script(d, d->network_script, "0", "/dev/null") == 0) {
+        plog(d, "Network setup successful - promoting to Tier 2");
+        if (transition(d, TIER_2, HISTORY_REASON_PROMOTE) == 0)
+            return;
+    } else {
+        plog(d, "Network setup failed - Tier 2 promotion aborted");
+    }
+    decrement_tries(d, TIER_2);
+}
+
+static void promote_t3(struct Daemon *d)
+{
+    static const char *const passed[] = { "ATTESTATION PASSED", "Attestation passed", NULL };
+    char out[64];
+    snprintf(out, sizeof(out), "/tmp/pac_attest_output_%d", (int)getpid());
+    plog(d, "Verifier available - running attestation...");
+    int ret = run_script(d, d->attest_script, "1", out);
+    bool ok = ret == 0 && file_contains(out, passed);
+    unlink(out);
+    if (ok) {
+        plog(d, "Attestation passed - promoting to Tier 3");
+        if (transition(d, TIER_3, HISTORY_REASON_PROMOTE) == 0)
+            return;
+    } else {
+        plog(d, "Attestation failed - remaining in Tier 2");
+    }
+    decrement_tries(d, TIER_3);
+}
+
+static void sanity_check(struct Daemon *d)
+{
+    plog(d, "Verifier failure threshold reached - running attestation sanity check");
+    bool ok = run_script(d, d->attest_script, "0", POLICYD_SANITY_LOG) == 0;
+    policy_note_sanity(&d->counters, ok);
+    plog(d, ok ? "Sanity check succeeded - clearing verifier failure counter"
+               : "Sanity check failed");
+}
+
+static void publish_state(struct Daemon *d, const struct PolicyDecision *dec)
+{
+    char buf[sizeof(d->last_status)];
+    int n = snprintf(buf, sizeof(buf),
+                     "POLICY_STATE=S%d\nPOLICY_STATE_NAME=%s\nPOLICY_TIER=%u\n"
+                     "POLICY_ACTION=%s\nPOLICY_HEALTH_SCORE=%d\nPOLICY_HEALTH_FAILS=%u\n"
+                     "POLICY_VERIFIER_UP=%d\nPOLICY_VERIFIER_FAILS=%u\nPOLICY_REASON='%s'\n",
+                     dec->state, policy_state_name(dec->state), d->tier,
+                     policy_action_name(dec->action),
+                     d->health_valid ? d->health_score : -1, d->counters.health_fail,
+                     d->counters.verifier_up ? 1 : 0, d->counters.verifier_fail, dec->reason);
+    if (n < 0 || (size_t)n >= sizeof(buf) || strcmp(buf, d->last_status) == 0)
+        return;
+    memcpy(d->last_status, buf, (size_t)n + 1);
+    if (d->state_path && atomic_publish(d->state_path, buf, (size_t)n, 0644, 0) != ATOMIC_OK)
+        fprintf(stderr, "policy: cannot publish %s\n", d->state_path);
+}
+
+static void step(struct Daemon *d)
+{
+    for (int round = 0; round < 2; round++) {
+        struct PolicyInputs in;
+        if (gather_inputs(d, &in) != 0) {
+            plog(d, "Cannot read journal %s", d->journal_path);
+            return;
+        }
+        struct PolicyDecision dec;
+        policy_evaluate(&d->config, &d->counters, &in, &dec);
+        if (dec.state != d->last_state || dec.action != d->last_action ||
+            strcmp(dec.reason, d->last_reason) != 0) {
+            plog(d, "S%d %s: %s%s%s", dec.state, policy_state_name(dec.state), dec.reason,
+                 dec.action ? " -> " : "", dec.action ? policy_action_name(dec.action) : "");
+            d->last_state = dec.state;
+            d->last_action = dec.action;
+            memcpy(d->last_reason, dec.reason, sizeof(d->last_reason));
+        }
+        publish_state(d, &dec);
+        switch (dec.action) {
+        case POLICY_ACT_PROMOTE_T2:
+            promote_t2(d);
+            return;
+        case POLICY_ACT_PROMOTE_T3:
+            promote_t3(d);
+            return;
+        case POLICY_ACT_DEGRADE:
+            plog(d, "DEGRADING: %s", dec.reason);
+            transition(d, dec.target_tier, HISTORY_REASON_DEMOTE);
+            return;
+        case POLICY_ACT_SANITY:
+            sanity_check(d);
+            break;
+        default:
+            return;
+        }
+    }
+}
+
+static bool drain_inotify(struct Daemon *d)
+{
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool hit = false;
+    for (;;) {
+        ssize_t got = read(d->inotify_fd, buf, sizeof(buf));
+        if (got <= 0)
+            break;
+        for (char *p = buf; p < buf + got;) {
+            const struct inotify_event *ev = (const struct inotify_event *)p;
+            if (ev->len > 0 && strcmp(ev->name, d->journal_base) == 0)
+                hit = true;
+            p += sizeof(*ev) + ev->len;
+        }
+    }
+    return hit;
+}
+
+/* Our own reads and extension writes touch the file without changing the record */
+static bool journal_changed(struct Daemon *d)
+{
+    struct BootRecord rec;
+    if (read_journal(d, &rec) != JOURNAL_OK)
+        return true;
+    return !d->journal_seen || rec.crc32 != d->journal_crc;
+}
+
+static int add_fd(struct Daemon *d, int fd)
+{
+    struct epoll_event ev = { .events = EPOLLIN, .data.fd = fd };
+    return fd < 0 ? -1 : epoll_ctl(d->epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+static int setup_loop(struct Daemon *d)
+{
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGHUP);
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+    d->epfd = epoll_create1(EPOLL_CLOEXEC);
+    d->signal_fd = signalfd(-1, &mask, SFD_CLOEXEC | SFD_NONBLOCK);
+    d->tick_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    d->probe_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    d->health_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    d->direct_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    d->inotify_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (add_fd(d, d->signal_fd) || add_fd(d, d->tick_fd) || add_fd(d, d->probe_fd) ||
+        add_fd(d, d->health_fd) || add_fd(d, d->direct_fd) || add_fd(d, d->inotify_fd)) {
+        fprintf(stderr, "policy: event loop setup failed: %s\n", strerror(errno));
+        return -1;
+    }
+    /* not IN_CLOSE_WRITE: every journal_init opens read-write, so each read would re-fire */
+    if (inotify_add_watch(d->inotify_fd, d->journal_dir, IN_MODIFY | IN_MOVED_TO | IN_CREATE) < 0)
+        fprintf(stderr, "policy: cannot watch %s: %s\n", d->journal_dir, strerror(errno));
+    arm_timer(d->tick_fd, d->config.interval_ms);
+    arm_timer(d->probe_fd, d->config.probe_interval_ms);
+    arm_timer(d->health_fd, d->shm_interval_ms ? d->shm_interval_ms : POLICYD_HEALTH_POLL_MS);
+    return 0;
+}
+
+static void drain_timer(int fd)
+{
+    uint64_t expirations;
+    while (read(fd, &expirations, sizeof(expirations)) > 0)
+        ;
+}
+
+static int run_loop(struct Daemon *d)
+{
+    if (setup_loop(d) != 0)
+        return 255;
+    plog(d, "Policy daemon started (interval: %us, journal: %s)",
+         d->config.interval_ms / 1000, d->journal_path);
+    if (!poll_health_shm(d))
+        start_health_direct(d);
+    step(d);
+    bool running = true;
+    while (running) {
+        struct epoll_event events[8];
+        int n = epoll_wait(d->epfd, events, 8, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "policy: epoll_wait: %s\n", strerror(errno));
+            return 255;
+        }
+        bool evaluate = false;
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == d->signal_fd) {
+                struct signalfd_siginfo si;
+                while (read(fd, &si, sizeof(si)) == sizeof(si)) {
+                    if (si.ssi_signo == SIGHUP)
+                        d->reload_pending = true;
+                    else
+                        running = false;
+                }
+            } else if (fd == d->tick_fd) {
+                drain_timer(fd);
+                if (!poll_health_shm(d) && (!d->shm || !d->health_valid))
+                    start_health_direct(d);
+                evaluate = true;
+            } else if (fd == d->probe_fd) {
+                drain_timer(fd);
+                if (d->tier >= TIER_2) {
+                    probe_verifier(d);
+                    evaluate = true;
+                }
+            } else if (fd == d->health_fd) {
+                drain_timer(fd);
+                evaluate |= poll_health_shm(d);
+            } else if (fd == d->direct_fd) {
+                evaluate |= finish_health_direct(d);
+            } else if (fd == d->inotify_fd) {
+                evaluate |= drain_inotify(d) && journal_changed(d);
+            }
+        }
+        /* the worker reads the scoring table, so a reload waits for it */
+        if (d->reload_pending && !d->direct_busy) {
+            plog(d, "Reloading configuration");
+            load_config(d);
+            d->reload_pending = false;
+            evaluate = true;
+        }
+        if (running && evaluate)
+            step(d);
+    }
+    plog(d, "Policy daemon stopped");
+    return 0;
+}
+
+static int run_once(struct Daemon *d)
+{
+    if (!poll_health_shm(d))
+        run_health_direct(d);
+    struct PolicyInputs in;
+    if (gather_inputs(d, &in) != 0) {
+        fprintf(stderr, "policy: cannot read journal %s\n", d->journal_path);
+        return 255;
+    }
+    if (in.rec.tier >= TIER_2)
+        probe_verifier(d);
+    struct PolicyDecision dec;
+    policy_evaluate(&d->config, &d->counters, &in, &dec);
+    d->state_path = NULL;
+    publish_state(d, &dec);
+    fputs(d->last_status, stdout);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    struct Daemon d;
+    memset(&d, 0, sizeof(d));
+    d.journal_path = env_str("JOURNAL", POLICYD_JOURNAL);
+    d.shm_path = env_str("HEALTH_SHM", HEALTH_SHM_PATH);
+    d.state_path = POLICYD_STATE;
+    d.attest_script = env_str("ATTEST_SCRIPT", POLICYD_ATTEST);
+    d.network_script = env_str("NETWORK_SETUP_SCRIPT", POLICYD_NETWORK_SETUP);
+    d.log_fd = -1;
+    d.epfd = d.tick_fd = d.probe_fd = d.health_fd = d.direct_fd = d.inotify_fd = d.signal_fd = -1;
+    d.last_state = -1;
+    const char *log_path = POLICYD_LOG;
+    bool once = false;
+    static const struct option long_opts[] = {
+        { "shm",       required_argument, NULL, 'S' },
+        { "state",     required_argument, NULL, 'T' },
+        { "log",       required_argument, NULL, 'L' },
+        { "once",      no_argument,       NULL, 'O' },
+        { "no-reboot", no_argument,       NULL, 'N' },
+        { "help",      no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "j:c:vh", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'j': d.journal_path = optarg; break;
+        case 'c': d.score_path = optarg; break;
+        case 'S': d.shm_path = optarg; break;
+        case 'T': d.state_path = optarg; break;
+        case 'L': log_path = optarg; break;
+        case 'O': once = true; break;
+        case 'N': d.no_reboot = true; break;
+        case 'v': d.verbose = true; break;
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    load_config(&d);
+    if (once)
+        return run_once(&d);
+    const char *slash = strrchr(d.journal_path, '/');
+    if (!slash) {
+        strcpy(d.journal_dir, ".");
+        d.journal_base = d.journal_path;
+    } else if (slash == d.journal_path) {
+        strcpy(d.journal_dir, "/");
+        d.journal_base = slash + 1;
+    } else if ((size_t)(slash - d.journal_path) < sizeof(d.journal_dir)) {
+        memcpy(d.journal_dir, d.journal_path, (size_t)(slash - d.journal_path));
+        d.journal_dir[slash - d.journal_path] = '\0';
+        d.journal_base = slash + 1;
+    } else {
+        fprintf(stderr, "policy: journal path too long\n");
+        return 1;
+    }
+    if (log_path && *log_path)
+        d.log_fd = open(log_path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    return run_loop(&d);
+}
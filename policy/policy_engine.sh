@@ -6,6 +6,12 @@ JOURNAL="${JOURNAL:-/var/pac/journal.dat}"
 HEALTH_JSON="${HEALTH_JSON:-/tmp/health.json}"
 POLICY_CONFIG="${POLICY_CONFIG:-/etc/pac/policy.conf}"
 JOURNAL_TOOL="${JOURNAL_TOOL:-journal_tool}"
+PAC_MERKLE="${PAC_MERKLE:-/bin/pac_merkle}"
+PAC_PUBKEY="${PAC_PUBKEY:-${FT_PAC:-${HOME}/ft-pac}/keys/pac_public.pem}"
+MERKLE_MODE="${MERKLE_MODE:-lazy}"
+MERKLE_DEADLINE_MS="${MERKLE_DEADLINE_MS:-2000}"
+PAC_POLICY="${PAC_POLICY:-/bin/pac_policy}"
+POLICY_NATIVE="${POLICY_NATIVE:-1}"
 
 VERBOSE="${POLICY_VERBOSE:-0}"
 
@@ -50,6 +56,37 @@ read_journal_field() {
     echo "${value:-0}"
 }
 
+read_journal_state() {
+    local state
+    if state=$($JOURNAL_TOOL get tier,tries_t2,tries_t3,boot_count,flags --format=shell "$JOURNAL" 2>/dev/null); then
+        eval "$state"
+        CURRENT_TIER="$tier"
+        TRIES_T2="$tries_t2"
+        TRIES_T3="$tries_t3"
+        BOOT_COUNT="$boot_count"
+        HAS_EMERGENCY_FLAG=$((flags & 1))
+        HAS_BROWNOUT_FLAG=$(((flags >> 2) & 1))
+        return 0
+    fi
+    
+    CURRENT_TIER=$(read_journal_field "Tier")
+    TRIES_T2=$(read_journal_field "Tries T2")
+    TRIES_T3=$(read_journal_field "Tries T3")
+    BOOT_COUNT=$(read_journal_field "Boot Count")
+    
+    if $JOURNAL_TOOL read "$JOURNAL" 2>/dev/null | grep -q "FLAG.*BROWNOUT"; then
+        HAS_BROWNOUT_FLAG=1
+    else
+        HAS_BROWNOUT_FLAG=0
+    fi
+    
+    if $JOURNAL_TOOL read "$JOURNAL" 2>/dev/null | grep -q "FLAG.*EMERGENCY"; then
+        HAS_EMERGENCY_FLAG=1
+    else
+        HAS_EMERGENCY_FLAG=0
+    fi
+}
+
 read_health_field() {
     local field="$1"
     if [ -f "$HEALTH_JSON" ]; then
@@ -85,10 +122,35 @@ load_policy_config() {
     fi
 }
 
+# Merkle manifest check: lazy hashes only the files marked as opened
+# during early boot, full hashes the whole tree; both stop at the deadline
+verify_tier_manifest() {
+    local tier="$1"
+    local root="$2"
+    local mode=""
+    
+    [ "$MERKLE_MODE" = "lazy" ] && mode="--lazy"
+    log "Verifying Tier-$tier Merkle manifest ($MERKLE_MODE)..."
+    local start_time=$(date +%s%3N 2>/dev/null || echo 0)
+    
+    if "$PAC_MERKLE" verify "$root" -p "$PAC_PUBKEY" $mode --deadline "$MERKLE_DEADLINE_MS"; then
+        local end_time=$(date +%s%3N 2>/dev/null || echo 0)
+        log "Tier-$tier manifest verified ($((end_time - start_time))ms)"
+        return 0
+    fi
+    warn "Tier-$tier manifest verification failed"
+    return 1
+}
+
 verify_tier2_signatures() {
     local tier2_root="${TIER2_ROOT:-/tier2-root}"
     local verify_script="${FT_PAC:-${HOME}/ft-pac}/scripts/verify_tier_signature.sh"
     
+    if [ -x "$PAC_MERKLE" ] && [ -f "$tier2_root/manifest.merkle" ]; then
+        verify_tier_manifest 2 "$tier2_root"
+        return
+    fi
+    
     if [ -x "$verify_script" ] && [ -f "$tier2_root/manifest.sig" ]; then
         log "Verifying Tier-2 RSA-2048 signature..."
         local start_time=$(date +%s%3N 2>/dev/null || echo 0)
@@ -109,11 +171,6 @@ verify_tier2_signatures() {
         return 0
     fi
     
-    if [ -d "$tier2_root" ]; then
-        log "Tier-2 signatures verified (fallback check)"
-        return 0
-    fi
-    
     log "Tier-2 signature verification failed (no valid signature method)"
     return 1
 }
@@ -122,6 +179,11 @@ verify_tier3_signatures() {
     local tier3_root="${TIER3_ROOT:-/tier3-root}"
     local verify_script="${FT_PAC:-${HOME}/ft-pac}/scripts/verify_tier_signature.sh"
     
+    if [ -x "$PAC_MERKLE" ] && [ -f "$tier3_root/manifest.merkle" ]; then
+        verify_tier_manifest 3 "$tier3_root"
+        return
+    fi
+    
     if [ -x "$verify_script" ] && [ -f "$tier3_root/manifest.sig" ]; then
         log "Verifying Tier-3 RSA-2048 signature..."
         local start_time=$(date +%s%3N 2>/dev/null || echo 0)
@@ -142,21 +204,53 @@ verify_tier3_signatures() {
         return 0
     fi
     
-    if [ -d "$tier3_root" ] || [ -d /tier2-root ]; then
-        log "Tier-3 signatures verified (fallback check)"
-        return 0
-    fi
-    
     log "Tier-3 signature verification failed (no valid signature method)"
     return 1
 }
 
+# Only a journal_tool without 'apply' gets the ops one call at a time; a
+# failed apply is returned as is so a list is never half committed
+journal_apply() {
+    local ops="$1"
+    local op
+    
+    if [ -z "$JOURNAL_HAS_APPLY" ]; then
+        JOURNAL_HAS_APPLY=0
+        $JOURNAL_TOOL 2>&1 | grep -q "apply" && JOURNAL_HAS_APPLY=1
+    fi
+    if [ "$JOURNAL_HAS_APPLY" -eq 1 ]; then
+        if $JOURNAL_TOOL apply "$ops" "$JOURNAL" >/dev/null; then
+            return 0
+        fi
+        error "Journal update failed: $ops"
+        return 1
+    fi
+    
+    local old_ifs="$IFS"
+    IFS=';'
+    for op in $ops; do
+        IFS="$old_ifs"
+        case "$op" in
+            tier=*)       $JOURNAL_TOOL set-tier "${op#tier=}" "$JOURNAL" ;;
+            dec-tries=*)  $JOURNAL_TOOL dec-tries "${op#dec-tries=}" "$JOURNAL" ;;
+            set-flag=*)   $JOURNAL_TOOL set-flag "${op#set-flag=}" "$JOURNAL" ;;
+            clear-flag=*) $JOURNAL_TOOL clear-flag "${op#clear-flag=}" "$JOURNAL" 2>/dev/null || true ;;
+            reset-tries)  $JOURNAL_TOOL reset-tries "$JOURNAL" ;;
+            inc-boot)     $JOURNAL_TOOL inc-boot "$JOURNAL" ;;
+        esac
+        IFS=';'
+    done
+    IFS="$old_ifs"
+}
+
+record_history() {
+    $JOURNAL_TOOL history-add "${CURRENT_TIER:-1}" "$1" "$2" "${HEALTH_SCORE:-0}" "$JOURNAL" >/dev/null 2>&1 || true
+}
+
 promote_to_tier2() {
     log "Promoting to Tier-2"
-    $JOURNAL_TOOL set-tier 2 "$JOURNAL"
-    $JOURNAL_TOOL reset-tries "$JOURNAL"
-    
-    $JOURNAL_TOOL clear-flag dirty "$JOURNAL" 2>/dev/null || true
+    journal_apply "tier=2;reset-tries;clear-flag=dirty"
+    record_history 2 promote
     
     DECISION="promote"
     ACTION="tier2"
@@ -165,8 +259,8 @@ promote_to_tier2() {
 
 promote_to_tier3() {
     log "Promoting to Tier-3"
-    $JOURNAL_TOOL set-tier 3 "$JOURNAL"
-    $JOURNAL_TOOL reset-tries "$JOURNAL"
+    journal_apply "tier=3;reset-tries"
+    record_history 3 promote
     
     DECISION="promote"
     ACTION="tier3"
@@ -179,6 +273,7 @@ stay_in_tier() {
     
     log "Staying in Tier-$tier: $reason"
     $JOURNAL_TOOL set-tier "$tier" "$JOURNAL"
+    record_history "$tier" stay
     
     DECISION="stay"
     ACTION="tier$tier"
@@ -190,16 +285,16 @@ demote_tier() {
     local from_tier="$1"
     local to_tier="$2"
     local reason="$3"
+    local ops="tier=$to_tier;set-flag=dirty"
     
     warn "Demoting from Tier-$from_tier to Tier-$to_tier: $reason"
-    $JOURNAL_TOOL set-tier "$to_tier" "$JOURNAL"
-    $JOURNAL_TOOL set-flag dirty "$JOURNAL"
-    
-    if [ "$from_tier" -eq 2 ]; then
-        $JOURNAL_TOOL dec-tries 2 "$JOURNAL"
-    elif [ "$from_tier" -eq 3 ]; then
-        $JOURNAL_TOOL dec-tries 3 "$JOURNAL"
+    if [ "$from_tier" -eq 2 ] || [ "$from_tier" -eq 3 ]; then
+        ops="$ops;dec-tries=$from_tier"
+    elif [ "$from_tier" -eq 1 ]; then
+        ops="$ops;dec-tries=2"
     fi
+    journal_apply "$ops"
+    record_history "$to_tier" demote
     
     DECISION="demote"
     ACTION="tier$to_tier"
@@ -211,9 +306,8 @@ enter_emergency_mode() {
     local reason="$1"
     
     error "Entering emergency mode: $reason"
-    $JOURNAL_TOOL set-tier 1 "$JOURNAL"
-    $JOURNAL_TOOL set-flag emergency "$JOURNAL"
-    $JOURNAL_TOOL set-flag quarantine "$JOURNAL"
+    journal_apply "tier=1;set-flag=emergency;set-flag=quarantine"
+    record_history 1 emergency
     
     DECISION="emergency"
     ACTION="tier1_emergency"
@@ -358,27 +452,20 @@ evaluate_tier3_health() {
 }
 
 main() {
+    # The compiled evaluator makes the same decision without a fork per field
+    if [ "$POLICY_NATIVE" -eq 1 ] && [ -x "$PAC_POLICY" ]; then
+        if [ "$VERBOSE" -eq 1 ]; then
+            exec "$PAC_POLICY" -v -j "$JOURNAL" -c "$POLICY_CONFIG" --health "$HEALTH_JSON"
+        fi
+        exec "$PAC_POLICY" -j "$JOURNAL" -c "$POLICY_CONFIG" --health "$HEALTH_JSON"
+    fi
+
     log "PAC Policy Engine starting..."
     
     load_policy_config
     
     log "Reading journal state from $JOURNAL"
-    CURRENT_TIER=$(read_journal_field "Tier")
-    TRIES_T2=$(read_journal_field "Tries T2")
-    TRIES_T3=$(read_journal_field "Tries T3")
-    BOOT_COUNT=$(read_journal_field "Boot Count")
-    
-    if $JOURNAL_TOOL read "$JOURNAL" 2>/dev/null | grep -q "FLAG.*BROWNOUT"; then
-        HAS_BROWNOUT_FLAG=1
-    else
-        HAS_BROWNOUT_FLAG=0
-    fi
-    
-    if $JOURNAL_TOOL read "$JOURNAL" 2>/dev/null | grep -q "FLAG.*EMERGENCY"; then
-        HAS_EMERGENCY_FLAG=1
-    else
-        HAS_EMERGENCY_FLAG=0
-    fi
+    read_journal_state
     
     log "Current state: Tier=$CURRENT_TIER, T2_tries=$TRIES_T2, T3_tries=$TRIES_T3, Boots=$BOOT_COUNT"
     
@@ -421,7 +508,8 @@ main() {
             RESULT=$?
             ;;
         2)
-            if [ "$TRIES_T3" -gt 0 ]; then
+            if [ "$TRIES_T3" -gt 0 ] && [ "$HEALTH_SCORE" -ge 3 ] &&
+               [ "$STORAGE_OK" -ne 0 ] && [ "$MEM_OK" -ne 0 ]; then
                 evaluate_tier2_to_tier3
                 RESULT=$?
             else
@@ -0,0 +1,253 @@
+#include "policy_fsm.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+static const char *const state_names[POLICY_STATE_COUNT] = {
+    "INIT", "T1_LOAD", "T1_MEASURE", "T1_HEALTH", "T1_OK",
+    "T2_LOAD", "T2_MEASURE", "T2_HEALTH", "T2_OK",
+    "T3_LOAD", "T3_MEASURE", "T3_HEALTH", "T3_OK",
+    "RECOVERY", "FAULT",
+};
+
+static const char *const action_names[] = {
+    "none", "promote-t2", "promote-t3", "degrade", "sanity-check",
+};
+
+int policy_state_for(const struct BootRecord *rec)
+{
+    if (journal_has_flag(rec, FLAG_EMERGENCY))
+        return POLICY_S_RECOVERY;
+    switch (rec->tier) {
+    case TIER_2: return POLICY_S_T2_OK;
+    case TIER_3: return POLICY_S_T3_OK;
+    default:     return POLICY_S_T1_OK;
+    }
+}
+
+const char *policy_state_name(int state)
+{
+    return state >= 0 && state < POLICY_STATE_COUNT ? state_names[state] : "UNKNOWN";
+}
+
+const char *policy_action_name(int action)
+{
+    if (action < 0 || action >= (int)(sizeof(action_names) / sizeof(action_names[0])))
+        return "unknown";
+    return action_names[action];
+}
+
+void policy_note_health(const struct PolicyConfig *config, struct PolicyCounters *counters,
+                        uint8_t score)
+{
+    if (score >= config->min_score_t2)
+        counters->health_fail = 0;
+    else if (counters->health_fail < UINT8_MAX)
+        counters->health_fail++;
+}
+
+void policy_note_verifier(struct PolicyCounters *counters, uint64_t now_ms, bool up)
+{
+    counters->verifier_up = up;
+    if (up) {
+        counters->verifier_fail = 0;
+        counters->sanity_failed = false;
+        if (counters->net_up_since_ms == 0)
+            counters->net_up_since_ms = now_ms;
+        return;
+    }
+    counters->net_up_since_ms = 0;
+    if (counters->verifier_fail < UINT8_MAX)
+        counters->verifier_fail++;
+}
+
+void policy_note_sanity(struct PolicyCounters *counters, bool ok)
+{
+    if (ok)
+        counters->verifier_fail = 0;
+    counters->sanity_failed = !ok;
+}
+
+static void add_reason(struct PolicyDecision *d, const char *fmt, ...)
+{
+    size_t off = strlen(d->reason);
+    if (off > 0 && off < sizeof(d->reason) - 2) {
+        memcpy(d->reason + off, "; ", 3);
+        off += 2;
+    }
+    if (off >= sizeof(d->reason) - 1)
+        return;
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(d->reason + off, sizeof(d->reason) - off, fmt, ap);
+    va_end(ap);
+}
+
+static bool attempt_allowed(const struct PolicyConfig *config,
+                            const struct PolicyCounters *counters, uint64_t now_ms)
+{
+    return counters->last_attempt_ms == 0 ||
+           now_ms - counters->last_attempt_ms >= config->interval_ms;
+}
+
+static bool guards_t2(const struct PolicyConfig *config, const struct PolicyInputs *in,
+                      struct PolicyDecision *d)
+{
+    if (in->rec.tries_t2 == 0)
+        add_reason(d, "Tier 2 attempts exhausted");
+    else if (journal_has_flag(&in->rec, FLAG_QUARANTINE))
+        add_reason(d, "system quarantined");
+    else if (!in->t2_image)
+        add_reason(d, "Tier 2 rootfs image missing");
+    else if (!in->health_valid)
+        add_reason(d, "health data unavailable");
+    else if (in->health_score < config->promote_t2_score)
+        add_reason(d, "health %u < %u for Tier 2", in->health_score, config->promote_t2_score);
+    else
+        return true;
+    return false;
+}
+
+static bool guards_t3(const struct PolicyConfig *config, const struct PolicyCounters *counters,
+                      const struct PolicyInputs *in, struct PolicyDecision *d)
+{
+    if (in->rec.tries_t3 == 0)
+        add_reason(d, "Tier 3 attempts exhausted");
+    else if (!in->health_valid)
+        add_reason(d, "health data unavailable");
+    else if (in->health_score < config->promote_t3_score)
+        add_reason(d, "health %u < %u for Tier 3", in->health_score, config->promote_t3_score);
+    else if (counters->net_up_since_ms == 0 ||
+             in->now_ms - counters->net_up_since_ms < config->net_stable_ms)
+        add_reason(d, "network not stable for %us", config->net_stable_ms / 1000);
+    else if (!counters->verifier_up)
+        add_reason(d, "verifier not reachable");
+    else
+        return true;
+    return false;
+}
+
+static bool resources_low(const struct PolicyInputs *in, uint32_t min_var_kb, uint8_t min_mem_pct,
+                          struct PolicyDecision *d)
+{
+    bool low = false;
+    if (in->var_known && in->var_free_kb < min_var_kb) {
+        add_reason(d, "disk space critical (/var: %lluKB < %uKB)",
+                   (unsigned long long)in->var_free_kb, min_var_kb);
+        low = true;
+    }
+    if (in->mem_avail_pct >= 0 && in->mem_avail_pct < min_mem_pct) {
+        add_reason(d, "memory exhaustion (%d%% < %u%% available)", in->mem_avail_pct, min_mem_pct);
+        low = true;
+    }
+    return low;
+}
+
+static int evaluate_t1(const struct PolicyConfig *config, struct PolicyCounters *counters,
+                       const struct PolicyInputs *in, struct PolicyDecision *d)
+{
+    if (!attempt_allowed(config, counters, in->now_ms)) {
+        add_reason(d, "waiting before next Tier 2 attempt");
+        return POLICY_ACT_NONE;
+    }
+    if (!guards_t2(config, in, d))
+        return POLICY_ACT_NONE;
+    counters->last_attempt_ms = in->now_ms;
+    add_reason(d, "Tier 2 guards satisfied (health %u)", in->health_score);
+    d->target_tier = TIER_2;
+    return POLICY_ACT_PROMOTE_T2;
+}
+
+static int evaluate_t2(const struct PolicyConfig *config, struct PolicyCounters *counters,
+                       const struct PolicyInputs *in, struct PolicyDecision *d)
+{
+    struct PolicyDecision promote = { 0 };
+    if (attempt_allowed(config, counters, in->now_ms) && guards_t3(config, counters, in, &promote)) {
+        counters->last_attempt_ms = in->now_ms;
+        add_reason(d, "Tier 3 guards satisfied (health %u)", in->health_score);
+        d->target_tier = TIER_3;
+        return POLICY_ACT_PROMOTE_T3;
+    }
+    bool degrade = false;
+    if (counters->health_fail >= config->health_fail_threshold) {
+        add_reason(d, "sustained health degradation (%u consecutive failures)",
+                   counters->health_fail);
+        degrade = true;
+    }
+    if (resources_low(in, config->t2_min_var_kb, config->t2_min_mem_pct, d))
+        degrade = true;
+    if (!degrade) {
+        add_reason(d, "%s", promote.reason[0] ? promote.reason : "waiting before next Tier 3 attempt");
+        return POLICY_ACT_NONE;
+    }
+    d->target_tier = TIER_1;
+    return POLICY_ACT_DEGRADE;
+}
+
+static int evaluate_t3(const struct PolicyConfig *config, struct PolicyCounters *counters,
+                       const struct PolicyInputs *in, struct PolicyDecision *d)
+{
+    if (counters->tier3_start_ms == 0 || in->now_ms < counters->tier3_start_ms)
+        counters->tier3_start_ms = in->now_ms;
+    uint64_t in_tier3 = in->now_ms - counters->tier3_start_ms;
+    if (in_tier3 < config->min_tier3_ms) {
+        add_reason(d, "Tier 3 grace period active (%llus < %us)",
+                   (unsigned long long)(in_tier3 / 1000), config->min_tier3_ms / 1000);
+        return POLICY_ACT_NONE;
+    }
+    bool degrade = false;
+    if (in->health_valid && in->health_score < config->min_score_t3) {
+        add_reason(d, "health degraded (%u < %u)", in->health_score, config->min_score_t3);
+        degrade = true;
+    }
+    if (in->ima_violations > 0) {
+        add_reason(d, "IMA integrity violation detected (%u violations)", in->ima_violations);
+        degrade = true;
+    }
+    if (resources_low(in, config->t3_min_var_kb, config->t3_min_mem_pct, d))
+        degrade = true;
+    if (journal_has_flag(&in->rec, FLAG_BROWNOUT)) {
+        add_reason(d, "brownout flag present");
+        degrade = true;
+    }
+    if (!degrade && counters->verifier_fail >= config->verifier_fail_threshold) {
+        if (!counters->sanity_failed) {
+            add_reason(d, "verifier unreachable (%u consecutive failures)", counters->verifier_fail);
+            return POLICY_ACT_SANITY;
+        }
+        add_reason(d, "verifier unreachable (%u consecutive failures, attestation sanity check failed)",
+                   counters->verifier_fail);
+        degrade = true;
+    }
+    if (!degrade) {
+        add_reason(d, "Tier 3 healthy");
+        return POLICY_ACT_NONE;
+    }
+    d->target_tier = TIER_2;
+    return POLICY_ACT_DEGRADE;
+}
+
+int policy_evaluate(const struct PolicyConfig *config, struct PolicyCounters *counters,
+                    const struct PolicyInputs *in, struct PolicyDecision *decision)
+{
+    memset(decision, 0, sizeof(*decision));
+    decision->state = policy_state_for(&in->rec);
+    if (decision->state != POLICY_S_T3_OK)
+        counters->tier3_start_ms = 0;
+    switch (decision->state) {
+    case POLICY_S_RECOVERY:
+        add_reason(decision, "emergency flag set - awaiting operator intervention");
+        decision->action = POLICY_ACT_NONE;
+        break;
+    case POLICY_S_T1_OK:
+        decision->action = evaluate_t1(config, counters, in, decision);
+        break;
+    case POLICY_S_T2_OK:
+        decision->action = evaluate_t2(config, counters, in, decision);
+        break;
+    default:
+        decision->action = evaluate_t3(config, counters, in, decision);
+        break;
+    }
+    return decision->action;
+}
@@ -0,0 +1,110 @@
+#ifndef POLICY_FSM_H
+#define POLICY_FSM_H
+#include "boot_journal.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Same numbering as the STATE_* names in policy_monitor.sh */
+#define POLICY_S_INIT         0
+#define POLICY_S_T1_LOAD      1
+#define POLICY_S_T1_MEASURE   2
+#define POLICY_S_T1_HEALTH    3
+#define POLICY_S_T1_OK        4
+#define POLICY_S_T2_LOAD      5
+#define POLICY_S_T2_MEASURE   6
+#define POLICY_S_T2_HEALTH    7
+#define POLICY_S_T2_OK        8
+#define POLICY_S_T3_LOAD      9
+#define POLICY_S_T3_MEASURE   10
+#define POLICY_S_T3_HEALTH    11
+#define POLICY_S_T3_OK        12
+#define POLICY_S_RECOVERY     13
+#define POLICY_S_FAULT        14
+#define POLICY_STATE_COUNT    15
+
+#define POLICY_ACT_NONE        0
+#define POLICY_ACT_PROMOTE_T2  1
+#define POLICY_ACT_PROMOTE_T3  2
+#define POLICY_ACT_DEGRADE     3
+#define POLICY_ACT_SANITY      4
+
+struct PolicyConfig {
+    uint32_t interval_ms;
+    uint32_t probe_interval_ms;
+    uint32_t min_tier3_ms;
+    uint32_t net_stable_ms;
+    uint8_t  verifier_fail_threshold;
+    uint8_t  health_fail_threshold;
+    uint8_t  promote_t2_score;
+    uint8_t  promote_t3_score;
+    uint8_t  min_score_t2;
+    uint8_t  min_score_t3;
+    uint32_t t2_min_var_kb;
+    uint32_t t3_min_var_kb;
+    uint8_t  t2_min_mem_pct;
+    uint8_t  t3_min_mem_pct;
+};
+
+#define POLICY_CONFIG_DEFAULT { \
+    .interval_ms = 10000, \
+    .probe_interval_ms = 2000, \
+    .min_tier3_ms = 10000, \
+    .net_stable_ms = 60000, \
+    .verifier_fail_threshold = 2, \
+    .health_fail_threshold = 2, \
+    .promote_t2_score = 3, \
+    .promote_t3_score = 8, \
+    .min_score_t2 = 6, \
+    .min_score_t3 = 9, \
+    .t2_min_var_kb = 5120, \
+    .t3_min_var_kb = 10240, \
+    .t2_min_mem_pct = 3, \
+    .t3_min_mem_pct = 5 \
+}
+
+/* Everything one evaluation looks at; gathered by the caller without forking */
+struct PolicyInputs {
+    uint64_t now_ms;
+    struct BootRecord rec;
+    bool     health_valid;
+    uint8_t  health_score;
+    bool     t2_image;
+    bool     t3_image;
+    uint32_t ima_violations;
+    bool     var_known;
+    uint64_t var_free_kb;
+    int      mem_avail_pct;
+};
+
+/* State carried between evaluations, the counter files of the shell monitor */
+struct PolicyCounters {
+    uint8_t  health_fail;
+    uint8_t  verifier_fail;
+    bool     verifier_up;
+    bool     sanity_failed;
+    uint64_t net_up_since_ms;
+    uint64_t tier3_start_ms;
+    uint64_t last_attempt_ms;
+};
+
+struct PolicyDecision {
+    int     state;
+    int     action;
+    uint8_t target_tier;
+    char    reason[160];
+};
+
+int policy_state_for(const struct BootRecord *rec);
+const char *policy_state_name(int state);
+const char *policy_action_name(int action);
+
+void policy_note_health(const struct PolicyConfig *config, struct PolicyCounters *counters,
+                        uint8_t score);
+void policy_note_verifier(struct PolicyCounters *counters, uint64_t now_ms, bool up);
+void policy_note_sanity(struct PolicyCounters *counters, bool ok);
+
+int policy_evaluate(const struct PolicyConfig *config, struct PolicyCounters *counters,
+                    const struct PolicyInputs *in, struct PolicyDecision *decision);
+
+#endif
@@ -0,0 +1,511 @@
+#include "policy_rules.h"
+#include "boot_history.h"
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+
+#define KEY_U8   0
+#define KEY_BOOL 1
+#define KEY_U32  2
+
+static const struct {
+    const char *name;
+    size_t offset;
+    uint8_t kind;
+} conf_keys[] = {
+    { "POLICY_T2_MIN_HEALTH_SCORE",    offsetof(struct PolicyConf, t2_min_health),          KEY_U8 },
+    { "POLICY_T2_REQUIRE_WDT",         offsetof(struct PolicyConf, t2_require_wdt),         KEY_BOOL },
+    { "POLICY_T2_REQUIRE_ECC",         offsetof(struct PolicyConf, t2_require_ecc),         KEY_BOOL },
+    { "POLICY_T2_REQUIRE_STORAGE",     offsetof(struct PolicyConf, t2_require_storage),     KEY_BOOL },
+    { "POLICY_T2_REQUIRE_MEMORY",      offsetof(struct PolicyConf, t2_require_memory),      KEY_BOOL },
+    { "POLICY_T2_REQUIRE_NETWORK",     offsetof(struct PolicyConf, t2_require_network),     KEY_BOOL },
+    { "POLICY_T3_MIN_HEALTH_SCORE",    offsetof(struct PolicyConf, t3_min_health),          KEY_U8 },
+    { "POLICY_T3_REQUIRE_NETWORK",     offsetof(struct PolicyConf, t3_require_network),     KEY_BOOL },
+    { "POLICY_EMERGENCY_ON_EXHAUSTED", offsetof(struct PolicyConf, emergency_on_exhausted), KEY_BOOL },
+    { "POLICY_BROWNOUT_WAIT_BOOTS",    offsetof(struct PolicyConf, brownout_wait_boots),    KEY_U32 },
+};
+
+#define CONF_KEY_COUNT (int)(sizeof(conf_keys) / sizeof(conf_keys[0]))
+
+/* Rule sources are 1 + the conf_keys index; 0 marks rules every policy has */
+#define SRC_BUILTIN          0
+#define SRC_T2_MIN_HEALTH    1
+#define SRC_T2_WDT           2
+#define SRC_T2_ECC           3
+#define SRC_T2_STORAGE       4
+#define SRC_T2_MEMORY        5
+#define SRC_T2_NETWORK       6
+#define SRC_T3_MIN_HEALTH    7
+#define SRC_T3_NETWORK       8
+#define SRC_EXHAUSTED        9
+#define SRC_BROWNOUT_WAIT    10
+
+/* Reasons use the observed value and limit of the rule's last condition */
+static const char *const reasons[] = {
+    "",
+    "Emergency mode",
+    "Tier-2 attempts exhausted",
+    "Recovering from brownout (boot %llu)",
+    "Brownout recovery period complete",
+    "Health score too low (%llu < %llu)",
+    "Critical component check failed",
+    "Signature verification failed",
+    "Health score insufficient for Tier-3 (%llu < %llu)",
+    "Network required for Tier-3 but unavailable",
+    "Tier-3 signature verification failed",
+    "Critical health degradation",
+    "Critical component failure",
+    "Health check passed",
+    "Health degradation",
+    "Network unavailable",
+    "Unknown tier, resetting to safe mode",
+};
+
+#define R_NONE            0
+#define R_EMERGENCY       1
+#define R_T2_EXHAUSTED    2
+#define R_BROWNOUT_WAIT   3
+#define R_BROWNOUT_CLEAR  4
+#define R_T2_LOW_HEALTH   5
+#define R_T2_COMPONENT    6
+#define R_T2_SIG          7
+#define R_T3_LOW_HEALTH   8
+#define R_T3_NO_NETWORK   9
+#define R_T3_SIG          10
+#define R_T2_CRITICAL     11
+#define R_T2_FAILURE      12
+#define R_PASSED          13
+#define R_T3_DEGRADED     14
+#define R_T3_NET_LOST     15
+#define R_UNKNOWN_TIER    16
+
+static const char *const field_names[POLICY_F_COUNT] = {
+    "always", "emergency", "brownout", "tries_t2", "tries_t3", "boot_count", "health",
+    "wdt_ok", "ecc_ok", "storage_ok", "net_ok", "mem_ok", "sig_t2", "sig_t3",
+};
+
+static const char *const op_names[] = { "<", ">=", "==", "!=" };
+
+static const char *const decision_names[] = {
+    "continue", "promote", "stay", "demote", "emergency", "emergency",
+};
+
+const char *policy_decision_name(uint8_t decision)
+{
+    return decision <= POLICY_D_HOLD ? decision_names[decision] : "unknown";
+}
+
+uint8_t policy_decision_history(uint8_t decision)
+{
+    switch (decision) {
+    case POLICY_D_PROMOTE:   return HISTORY_REASON_PROMOTE;
+    case POLICY_D_DEMOTE:    return HISTORY_REASON_DEMOTE;
+    case POLICY_D_EMERGENCY: return HISTORY_REASON_EMERGENCY;
+    default:                 return HISTORY_REASON_STAY;
+    }
+}
+
+static const char *tier_name(uint8_t tier)
+{
+    static const char *const names[] = { "any", "T1", "T2", "T3" };
+    return tier <= TIER_3 ? names[tier] : "?";
+}
+
+static const char *source_name(uint8_t source)
+{
+    return source > 0 && source <= CONF_KEY_COUNT ? conf_keys[source - 1].name : "builtin";
+}
+
+static int set_key(struct PolicyConf *conf, const char *key, const char *value)
+{
+    for (int i = 0; i < CONF_KEY_COUNT; i++) {
+        if (strcmp(conf_keys[i].name, key) != 0)
+            continue;
+        char *end;
+        errno = 0;
+        unsigned long v = strtoul(value, &end, 10);
+        if (errno != 0 || end == value || *end != '\0')
+            return POLICY_ERR_PARSE;
+        void *slot = (char *)conf + conf_keys[i].offset;
+        switch (conf_keys[i].kind) {
+        case KEY_U8:
+            if (v > UINT8_MAX)
+                return POLICY_ERR_PARSE;
+            *(uint8_t *)slot = (uint8_t)v;
+            break;
+        case KEY_BOOL:
+            /* policy_engine.sh tests these with -eq 1 */
+            *(bool *)slot = v == 1;
+            break;
+        default:
+            if (v > UINT32_MAX)
+                return POLICY_ERR_PARSE;
+            *(uint32_t *)slot = (uint32_t)v;
+            break;
+        }
+        return POLICY_OK;
+    }
+    return 1;
+}
+
+void policy_conf_env(struct PolicyConf *conf)
+{
+    for (int i = 0; i < CONF_KEY_COUNT; i++) {
+        const char *v = getenv(conf_keys[i].name);
+        if (v && *v && set_key(conf, conf_keys[i].name, v) != POLICY_OK)
+            fprintf(stderr, "policy: ignoring invalid %s=%s\n", conf_keys[i].name, v);
+    }
+}
+
+static char *trim(char *s)
+{
+    while (isspace((unsigned char)*s))
+        s++;
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1]))
+        *--end = '\0';
+    return s;
+}
+
+/* Accepts the KEY=VALUE subset of shell that policy.conf is written in */
+static int parse_line(struct PolicyConf *conf, char *line)
+{
+    char *hash = strchr(line, '#');
+    if (hash)
+        *hash = '\0';
+    char *s = trim(line);
+    if (*s == '\0')
+        return POLICY_OK;
+    if (strncmp(s, "export ", 7) == 0)
+        s = trim(s + 7);
+    char *eq = strchr(s, '=');
+    if (!eq)
+        return POLICY_ERR_PARSE;
+    *eq = '\0';
+    char *key = trim(s);
+    char *value = trim(eq + 1);
+    size_t len = strlen(value);
+    if (len >= 2 && (value[0] == '"' || value[0] == '\'') && value[len - 1] == value[0]) {
+        value[len - 1] = '\0';
+        value++;
+    }
+    int ret = set_key(conf, key, value);
+    if (ret == 1 && strncmp(key, "POLICY_", 7) != 0)
+        return POLICY_OK;
+    return ret == 1 ? POLICY_ERR_PARSE : ret;
+}
+
+int policy_conf_load(struct PolicyConf *conf, const char *path)
+{
+    if (!path)
+        path = POLICY_CONF_PATH;
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        if (errno == ENOENT)
+            return 1;
+        fprintf(stderr, "policy: cannot open %s: %s\n", path, strerror(errno));
+        return POLICY_ERR_IO;
+    }
+    struct PolicyConf loaded = *conf;
+    char line[256];
+    int lineno = 0;
+    int ret = POLICY_OK;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        if (parse_line(&loaded, line) != POLICY_OK) {
+            fprintf(stderr, "policy: %s:%d: invalid entry\n", path, lineno);
+            ret = POLICY_ERR_PARSE;
+            break;
+        }
+    }
+    fclose(f);
+    if (ret == POLICY_OK)
+        *conf = loaded;
+    return ret;
+}
+
+#define COND(f, o, v) ((struct PolicyCond){ (f), (o), (v) })
+#define ALWAYS        COND(POLICY_F_ALWAYS, POLICY_OP_NE, 0)
+
+static void emit(struct PolicyProgram *prog, uint8_t tier, uint8_t decision, uint8_t to_tier,
+                 uint8_t reason, uint8_t source, struct PolicyCond a, struct PolicyCond b)
+{
+    if (prog->count >= POLICY_RULES_MAX) {
+        prog->count++;
+        return;
+    }
+    struct PolicyRule *r = &prog->rules[prog->count++];
+    memset(r, 0, sizeof(*r));
+    r->tier = tier;
+    r->decision = decision;
+    r->to_tier = to_tier;
+    r->reason = reason;
+    r->source = source;
+    r->cond[0] = a;
+    r->cond[1] = b;
+    /* exit status follows the return codes of policy_engine.sh */
+    if (decision == POLICY_D_EMERGENCY || decision == POLICY_D_HOLD)
+        r->exit_code = 2;
+    else if (decision == POLICY_D_PROMOTE || reason == R_PASSED)
+        r->exit_code = 0;
+    else
+        r->exit_code = 1;
+}
+
+/*
+ * Flattens policy_engine.sh into first-match rows. Disabled requirements and
+ * zero thresholds are folded away here so the evaluator never sees them.
+ */
+int policy_compile(const struct PolicyConf *conf, struct PolicyProgram *prog)
+{
+    memset(prog, 0, sizeof(*prog));
+    emit(prog, POLICY_TIER_ANY, POLICY_D_HOLD, 0, R_EMERGENCY, SRC_BUILTIN,
+         COND(POLICY_F_EMERGENCY, POLICY_OP_NE, 0), ALWAYS);
+
+    emit(prog, TIER_1, conf->emergency_on_exhausted ? POLICY_D_EMERGENCY : POLICY_D_STAY, TIER_1,
+         R_T2_EXHAUSTED, SRC_EXHAUSTED, COND(POLICY_F_TRIES_T2, POLICY_OP_EQ, 0), ALWAYS);
+    if (conf->brownout_wait_boots > 0)
+        emit(prog, TIER_1, POLICY_D_STAY, TIER_1, R_BROWNOUT_WAIT, SRC_BROWNOUT_WAIT,
+             COND(POLICY_F_BROWNOUT, POLICY_OP_NE, 0),
+             COND(POLICY_F_BOOT_COUNT, POLICY_OP_LT, conf->brownout_wait_boots));
+    emit(prog, TIER_1, POLICY_D_CONTINUE, 0, R_BROWNOUT_CLEAR, SRC_BROWNOUT_WAIT,
+         COND(POLICY_F_BROWNOUT, POLICY_OP_NE, 0), ALWAYS);
+    if (prog->count <= POLICY_RULES_MAX)
+        prog->rules[prog->count - 1].clear_flags = FLAG_BROWNOUT;
+    if (conf->t2_min_health > 0)
+        emit(prog, TIER_1, POLICY_D_DEMOTE, TIER_1, R_T2_LOW_HEALTH, SRC_T2_MIN_HEALTH,
+             COND(POLICY_F_HEALTH, POLICY_OP_LT, conf->t2_min_health), ALWAYS);
+    static const struct { uint8_t source; uint8_t field; size_t offset; } t2_requires[] = {
+        { SRC_T2_WDT,     POLICY_F_WDT,     offsetof(struct PolicyConf, t2_require_wdt) },
+        { SRC_T2_ECC,     POLICY_F_ECC,     offsetof(struct PolicyConf, t2_require_ecc) },
+        { SRC_T2_STORAGE, POLICY_F_STORAGE, offsetof(struct PolicyConf, t2_require_storage) },
+        { SRC_T2_MEMORY,  POLICY_F_MEMORY,  offsetof(struct PolicyConf, t2_require_memory) },
+        { SRC_T2_NETWORK, POLICY_F_NETWORK, offsetof(struct PolicyConf, t2_require_network) },
+    };
+    for (size_t i = 0; i < sizeof(t2_requires) / sizeof(t2_requires[0]); i++) {
+        if (*(const bool *)((const char *)conf + t2_requires[i].offset))
+            emit(prog, TIER_1, POLICY_D_DEMOTE, TIER_1, R_T2_COMPONENT, t2_requires[i].source,
+                 COND(t2_requires[i].field, POLICY_OP_EQ, 0), ALWAYS);
+    }
+    emit(prog, TIER_1, POLICY_D_DEMOTE, TIER_1, R_T2_SIG, SRC_BUILTIN,
+         COND(POLICY_F_SIG_T2, POLICY_OP_EQ, 0), ALWAYS);
+    emit(prog, TIER_1, POLICY_D_PROMOTE, TIER_2, R_NONE, SRC_BUILTIN, ALWAYS, ALWAYS);
+    if (prog->count <= POLICY_RULES_MAX)
+        prog->rules[prog->count - 1].clear_flags = FLAG_DIRTY;
+
+    /* Critical failures demote from Tier 2 even while Tier 3 attempts remain */
+    emit(prog, TIER_2, POLICY_D_DEMOTE, TIER_1, R_T2_CRITICAL, SRC_BUILTIN,
+         COND(POLICY_F_HEALTH, POLICY_OP_LT, 3), ALWAYS);
+    emit(prog, TIER_2, POLICY_D_DEMOTE, TIER_1, R_T2_FAILURE, SRC_BUILTIN,
+         COND(POLICY_F_STORAGE, POLICY_OP_EQ, 0), ALWAYS);
+    emit(prog, TIER_2, POLICY_D_DEMOTE, TIER_1, R_T2_FAILURE, SRC_BUILTIN,
+         COND(POLICY_F_MEMORY, POLICY_OP_EQ, 0), ALWAYS);
+    struct PolicyCond t3_left = COND(POLICY_F_TRIES_T3, POLICY_OP_NE, 0);
+    if (conf->t3_min_health > 0)
+        emit(prog, TIER_2, POLICY_D_STAY, TIER_2, R_T3_LOW_HEALTH, SRC_T3_MIN_HEALTH, t3_left,
+             COND(POLICY_F_HEALTH, POLICY_OP_LT, conf->t3_min_health));
+    if (conf->t3_require_network)
+        emit(prog, TIER_2, POLICY_D_STAY, TIER_2, R_T3_NO_NETWORK, SRC_T3_NETWORK, t3_left,
+             COND(POLICY_F_NETWORK, POLICY_OP_EQ, 0));
+    emit(prog, TIER_2, POLICY_D_STAY, TIER_2, R_T3_SIG, SRC_BUILTIN, t3_left,
+         COND(POLICY_F_SIG_T3, POLICY_OP_EQ, 0));
+    emit(prog, TIER_2, POLICY_D_PROMOTE, TIER_3, R_NONE, SRC_BUILTIN, t3_left, ALWAYS);
+    emit(prog, TIER_2, POLICY_D_STAY, TIER_2, R_PASSED, SRC_BUILTIN, ALWAYS, ALWAYS);
+
+    emit(prog, TIER_3, POLICY_D_DEMOTE, TIER_2, R_T3_DEGRADED, SRC_BUILTIN,
+         COND(POLICY_F_HEALTH, POLICY_OP_LT, 4), ALWAYS);
+    if (conf->t3_require_network)
+        emit(prog, TIER_3, POLICY_D_DEMOTE, TIER_2, R_T3_NET_LOST, SRC_T3_NETWORK,
+             COND(POLICY_F_NETWORK, POLICY_OP_EQ, 0), ALWAYS);
+    emit(prog, TIER_3, POLICY_D_STAY, TIER_3, R_PASSED, SRC_BUILTIN, ALWAYS, ALWAYS);
+
+    emit(prog, POLICY_TIER_ANY, POLICY_D_STAY, TIER_1, R_UNKNOWN_TIER, SRC_BUILTIN,
+         ALWAYS, ALWAYS);
+    if (prog->count > POLICY_RULES_MAX) {
+        fprintf(stderr, "policy: compiled policy exceeds %d rules\n", POLICY_RULES_MAX);
+        prog->count = 0;
+        return POLICY_ERR_FULL;
+    }
+    return prog->count;
+}
+
+struct EvalState {
+    const struct PolicyFacts *facts;
+    int8_t sig[TIER_3 + 1];
+};
+
+static uint64_t fact_value(struct EvalState *st, uint8_t field)
+{
+    const struct PolicyFacts *f = st->facts;
+    switch (field) {
+    case POLICY_F_EMERGENCY:  return journal_has_flag(&f->rec, FLAG_EMERGENCY);
+    case POLICY_F_BROWNOUT:   return journal_has_flag(&f->rec, FLAG_BROWNOUT);
+    case POLICY_F_TRIES_T2:   return f->rec.tries_t2;
+    case POLICY_F_TRIES_T3:   return f->rec.tries_t3;
+    case POLICY_F_BOOT_COUNT: return f->rec.boot_count;
+    case POLICY_F_HEALTH:     return f->health_score;
+    case POLICY_F_WDT:        return f->wdt_ok;
+    case POLICY_F_ECC:        return f->ecc_ok;
+    case POLICY_F_STORAGE:    return f->storage_ok;
+    case POLICY_F_NETWORK:    return f->net_ok;
+    case POLICY_F_MEMORY:     return f->mem_ok;
+    case POLICY_F_SIG_T2:
+    case POLICY_F_SIG_T3: {
+        uint8_t tier = field == POLICY_F_SIG_T2 ? TIER_2 : TIER_3;
+        if (st->sig[tier] < 0)
+            st->sig[tier] = f->verify_sig ? f->verify_sig(tier, f->sig_arg) : 1;
+        return (uint64_t)st->sig[tier];
+    }
+    default:
+        return 1;
+    }
+}
+
+static bool cond_holds(uint64_t value, const struct PolicyCond *c)
+{
+    switch (c->op) {
+    case POLICY_OP_LT: return value < c->value;
+    case POLICY_OP_GE: return value >= c->value;
+    case POLICY_OP_EQ: return value == c->value;
+    default:           return value != c->value;
+    }
+}
+
+static void add_op(struct PolicyVerdict *v, const char *fmt, ...)
+{
+    size_t off = strlen(v->ops);
+    if (off > 0 && off < sizeof(v->ops) - 1)
+        v->ops[off++] = ';';
+    if (off >= sizeof(v->ops) - 1)
+        return;
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(v->ops + off, sizeof(v->ops) - off, fmt, ap);
+    va_end(ap);
+}
+
+/* Journal operations in the syntax of journal_txn_apply, matching policy_engine.sh */
+static void build_ops(struct PolicyVerdict *v, uint8_t clear_flags)
+{
+    switch (v->decision) {
+    case POLICY_D_PROMOTE:
+        add_op(v, "tier=%u;reset-tries", v->to_tier);
+        break;
+    case POLICY_D_DEMOTE:
+        add_op(v, "tier=%u;set-flag=dirty", v->to_tier);
+        if (v->from_tier == TIER_2 || v->from_tier == TIER_3)
+            add_op(v, "dec-tries=%u", v->from_tier);
+        else if (v->from_tier == TIER_1)
+            add_op(v, "dec-tries=2");
+        break;
+    case POLICY_D_EMERGENCY:
+        add_op(v, "tier=1;set-flag=emergency;set-flag=quarantine");
+        break;
+    default:
+        if (v->to_tier >= TIER_1 && v->to_tier <= TIER_3)
+            add_op(v, "tier=%u", v->to_tier);
+        break;
+    }
+    if (clear_flags & FLAG_BROWNOUT)
+        add_op(v, "clear-flag=brownout");
+    if (clear_flags & FLAG_DIRTY)
+        add_op(v, "clear-flag=dirty");
+}
+
+static void explain_rule(FILE *out, int idx, const struct PolicyRule *r, const uint64_t *values,
+                         int evaluated, bool fired)
+{
+    fprintf(out, "rule %2d %-4s %-30s", idx, tier_name(r->tier),
+            source_name(r->source));
+    for (int i = 0; i < 2; i++) {
+        const struct PolicyCond *c = &r->cond[i];
+        if (c->field == POLICY_F_ALWAYS)
+            continue;
+        if (i < evaluated)
+            fprintf(out, " %s=%llu %s %u", field_names[c->field], (unsigned long long)values[i],
+                    op_names[c->op], c->value);
+        else
+            fprintf(out, " %s %s %u (not evaluated)", field_names[c->field], op_names[c->op],
+                    c->value);
+    }
+    if (r->cond[0].field == POLICY_F_ALWAYS && r->cond[1].field == POLICY_F_ALWAYS)
+        fprintf(out, " always");
+    fprintf(out, " -> %s\n", fired ? policy_decision_name(r->decision) : "no match");
+}
+
+int policy_run(const struct PolicyProgram *prog, const struct PolicyFacts *facts,
+               struct PolicyVerdict *verdict, FILE *explain)
+{
+    struct EvalState st = { .facts = facts, .sig = { -1, -1, -1, -1 } };
+    uint8_t tier = facts->rec.tier;
+    uint8_t clear_flags = 0;
+    memset(verdict, 0, sizeof(*verdict));
+    verdict->rule = -1;
+    verdict->from_tier = tier;
+    for (int i = 0; i < prog->count; i++) {
+        const struct PolicyRule *r = &prog->rules[i];
+        if (r->tier != POLICY_TIER_ANY && r->tier != tier)
+            continue;
+        uint64_t values[2] = { 0, 0 };
+        int evaluated = 0;
+        bool match = true;
+        for (int c = 0; c < 2 && match; c++) {
+            if (r->cond[c].field == POLICY_F_ALWAYS)
+                continue;
+            values[c] = fact_value(&st, r->cond[c].field);
+            evaluated = c + 1;
+            match = cond_holds(values[c], &r->cond[c]);
+        }
+        if (explain)
+            explain_rule(explain, i, r, values, evaluated, match);
+        if (!match)
+            continue;
+        clear_flags |= r->clear_flags;
+        if (r->decision == POLICY_D_CONTINUE)
+            continue;
+        const struct PolicyCond *last = &r->cond[r->cond[1].field != POLICY_F_ALWAYS ? 1 : 0];
+        snprintf(verdict->reason, sizeof(verdict->reason), reasons[r->reason],
+                 (unsigned long long)values[last == &r->cond[1] ? 1 : 0],
+                 (unsigned long long)last->value);
+        verdict->rule = i;
+        verdict->decision = r->decision;
+        verdict->to_tier = r->to_tier ? r->to_tier : tier;
+        verdict->exit_code = r->exit_code;
+        if (r->decision == POLICY_D_HOLD)
+            snprintf(verdict->action, sizeof(verdict->action), "manual_intervention");
+        else if (r->decision == POLICY_D_EMERGENCY)
+            snprintf(verdict->action, sizeof(verdict->action), "tier1_emergency");
+        else
+            snprintf(verdict->action, sizeof(verdict->action), "tier%u", verdict->to_tier);
+        build_ops(verdict, clear_flags);
+        return verdict->exit_code;
+    }
+    return POLICY_ERR_PARSE;
+}
+
+void policy_program_dump(const struct PolicyProgram *prog, FILE *out)
+{
+    for (int i = 0; i < prog->count; i++) {
+        const struct PolicyRule *r = &prog->rules[i];
+        fprintf(out, "%2d  %-3s ", i, tier_name(r->tier));
+        int n = 0;
+        for (int c = 0; c < 2; c++) {
+            const struct PolicyCond *cond = &r->cond[c];
+            if (cond->field == POLICY_F_ALWAYS)
+                continue;
+            fprintf(out, "%s%s %s %u", n++ ? " && " : "", field_names[cond->field],
+                    op_names[cond->op], cond->value);
+        }
+        if (n == 0)
+            fprintf(out, "always");
+        fprintf(out, " -> %s", policy_decision_name(r->decision));
+        if (r->decision != POLICY_D_CONTINUE && r->to_tier)
+            fprintf(out, " tier%u", r->to_tier);
+        if (r->decision == POLICY_D_CONTINUE)
+            fprintf(out, " (clears flags 0x%x, %s)\n", r->clear_flags, source_name(r->source));
+        else
+            fprintf(out, " (exit %u, %s)\n", r->exit_code, source_name(r->source));
+    }
+}
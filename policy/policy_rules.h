@@ -0,0 +1,134 @@
+#ifndef POLICY_RULES_H
+#define POLICY_RULES_H
+#include "boot_journal.h"
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define POLICY_CONF_PATH     "/etc/pac/policy.conf"
+#define POLICY_RULES_MAX     32
+
+/* Facts a rule condition can test */
+#define POLICY_F_ALWAYS      0
+#define POLICY_F_EMERGENCY   1
+#define POLICY_F_BROWNOUT    2
+#define POLICY_F_TRIES_T2    3
+#define POLICY_F_TRIES_T3    4
+#define POLICY_F_BOOT_COUNT  5
+#define POLICY_F_HEALTH      6
+#define POLICY_F_WDT         7
+#define POLICY_F_ECC         8
+#define POLICY_F_STORAGE     9
+#define POLICY_F_NETWORK     10
+#define POLICY_F_MEMORY      11
+#define POLICY_F_SIG_T2      12
+#define POLICY_F_SIG_T3      13
+#define POLICY_F_COUNT       14
+
+#define POLICY_OP_LT         0
+#define POLICY_OP_GE         1
+#define POLICY_OP_EQ         2
+#define POLICY_OP_NE         3
+
+/* Same names policy_engine.sh prints as DECISION= */
+#define POLICY_D_CONTINUE    0
+#define POLICY_D_PROMOTE     1
+#define POLICY_D_STAY        2
+#define POLICY_D_DEMOTE      3
+#define POLICY_D_EMERGENCY   4
+#define POLICY_D_HOLD        5
+
+#define POLICY_TIER_ANY      0
+
+#define POLICY_OK            0
+#define POLICY_ERR_IO       -1
+#define POLICY_ERR_PARSE    -2
+#define POLICY_ERR_FULL     -3
+
+/* The POLICY_* variables of policy.conf */
+struct PolicyConf {
+    uint8_t  t2_min_health;
+    bool     t2_require_wdt;
+    bool     t2_require_ecc;
+    bool     t2_require_storage;
+    bool     t2_require_memory;
+    bool     t2_require_network;
+    uint8_t  t3_min_health;
+    bool     t3_require_network;
+    bool     emergency_on_exhausted;
+    uint32_t brownout_wait_boots;
+};
+
+#define POLICY_CONF_DEFAULT { \
+    .t2_min_health = 4, \
+    .t2_require_wdt = false, \
+    .t2_require_ecc = true, \
+    .t2_require_storage = true, \
+    .t2_require_memory = true, \
+    .t2_require_network = false, \
+    .t3_min_health = 5, \
+    .t3_require_network = true, \
+    .emergency_on_exhausted = true, \
+    .brownout_wait_boots = 2 \
+}
+
+struct PolicyCond {
+    uint8_t  field;
+    uint8_t  op;
+    uint32_t value;
+};
+
+/* One row of the compiled table; the first row whose conditions all hold decides */
+struct PolicyRule {
+    uint8_t  tier;
+    uint8_t  decision;
+    uint8_t  to_tier;
+    uint8_t  exit_code;
+    uint8_t  reason;
+    uint8_t  source;
+    uint8_t  clear_flags;
+    struct PolicyCond cond[2];
+};
+
+struct PolicyProgram {
+    struct PolicyRule rules[POLICY_RULES_MAX];
+    int count;
+};
+
+/* Signature checks are the only facts that may cost a fork, so they are asked for lazily */
+typedef bool (*policy_sig_fn)(uint8_t tier, void *arg);
+
+struct PolicyFacts {
+    struct BootRecord rec;
+    uint8_t health_score;
+    bool    wdt_ok;
+    bool    ecc_ok;
+    bool    storage_ok;
+    bool    net_ok;
+    bool    mem_ok;
+    policy_sig_fn verify_sig;
+    void   *sig_arg;
+};
+
+struct PolicyVerdict {
+    int     rule;
+    uint8_t decision;
+    uint8_t from_tier;
+    uint8_t to_tier;
+    int     exit_code;
+    char    reason[128];
+    char    action[32];
+    char    ops[128];
+};
+
+void policy_conf_env(struct PolicyConf *conf);
+int policy_conf_load(struct PolicyConf *conf, const char *path);
+int policy_compile(const struct PolicyConf *conf, struct PolicyProgram *prog);
+int policy_run(const struct PolicyProgram *prog, const struct PolicyFacts *facts,
+               struct PolicyVerdict *verdict, FILE *explain);
+void policy_program_dump(const struct PolicyProgram *prog, FILE *out);
+const char *policy_decision_name(uint8_t decision);
+uint8_t policy_decision_history(uint8_t decision);
+
+#endif
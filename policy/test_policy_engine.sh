@@ -12,6 +12,7 @@ setup() {
     echo "Setting up test environment..."
     rm -rf "$TEST_DIR"
     mkdir -p "$TEST_DIR/tier2-root" "$TEST_DIR/tier3-root"
+    touch "$TEST_DIR/tier2-root/.verified" "$TEST_DIR/tier3-root/.verified"
     
     cat > "$TEST_DIR/health_healthy.json" <<EOF
 {
@@ -6,6 +6,7 @@ VERIFIER_URL="${VERIFIER_URL:-http://10.0.2.2:8080}"
 TPM_DEVICE="${TPM_DEVICE:-/tmp/swtpm.sock}"
 JOURNAL="${JOURNAL:-/var/pac/journal.dat}"
 HEALTH_JSON="${HEALTH_JSON:-/tmp/health.json}"
+HEALTH_TOOL="${HEALTH_TOOL:-/bin/health_check_tool}"
 OUTPUT_DIR="${OUTPUT_DIR:-/tmp/pac_attestation}"
 VERBOSE="${ATTEST_VERBOSE:-0}"
 TOKEN_FORMAT="${TOKEN_FORMAT:-json}"  
@@ -244,7 +245,7 @@ create_eat_token() {
         boot_count=$(journal_tool read "$JOURNAL" 2>/dev/null | grep "^  Boot Count:" | awk '{print $3}')
     fi
     
-    cat > "$eat_file" <<EOF
+    cat > "$eat_file.tmp.$$" <<EOF
 {
   "format": "pac-eat-v1",
   "timestamp": $(date +%s),
@@ -267,6 +268,7 @@ create_eat_token() {
   }
 }
 EOF
+    mv -f "$eat_file.tmp.$$" "$eat_file"
     
     if [ -f "$eat_file" ]; then
         log "EAT token created (JSON): $eat_file"
@@ -275,12 +277,22 @@ EOF
             local cbor_encoder="$(dirname "$0")/eat_cbor_encoder.py"
             local cbor_file="$OUTPUT_DIR/eat_token.cbor"
             
+            local health_cbor="$OUTPUT_DIR/health.cbor"
+            set --
+            rm -f "$health_cbor"
+            if [ -x "$HEALTH_TOOL" ]; then
+                "$HEALTH_TOOL" -q -s --format=cbor --compact -o "$health_cbor" || true
+                [ -s "$health_cbor" ] && set -- --health-cbor "$health_cbor"
+            fi
+            
             if [ -x "$cbor_encoder" ] || command -v python3 >/dev/null 2>&1; then
-                if python3 "$cbor_encoder" encode < "$eat_file" > "$cbor_file" 2>/dev/null; then
+                if python3 "$cbor_encoder" encode "$@" < "$eat_file" > "$cbor_file.tmp.$$" 2>/dev/null &&
+                   mv -f "$cbor_file.tmp.$$" "$cbor_file"; then
                     local json_size=$(stat -c%s "$eat_file" 2>/dev/null || echo 0)
                     local cbor_size=$(stat -c%s "$cbor_file" 2>/dev/null || echo 0)
                     log "EAT token converted to CBOR: $cbor_file ($json_size -> $cbor_size bytes)"
                 else
+                    rm -f "$cbor_file.tmp.$$"
                     warn "CBOR encoding failed, falling back to JSON"
                 fi
             else
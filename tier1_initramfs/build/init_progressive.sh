@@ -96,9 +96,9 @@ HEALTH_SCORE=0
 HEALTH_STATUS="unknown"
 
 if [ -f "$HEALTH_LOG" ]; then
-    HEALTH_SCORE=$(cat "$HEALTH_LOG" | grep -o '"overall_score":[0-9]*' | cut -d':' -f2 | head -1)
+    HEALTH_SCORE=$(grep -o '"overall_score": *[0-9]*' "$HEALTH_LOG" | grep -o '[0-9]*$' | head -1)
     HEALTH_SCORE=${HEALTH_SCORE:-0}
-    HEALTH_STATUS=$(cat "$HEALTH_LOG" | grep -o '"overall_status":"[^"]*"' | cut -d'"' -f4 | head -1)
+    HEALTH_STATUS=$(grep -o '"overall_status": *"[^"]*"' "$HEALTH_LOG" | cut -d'"' -f4 | head -1)
     HEALTH_STATUS=${HEALTH_STATUS:-unknown}
     
     echo ""
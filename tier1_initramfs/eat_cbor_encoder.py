@@ -6,7 +6,14 @@ import cbor2
 from datetime import datetime, timezone
 import base64
 
-def json_to_eat_cbor(json_data):
+# -70002 keys written by health_check_tool --format=cbor (health_check.h)
+HEALTH_CLAIM_FIELDS = {
+    1: 'wdt_ok', 2: 'ecc_ok', 3: 'storage_ok', 4: 'network_ok', 5: 'mem_ok', 6: 'temp_ok',
+    7: 'overall_score', 8: 'max_score', 9: 'overall_status', 10: 'timestamp', 11: 'max_tier',
+    12: 'values', 13: 'messages',
+}
+
+def json_to_eat_cbor(json_data, health_cbor=None):
     
     
     if isinstance(json_data, str):
@@ -47,7 +54,9 @@ def json_to_eat_cbor(json_data):
         
         eat_claims[-70001] = measurements
     
-    if 'health' in token:
+    if health_cbor is not None:
+        eat_claims[-70002] = cbor2.loads(health_cbor)
+    elif 'health' in token:
         health = token['health']
         health_cbor = {}
         
@@ -96,14 +105,18 @@ def eat_cbor_to_json(cbor_bytes):
             'storage_ok': health_cbor.get(3, True),
             'network_ok': health_cbor.get(4, False)
         }
+        for key, name in HEALTH_CLAIM_FIELDS.items():
+            if key > 4 and key in health_cbor:
+                token['health'][name] = health_cbor[key]
     
     return token
 
 def main():
     
     if len(sys.argv) < 2:
-        print("Usage: eat_cbor_encoder.py {encode|decode}", file=sys.stderr)
-        print("  encode: Convert JSON to CBOR", file=sys.stderr)
+        print("Usage: eat_cbor_encoder.py {encode [--health-cbor FILE]|decode}", file=sys.stderr)
+        print("  encode: Convert JSON to CBOR, optionally embedding a", file=sys.stderr)
+        print("          health_check_tool --format=cbor report as claim -70002", file=sys.stderr)
         print("  decode: Convert CBOR to JSON", file=sys.stderr)
         sys.exit(1)
     
@@ -111,7 +124,11 @@ def main():
     
     if mode == 'encode':
         json_data = sys.stdin.read()
-        cbor_bytes = json_to_eat_cbor(json_data)
+        health_cbor = None
+        if len(sys.argv) == 4 and sys.argv[2] == '--health-cbor':
+            with open(sys.argv[3], 'rb') as f:
+                health_cbor = f.read()
+        cbor_bytes = json_to_eat_cbor(json_data, health_cbor)
         sys.stdout.buffer.write(cbor_bytes)
     
     elif mode == 'decode':
@@ -3,6 +3,14 @@
 set -e
 
 OUTPUT_FILE="${HEALTH_OUTPUT:-/tmp/health.json}"
+
+HEALTH_TOOL="${HEALTH_TOOL:-/bin/health_check_tool}"
+if [ -x "$HEALTH_TOOL" ]; then
+    rc=0
+    "$HEALTH_TOOL" -s -o "$OUTPUT_FILE" || rc=$?
+    [ $rc -ne 255 ] && exit $rc
+    echo "[HEALTH] health_check_tool failed - falling back to shell checks" >&2
+fi
 VERBOSE="${HEALTH_VERBOSE:-0}"
 TIMESTAMP=$(date +%s)
 
@@ -278,7 +286,8 @@ fi
 
 log "Health score: $OVERALL_SCORE/$MAX_SCORE ($OVERALL_STATUS)"
 
-cat > "$OUTPUT_FILE" <<EOF
+OUTPUT_TMP="$OUTPUT_FILE.tmp.$$"
+cat > "$OUTPUT_TMP" <<EOF
 {
   "timestamp": $TIMESTAMP,
   "overall_score": $OVERALL_SCORE,
@@ -320,6 +329,7 @@ cat > "$OUTPUT_FILE" <<EOF
   }
 }
 EOF
+mv -f "$OUTPUT_TMP" "$OUTPUT_FILE"
 
 if [ "$VERBOSE" -eq 1 ]; then
     log "Health report written to $OUTPUT_FILE"
@@ -11,6 +11,8 @@ VERBOSE="${VERBOSE:-1}"
 KEY_SIZE=2048
 HASH_ALG="sha256"
 
+PAC_ATTESTD="${PAC_ATTESTD:-/bin/pac_attestd}"
+
 EAT_FORMAT="${EAT_FORMAT:-json}"
 CBOR_ENCODER="/usr/lib/pac/eat_cbor_encoder.py"
 
@@ -173,7 +175,7 @@ extract_boot_count() {
 
 get_health_score() {
     if [ -f "$HEALTH_JSON" ]; then
-        grep -o '"overall_score":[0-9]*' "$HEALTH_JSON" | cut -d':' -f2 || echo "8"
+        grep -o '"overall_score": *[0-9]*' "$HEALTH_JSON" | grep -o '[0-9]*$' || echo "8"
     else
         echo "8"
     fi
@@ -204,9 +206,10 @@ create_eat_token() {
     local boot_count=$(extract_boot_count)
     local device_id="pac-$(hostname)-$(cat /proc/sys/kernel/random/boot_id 2>/dev/null | cut -c1-8 || echo 'secure')"
     
-    cat > "$eat_file" <<EATEOF
+    cat > "$eat_file.tmp.$$" <<EATEOF
 {"format":"pac-eat-v2-signed","timestamp":$(date +%s),"nonce":"$nonce","device_id":"$device_id","boot_state":{"tier":$tier,"boot_count":$boot_count},"tpm_attestation":{"version":"2.0","quote_data":"$quote_data_b64","signature":"$quote_sig_b64","signature_algorithm":"RSA-${KEY_SIZE}-SHA256","public_key":"$pub_key_b64","pcr_digest":"$pcr_digest","pcrs":{"0":"$pcr0","1":"$pcr1","2":"$pcr2","7":"$pcr7"}},"health_status":$health_json,"metadata":{"pac_version":"2.0","agent":"attest_agent_crypto.sh","crypto":"real"}}
 EATEOF
+    mv -f "$eat_file.tmp.$$" "$eat_file"
     
     if [ -f "$eat_file" ]; then
         log " EAT token created with real cryptographic signatures (JSON format)"
@@ -298,6 +301,11 @@ send_to_verifier() {
 }
 
 main() {
+    # Native agent builds and signs the JSON token in-process
+    if [ -x "$PAC_ATTESTD" ] && [ "$EAT_FORMAT" = "json" ]; then
+        exec "$PAC_ATTESTD" -o "$OUTPUT_DIR" -j "$JOURNAL" --health "$HEALTH_JSON" --verifier "$VERIFIER_URL"
+    fi
+    
     log ""
     log "PAC Cryptographic Attestation Agent"
     log "Real RSA signatures with OpenSSL"
@@ -2,6 +2,13 @@
 
 OUTPUT_FILE="${HEALTH_OUTPUT:-/tmp/health.json}"
 
+HEALTH_TOOL="${HEALTH_TOOL:-/bin/health_check_tool}"
+if [ -x "$HEALTH_TOOL" ]; then
+    "$HEALTH_TOOL" -s -o "$OUTPUT_FILE"; rc=$?
+    [ $rc -ne 255 ] && exit $rc
+    echo "[HEALTH] health_check_tool failed - falling back to shell checks" >&2
+fi
+
 MEM_OK=0
 STORAGE_OK=0
 OVERALL_SCORE=0
@@ -121,9 +128,11 @@ echo "  Score:  $OVERALL_SCORE/10"
 echo ""
 
 TIMESTAMP=$(date +%s 2>/dev/null || echo "0")
-cat > "$OUTPUT_FILE" <<JSONEOF
+OUTPUT_TMP="$OUTPUT_FILE.tmp.$$"
+cat > "$OUTPUT_TMP" <<JSONEOF
 {"timestamp":${TIMESTAMP},"overall_status":"$OVERALL_STATUS","overall_score":$OVERALL_SCORE,"checks":{"memory":$([ "$MEM_OK" -eq 1 ] && echo "true" || echo "false"),"storage":$([ "$STORAGE_OK" -eq 1 ] && echo "true" || echo "false"),"utilities":$([ "$UTILS_OK" -eq 1 ] && echo "true" || echo "false"),"kernel":$([ "$KERNEL_OK" -eq 1 ] && echo "true" || echo "false"),"watchdog":$([ "$WATCHDOG_OK" -eq 1 ] && echo "true" || echo "false"),"ecc":$([ "$ECC_OK" -eq 1 ] && echo "true" || echo "false"),"temperature":$([ "$TEMP_OK" -eq 1 ] && echo "true" || echo "false")},"scores":{"memory":$((MEM_OK * 3)),"storage":$((STORAGE_OK * 2)),"utilities":$((UTILS_OK * 2)),"kernel":$((KERNEL_OK * 3)),"watchdog":$((WATCHDOG_OK * 2)),"ecc":$((ECC_OK * 2)),"temperature":$((TEMP_OK * 2))},"hardware_simulation":{"watchdog_fault_file":"/tmp/inject_watchdog_fault","ecc_errors":${ECC_ERRORS},"temperature_celsius":${TEMPERATURE},"storage_fault_file":"/tmp/inject_storage_fault"}}
 JSONEOF
+mv -f "$OUTPUT_TMP" "$OUTPUT_FILE"
 
 echo "Health data written to: $OUTPUT_FILE"
 echo ""
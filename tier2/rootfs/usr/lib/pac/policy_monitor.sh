@@ -4,12 +4,21 @@ set +e
 
 JOURNAL="/var/pac/journal.dat"
 JOURNAL_TOOL="/bin/journal_tool"
+JOURNALD="${JOURNALD:-/bin/pac-journald}"
+JOURNALD_SOCKET="${JOURNALD_SOCKET:-/tmp/pac-journald.sock}"
+JOURNALD_PIDFILE="/var/pac/pac-journald.pid"
 HEALTH_SCRIPT="/usr/lib/pac/health_check.sh"
+HEALTH_TOOL="${HEALTH_TOOL:-/bin/health_check_tool}"
+HEALTH_SHM="${HEALTH_SHM:-/tmp/pac-health.shm}"
+POLICYD="${POLICYD:-/bin/pac_policyd}"
+POLICYD_STATE="/var/pac/policyd.state"
 ATTEST_SCRIPT="/usr/lib/pac/attest_agent.sh"
 POLICY_ENGINE="/usr/lib/pac/policy_engine.sh"
 MONITOR_INTERVAL="${MONITOR_INTERVAL:-10}"  
 VERIFIER_URL="${VERIFIER_URL:-http://10.0.2.2:8080}"
 NETWORK_TEST_HOST="${NETWORK_TEST_HOST:-10.0.2.2}"
+VERIFIER_STATE="${VERIFIER_STATE:-/tmp/pac_attestation/verifier.state}"
+VERIFIER_STATE_MAX_AGE="${VERIFIER_STATE_MAX_AGE:-120}"
 
 PIDFILE="/var/pac/pac_policy_monitor.pid"
 
@@ -19,8 +28,10 @@ HEALTH_FAIL_COUNT_FILE="/var/pac/health_fail_count"
 MIN_TIER3_TIME="${MIN_TIER3_TIME:-10}"  
 VERIFIER_FAIL_THRESHOLD="${VERIFIER_FAIL_THRESHOLD:-2}"  
 HEALTH_FAIL_THRESHOLD="${HEALTH_FAIL_THRESHOLD:-2}"      
-MIN_HEALTH_SCORE_T2="${MIN_HEALTH_SCORE_T2:-6}"        
-MIN_HEALTH_SCORE_T3="${MIN_HEALTH_SCORE_T3:-9}"        
+# Tier thresholds come from the same scoring table health_check_tool uses
+[ -x "$HEALTH_TOOL" ] && eval "$("$HEALTH_TOOL" --thresholds 2>/dev/null)"
+MIN_HEALTH_SCORE_T2="${MIN_HEALTH_SCORE_T2:-${HEALTH_MIN_T2:-6}}"
+MIN_HEALTH_SCORE_T3="${MIN_HEALTH_SCORE_T3:-${HEALTH_MIN_T3:-9}}"
 ATTEST_SANITY_LOG="/var/pac/attest_sanity.log"
 HEALTH_OUTPUT_FILE="/var/pac/policy_monitor_health.json"
 LOG_FILE="/var/pac/policy_monitor.log"
@@ -57,6 +68,15 @@ error() {
     fi
 }
 
+write_state() {
+    _ws_tmp="$1.tmp.$$"
+    if echo "$2" > "$_ws_tmp" 2>/dev/null && mv -f "$_ws_tmp" "$1" 2>/dev/null; then
+        return 0
+    fi
+    rm -f "$_ws_tmp" 2>/dev/null
+    return 1
+}
+
 now_seconds() {
     if [ -r /proc/uptime ]; then
         awk '{print int($1)}' /proc/uptime 2>/dev/null && return 0
@@ -64,27 +84,58 @@ now_seconds() {
     date +%s 2>/dev/null || echo "0"
 }
 
+capture_health_snapshot() {
+    [ -f "$HEALTH_SHM" ] && [ -x "$HEALTH_TOOL" ] || return 1
+    _chs_vars=$("$HEALTH_TOOL" --snapshot --shm "$HEALTH_SHM" 2>/dev/null)
+    case $? in
+        0|1|2) ;;
+        *) return 1 ;;
+    esac
+    eval "$_chs_vars"
+    if [ "${HEALTH_MAX_SCORE:-0}" -le 0 ] || \
+       [ "${HEALTH_AGE_MS:-0}" -gt $((${HEALTH_INTERVAL_MS:-0} * 3)) ]; then
+        log "Health snapshot stale (age ${HEALTH_AGE_MS}ms) - falling back to health script"
+        return 1
+    fi
+    LAST_HEALTH_SCORE=$((HEALTH_SCORE * 10 / HEALTH_MAX_SCORE))
+    log "Health score from daemon snapshot: $LAST_HEALTH_SCORE (age ${HEALTH_AGE_MS}ms)"
+    # Rate alarms fire before the hard thresholds do; treat them as low health
+    if [ "${TREND_ALARMS:-0}" -ne 0 ] && [ "$LAST_HEALTH_SCORE" -ge "$MIN_HEALTH_SCORE_T2" ]; then
+        LAST_HEALTH_SCORE=$((MIN_HEALTH_SCORE_T2 - 1))
+        log "Health trend alarm: $TREND_ALARM_NAMES (ECC ${ECC_RATE_PER_MIN}/min, temp ${TEMP_RATE_PER_MIN}C/min) - score capped at $LAST_HEALTH_SCORE"
+    fi
+    return 0
+}
+
 capture_health_score() {
     LAST_HEALTH_SCORE=""
+    if capture_health_snapshot; then
+        return 0
+    fi
     if [ ! -f "$HEALTH_SCRIPT" ]; then
         log "Health script missing - skipping health evaluation"
         return 1
     fi
 
     mkdir -p "$(dirname "$HEALTH_OUTPUT_FILE")" 2>/dev/null || true
-    rm -f "$HEALTH_OUTPUT_FILE" 2>/dev/null || true
 
-    HEALTH_OUTPUT="$HEALTH_OUTPUT_FILE" sh "$HEALTH_SCRIPT" >/dev/null 2>&1 || {
-        log "Health script execution failed"
-        return 1
-    }
+    # 1 and 2 are degraded/critical verdicts with a valid report, not failures
+    HEALTH_OUTPUT="$HEALTH_OUTPUT_FILE" sh "$HEALTH_SCRIPT" >/dev/null 2>&1
+    _chsc_rc=$?
+    case $_chsc_rc in
+        0|1|2) ;;
+        *)
+            log "Health script execution failed (exit $_chsc_rc)"
+            return 1
+            ;;
+    esac
 
     if [ ! -s "$HEALTH_OUTPUT_FILE" ]; then
         log "Health output file empty - skipping health evaluation"
         return 1
     fi
 
-    score=$(sed -n 's/.*"overall_score":\([0-9]*\).*/\1/p' "$HEALTH_OUTPUT_FILE" 2>/dev/null)
+    score=$(sed -n 's/.*"overall_score": *\([0-9]*\).*/\1/p' "$HEALTH_OUTPUT_FILE" 2>/dev/null)
     if [ -z "$score" ]; then
         log "Health score missing in output (file exists but score not parsed)"
         log "Health file content: $(cat "$HEALTH_OUTPUT_FILE" 2>/dev/null | head -c 200)"
@@ -107,44 +158,68 @@ hex_to_dec() {
     fi
 }
 
-get_journal_field() {
-    _gjf_key="$1"
-    "$JOURNAL_TOOL" read "$JOURNAL" 2>/dev/null | awk -v k="$_gjf_key" -F':' '
-        $1 ~ k {
-            gsub(/^[ \t]+|[ \t]+$/, "", $2)
-            print $2
-            exit
-        }'
+# Loads every journal field the monitor uses with one batched pac-journald
+# 'get' (or one journal_tool read when the daemon is not running). The loop
+# calls it once per cycle and after each journal write; getters that run
+# before a load fetch the fields themselves.
+load_journal_fields() {
+    _ljf_out=""
+    if [ -S "$JOURNALD_SOCKET" ] && [ -x "$JOURNALD" ]; then
+        _ljf_out=$("$JOURNALD" -s "$JOURNALD_SOCKET" \
+            -q "get tier tries_t2 tries_t3 rollback_idx flags" 2>/dev/null) || _ljf_out=""
+    fi
+    if [ -z "$_ljf_out" ]; then
+        _ljf_out=$("$JOURNAL_TOOL" read "$JOURNAL" 2>/dev/null | awk -F':' '
+            {
+                k = $1; gsub(/^[ \t]+|[ \t]+$/, "", k)
+                split($2, v, " ")
+                if (k == "Tier") print "tier=" v[1]
+                else if (k == "Tries T2") print "tries_t2=" v[1]
+                else if (k == "Tries T3") print "tries_t3=" v[1]
+                else if (k == "Rollback IDX") print "rollback_idx=" v[1]
+                else if (k == "Flags") print "flags=" v[1]
+            }')
+    fi
+    JF_TIER=""; JF_TRIES_T2=""; JF_TRIES_T3=""; JF_ROLLBACK_IDX=""; JF_FLAGS=""
+    for _ljf_line in $_ljf_out; do
+        case "$_ljf_line" in
+            tier=*)         JF_TIER="${_ljf_line#*=}" ;;
+            tries_t2=*)     JF_TRIES_T2="${_ljf_line#*=}" ;;
+            tries_t3=*)     JF_TRIES_T3="${_ljf_line#*=}" ;;
+            rollback_idx=*) JF_ROLLBACK_IDX="${_ljf_line#*=}" ;;
+            flags=*)        JF_FLAGS="${_ljf_line#*=}" ;;
+        esac
+    done
+    JF_LOADED=1
 }
 
 get_journal_tier() {
-    _gjt_tier=$(get_journal_field "Tier")
-    _gjt_tier=${_gjt_tier:-1}
-    echo "$_gjt_tier"
+    [ -n "$JF_LOADED" ] || load_journal_fields
+    echo "${JF_TIER:-1}"
 }
 
 get_journal_tries_t2() {
-    _gjtt2_tries=$(get_journal_field "Tries T2")
-    _gjtt2_tries=${_gjtt2_tries:-0}
-    echo "$_gjtt2_tries"
+    [ -n "$JF_LOADED" ] || load_journal_fields
+    echo "${JF_TRIES_T2:-0}"
 }
 
 get_journal_tries_t3() {
-    _gjtt3_tries=$(get_journal_field "Tries T3")
-    _gjtt3_tries=${_gjtt3_tries:-0}
-    echo "$_gjtt3_tries"
+    [ -n "$JF_LOADED" ] || load_journal_fields
+    echo "${JF_TRIES_T3:-0}"
 }
 
 get_journal_rollback_idx() {
-    _gjri_idx=$(get_journal_field "Rollback IDX")
-    _gjri_idx=${_gjri_idx:-0}
-    echo "$_gjri_idx"
+    [ -n "$JF_LOADED" ] || load_journal_fields
+    echo "${JF_ROLLBACK_IDX:-0}"
 }
 
 get_journal_flags() {
-    _gjf_flags=$(get_journal_field "Flags")
-    _gjf_flags=${_gjf_flags:-0x0}
-    echo "$_gjf_flags"
+    [ -n "$JF_LOADED" ] || load_journal_fields
+    case "$JF_FLAGS" in
+        0x*|0X*) echo "$JF_FLAGS" ;;
+        "") echo "0x0" ;;
+        *) printf "0x%x\n" "$JF_FLAGS" ;;
+    esac
 }
 
 journal_flag_set() {
@@ -289,6 +364,7 @@ decrement_attempt_counter() {
             log "Tier 3 promotion attempts decremented"
             ;;
     esac
+    load_journal_fields
 }
 
 can_promote_t1_to_t2() {
@@ -308,9 +384,20 @@ can_promote_t2_to_t3() {
     return 0
 }
 
+# pac_attestd records how its last exchange with the verifier went; while
+# that is recent it is trusted instead of probing, and the fallback probe
+# asks /health so it no longer spends a nonce
 check_verifier_reachable() {
+    if [ -f "$VERIFIER_STATE" ]; then
+        _cvr_now=$(date +%s)
+        _cvr_mtime=$(stat -c %Y "$VERIFIER_STATE" 2>/dev/null || echo 0)
+        if [ $((_cvr_now - _cvr_mtime)) -le "$VERIFIER_STATE_MAX_AGE" ]; then
+            grep -q "^reachable=1" "$VERIFIER_STATE"
+            return
+        fi
+    fi
     ping -c 1 -W 2 10.0.2.2 >/dev/null 2>&1 && \
-    wget -q -O- -T 2 "$VERIFIER_URL/nonce" >/dev/null 2>&1
+    wget -q -O- -T 2 "$VERIFIER_URL/health" >/dev/null 2>&1
 }
 
 run_attestation_sanity_check() {
@@ -410,7 +497,7 @@ check_tier3_degradation() {
         time_in_tier3=$((current_time - tier3_start))
         if [ "$time_in_tier3" -lt 0 ]; then
             log "Tier 3 clock skew detected (${time_in_tier3}s) - resetting grace timer"
-            echo "$current_time" > "$TIER3_START_TIME_FILE" 2>/dev/null || true
+            write_state "$TIER3_START_TIME_FILE" "$current_time" || true
             time_in_tier3=0
         fi
         if [ "$time_in_tier3" -lt "$MIN_TIER3_TIME" ]; then
@@ -418,7 +505,7 @@ check_tier3_degradation() {
             return 1  
         fi
     else
-        echo "$current_time" > "$TIER3_START_TIME_FILE" 2>/dev/null || true
+        write_state "$TIER3_START_TIME_FILE" "$current_time" || true
         log "Tier 3 grace period started (${MIN_TIER3_TIME}s)"
         return 1  
     fi
@@ -493,7 +580,7 @@ check_tier3_degradation() {
         
         fail_count=$(cat "$VERIFIER_FAIL_COUNT_FILE" 2>/dev/null || echo "0")
         fail_count=$((fail_count + 1))
-        echo "$fail_count" > "$VERIFIER_FAIL_COUNT_FILE" 2>/dev/null || true
+        write_state "$VERIFIER_FAIL_COUNT_FILE" "$fail_count" || true
         log "Verifier failure count: $fail_count/$VERIFIER_FAIL_THRESHOLD"
 
         if [ "$fail_count" -ge "$VERIFIER_FAIL_THRESHOLD" ]; then
@@ -594,7 +681,7 @@ check_tier2_degradation() {
         if [ "$HEALTH_SCORE" -lt "$MIN_HEALTH_SCORE_T2" ]; then
             low_health=$(cat "$HEALTH_FAIL_COUNT_FILE" 2>/dev/null || echo "0")
             low_health=$((low_health + 1))
-            echo "$low_health" > "$HEALTH_FAIL_COUNT_FILE" 2>/dev/null || true
+            write_state "$HEALTH_FAIL_COUNT_FILE" "$low_health" || true
             log "Health degraded ($HEALTH_SCORE < $MIN_HEALTH_SCORE_T2) - consecutive low health: ${low_health}/${HEALTH_FAIL_THRESHOLD}"
 
             if [ "$low_health" -ge "$HEALTH_FAIL_THRESHOLD" ]; then
@@ -668,6 +755,7 @@ monitor_loop() {
     log "Monitoring for tier promotion/degradation conditions..."
     
     while true; do
+        load_journal_fields
         if journal_flag_set "EMERGENCY"; then
             log " EMERGENCY FLAG DETECTED - entering recovery mode (S_13)"
             log "System will remain in recovery mode until flag is cleared manually"
@@ -699,7 +787,7 @@ monitor_loop() {
                 log "Checking Tier 3 degradation conditions..."
                 
                 if [ ! -f "$TIER3_START_TIME_FILE" ]; then
-                    echo "$(now_seconds)" > "$TIER3_START_TIME_FILE" 2>/dev/null || true
+                    write_state "$TIER3_START_TIME_FILE" "$(now_seconds)" || true
                 fi
                 
                 if check_tier3_degradation; then
@@ -733,6 +821,19 @@ monitor_loop() {
     done
 }
 
+# pac-journald keeps the journal open so field reads are one socket round-trip
+start_journald() {
+    [ -x "$JOURNALD" ] || return 0
+    if [ -S "$JOURNALD_SOCKET" ] &&
+       "$JOURNALD" -s "$JOURNALD_SOCKET" -q "get tier" >/dev/null 2>&1; then
+        return 0
+    fi
+    "$JOURNALD" -s "$JOURNALD_SOCKET" "$JOURNAL" >/dev/null 2>&1 &
+    _sj_pid=$!
+    write_state "$JOURNALD_PIDFILE" "$_sj_pid" || true
+    log "Journal daemon started (PID: $_sj_pid)"
+}
+
 start_daemon() {
     mkdir -p "$(dirname "$PIDFILE")" 2>/dev/null || true
     
@@ -745,10 +846,16 @@ start_daemon() {
         rm -f "$PIDFILE"
     fi
     
+    start_journald
     log "Starting policy monitor daemon..."
-    monitor_loop &
+    # The native daemon reacts to journal, health and verifier events instead of polling
+    if [ -x "$POLICYD" ]; then
+        "$POLICYD" -j "$JOURNAL" &
+    else
+        monitor_loop &
+    fi
     pid=$!
-    echo "$pid" > "$PIDFILE" 2>/dev/null || true
+    write_state "$PIDFILE" "$pid" || true
     log "Policy monitor daemon started (PID: $pid)"
     return 0
 }
@@ -784,6 +891,7 @@ case "${1:-start}" in
                 echo "Policy monitor running (PID: $pid)"
                 CURRENT_TIER=$(get_current_tier)
                 echo "Current tier: $CURRENT_TIER"
+                [ -f "$POLICYD_STATE" ] && cat "$POLICYD_STATE"
                 check_verifier_reachable && echo "Verifier: reachable" || echo "Verifier: unreachable"
                 exit 0
             fi
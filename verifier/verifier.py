@@ -7,11 +7,12 @@ import base64
 import hashlib
 import secrets
 from flask import Flask, request, jsonify
+from werkzeug.serving import WSGIRequestHandler
 from datetime import datetime, timedelta
 
 try:
     from cryptography.hazmat.primitives import hashes, serialization
-    from cryptography.hazmat.primitives.asymmetric import padding
+    from cryptography.hazmat.primitives.asymmetric import padding, rsa, ec, ed25519
     from cryptography.hazmat.backends import default_backend
     CRYPTO_AVAILABLE = True
 except ImportError:
@@ -22,6 +23,13 @@ app = Flask(__name__)
 
 NONCE_TIMEOUT = int(os.environ.get('NONCE_TIMEOUT', '60'))  
 NONCE_LENGTH = int(os.environ.get('NONCE_LENGTH', '32'))  
+# Same 0-10 scale and 'attest' threshold as health_check/health_score.conf
+MIN_HEALTH_SCORE = int(os.environ.get('MIN_HEALTH_SCORE', '5'))
+# Image path -> accepted SHA-256 digests for PCR-8 events, written by build_pac_system.sh
+REFERENCE_MEASUREMENTS = os.environ.get(
+    'REFERENCE_MEASUREMENTS',
+    os.path.join(os.path.dirname(os.path.abspath(__file__)), 'reference_measurements.json'))
+IMAGE_PCR = '8'
 
 nonces = {}  
 attestation_history = []  
@@ -44,7 +52,7 @@ def log_attestation(result):
     if len(attestation_history) > 100:
         attestation_history.pop(0)
 
-def verify_rsa_signature(quote_data_b64, signature_b64, public_key_b64):
+def verify_quote_signature(quote_data_b64, signature_b64, public_key_b64):
     
     if not CRYPTO_AVAILABLE:
         return False, "Cryptography library not available"
@@ -59,18 +67,70 @@ def verify_rsa_signature(quote_data_b64, signature_b64, public_key_b64):
             backend=default_backend()
         )
         
-        public_key.verify(
-            signature,
-            quote_data,
-            padding.PKCS1v15(),
-            hashes.SHA256()
-        )
+        # The AIK type decides the scheme, never the token's signature_algorithm label
+        if isinstance(public_key, rsa.RSAPublicKey):
+            public_key.verify(signature, quote_data, padding.PKCS1v15(), hashes.SHA256())
+            scheme = f"RSA-{public_key.key_size}-SHA256"
+        elif isinstance(public_key, ec.EllipticCurvePublicKey):
+            if not isinstance(public_key.curve, ec.SECP256R1):
+                return False, f"Unsupported EC curve: {public_key.curve.name}"
+            public_key.verify(signature, quote_data, ec.ECDSA(hashes.SHA256()))
+            scheme = "ECDSA-P256-SHA256"
+        elif isinstance(public_key, ed25519.Ed25519PublicKey):
+            public_key.verify(signature, quote_data)
+            scheme = "Ed25519"
+        else:
+            return False, f"Unsupported AIK type: {type(public_key).__name__}"
         
-        return True, "Signature verification successful"
+        return True, f"Signature verification successful ({scheme})"
         
     except Exception as e:
         return False, f"Signature verification failed: {str(e)}"
 
+def load_reference_measurements():
+    
+    try:
+        with open(REFERENCE_MEASUREMENTS) as f:
+            refs = json.load(f)
+        return {name: {d.lower() for d in digests} for name, digests in refs.items()}
+    except (OSError, ValueError, AttributeError, TypeError):
+        return None
+
+def verify_event_log(event_log, pcrs, quote_data_b64):
+    
+    # Replay the TCG-style log from zeroed PCRs and tie the result to the signed quote
+    try:
+        if not event_log:
+            return False, "Event log is empty"
+        refs = load_reference_measurements()
+        if refs is None:
+            return False, f"No reference measurements ({REFERENCE_MEASUREMENTS})"
+        replayed = {}
+        for event in event_log:
+            index = str(int(event['pcr']))
+            if index == IMAGE_PCR and event['digest'].lower() not in refs.get(event.get('name'), ()):
+                return False, f"Unexpected measurement of {event.get('name', '?')} in PCR-08"
+            current = bytes.fromhex(replayed.get(index, '00' * 32))
+            replayed[index] = hashlib.sha256(current + bytes.fromhex(event['digest'])).hexdigest()
+        
+        for index, value in replayed.items():
+            if pcrs.get(index) != value:
+                return False, f"PCR-{int(index):02d} does not match its event log"
+        if IMAGE_PCR in pcrs and IMAGE_PCR not in replayed:
+            return False, "PCR-08 has no events in the event log"
+        
+        pcr_text = ''.join(f"PCR-{int(i):02d}: {pcrs[i]}\n" for i in sorted(pcrs, key=int))
+        quote = base64.b64decode(quote_data_b64).decode()
+        signed = [line.split(': ', 1)[1] for line in quote.splitlines()
+                  if line.startswith('pcr_digest: ')]
+        if not signed or signed[0] != hashlib.sha256(pcr_text.encode()).hexdigest():
+            return False, "PCR values do not match the signed pcr_digest"
+        
+        return True, f"Event log replayed ({len(event_log)} events)"
+        
+    except Exception as e:
+        return False, f"Event log invalid: {str(e)}"
+
 @app.route('/')
 def index():
     
@@ -167,13 +227,24 @@ def verify_attestation():
         if quote_data and signature and public_key:
             checks['tpm_quote_present'] = True
             
-            sig_valid, sig_msg = verify_rsa_signature(quote_data, signature, public_key)
+            sig_valid, sig_msg = verify_quote_signature(quote_data, signature, public_key)
             if sig_valid:
                 checks['signature_valid'] = True
-                app.logger.info(f" RSA signature verified: {sig_msg}")
+                app.logger.info(f" Quote signature verified: {sig_msg}")
             else:
                 reasons.append(f'Signature verification failed: {sig_msg}')
                 app.logger.warning(f" {sig_msg}")
+            
+            # PCR-8 is only meaningful with the log that proves what was measured
+            if IMAGE_PCR in tpm_attestation.get('pcrs', {}) and 'event_log' not in tpm_attestation:
+                checks['event_log_valid'] = False
+                reasons.append('PCR-08 reported without an event log')
+            elif 'event_log' in tpm_attestation:
+                log_valid, log_msg = verify_event_log(tpm_attestation['event_log'],
+                                                      tpm_attestation.get('pcrs', {}), quote_data)
+                checks['event_log_valid'] = log_valid
+                if not log_valid:
+                    reasons.append(log_msg)
         else:
             reasons.append('TPM attestation data incomplete')
     elif tpm_quote.get('message') and tpm_quote.get('signature'):
@@ -186,8 +257,10 @@ def verify_attestation():
     if isinstance(health_status, dict):
         overall_status = health_status.get('overall_status', 'unknown')
         overall_score = health_status.get('overall_score', 0)
+        max_score = health_status.get('max_score', 10) or 10
+        normalised_score = overall_score * 10 // max_score
         
-        if overall_status in ['healthy', 'degraded'] and overall_score >= 3:
+        if overall_status in ['healthy', 'degraded'] and normalised_score >= MIN_HEALTH_SCORE:
             checks['health_acceptable'] = True
         else:
             reasons.append(f'Health unacceptable: {overall_status} (score: {overall_score})')
@@ -220,6 +293,9 @@ def verify_attestation():
             'tier_valid'
         ]
     
+    if 'event_log_valid' in checks:
+        required_checks.append('event_log_valid')
+    
     passed_checks = sum(1 for check in required_checks if checks[check])
     total_checks = len(required_checks)
     
@@ -294,5 +370,8 @@ if __name__ == '__main__':
     print(f"  GET  /health    - Health check")
     print(f"")
     
-    app.run(host=host, port=port, debug=debug)
+    # HTTP/1.1 lets pac_attestd fetch the nonce and post the token over one
+    # kept-alive connection instead of a connection per request
+    WSGIRequestHandler.protocol_version = "HTTP/1.1"
+    app.run(host=host, port=port, debug=debug, threaded=True)
 